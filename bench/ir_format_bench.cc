@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/compilationunit.hh"
+#include "src/compiler.hh"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+
+// Compares writing and reading back textual IR (.ll) against bitcode (.bc) for
+// each runtime workload and for a generated program with many functions.
+namespace
+{
+    std::string readFile(const std::filesystem::path &path)
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
+    std::string generateProgram(int functions)
+    {
+        std::string source;
+        for (int i = 0; i < functions; i++)
+        {
+            source += "function integer f" + std::to_string(i) + R"((integer a, integer b) {
+    integer c;
+    c = a + b * 2;
+    while (c < 100) {
+        c = c + 1;
+    };
+    print("f)" + std::to_string(i) + R"(");
+    return c;
+};
+)";
+        }
+        source += R"(function integer main() {
+    print(f0(1, 2));
+    return 0;
+};
+)";
+        return source;
+    }
+
+    double bestOf(int repetitions, const std::function<void()> &run)
+    {
+        double best = 0;
+        for (int i = 0; i < repetitions; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            auto end = std::chrono::steady_clock::now();
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            best = i == 0 ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    }
+
+    void load(llvm::StringRef contents)
+    {
+        llvm::LLVMContext context;
+#if LLVM_VERSION_MAJOR < 15
+        context.enableOpaquePointers();
+#endif
+        llvm::SMDiagnostic error;
+        std::unique_ptr<llvm::Module> module = llvm::parseIR(llvm::MemoryBufferRef(contents, "bench"), error, context);
+        if (module == nullptr)
+        {
+            throw std::runtime_error("Could not load module: " + error.getMessage().str());
+        }
+    }
+
+    void report(const std::string &name, const std::string &source, int repetitions)
+    {
+        anchor::CompilationUnit unit(source);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            throw std::runtime_error(name + " has errors: " + unit.diagnostics[0].getMessage());
+        }
+
+        compiler::Compiler compiler;
+        compiler.compile(unit.program);
+
+        std::string text;
+        double textWrite = bestOf(repetitions, [&]()
+                                  {
+                                      text.clear();
+                                      llvm::raw_string_ostream out(text);
+                                      compiler.print(out);
+                                      out.flush(); });
+        double textLoad = bestOf(repetitions, [&]()
+                                 { load(text); });
+
+        llvm::SmallVector<char, 0> bitcode;
+        double bitcodeWrite = bestOf(repetitions, [&]()
+                                     {
+                                         bitcode.clear();
+                                         llvm::raw_svector_ostream out(bitcode);
+                                         compiler.writeBitcode(out); });
+        double bitcodeLoad = bestOf(repetitions, [&]()
+                                    { load(llvm::StringRef(bitcode.data(), bitcode.size())); });
+
+        std::cout << name << " .ll: " << text.size() / 1024 << " KB, write " << textWrite << " ms, load " << textLoad << " ms\n"
+                  << name << " .bc: " << bitcode.size() / 1024 << " KB, write " << bitcodeWrite << " ms, load " << bitcodeLoad << " ms"
+                  << " (" << (textWrite + textLoad) / (bitcodeWrite + bitcodeLoad) << "x faster round trip)\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::filesystem::path workloads = argc > 1 ? argv[1] : ANCHOR_BENCH_WORKLOADS_DIR;
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::vector<std::filesystem::path> sources;
+    for (const auto &entry : std::filesystem::directory_iterator(workloads))
+    {
+        if (entry.path().extension() == ".anchor")
+        {
+            sources.push_back(entry.path());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+
+    for (const auto &source : sources)
+    {
+        report(source.filename().string(), readFile(source), repetitions);
+    }
+    report("generated-5000-functions", generateProgram(5000), repetitions);
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+
+#include "src/compilationunit.hh"
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/lazy.hh"
+
+// Runs generated programs of 1k, 10k and 100k functions, of which main calls only
+// ten, and each workload, in-process with the whole program JIT compiled up front
+// and with lazy::LazyJit, at -O0 and -O2. Reports the best time to first output
+// and to completion. Output is discarded. Anchor programs never free their
+// strings, so every run happens in a fresh child process.
+//
+// Takes the number of repetitions, 3 by default, then the program sizes to
+// generate instead.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point firstOutput;
+    bool printed = false;
+
+    int discardPrintf(const char *format, ...)
+    {
+        if (!printed)
+        {
+            firstOutput = Clock::now();
+            printed = true;
+        }
+
+        va_list args;
+        va_start(args, format);
+        int length = std::vsnprintf(nullptr, 0, format, args);
+        va_end(args);
+        return length;
+    }
+
+    std::string readFile(const std::filesystem::path &path)
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
+    // A tool with many commands, of which one run only uses a few.
+    std::string generateTool(int functions)
+    {
+        std::string source;
+        for (int i = 0; i < functions; i++)
+        {
+            source += "function integer f" + std::to_string(i) + R"((integer a, integer b) {
+    integer c;
+    c = a + b * 2;
+    while (c < 100) {
+        c = c + 1;
+    };
+    return c;
+};
+)";
+        }
+        source += "function integer main() {\n    print(\"started\");\n";
+        for (int i = 0; i < std::min(functions, 10); i++)
+        {
+            source += "    print(f" + std::to_string(i) + "(1, 2));\n";
+        }
+        source += "    return 0;\n};\n";
+        return source;
+    }
+
+    struct Timing
+    {
+        double firstOutput;
+        double total;
+    };
+
+    Timing measure(const std::string &source, compiler::OptimizationLevel level, bool lazily)
+    {
+        auto start = Clock::now();
+        printed = false;
+
+        anchor::CompilationUnit unit(source);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            throw std::runtime_error(unit.diagnostics[0].getMessage());
+        }
+
+        jit::Jit jit(level);
+        jit.define("printf", reinterpret_cast<void *>(&discardPrintf));
+        if (lazily)
+        {
+            lazy::LazyJit lazy(jit, unit.program, level);
+            lazy.runMain();
+        }
+        else
+        {
+            compiler::Compiler compiler(level);
+            compiler.compile(unit.program);
+            auto [context, module] = compiler.release();
+            jit.add(std::move(context), std::move(module));
+            jit.runMain();
+        }
+        auto end = Clock::now();
+
+        double total = std::chrono::duration<double, std::milli>(end - start).count();
+        double first = printed ? std::chrono::duration<double, std::milli>(firstOutput - start).count() : total;
+        return Timing{first, total};
+    }
+
+    Timing runOnce(const std::string &source, compiler::OptimizationLevel level, bool lazily)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            throw std::runtime_error("Could not create pipe.");
+        }
+
+        // Anything still buffered would be written again by the child.
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0)
+        {
+            close(fds[0]);
+            Timing timing = measure(source, level, lazily);
+            bool written = write(fds[1], &timing, sizeof(timing)) == sizeof(timing);
+            _exit(written ? 0 : 1);
+        }
+
+        close(fds[1]);
+        Timing timing{0, 0};
+        bool received = read(fds[0], &timing, sizeof(timing)) == sizeof(timing);
+        close(fds[0]);
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!received || status != 0)
+        {
+            throw std::runtime_error(std::string("Running ") + (lazily ? "lazily" : "eagerly") + " failed.");
+        }
+        return timing;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int repetitions = argc > 1 ? std::stoi(argv[1]) : 3;
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; i++)
+    {
+        sizes.push_back(std::stoi(argv[i]));
+    }
+    if (sizes.empty())
+    {
+        sizes = {1000, 10000, 100000};
+    }
+
+    std::vector<std::pair<std::string, std::string>> programs;
+    for (int functions : sizes)
+    {
+        programs.emplace_back("tool (" + std::to_string(functions) + " functions)", generateTool(functions));
+    }
+    std::vector<std::filesystem::path> sources;
+    for (const auto &entry : std::filesystem::directory_iterator(ANCHOR_BENCH_WORKLOADS_DIR))
+    {
+        if (entry.path().extension() == ".anchor")
+        {
+            sources.push_back(entry.path());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+    for (const auto &source : sources)
+    {
+        programs.emplace_back(source.filename().string(), readFile(source));
+    }
+
+    for (const auto &[name, source] : programs)
+    {
+        for (compiler::OptimizationLevel level : {compiler::OptimizationLevel::O0, compiler::OptimizationLevel::O2})
+        {
+            for (bool lazily : {false, true})
+            {
+                Timing best{0, 0};
+                for (int i = 0; i < repetitions; i++)
+                {
+                    Timing timing = runOnce(source, level, lazily);
+                    best.firstOutput = i == 0 ? timing.firstOutput : std::min(best.firstOutput, timing.firstOutput);
+                    best.total = i == 0 ? timing.total : std::min(best.total, timing.total);
+                }
+
+                std::string mode = std::string(level == compiler::OptimizationLevel::O0 ? "-O0" : "-O2") + (lazily ? " lazy" : " eager");
+                std::cout << name << " " << mode << ": first output " << best.firstOutput << " ms, total " << best.total << " ms\n";
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/lsp.hh"
+
+// Replays a recorded editor session (one JSON-RPC message per line) against an
+// in-process server and reports the time from receiving each edit to having
+// published its diagnostics.
+int main(int argc, char *argv[])
+{
+    std::string sessionPath = argc > 1 ? argv[1] : std::string(ANCHOR_BENCH_DATA_DIR) + "/edit_session.jsonl";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::ifstream session(sessionPath);
+    if (!session)
+    {
+        std::cerr << "Could not find session with name " << sessionPath << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> messages;
+    for (std::string line; std::getline(session, line);)
+    {
+        if (!line.empty())
+        {
+            messages.push_back(line);
+        }
+    }
+
+    std::vector<double> latencies;
+    for (int i = 0; i < iterations; i++)
+    {
+        std::ostringstream published;
+        lsp::Server server(published);
+        for (const std::string &message : messages)
+        {
+            bool isEdit = message.find("\"textDocument/didChange\"") != std::string::npos;
+
+            auto start = std::chrono::steady_clock::now();
+            server.handle(message);
+            auto end = std::chrono::steady_clock::now();
+
+            if (isEdit)
+            {
+                latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+        }
+    }
+
+    if (latencies.empty())
+    {
+        std::cerr << "Session " << sessionPath << " did not contain any edits." << std::endl;
+        return 1;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p)
+    {
+        std::size_t index = static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1));
+        return latencies[index];
+    };
+
+    std::cout << "edits: " << latencies.size() << "\n"
+              << "p50 time-to-diagnostics: " << percentile(0.50) << " us\n"
+              << "p99 time-to-diagnostics: " << percentile(0.99) << " us\n"
+              << "max time-to-diagnostics: " << latencies.back() << " us\n";
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/compilationunit.hh"
+#include "src/compiler.hh"
+#include "src/parallel.hh"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Compiles a generated program of many functions at -O2 to native objects, once as
+// a single module and then partitioned across a growing number of threads, and
+// reports the best wall-clock time of each. Parsing is not included.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string generateProgram(int functions)
+    {
+        std::string source;
+        for (int i = 0; i < functions; i++)
+        {
+            source += "function integer f" + std::to_string(i) + R"((integer a, integer b) {
+    integer c;
+    c = a + b * 2;
+    while (c < 100) {
+        c = c + 1;
+    };
+    if (c > 150) {
+        print("big");
+    };
+    return c;
+};
+)";
+        }
+        source += "function integer main() {\n    print(f" + std::to_string(functions - 1) + "(1, 2));\n    return 0;\n};\n";
+        return source;
+    }
+
+    double measure(const parser::Program &program, unsigned threads, const std::filesystem::path &directory)
+    {
+        auto start = Clock::now();
+        if (threads == 0)
+        {
+            compiler::Compiler compiler(compiler::OptimizationLevel::O2);
+            compiler.compile(program);
+            llvm::SmallVector<char, 0> object;
+            llvm::raw_svector_ostream out(object);
+            compiler.emitObject(out);
+        }
+        else
+        {
+            parallel::PartitionedCompiler partitioned(compiler::OptimizationLevel::O2, threads);
+            partitioned.compile(program);
+            std::vector<std::string> objectPaths;
+            for (std::size_t i = 0; i < partitioned.size(); i++)
+            {
+                objectPaths.push_back((directory / (std::to_string(i) + ".o")).string());
+            }
+            partitioned.emitObjects(objectPaths);
+        }
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int functions = argc > 1 ? std::stoi(argv[1]) : 50000;
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    anchor::CompilationUnit unit(generateProgram(functions));
+    anchor::lex(unit);
+    anchor::parse(unit);
+    if (unit.hasErrors())
+    {
+        std::cerr << unit.diagnostics[0].getMessage() << '\n';
+        return 1;
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "anchor_parallel_bench";
+    std::filesystem::create_directories(directory);
+
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1U);
+    std::vector<unsigned> configurations{0};
+    for (unsigned threads = 1; threads < cores; threads *= 2)
+    {
+        configurations.push_back(threads);
+    }
+    configurations.push_back(cores);
+
+    std::cout << functions << " functions, -O2, to objects\n";
+    for (unsigned threads : configurations)
+    {
+        double best = 0;
+        for (int i = 0; i < repetitions; i++)
+        {
+            double elapsed = measure(unit.program, threads, directory);
+            best = i == 0 ? elapsed : std::min(best, elapsed);
+        }
+
+        std::string name = threads == 0 ? "one module" : std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+        std::cout << "  " << name << ": " << best << " ms\n";
+    }
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/repl.hh"
+
+// Types a long session into one repl::Repl: rounds of a function definition, a
+// redefinition of an earlier function, a variable declaration, an assignment
+// calling the new function and a print. Reports the median and slowest response
+// per window of inputs, so growth with session length shows. Output is discarded.
+//
+// Takes the number of rounds, 2000 by default, then the optimization level, 0 or 2.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    int discardPrintf(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int length = std::vsnprintf(nullptr, 0, format, args);
+        va_end(args);
+        return length;
+    }
+
+    std::vector<std::string> generateRound(int round)
+    {
+        std::string name = "f" + std::to_string(round);
+        std::string callee = round > 0 ? "f" + std::to_string(round - 1) + "(n)" : "n";
+        std::string variable = "v" + std::to_string(round);
+        std::string redefined = "f" + std::to_string(round / 2);
+        return {
+            "function integer " + name + "(integer n) {\n    if (n > 100) {\n        return n;\n    };\n    return " + callee + " + 1;\n};",
+            "function integer " + redefined + "(integer n) {\n    return n + " + std::to_string(round) + ";\n};",
+            "integer " + variable + ";",
+            variable + " = " + name + "(1);",
+            "print(" + variable + ");",
+        };
+    }
+
+    double percentile(std::vector<double> latencies, double fraction)
+    {
+        std::sort(latencies.begin(), latencies.end());
+        return latencies[static_cast<std::size_t>(fraction * (latencies.size() - 1))];
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? std::stoi(argv[1]) : 2000;
+    compiler::OptimizationLevel level = argc > 2 && std::string(argv[2]) == "2" ? compiler::OptimizationLevel::O2 : compiler::OptimizationLevel::O0;
+    int window = std::max(rounds / 10, 1);
+
+    jit::Jit jit(level);
+    jit.define("printf", reinterpret_cast<void *>(&discardPrintf));
+    repl::Repl session(jit, level);
+
+    std::vector<double> latencies;
+    for (int round = 0; round < rounds; round++)
+    {
+        for (const std::string &input : generateRound(round))
+        {
+            auto start = Clock::now();
+            std::string diagnostics = session.evaluate(input);
+            latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            if (!diagnostics.empty())
+            {
+                throw std::runtime_error(input + ": " + diagnostics);
+            }
+        }
+
+        if ((round + 1) % window == 0 || round + 1 == rounds)
+        {
+            std::size_t inputs = static_cast<std::size_t>(round + 1) * 5;
+            std::cout << "inputs up to " << inputs << ": median " << percentile(latencies, 0.5) << " ms, p99 " << percentile(latencies, 0.99) << " ms, slowest " << percentile(latencies, 1) << " ms\n";
+            latencies.clear();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/anchor.hh"
+
+// Compiles every workload at each optimization level, runs the IR with lli and
+// reports the best wall time per level along with its speedup over -O0.
+namespace
+{
+    std::string readFile(const std::filesystem::path &path)
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
+    double timeRun(const std::string &command, int repetitions)
+    {
+        double best = 0;
+        for (int i = 0; i < repetitions; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            int status = std::system(command.c_str());
+            auto end = std::chrono::steady_clock::now();
+            if (status != 0)
+            {
+                throw std::runtime_error(command + " returned " + std::to_string(status));
+            }
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            best = i == 0 ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::filesystem::path workloads = argc > 1 ? argv[1] : ANCHOR_BENCH_WORKLOADS_DIR;
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 3;
+    const char *lli = std::getenv("ANCHOR_LLI");
+    std::string interpreter = lli != nullptr ? lli : "lli";
+
+    const std::vector<std::pair<std::string, compiler::OptimizationLevel>> levels{
+        {"-O0", compiler::OptimizationLevel::O0},
+        {"-O1", compiler::OptimizationLevel::O1},
+        {"-O2", compiler::OptimizationLevel::O2},
+        {"-O3", compiler::OptimizationLevel::O3},
+    };
+
+    std::vector<std::filesystem::path> sources;
+    for (const auto &entry : std::filesystem::directory_iterator(workloads))
+    {
+        if (entry.path().extension() == ".anchor")
+        {
+            sources.push_back(entry.path());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "anchor_runtime_bench.ll";
+    for (const auto &source : sources)
+    {
+        std::string program = readFile(source);
+
+        double baseline = 0;
+        for (const auto &[name, level] : levels)
+        {
+            {
+                std::ofstream ir(scratch);
+                ir << anchor::compile(program, level);
+            }
+
+            double elapsed = timeRun(interpreter + " " + scratch.string() + " > /dev/null", repetitions);
+            if (level == compiler::OptimizationLevel::O0)
+            {
+                baseline = elapsed;
+            }
+
+            std::cout << source.filename().string() << " " << name << ": " << elapsed << " ms"
+                      << " (" << baseline / elapsed << "x vs -O0)\n";
+        }
+    }
+
+    std::filesystem::remove(scratch);
+    return 0;
+}
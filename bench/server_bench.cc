@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "src/protocol.hh"
+
+extern char **environ;
+
+// Compiles a workload to textual IR over and over, from a number of concurrent
+// clients: as a fresh main process per compile, as an anchor_client process per
+// compile talking to a running anchor_server, and as requests sent straight to
+// the server from this process. Reports requests per second and the median and
+// 99th percentile latency of each. The cache is off throughout.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Runs the command with its output discarded, and returns its exit status.
+    int spawn(const std::vector<std::string> &command)
+    {
+        std::vector<char *> argv;
+        for (const std::string &arg : command)
+        {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        pid_t pid;
+        int error = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (error != 0)
+        {
+            throw std::runtime_error("Could not start " + command[0]);
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+        return status;
+    }
+
+    void measure(const std::string &name, int requests, unsigned clients, const std::function<void()> &compile)
+    {
+        std::vector<double> latencies(static_cast<std::size_t>(requests));
+        std::atomic<int> next = 0;
+
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < clients; i++)
+        {
+            threads.emplace_back([&]()
+                                 {
+                                     for (int request = next++; request < requests; request = next++)
+                                     {
+                                         auto sent = Clock::now();
+                                         compile();
+                                         latencies[static_cast<std::size_t>(request)] = std::chrono::duration<double, std::milli>(Clock::now() - sent).count();
+                                     } });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::sort(latencies.begin(), latencies.end());
+        double p50 = latencies[latencies.size() / 2];
+        double p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        std::cout << name << ", " << clients << " clients: " << requests / elapsed << " requests/s, p50 " << p50 << " ms, p99 " << p99 << " ms\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::filesystem::path workload = argc > 1 ? argv[1] : std::string(ANCHOR_BENCH_WORKLOADS_DIR) + "/calls.anchor";
+    int requests = argc > 2 ? std::stoi(argv[2]) : 200;
+    unsigned clients = argc > 3 ? static_cast<unsigned>(std::stoi(argv[3])) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::string socketPath = "/tmp/anchor_server_bench_" + std::to_string(getpid()) + ".sock";
+    std::vector<std::string> server{ANCHOR_SERVER_PATH, "--socket=" + socketPath, "--threads=" + std::to_string(clients)};
+    std::vector<char *> serverArgv;
+    for (std::string &arg : server)
+    {
+        serverArgv.push_back(arg.data());
+    }
+    serverArgv.push_back(nullptr);
+    pid_t serverPid;
+    if (posix_spawn(&serverPid, serverArgv[0], nullptr, nullptr, serverArgv.data(), environ) != 0)
+    {
+        std::cerr << "Could not start " << server[0] << '\n';
+        return 1;
+    }
+
+    bool listening = false;
+    for (int attempt = 0; attempt < 500 && !listening; attempt++)
+    {
+        try
+        {
+            close(protocol::connect(socketPath));
+            listening = true;
+        }
+        catch (std::runtime_error &)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    if (!listening)
+    {
+        std::cerr << "The server did not start listening on " << socketPath << '\n';
+        kill(serverPid, SIGTERM);
+        return 1;
+    }
+
+    protocol::Request request;
+    request.workingDirectory = std::filesystem::current_path().string();
+
+    for (const std::string &level : {"-O0", "-O2"})
+    {
+        std::cout << workload.filename().string() << " " << level << "\n";
+        request.args = {"--no-cache", level, workload.string()};
+
+        measure("fresh main process", requests, clients, [&]()
+                { spawn({ANCHOR_MAIN_PATH, "--no-cache", level, workload.string()}); });
+        measure("anchor_client process", requests, clients, [&]()
+                { spawn({ANCHOR_CLIENT_PATH, "--socket=" + socketPath, "--no-cache", level, workload.string()}); });
+        measure("in-process client", requests, clients, [&]()
+                { protocol::send(socketPath, request); });
+    }
+
+    kill(serverPid, SIGTERM);
+    int status;
+    waitpid(serverPid, &status, 0);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// Compiles an empty program to textual IR with a fresh compiler process, over
+// and over, and reports the mean and median wall time of each. With the cache
+// off, nearly all of that is the process starting up and shutting down.
+//
+// Takes the number of runs, then any number of compiler binaries to compare,
+// such as one built before a change and one after. Defaults to 1000 runs of
+// this build's main.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Runs the command with its output discarded, and returns its exit status.
+    int spawn(const std::vector<std::string> &command)
+    {
+        std::vector<char *> argv;
+        for (const std::string &arg : command)
+        {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        pid_t pid;
+        int error = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (error != 0)
+        {
+            throw std::runtime_error("Could not start " + command[0]);
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+        return status;
+    }
+
+    void measure(const std::string &binary, const std::filesystem::path &program, int runs)
+    {
+        std::vector<std::string> command{binary, "--no-cache", program.string()};
+        if (spawn(command) != 0)
+        {
+            std::cerr << binary << " could not compile " << program.string() << '\n';
+            return;
+        }
+
+        std::vector<double> times(static_cast<std::size_t>(runs));
+        for (double &time : times)
+        {
+            auto start = Clock::now();
+            spawn(command);
+            time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        double mean = 0;
+        for (double time : times)
+        {
+            mean += time;
+        }
+        mean /= runs;
+        std::sort(times.begin(), times.end());
+        std::cout << binary << ": mean " << mean << " ms, p50 " << times[times.size() / 2] << " ms over " << runs << " runs\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int runs = argc > 1 ? std::stoi(argv[1]) : 1000;
+    if (runs <= 0)
+    {
+        std::cerr << "Expected a positive number of runs.\n";
+        return 1;
+    }
+
+    std::vector<std::string> binaries(argv + std::min(argc, 2), argv + argc);
+    if (binaries.empty())
+    {
+        binaries.push_back(ANCHOR_MAIN_PATH);
+    }
+
+    std::filesystem::path program = std::filesystem::temp_directory_path() / ("anchor_startup_bench_" + std::to_string(getpid()) + ".anchor");
+    std::ofstream(program) << "function integer main() {\n    return 0;\n};\n";
+
+    for (const std::string &binary : binaries)
+    {
+        measure(binary, program, runs);
+    }
+
+    std::filesystem::remove(program);
+    return 0;
+}
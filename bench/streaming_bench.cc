@@ -0,0 +1,120 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// Compiles generated programs of 1k, 10k and 100k functions to textual IR with a
+// fresh main process, once as a whole module and once with --stream, and reports
+// the wall time and peak resident memory of each. Takes the sizes to compile
+// instead, and an optimization level after them, such as -O2. The cache is off.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Every function calls the one before it, so every chunk calls into the last.
+    std::string generateProgram(int functions)
+    {
+        std::string source = "function integer f0(integer n) {\n    return n + 1;\n};\n";
+        for (int i = 1; i < functions; i++)
+        {
+            std::string index = std::to_string(i);
+            source += "function integer f" + index + "(integer n) {\n";
+            source += "    integer total;\n";
+            source += "    total = f" + std::to_string(i - 1) + "(n) + " + index + ";\n";
+            source += "    if (total > 100000) {\n        total = total - 100000;\n    };\n";
+            source += "    return total;\n};\n";
+        }
+        source += "function integer main() {\n    print(f" + std::to_string(functions - 1) + "(0));\n    return 0;\n};\n";
+        return source;
+    }
+
+    class Usage
+    {
+    public:
+        double seconds;
+        long peakKilobytes;
+        int status;
+    };
+
+    // Runs the command with its output discarded.
+    Usage spawn(const std::vector<std::string> &command)
+    {
+        std::vector<char *> argv;
+        for (const std::string &arg : command)
+        {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        auto start = Clock::now();
+        pid_t pid;
+        int error = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (error != 0)
+        {
+            throw std::runtime_error("Could not start " + command[0]);
+        }
+
+        Usage usage;
+        rusage resources;
+        wait4(pid, &usage.status, 0, &resources);
+        usage.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        usage.peakKilobytes = resources.ru_maxrss;
+        return usage;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<int> sizes;
+    std::string level = "-O0";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.starts_with("-O"))
+        {
+            level = arg;
+        }
+        else
+        {
+            sizes.push_back(std::stoi(arg));
+        }
+    }
+    if (sizes.empty())
+    {
+        sizes = {1000, 10000, 100000};
+    }
+
+    std::filesystem::path program = std::filesystem::temp_directory_path() / ("anchor_streaming_bench_" + std::to_string(getpid()) + ".anchor");
+    for (int functions : sizes)
+    {
+        std::ofstream(program) << generateProgram(functions);
+        for (bool stream : {false, true})
+        {
+            std::vector<std::string> command{ANCHOR_MAIN_PATH, "--no-cache", level, program.string()};
+            if (stream)
+            {
+                command.insert(command.begin() + 1, "--stream");
+            }
+
+            Usage usage = spawn(command);
+            std::cout << functions << " functions " << level << (stream ? ", streamed: " : ", whole module: ") << usage.seconds << " s, peak RSS " << usage.peakKilobytes / 1024 << " MB";
+            std::cout << (usage.status == 0 ? "\n" : ", failed\n");
+        }
+    }
+    std::filesystem::remove(program);
+    return 0;
+}
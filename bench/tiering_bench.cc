@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+
+#include "src/compilationunit.hh"
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/tiering.hh"
+
+// Runs each workload in-process with the whole program JIT compiled at -O0, at
+// -O2, and tiered, and reports the best time to first output and to completion.
+// A generated script with many functions called once stands in for a short-lived
+// program, where compile time dominates, and a generated job that calls one
+// function many times for a long-running one. Output is discarded. Anchor programs
+// never free their strings, so every run happens in a fresh child process.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point firstOutput;
+    bool printed = false;
+
+    int discardPrintf(const char *format, ...)
+    {
+        if (!printed)
+        {
+            firstOutput = Clock::now();
+            printed = true;
+        }
+
+        va_list args;
+        va_start(args, format);
+        int length = std::vsnprintf(nullptr, 0, format, args);
+        va_end(args);
+        return length;
+    }
+
+    std::string readFile(const std::filesystem::path &path)
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
+    std::string generateScript(int functions)
+    {
+        std::string source;
+        for (int i = 0; i < functions; i++)
+        {
+            source += "function integer f" + std::to_string(i) + R"((integer a, integer b) {
+    integer c;
+    c = a + b * 2;
+    while (c < 100) {
+        c = c + 1;
+    };
+    return c;
+};
+)";
+        }
+        source += "function integer main() {\n    print(\"started\");\n";
+        for (int i = 0; i < functions; i++)
+        {
+            source += "    f" + std::to_string(i) + "(1, 2);\n";
+        }
+        source += "    return 0;\n};\n";
+        return source;
+    }
+
+    const std::string job = R"(function integer work(integer n) {
+    integer j;
+    integer sum;
+    j = 0;
+    sum = 0;
+    while (j < 10000) {
+        sum = sum + j * n;
+        j = j + 1;
+    };
+    return sum;
+};
+
+function integer main() {
+    integer i;
+    integer total;
+    i = 0;
+    total = 0;
+    while (i < 20000) {
+        total = total + work(i);
+        i = i + 1;
+    };
+    print(total);
+    return 0;
+};
+)";
+
+    struct Timing
+    {
+        double firstOutput;
+        double total;
+    };
+
+    Timing measure(const std::string &source, const std::string &mode)
+    {
+        auto start = Clock::now();
+        printed = false;
+
+        anchor::CompilationUnit unit(source);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            throw std::runtime_error(unit.diagnostics[0].getMessage());
+        }
+
+        compiler::OptimizationLevel level = mode == "-O2" ? compiler::OptimizationLevel::O2 : compiler::OptimizationLevel::O0;
+        jit::Jit jit(level);
+        jit.define("printf", reinterpret_cast<void *>(&discardPrintf));
+        if (mode == "tiered")
+        {
+            tiering::TieredJit tiered(jit, unit.program);
+            tiered.runMain();
+        }
+        else
+        {
+            compiler::Compiler compiler(level);
+            compiler.compile(unit.program);
+            auto [context, module] = compiler.release();
+            jit.add(std::move(context), std::move(module));
+            jit.runMain();
+        }
+        auto end = Clock::now();
+
+        double total = std::chrono::duration<double, std::milli>(end - start).count();
+        double first = printed ? std::chrono::duration<double, std::milli>(firstOutput - start).count() : total;
+        return Timing{first, total};
+    }
+
+    Timing runOnce(const std::string &source, const std::string &mode)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            throw std::runtime_error("Could not create pipe.");
+        }
+
+        // Anything still buffered would be written again by the child.
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0)
+        {
+            close(fds[0]);
+            Timing timing = measure(source, mode);
+            bool written = write(fds[1], &timing, sizeof(timing)) == sizeof(timing);
+            _exit(written ? 0 : 1);
+        }
+
+        close(fds[1]);
+        Timing timing{0, 0};
+        bool received = read(fds[0], &timing, sizeof(timing)) == sizeof(timing);
+        close(fds[0]);
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!received || status != 0)
+        {
+            throw std::runtime_error("Running " + mode + " failed.");
+        }
+        return timing;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::filesystem::path workloads = argc > 1 ? argv[1] : ANCHOR_BENCH_WORKLOADS_DIR;
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    std::vector<std::pair<std::string, std::string>> programs{{"script (2000 functions)", generateScript(2000)}, {"job (20000 calls)", job}};
+    std::vector<std::filesystem::path> sources;
+    for (const auto &entry : std::filesystem::directory_iterator(workloads))
+    {
+        if (entry.path().extension() == ".anchor")
+        {
+            sources.push_back(entry.path());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+    for (const auto &source : sources)
+    {
+        programs.emplace_back(source.filename().string(), readFile(source));
+    }
+
+    for (const auto &[name, source] : programs)
+    {
+        for (const std::string mode : {"-O0", "-O2", "tiered"})
+        {
+            Timing best{0, 0};
+            for (int i = 0; i < repetitions; i++)
+            {
+                Timing timing = runOnce(source, mode);
+                best.firstOutput = i == 0 ? timing.firstOutput : std::min(best.firstOutput, timing.firstOutput);
+                best.total = i == 0 ? timing.total : std::min(best.total, timing.total);
+            }
+
+            std::cout << name << " " << mode << ": first output " << best.firstOutput << " ms, total " << best.total << " ms\n";
+        }
+    }
+    return 0;
+}
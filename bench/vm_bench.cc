@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Compares end-to-end latency of running each workload, and a one-line script, as
+// separate processes: on the bytecode VM from source and precompiled, through the
+// JIT, and compiled ahead of time, both including and excluding the compile step.
+namespace
+{
+    double timeRun(const std::string &command, int repetitions)
+    {
+        double best = 0;
+        for (int i = 0; i < repetitions; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            int status = std::system(command.c_str());
+            auto end = std::chrono::steady_clock::now();
+            if (status != 0)
+            {
+                throw std::runtime_error(command + " returned " + std::to_string(status));
+            }
+
+            double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+            best = i == 0 ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::filesystem::path workloads = argc > 1 ? argv[1] : ANCHOR_BENCH_WORKLOADS_DIR;
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 5;
+    std::string anchor = ANCHOR_MAIN_PATH;
+    std::string anchorVm = ANCHOR_VM_PATH;
+
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "anchor_vm_bench";
+    std::filesystem::create_directories(scratch);
+
+    std::vector<std::filesystem::path> sources;
+    {
+        std::ofstream script(scratch / "script.anchor");
+        script << "function integer main() {\n    print(\"Hello, World!\");\n    return 0;\n};\n";
+    }
+    sources.push_back(scratch / "script.anchor");
+    for (const auto &entry : std::filesystem::directory_iterator(workloads))
+    {
+        if (entry.path().extension() == ".anchor")
+        {
+            sources.push_back(entry.path());
+        }
+    }
+    std::sort(sources.begin() + 1, sources.end());
+
+    std::string bytecode = (scratch / "program.anchorbc").string();
+    std::string executable = (scratch / "program").string();
+    for (const auto &source : sources)
+    {
+        std::string name = source.filename().string();
+        std::string quiet = " > /dev/null";
+
+        std::vector<std::pair<std::string, double>> timings;
+        timings.emplace_back("vm", timeRun(anchorVm + " " + source.string() + quiet, repetitions));
+        timeRun(anchorVm + " -o " + bytecode + " " + source.string(), 1);
+        timings.emplace_back("vm precompiled", timeRun(anchorVm + " " + bytecode + quiet, repetitions));
+        timings.emplace_back("jit -O0", timeRun(anchor + " --run " + source.string() + quiet, repetitions));
+        timings.emplace_back("aot -O2 compile+run", timeRun(anchor + " -O2 -o " + executable + " " + source.string() + " && " + executable + quiet, repetitions));
+        timings.emplace_back("aot -O2 run", timeRun(executable + quiet, repetitions));
+
+        for (const auto &[engine, elapsed] : timings)
+        {
+            std::cout << name << " " << engine << ": " << elapsed << " ms\n";
+        }
+    }
+
+    std::filesystem::remove_all(scratch);
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+
+#include "src/compilationunit.hh"
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/x86.hh"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Compiles generated programs of 1k and 10k functions with LLVM at -O0, through
+// IRBuilder, instruction selection and the object writer, and with x86::compile,
+// and reports compile throughput in functions per second. Parsing is not timed.
+// Then runs each workload on both backends and reports the best time from parsed
+// program to completion, which includes the time the code takes to run. Output
+// is discarded. Anchor programs never free their strings, so every run happens in
+// a fresh child process.
+//
+// Takes the number of repetitions, 3 by default, then the program sizes to
+// generate instead.
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    int discardPrintf(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int length = std::vsnprintf(nullptr, 0, format, args);
+        va_end(args);
+        return length;
+    }
+
+    std::string readFile(const std::filesystem::path &path)
+    {
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+
+    std::string generateProgram(int functions)
+    {
+        std::string source;
+        for (int i = 0; i < functions; i++)
+        {
+            std::string callee = i > 0 ? "f" + std::to_string(i - 1) + "(a, b)" : "a";
+            source += "function integer f" + std::to_string(i) + R"((integer a, integer b) {
+    integer c;
+    string s;
+    c = a + b * 2;
+    while (c < 100) {
+        c = c + 1;
+        s = s + "x";
+    };
+    if (c > 1000) {
+        return )" + callee + R"(;
+    };
+    return c;
+};
+)";
+        }
+        source += "function integer main() {\n    print(f" + std::to_string(functions - 1) + "(1, 2));\n    return 0;\n};\n";
+        return source;
+    }
+
+    parser::Program parse(const std::string &source)
+    {
+        anchor::CompilationUnit unit(source);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            throw std::runtime_error(unit.diagnostics[0].getMessage());
+        }
+        return unit.program;
+    }
+
+    double compileLlvm(const parser::Program &program)
+    {
+        auto start = Clock::now();
+        compiler::Compiler compiler(compiler::OptimizationLevel::O0);
+        compiler.compile(program);
+        llvm::SmallVector<char, 0> object;
+        llvm::raw_svector_ostream out(object);
+        compiler.emitObject(out);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double compileX86(const parser::Program &program)
+    {
+        auto start = Clock::now();
+        x86::Code code = x86::compile(program);
+        x86::Jit jit;
+        jit.add(code);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double runOnce(const parser::Program &program, bool onX86)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            throw std::runtime_error("Could not create pipe.");
+        }
+
+        // Anything still buffered would be written again by the child.
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0)
+        {
+            close(fds[0]);
+            auto start = Clock::now();
+            if (onX86)
+            {
+                x86::Jit jit;
+                jit.define("printf", reinterpret_cast<void *>(&discardPrintf));
+                jit.add(x86::compile(program));
+                jit.runMain();
+            }
+            else
+            {
+                jit::Jit jit(compiler::OptimizationLevel::O0);
+                jit.define("printf", reinterpret_cast<void *>(&discardPrintf));
+                compiler::Compiler compiler(compiler::OptimizationLevel::O0);
+                compiler.compile(program);
+                auto [context, module] = compiler.release();
+                jit.add(std::move(context), std::move(module));
+                jit.runMain();
+            }
+            double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            bool written = write(fds[1], &elapsed, sizeof(elapsed)) == sizeof(elapsed);
+            _exit(written ? 0 : 1);
+        }
+
+        close(fds[1]);
+        double elapsed = 0;
+        bool received = read(fds[0], &elapsed, sizeof(elapsed)) == sizeof(elapsed);
+        close(fds[0]);
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!received || status != 0)
+        {
+            throw std::runtime_error(std::string("Running on ") + (onX86 ? "x86" : "LLVM") + " failed.");
+        }
+        return elapsed;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int repetitions = argc > 1 ? std::stoi(argv[1]) : 3;
+    std::vector<int> sizes;
+    for (int i = 2; i < argc; i++)
+    {
+        sizes.push_back(std::stoi(argv[i]));
+    }
+    if (sizes.empty())
+    {
+        sizes = {1000, 10000};
+    }
+
+    for (int functions : sizes)
+    {
+        parser::Program program = parse(generateProgram(functions));
+        double llvm = 0;
+        double x86 = 0;
+        for (int i = 0; i < repetitions; i++)
+        {
+            double llvmSeconds = compileLlvm(program);
+            double x86Seconds = compileX86(program);
+            llvm = i == 0 ? llvmSeconds : std::min(llvm, llvmSeconds);
+            x86 = i == 0 ? x86Seconds : std::min(x86, x86Seconds);
+        }
+
+        // main is a function too.
+        double compiled = functions + 1;
+        std::cout << functions << " functions: LLVM -O0 " << compiled / llvm << " functions/s, x86 " << compiled / x86 << " functions/s\n";
+    }
+
+    std::vector<std::filesystem::path> sources;
+    for (const auto &entry : std::filesystem::directory_iterator(ANCHOR_BENCH_WORKLOADS_DIR))
+    {
+        if (entry.path().extension() == ".anchor")
+        {
+            sources.push_back(entry.path());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+    for (const auto &source : sources)
+    {
+        parser::Program program = parse(readFile(source));
+        for (bool onX86 : {false, true})
+        {
+            double best = 0;
+            for (int i = 0; i < repetitions; i++)
+            {
+                double elapsed = runOnce(program, onX86);
+                best = i == 0 ? elapsed : std::min(best, elapsed);
+            }
+            std::cout << source.filename().string() << (onX86 ? " x86" : " LLVM -O0") << ": " << best << " ms\n";
+        }
+    }
+    return 0;
+}
@@ -3,34 +3,408 @@
 #include "src/lexer.hh"
 #include "src/parser.hh"
 #include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/lazy.hh"
+#include "src/modules.hh"
+#include "src/parallel.hh"
+#include "src/tiering.hh"
+#include "src/x86.hh"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+
 namespace anchor
 {
-    std::string compile(std::string input)
+    namespace
     {
-        parser::Parser parser(lexer::lex(input));
-        compiler::Compiler compiler;
+        std::string diagnostics(const anchor::CompilationUnit &unit)
+        {
+            std::string errors = "";
+            for (const parser::ErrorLog &errorLog : unit.diagnostics)
+            {
+                errors += errorLog.getMessage() + "\n";
+            }
+            return errors;
+        }
 
-        parser::Program program = parser.parse();
+        std::string shellQuote(const std::string &argument)
+        {
+            std::string quoted = "'";
+            for (char c : argument)
+            {
+                quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+            }
+            return quoted + "'";
+        }
 
-        if (program.isSyntacticallyCorrect())
+        // Compiles the program as one module on this thread, with the unit's compiler
+        // when it has one, or partitioned across codegenThreads threads and linked
+        // back together.
+        template <typename Use>
+        void compileLinked(const anchor::CompilationUnit &unit, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads, Use use)
         {
-            std::string llvmOutputRef;
-            llvm::raw_string_ostream llvmOutput(llvmOutputRef);
+            if (codegenThreads == 0 && unit.compiler != nullptr)
+            {
+                if (unit.compiler->getOptimizationLevel() != optimizationLevel)
+                {
+                    throw std::invalid_argument("Cannot compile a unit with a compiler at another optimization level.");
+                }
+                unit.compiler->reset();
+                unit.compiler->compile(unit.program);
+                use(*unit.compiler);
+                return;
+            }
+
+            if (codegenThreads == 0)
+            {
+                compiler::Compiler compiler(optimizationLevel);
+                compiler.compile(unit.program);
+                use(compiler);
+                return;
+            }
+
+            parallel::PartitionedCompiler partitioned(optimizationLevel, codegenThreads);
+            partitioned.compile(unit.program);
+            use(partitioned.link());
+        }
+    }
 
-            compiler.compile(llvmOutput, program);
+    std::string compile(std::string input, compiler::OptimizationLevel optimizationLevel)
+    {
+        anchor::CompilationUnit unit(std::move(input));
+        return compile(unit, optimizationLevel);
+    }
+
+    std::string compile(anchor::CompilationUnit &unit, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads)
+    {
+        std::string llvmOutputRef;
+        llvm::raw_string_ostream llvmOutput(llvmOutputRef);
+        std::string errors = compileToIR(unit, llvmOutput, optimizationLevel, codegenThreads);
+        llvmOutput.flush();
 
-            return llvmOutputRef;
+        if (unit.hasErrors())
+        {
+            return errors;
         }
-        else
+        return llvmOutputRef;
+    }
+
+    std::string compile(std::string input, llvm::SmallVectorImpl<char> &bitcode, compiler::OptimizationLevel optimizationLevel)
+    {
+        anchor::CompilationUnit unit(std::move(input));
+        return compile(unit, bitcode, optimizationLevel);
+    }
+
+    std::string compile(anchor::CompilationUnit &unit, llvm::SmallVectorImpl<char> &bitcode, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads)
+    {
+        llvm::raw_svector_ostream bitcodeOutput(bitcode);
+        return compileToBitcode(unit, bitcodeOutput, optimizationLevel, codegenThreads);
+    }
+
+    std::string compileToIR(anchor::CompilationUnit &unit, llvm::raw_ostream &out, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads)
+    {
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        if (unit.hasErrors())
         {
-            std::string errors = "";
-            for (parser::ErrorLog errorLog : program.errors)
+            return diagnostics(unit);
+        }
+
+        compileLinked(unit, optimizationLevel, codegenThreads, [&](compiler::Compiler &compiler)
+                      { compiler.print(out); });
+        return "";
+    }
+
+    std::string compileToBitcode(anchor::CompilationUnit &unit, llvm::raw_ostream &out, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads)
+    {
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        if (unit.hasErrors())
+        {
+            return diagnostics(unit);
+        }
+
+        compileLinked(unit, optimizationLevel, codegenThreads, [&](compiler::Compiler &compiler)
+                      { compiler.writeBitcode(out); });
+        return "";
+    }
+
+    std::string compileToObject(anchor::CompilationUnit &unit, const std::string &objectPath, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads)
+    {
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        if (unit.hasErrors())
+        {
+            return diagnostics(unit);
+        }
+
+        compileLinked(unit, optimizationLevel, codegenThreads, [&](compiler::Compiler &compiler)
+                      {
+                          std::error_code error;
+                          llvm::raw_fd_ostream object(objectPath, error, llvm::sys::fs::OF_None);
+                          if (error)
+                          {
+                              throw std::runtime_error("Could not open " + objectPath + " for writing: " + error.message());
+                          }
+                          compiler.emitObject(object); });
+        return "";
+    }
+
+    std::string compileToExecutable(anchor::CompilationUnit &unit, const std::string &executablePath, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads, modules::Importer *importer, const std::string &driver)
+    {
+        // Libraries compile on threads of their own while the program is parsed and compiled.
+        if (importer != nullptr)
+        {
+            importer->buildObjects(executablePath + ".lib", optimizationLevel);
+        }
+
+        std::vector<std::string> objectPaths;
+        bool librariesCollected = false;
+        auto removeObjects = [&]()
+        {
+            for (const std::string &objectPath : objectPaths)
             {
-                errors += errorLog.getMessage() + "\n";
+                std::error_code error;
+                std::filesystem::remove(objectPath, error);
             }
-            return errors;
+        };
+
+        std::string errors;
+        try
+        {
+            if (codegenThreads == 0)
+            {
+                objectPaths.push_back(executablePath + ".o");
+                errors = compileToObject(unit, objectPaths.back(), optimizationLevel);
+            }
+            else
+            {
+                anchor::lex(unit);
+                anchor::parse(unit);
+                if (unit.hasErrors())
+                {
+                    errors = diagnostics(unit);
+                }
+                else
+                {
+                    parallel::PartitionedCompiler partitioned(optimizationLevel, codegenThreads);
+                    partitioned.compile(unit.program);
+                    for (std::size_t i = 0; i < partitioned.size(); i++)
+                    {
+                        objectPaths.push_back(executablePath + "." + std::to_string(i) + ".o");
+                    }
+                    partitioned.emitObjects(objectPaths);
+                }
+            }
+
+            if (importer != nullptr)
+            {
+                librariesCollected = true;
+                std::vector<std::string> libraries = importer->objects();
+                objectPaths.insert(objectPaths.end(), libraries.begin(), libraries.end());
+            }
+            if (errors.empty())
+            {
+                link(objectPaths, executablePath, driver);
+            }
+        }
+        catch (...)
+        {
+            // The libraries may still be compiling; wait for them so theirs go too.
+            if (importer != nullptr && !librariesCollected)
+            {
+                try
+                {
+                    std::vector<std::string> libraries = importer->objects();
+                    objectPaths.insert(objectPaths.end(), libraries.begin(), libraries.end());
+                }
+                catch (...)
+                {
+                }
+            }
+            removeObjects();
+            throw;
+        }
+        removeObjects();
+        return errors;
+    }
+
+    std::string compileStreamingToIR(anchor::CompilationUnit &unit, llvm::raw_ostream &out, compiler::OptimizationLevel optimizationLevel, std::size_t chunkSize)
+    {
+        streaming::IRWriter writer(out);
+        streaming::StreamingCompiler streamed(optimizationLevel, [&](compiler::Compiler &compiler)
+                                              {
+                                                  auto [context, module] = compiler.release();
+                                                  writer.write(*module); },
+                                              chunkSize);
+        streamed.compile(unit);
+
+        if (unit.hasErrors())
+        {
+            return diagnostics(unit);
+        }
+        writer.finish();
+        return "";
+    }
+
+    std::string compileStreamingToExecutable(anchor::CompilationUnit &unit, const std::string &executablePath, compiler::OptimizationLevel optimizationLevel, modules::Importer *importer, std::size_t chunkSize)
+    {
+        if (importer != nullptr)
+        {
+            importer->buildObjects(executablePath + ".lib", optimizationLevel);
+        }
+
+        std::vector<std::string> objectPaths;
+        auto removeObjects = [&]()
+        {
+            for (const std::string &objectPath : objectPaths)
+            {
+                std::error_code error;
+                std::filesystem::remove(objectPath, error);
+            }
+        };
+
+        std::string errors;
+        try
+        {
+            streaming::StreamingCompiler streamed(optimizationLevel, [&](compiler::Compiler &compiler)
+                                                  {
+                                                      objectPaths.push_back(executablePath + "." + std::to_string(objectPaths.size()) + ".o");
+                                                      std::error_code error;
+                                                      llvm::raw_fd_ostream object(objectPaths.back(), error, llvm::sys::fs::OF_None);
+                                                      if (error)
+                                                      {
+                                                          throw std::runtime_error("Could not open " + objectPaths.back() + " for writing: " + error.message());
+                                                      }
+                                                      compiler.emitObject(object); },
+                                                  chunkSize);
+            streamed.compile(unit);
+            if (unit.hasErrors())
+            {
+                errors = diagnostics(unit);
+            }
+
+            if (importer != nullptr)
+            {
+                std::vector<std::string> libraries = importer->objects();
+                objectPaths.insert(objectPaths.end(), libraries.begin(), libraries.end());
+            }
+            if (errors.empty())
+            {
+                link(objectPaths, executablePath);
+            }
+        }
+        catch (...)
+        {
+            removeObjects();
+            throw;
+        }
+        removeObjects();
+        return errors;
+    }
+
+    std::optional<int> run(anchor::CompilationUnit &unit, compiler::OptimizationLevel optimizationLevel, unsigned codegenThreads)
+    {
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        if (unit.hasErrors())
+        {
+            return std::nullopt;
+        }
+
+        if (codegenThreads > 0)
+        {
+            parallel::PartitionedCompiler partitioned(optimizationLevel, codegenThreads);
+            partitioned.compile(unit.program);
+
+            jit::Jit jit(optimizationLevel);
+            partitioned.addTo(jit);
+            return jit.runMain();
+        }
+
+        compiler::Compiler compiler(optimizationLevel);
+        compiler.compile(unit.program);
+
+        jit::Jit jit(optimizationLevel);
+        auto [context, module] = compiler.release();
+        jit.add(std::move(context), std::move(module));
+        return jit.runMain();
+    }
+
+    std::optional<int> runTiered(anchor::CompilationUnit &unit, int threshold)
+    {
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        if (unit.hasErrors())
+        {
+            return std::nullopt;
+        }
+
+        jit::Jit jit;
+        tiering::TieredJit tiered(jit, unit.program, threshold);
+        return tiered.runMain();
+    }
+
+    std::optional<int> runLazy(anchor::CompilationUnit &unit, compiler::OptimizationLevel optimizationLevel)
+    {
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        if (unit.hasErrors())
+        {
+            return std::nullopt;
+        }
+
+        jit::Jit jit(optimizationLevel);
+        lazy::LazyJit lazy(jit, unit.program, optimizationLevel);
+        return lazy.runMain();
+    }
+
+    std::optional<int> runX86(anchor::CompilationUnit &unit)
+    {
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        if (unit.hasErrors())
+        {
+            return std::nullopt;
+        }
+
+        x86::Jit jit;
+        jit.add(x86::compile(unit.program));
+        return jit.runMain();
+    }
+
+    std::string linkDriver()
+    {
+        const char *cc = std::getenv("CC");
+        return cc != nullptr ? cc : "cc";
+    }
+
+    void link(const std::string &objectPath, const std::string &executablePath, const std::string &driver)
+    {
+        link(std::vector<std::string>{objectPath}, executablePath, driver);
+    }
+
+    void link(const std::vector<std::string> &objectPaths, const std::string &executablePath, const std::string &driver)
+    {
+        std::string command = driver;
+        for (const std::string &objectPath : objectPaths)
+        {
+            command += " " + shellQuote(objectPath);
+        }
+        command += " -o " + shellQuote(executablePath);
+        if (std::system(command.c_str()) != 0)
+        {
+            throw std::runtime_error("Could not link " + executablePath + " with " + driver + ".");
         }
     }
-}
\ No newline at end of file
+}
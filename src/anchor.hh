@@ -1,11 +1,73 @@
 #ifndef __ANCHOR_H__
 #define __ANCHOR_H__
 
+#include <optional>
 #include <string>
+#include <vector>
+
+#include "src/compilationunit.hh"
+#include "src/compiler.hh"
+#include "src/modules.hh"
+#include "src/streaming.hh"
 
 namespace anchor 
 {
-    std::string compile(std::string input);
+    // Wherever codegenThreads is above 0, the program is compiled by a
+    // parallel::PartitionedCompiler on that many threads rather than as one module.
+    std::string compile(std::string input, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+    std::string compile(anchor::CompilationUnit& unit, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, unsigned codegenThreads = 0);
+
+    // Streams the module as bitcode into the caller's buffer. Returns the unit's
+    // diagnostics, which are empty when bitcode was written.
+    std::string compile(std::string input, llvm::SmallVectorImpl<char>& bitcode, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+    std::string compile(anchor::CompilationUnit& unit, llvm::SmallVectorImpl<char>& bitcode, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, unsigned codegenThreads = 0);
+
+    // Stream textual IR, or bitcode, into out as the module is written, so the
+    // caller decides whether it lands in a file, a pipe or memory and no copy of it
+    // is made on the way. Return the unit's diagnostics, which are empty when the
+    // module was written; nothing is written otherwise.
+    std::string compileToIR(anchor::CompilationUnit& unit, llvm::raw_ostream& out, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, unsigned codegenThreads = 0);
+    std::string compileToBitcode(anchor::CompilationUnit& unit, llvm::raw_ostream& out, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, unsigned codegenThreads = 0);
+
+    // Writes a native object file for the host instead of textual IR. Returns the
+    // unit's diagnostics, which are empty when the object was written.
+    std::string compileToObject(anchor::CompilationUnit& unit, const std::string& objectPath, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, unsigned codegenThreads = 0);
+
+    // The system C compiler driver that links executables: $CC, or cc.
+    std::string linkDriver();
+
+    // Writes objects next to the executable and links them. Partitions are written
+    // as separate objects, so their machine code is generated in parallel too. Given
+    // the importer behind unit.importer, every imported library is compiled to an
+    // object of its own, in parallel with the unit, and linked in.
+    std::string compileToExecutable(anchor::CompilationUnit& unit, const std::string& executablePath, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, unsigned codegenThreads = 0, modules::Importer* importer = nullptr, const std::string& driver = anchor::linkDriver());
+
+    // Compile the unit with a streaming::StreamingCompiler, a chunk of functions at
+    // a time, so that peak memory does not grow with the program. Textual IR is
+    // written as each chunk is finished, and an executable is linked from an object
+    // per chunk. Return the unit's diagnostics. Output written before the first
+    // diagnostic was found stays written, apart from the executable.
+    std::string compileStreamingToIR(anchor::CompilationUnit& unit, llvm::raw_ostream& out, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, std::size_t chunkSize = streaming::defaultChunkSize);
+    std::string compileStreamingToExecutable(anchor::CompilationUnit& unit, const std::string& executablePath, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, modules::Importer* importer = nullptr, std::size_t chunkSize = streaming::defaultChunkSize);
+
+    // JIT-compiles the unit in this process and calls its main function. Returns
+    // main's exit code, or nothing when the unit has diagnostics.
+    std::optional<int> run(anchor::CompilationUnit& unit, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0, unsigned codegenThreads = 0);
+
+    // Like run, but starts every function at -O0 and recompiles hot ones at -O2
+    // while the program runs. See tiering::TieredJit.
+    std::optional<int> runTiered(anchor::CompilationUnit& unit, int threshold);
+
+    // Like run, but compiles each function the first time it is called. See lazy::LazyJit.
+    std::optional<int> runLazy(anchor::CompilationUnit& unit, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+
+    // Like run, but compiles the unit with x86::compile, straight to machine code
+    // without LLVM. Throws std::invalid_argument for a program only LLVM compiles.
+    std::optional<int> runX86(anchor::CompilationUnit& unit);
+
+    // Links object files against libc using a C compiler driver.
+    void link(const std::string& objectPath, const std::string& executablePath, const std::string& driver = anchor::linkDriver());
+    void link(const std::vector<std::string>& objectPaths, const std::string& executablePath, const std::string& driver = anchor::linkDriver());
 }
 
-#endif // __ANCHOR_H__
\ No newline at end of file
+#endif // __ANCHOR_H__
@@ -0,0 +1,860 @@
+#include "src/bytecode.hh"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace bytecode
+{
+    namespace
+    {
+        constexpr char magic[] = {'A', 'N', 'B', 'C'};
+        constexpr std::uint16_t version = 2;
+
+        bytecode::Kind kindOf(parser::Type type)
+        {
+            if (type == parser::Type::STRING)
+            {
+                return bytecode::Kind::STRING;
+            }
+            return type == parser::Type::VOID ? bytecode::Kind::NONE : bytecode::Kind::INTEGER;
+        }
+
+        class Lowerer
+        {
+        private:
+            bytecode::Module module;
+            std::unordered_map<std::string, std::int32_t> functionIndices;
+            std::unordered_map<std::string, std::int32_t> stringIndices;
+
+            bytecode::Function *function = nullptr;
+            std::unordered_map<const parser::Stmt *, std::uint16_t> variables;
+            // Variables occupy the registers below locals, temporaries the ones from
+            // there up to nextRegister.
+            int locals = 0;
+            int nextRegister = 0;
+
+            std::uint16_t allocate()
+            {
+                if (this->nextRegister >= std::numeric_limits<std::uint16_t>::max())
+                {
+                    throw std::invalid_argument("Cannot lower function " + this->function->name + " with more than 65535 registers.");
+                }
+                auto allocated = static_cast<std::uint16_t>(this->nextRegister++);
+                this->function->registers = std::max(this->function->registers, static_cast<std::uint16_t>(this->nextRegister));
+                return allocated;
+            }
+
+            std::size_t emit(bytecode::Opcode opcode, std::uint16_t a = 0, std::uint16_t b = 0, std::int32_t c = 0)
+            {
+                this->function->code.push_back(bytecode::Instruction{opcode, a, b, c});
+                return this->function->code.size() - 1;
+            }
+
+            std::int32_t here()
+            {
+                return static_cast<std::int32_t>(this->function->code.size());
+            }
+
+            std::int32_t getString(const std::string &contents)
+            {
+                auto [entry, inserted] = this->stringIndices.try_emplace(contents, static_cast<std::int32_t>(this->module.strings.size()));
+                if (inserted)
+                {
+                    this->module.strings.push_back(contents);
+                }
+                return entry->second;
+            }
+
+            std::uint16_t lookup(const parser::Stmt *declaration, const std::string &identifier)
+            {
+                auto found = this->variables.find(declaration);
+                if (found == this->variables.end())
+                {
+                    throw std::invalid_argument("Cannot lower reference to undeclared variable " + identifier + ".");
+                }
+                return found->second;
+            }
+
+            void lower(const std::shared_ptr<parser::FunctionStmt> &functionStmt)
+            {
+                this->function = &this->module.functions[this->functionIndices.at(functionStmt->identifier)];
+                this->variables.clear();
+                this->locals = 0;
+                this->nextRegister = 0;
+
+                for (const auto &arg : functionStmt->args)
+                {
+                    this->variables[arg.get()] = this->allocate();
+                    this->locals++;
+                }
+
+                this->lower(functionStmt->stmts);
+                this->emit(bytecode::Opcode::RETURN_VOID);
+            }
+
+            void lower(const std::vector<std::shared_ptr<parser::Stmt>> &stmts)
+            {
+                int scope = this->locals;
+                for (const auto &stmt : stmts)
+                {
+                    this->lower(stmt);
+                    this->nextRegister = this->locals;
+                }
+                this->locals = scope;
+                this->nextRegister = scope;
+            }
+
+            void lower(const std::shared_ptr<parser::Stmt> &stmt)
+            {
+                using enum parser::StmtType;
+                if (stmt->type == VAR_DECL)
+                {
+                    auto varDeclStmt = std::static_pointer_cast<parser::VarDeclStmt>(stmt);
+                    std::uint16_t variable = this->allocate();
+                    this->locals++;
+                    if (varDeclStmt->variableType == parser::Type::STRING)
+                    {
+                        this->emit(bytecode::Opcode::LOAD_STRING, variable, 0, this->getString(""));
+                    }
+                    else
+                    {
+                        this->emit(bytecode::Opcode::LOAD_INTEGER, variable, 0, 0);
+                    }
+                    this->variables[stmt.get()] = variable;
+                }
+                else if (stmt->type == PRINT)
+                {
+                    auto printStmt = std::static_pointer_cast<parser::PrintStmt>(stmt);
+                    std::uint16_t value = this->lower(printStmt->expr);
+                    bool isString = printStmt->expr->returnType == parser::Type::STRING;
+                    this->emit(isString ? bytecode::Opcode::PRINT_STRING : bytecode::Opcode::PRINT_INTEGER, value);
+                }
+                else if (stmt->type == RETURN)
+                {
+                    auto returnStmt = std::static_pointer_cast<parser::ReturnStmt>(stmt);
+                    this->emit(bytecode::Opcode::RETURN, this->lower(returnStmt->expr));
+                }
+                else if (stmt->type == EXPR)
+                {
+                    this->lower(std::static_pointer_cast<parser::ExprStmt>(stmt)->expr);
+                }
+                else if (stmt->type == IF)
+                {
+                    auto ifStmt = std::static_pointer_cast<parser::IfStmt>(stmt);
+                    std::size_t exit = this->branchIfFalse(ifStmt->condition);
+                    this->lower(ifStmt->stmts);
+                    this->function->code[exit].c = this->here();
+                }
+                else if (stmt->type == WHILE)
+                {
+                    auto whileStmt = std::static_pointer_cast<parser::WhileStmt>(stmt);
+                    std::int32_t start = this->here();
+                    std::size_t exit = this->branchIfFalse(whileStmt->condition);
+                    this->lower(whileStmt->stmts);
+                    this->emit(bytecode::Opcode::JUMP, 0, 0, start);
+                    this->function->code[exit].c = this->here();
+                }
+                else
+                {
+                    throw std::invalid_argument("Cannot lower statement outside of a function.");
+                }
+            }
+
+            // Emits a jump, to be patched by the caller, taken when the condition is false.
+            std::size_t branchIfFalse(const std::shared_ptr<parser::Expr> &condition)
+            {
+                std::size_t branch = 0;
+                if (condition->type == parser::ExprType::BINARY_OP)
+                {
+                    auto binaryOp = std::static_pointer_cast<parser::BinaryOperation>(condition);
+                    std::optional<bytecode::Opcode> fused;
+                    if (binaryOp->operation == parser::Operation::LESS_THAN)
+                    {
+                        fused = bytecode::Opcode::JUMP_IF_NOT_LESS_THAN;
+                    }
+                    else if (binaryOp->operation == parser::Operation::GREATER_THAN)
+                    {
+                        fused = bytecode::Opcode::JUMP_IF_NOT_GREATER_THAN;
+                    }
+                    else if (binaryOp->operation == parser::Operation::EQUALS)
+                    {
+                        fused = bytecode::Opcode::JUMP_IF_NOT_EQUAL;
+                    }
+
+                    if (fused.has_value() && binaryOp->left->returnType != parser::Type::STRING)
+                    {
+                        std::uint16_t left = this->lower(binaryOp->left);
+                        std::uint16_t right = this->lower(binaryOp->right);
+                        branch = this->emit(*fused, left, right);
+                        this->nextRegister = this->locals;
+                        return branch;
+                    }
+                }
+
+                branch = this->emit(bytecode::Opcode::JUMP_IF_FALSE, this->lower(condition));
+                this->nextRegister = this->locals;
+                return branch;
+            }
+
+            // Returns the register holding the value, which is destination when one is given.
+            std::uint16_t lower(const std::shared_ptr<parser::Expr> &expr, std::optional<std::uint16_t> destination = std::nullopt)
+            {
+                using enum parser::ExprType;
+                if (expr->type == INTEGER_LITERAL)
+                {
+                    std::uint16_t target = destination.value_or(this->allocate());
+                    this->emit(bytecode::Opcode::LOAD_INTEGER, target, 0, std::static_pointer_cast<parser::IntegerLiteral>(expr)->integer);
+                    return target;
+                }
+                else if (expr->type == BOOLEAN)
+                {
+                    std::uint16_t target = destination.value_or(this->allocate());
+                    this->emit(bytecode::Opcode::LOAD_INTEGER, target, 0, std::static_pointer_cast<parser::BooleanLiteralExpr>(expr)->value ? 1 : 0);
+                    return target;
+                }
+                else if (expr->type == STRING_LITERAL)
+                {
+                    std::uint16_t target = destination.value_or(this->allocate());
+                    this->emit(bytecode::Opcode::LOAD_STRING, target, 0, this->getString(std::static_pointer_cast<parser::StringLiteral>(expr)->literal));
+                    return target;
+                }
+                else if (expr->type == VAR)
+                {
+                    auto varExpr = std::static_pointer_cast<parser::VarExpr>(expr);
+                    return this->moveTo(this->lookup(varExpr->declaration, varExpr->identifier), destination);
+                }
+                else if (expr->type == ASSIGNMENT)
+                {
+                    auto assignment = std::static_pointer_cast<parser::VarAssignmentExpr>(expr);
+                    std::uint16_t variable = this->lookup(assignment->declaration, assignment->identifier);
+                    this->lower(assignment->expr, variable);
+                    return this->moveTo(variable, destination);
+                }
+                else if (expr->type == BINARY_OP)
+                {
+                    return this->lower(std::static_pointer_cast<parser::BinaryOperation>(expr), destination);
+                }
+                else if (expr->type == FUNCTION)
+                {
+                    return this->lower(std::static_pointer_cast<parser::FunctionExpr>(expr), destination);
+                }
+                throw std::invalid_argument("Unsupported expression type.");
+            }
+
+            std::uint16_t moveTo(std::uint16_t source, std::optional<std::uint16_t> destination)
+            {
+                if (destination.has_value() && *destination != source)
+                {
+                    this->emit(bytecode::Opcode::MOVE, *destination, source);
+                    return *destination;
+                }
+                return source;
+            }
+
+            std::uint16_t lower(const std::shared_ptr<parser::BinaryOperation> &binaryOp, std::optional<std::uint16_t> destination)
+            {
+                if (binaryOp->returnType == parser::Type::STRING)
+                {
+                    std::uint16_t left = this->lower(binaryOp->left);
+                    std::uint16_t right = this->lower(binaryOp->right);
+                    std::uint16_t target = destination.value_or(this->allocate());
+                    this->emit(bytecode::Opcode::CONCAT, target, left, right);
+                    return target;
+                }
+
+                if (std::optional<std::int32_t> addend = this->literalAddend(binaryOp))
+                {
+                    bool literalOnRight = binaryOp->right->type == parser::ExprType::INTEGER_LITERAL;
+                    std::uint16_t operand = this->lower(literalOnRight ? binaryOp->left : binaryOp->right);
+                    std::uint16_t target = destination.value_or(this->allocate());
+                    this->emit(bytecode::Opcode::ADD_INTEGER, target, operand, *addend);
+                    return target;
+                }
+
+                bytecode::Opcode opcode;
+                switch (binaryOp->operation)
+                {
+                case parser::Operation::ADD:
+                    opcode = bytecode::Opcode::ADD;
+                    break;
+                case parser::Operation::SUBTRACT:
+                    opcode = bytecode::Opcode::SUBTRACT;
+                    break;
+                case parser::Operation::MULTIPLICATION:
+                    opcode = bytecode::Opcode::MULTIPLY;
+                    break;
+                case parser::Operation::LESS_THAN:
+                    opcode = bytecode::Opcode::LESS_THAN;
+                    break;
+                case parser::Operation::GREATER_THAN:
+                    opcode = bytecode::Opcode::GREATER_THAN;
+                    break;
+                case parser::Operation::EQUALS:
+                    opcode = bytecode::Opcode::EQUALS;
+                    break;
+                default:
+                    throw std::invalid_argument("Unsupported parser::Operation");
+                }
+
+                if (binaryOp->left->returnType == parser::Type::STRING)
+                {
+                    throw std::invalid_argument("Cannot lower comparison of strings.");
+                }
+
+                std::uint16_t left = this->lower(binaryOp->left);
+                std::uint16_t right = this->lower(binaryOp->right);
+                std::uint16_t target = destination.value_or(this->allocate());
+                this->emit(opcode, target, left, right);
+                return target;
+            }
+
+            // The integer to add when one side of an addition, or the right side of a
+            // subtraction, is an integer literal.
+            std::optional<std::int32_t> literalAddend(const std::shared_ptr<parser::BinaryOperation> &binaryOp)
+            {
+                auto literal = [](const std::shared_ptr<parser::Expr> &expr) -> std::optional<std::int32_t>
+                {
+                    if (expr->type != parser::ExprType::INTEGER_LITERAL)
+                    {
+                        return std::nullopt;
+                    }
+                    return std::static_pointer_cast<parser::IntegerLiteral>(expr)->integer;
+                };
+
+                if (binaryOp->operation == parser::Operation::ADD)
+                {
+                    std::optional<std::int32_t> right = literal(binaryOp->right);
+                    return right.has_value() ? right : literal(binaryOp->left);
+                }
+
+                std::optional<std::int32_t> subtrahend = literal(binaryOp->right);
+                if (binaryOp->operation == parser::Operation::SUBTRACT && subtrahend.has_value() && *subtrahend != std::numeric_limits<std::int32_t>::min())
+                {
+                    return -*subtrahend;
+                }
+                return std::nullopt;
+            }
+
+            std::uint16_t lower(const std::shared_ptr<parser::FunctionExpr> &functionExpr, std::optional<std::uint16_t> destination)
+            {
+                auto found = this->functionIndices.find(functionExpr->identifier);
+                if (found == this->functionIndices.end())
+                {
+                    throw std::invalid_argument("Cannot lower call to unknown function " + functionExpr->identifier + ".");
+                }
+
+                // Arguments are evaluated straight into the registers that become the
+                // start of the callee's frame.
+                int base = this->nextRegister;
+                for (std::size_t i = 0; i < functionExpr->args.size(); i++)
+                {
+                    this->nextRegister = base + static_cast<int>(i);
+                    std::uint16_t argument = this->allocate();
+                    this->lower(functionExpr->args[i], argument);
+                }
+                this->nextRegister = base;
+                std::uint16_t first = this->allocate();
+                this->nextRegister = std::max(this->nextRegister, base + static_cast<int>(functionExpr->args.size()));
+
+                std::uint16_t target = destination.value_or(first);
+                this->emit(bytecode::Opcode::CALL, target, first, found->second);
+                // Keep the result, which may be in the first argument's register, out of
+                // reach of later temporaries.
+                this->nextRegister = std::max(this->locals, first + 1);
+                return target;
+            }
+
+        public:
+            bytecode::Module lower(const parser::Program &program)
+            {
+                std::vector<std::shared_ptr<parser::FunctionStmt>> functionStmts;
+                for (const auto &stmt : program.stmts)
+                {
+                    if (stmt->type != parser::StmtType::FUNCTION)
+                    {
+                        throw std::invalid_argument("Cannot lower statement outside of a function.");
+                    }
+
+                    auto functionStmt = std::static_pointer_cast<parser::FunctionStmt>(stmt);
+                    auto [entry, inserted] = this->functionIndices.try_emplace(functionStmt->identifier, static_cast<std::int32_t>(this->module.functions.size()));
+                    if (!inserted)
+                    {
+                        throw std::invalid_argument("Cannot lower second definition of function " + functionStmt->identifier + ".");
+                    }
+
+                    bytecode::Function function;
+                    function.name = functionStmt->identifier;
+                    for (const auto &arg : functionStmt->args)
+                    {
+                        function.parameters.push_back(kindOf(arg->returnType));
+                    }
+                    function.result = kindOf(functionStmt->returnType);
+                    this->module.functions.push_back(std::move(function));
+                    functionStmts.push_back(functionStmt);
+                }
+
+                auto main = this->functionIndices.find("main");
+                if (main == this->functionIndices.end())
+                {
+                    throw std::invalid_argument("Cannot lower program without a main function.");
+                }
+                this->module.main = main->second;
+
+                for (const auto &functionStmt : functionStmts)
+                {
+                    this->lower(functionStmt);
+                }
+                return std::move(this->module);
+            }
+        };
+
+        void writeU16(std::ostream &out, std::uint16_t value)
+        {
+            char bytes[] = {static_cast<char>(value & 0xFF), static_cast<char>(value >> 8)};
+            out.write(bytes, sizeof(bytes));
+        }
+
+        void writeU32(std::ostream &out, std::uint32_t value)
+        {
+            char bytes[] = {static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF), static_cast<char>((value >> 16) & 0xFF), static_cast<char>(value >> 24)};
+            out.write(bytes, sizeof(bytes));
+        }
+
+        void writeString(std::ostream &out, const std::string &value)
+        {
+            writeU32(out, static_cast<std::uint32_t>(value.size()));
+            out.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+
+        void readBytes(std::istream &in, char *bytes, std::size_t size)
+        {
+            if (!in.read(bytes, static_cast<std::streamsize>(size)))
+            {
+                throw std::invalid_argument("Invalid bytecode: unexpected end of file.");
+            }
+        }
+
+        std::uint16_t readU16(std::istream &in)
+        {
+            unsigned char bytes[2];
+            readBytes(in, reinterpret_cast<char *>(bytes), sizeof(bytes));
+            return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+        }
+
+        std::uint32_t readU32(std::istream &in)
+        {
+            unsigned char bytes[4];
+            readBytes(in, reinterpret_cast<char *>(bytes), sizeof(bytes));
+            return static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8) | (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+        }
+
+        std::string readString(std::istream &in)
+        {
+            std::uint32_t size = readU32(in);
+            std::string value;
+            // Grow as bytes actually arrive, so a corrupt size cannot allocate gigabytes.
+            char buffer[4096];
+            while (value.size() < size)
+            {
+                std::size_t chunk = std::min<std::size_t>(sizeof(buffer), size - value.size());
+                readBytes(in, buffer, chunk);
+                value.append(buffer, chunk);
+            }
+            return value;
+        }
+
+        bytecode::Kind readKind(std::istream &in)
+        {
+            std::uint16_t kind = readU16(in);
+            if (kind >= static_cast<std::uint16_t>(bytecode::Kind::COUNT))
+            {
+                throw std::invalid_argument("Invalid bytecode: unknown kind " + std::to_string(kind) + ".");
+            }
+            return static_cast<bytecode::Kind>(kind);
+        }
+
+        void invalid(const bytecode::Function &function, std::size_t index, const std::string &problem)
+        {
+            throw std::invalid_argument("Invalid bytecode: instruction " + std::to_string(index) + " of " + function.name + " " + problem + ".");
+        }
+
+        // Follows the kind of every register along each path through a function whose
+        // registers, constants and jump targets are already known to be in range. An
+        // instruction is visited again whenever a new path changes what it sees, and a
+        // register can only go from unreached to a kind to NONE, so this terminates.
+        void checkKinds(const bytecode::Module &module, const bytecode::Function &function)
+        {
+            using Kinds = std::vector<bytecode::Kind>;
+            std::vector<std::optional<Kinds>> entries(function.code.size());
+            std::vector<std::size_t> worklist;
+
+            auto reach = [&entries, &worklist](std::size_t index, const Kinds &kinds)
+            {
+                std::optional<Kinds> &entry = entries[index];
+                if (!entry.has_value())
+                {
+                    entry = kinds;
+                    worklist.push_back(index);
+                    return;
+                }
+
+                bool changed = false;
+                for (std::size_t i = 0; i < kinds.size(); i++)
+                {
+                    if ((*entry)[i] != kinds[i] && (*entry)[i] != bytecode::Kind::NONE)
+                    {
+                        (*entry)[i] = bytecode::Kind::NONE;
+                        changed = true;
+                    }
+                }
+                if (changed)
+                {
+                    worklist.push_back(index);
+                }
+            };
+
+            Kinds start(function.registers, bytecode::Kind::NONE);
+            std::copy(function.parameters.begin(), function.parameters.end(), start.begin());
+            reach(0, start);
+
+            while (!worklist.empty())
+            {
+                std::size_t i = worklist.back();
+                worklist.pop_back();
+                const bytecode::Instruction &instruction = function.code[i];
+                Kinds kinds = *entries[i];
+
+                auto expect = [&](std::uint16_t reg, bytecode::Kind kind)
+                {
+                    if (kinds[reg] != kind)
+                    {
+                        invalid(function, i, std::string("reads a register that does not hold ") + (kind == bytecode::Kind::STRING ? "a string" : "an integer"));
+                    }
+                };
+
+                using enum bytecode::Opcode;
+                switch (instruction.opcode)
+                {
+                case LOAD_INTEGER:
+                    kinds[instruction.a] = bytecode::Kind::INTEGER;
+                    break;
+                case LOAD_STRING:
+                    kinds[instruction.a] = bytecode::Kind::STRING;
+                    break;
+                case MOVE:
+                    kinds[instruction.a] = kinds[instruction.b];
+                    break;
+                case ADD:
+                case SUBTRACT:
+                case MULTIPLY:
+                case LESS_THAN:
+                case GREATER_THAN:
+                case EQUALS:
+                    expect(instruction.b, bytecode::Kind::INTEGER);
+                    expect(static_cast<std::uint16_t>(instruction.c), bytecode::Kind::INTEGER);
+                    kinds[instruction.a] = bytecode::Kind::INTEGER;
+                    break;
+                case CONCAT:
+                    expect(instruction.b, bytecode::Kind::STRING);
+                    expect(static_cast<std::uint16_t>(instruction.c), bytecode::Kind::STRING);
+                    kinds[instruction.a] = bytecode::Kind::STRING;
+                    break;
+                case ADD_INTEGER:
+                    expect(instruction.b, bytecode::Kind::INTEGER);
+                    kinds[instruction.a] = bytecode::Kind::INTEGER;
+                    break;
+                case JUMP:
+                    reach(static_cast<std::size_t>(instruction.c), kinds);
+                    continue;
+                case JUMP_IF_FALSE:
+                    expect(instruction.a, bytecode::Kind::INTEGER);
+                    reach(static_cast<std::size_t>(instruction.c), kinds);
+                    break;
+                case JUMP_IF_NOT_LESS_THAN:
+                case JUMP_IF_NOT_GREATER_THAN:
+                case JUMP_IF_NOT_EQUAL:
+                    expect(instruction.a, bytecode::Kind::INTEGER);
+                    expect(instruction.b, bytecode::Kind::INTEGER);
+                    reach(static_cast<std::size_t>(instruction.c), kinds);
+                    break;
+                case CALL:
+                {
+                    const bytecode::Function &callee = module.functions[instruction.c];
+                    for (std::size_t j = 0; j < callee.parameters.size(); j++)
+                    {
+                        expect(static_cast<std::uint16_t>(instruction.b + j), callee.parameters[j]);
+                    }
+                    // The callee's frame overwrites the caller's registers from b up.
+                    std::size_t clobbered = std::min<std::size_t>(kinds.size(), instruction.b + callee.registers);
+                    std::fill(kinds.begin() + instruction.b, kinds.begin() + clobbered, bytecode::Kind::NONE);
+                    kinds[instruction.a] = callee.result;
+                    break;
+                }
+                case RETURN:
+                    if (function.result == bytecode::Kind::NONE)
+                    {
+                        invalid(function, i, "returns a value from a function that returns nothing");
+                    }
+                    expect(instruction.a, function.result);
+                    continue;
+                case RETURN_VOID:
+                    if (function.result != bytecode::Kind::NONE)
+                    {
+                        invalid(function, i, "returns nothing from a function that returns a value");
+                    }
+                    continue;
+                case PRINT_INTEGER:
+                    expect(instruction.a, bytecode::Kind::INTEGER);
+                    break;
+                case PRINT_STRING:
+                    expect(instruction.a, bytecode::Kind::STRING);
+                    break;
+                default:
+                    invalid(function, i, "has an unknown opcode");
+                }
+
+                // Only returns and jumps end a function, so there is a next instruction.
+                reach(i + 1, kinds);
+            }
+        }
+    }
+
+    bytecode::Module lower(const parser::Program &program)
+    {
+        Lowerer lowerer;
+        return lowerer.lower(program);
+    }
+
+    void validate(const bytecode::Module &module)
+    {
+        if (module.main < 0 || static_cast<std::size_t>(module.main) >= module.functions.size())
+        {
+            throw std::invalid_argument("Invalid bytecode: no main function.");
+        }
+        if (!module.functions[module.main].parameters.empty())
+        {
+            throw std::invalid_argument("Invalid bytecode: main takes arguments.");
+        }
+
+        for (const bytecode::Function &function : module.functions)
+        {
+            if (function.parameters.size() > function.registers)
+            {
+                throw std::invalid_argument("Invalid bytecode: " + function.name + " has fewer registers than arguments.");
+            }
+
+            for (std::size_t i = 0; i < function.code.size(); i++)
+            {
+                const bytecode::Instruction &instruction = function.code[i];
+                auto isRegister = [&function](std::int64_t index)
+                {
+                    return index >= 0 && index < function.registers;
+                };
+                auto isTarget = [&function](std::int32_t target)
+                {
+                    return target >= 0 && static_cast<std::size_t>(target) < function.code.size();
+                };
+
+                using enum bytecode::Opcode;
+                switch (instruction.opcode)
+                {
+                case LOAD_INTEGER:
+                case PRINT_INTEGER:
+                case PRINT_STRING:
+                case RETURN:
+                    if (!isRegister(instruction.a))
+                    {
+                        invalid(function, i, "uses a register outside its frame");
+                    }
+                    break;
+                case LOAD_STRING:
+                    if (!isRegister(instruction.a))
+                    {
+                        invalid(function, i, "uses a register outside its frame");
+                    }
+                    if (instruction.c < 0 || static_cast<std::size_t>(instruction.c) >= module.strings.size())
+                    {
+                        invalid(function, i, "refers to an unknown string");
+                    }
+                    break;
+                case MOVE:
+                case ADD_INTEGER:
+                    if (!isRegister(instruction.a) || !isRegister(instruction.b))
+                    {
+                        invalid(function, i, "uses a register outside its frame");
+                    }
+                    break;
+                case ADD:
+                case SUBTRACT:
+                case MULTIPLY:
+                case LESS_THAN:
+                case GREATER_THAN:
+                case EQUALS:
+                case CONCAT:
+                    if (!isRegister(instruction.a) || !isRegister(instruction.b) || !isRegister(instruction.c))
+                    {
+                        invalid(function, i, "uses a register outside its frame");
+                    }
+                    break;
+                case JUMP:
+                    if (!isTarget(instruction.c))
+                    {
+                        invalid(function, i, "jumps outside its function");
+                    }
+                    break;
+                case JUMP_IF_FALSE:
+                    if (!isRegister(instruction.a))
+                    {
+                        invalid(function, i, "uses a register outside its frame");
+                    }
+                    if (!isTarget(instruction.c))
+                    {
+                        invalid(function, i, "jumps outside its function");
+                    }
+                    break;
+                case JUMP_IF_NOT_LESS_THAN:
+                case JUMP_IF_NOT_GREATER_THAN:
+                case JUMP_IF_NOT_EQUAL:
+                    if (!isRegister(instruction.a) || !isRegister(instruction.b))
+                    {
+                        invalid(function, i, "uses a register outside its frame");
+                    }
+                    if (!isTarget(instruction.c))
+                    {
+                        invalid(function, i, "jumps outside its function");
+                    }
+                    break;
+                case CALL:
+                    if (instruction.c < 0 || static_cast<std::size_t>(instruction.c) >= module.functions.size())
+                    {
+                        invalid(function, i, "calls an unknown function");
+                    }
+                    // The callee's arguments must be inside the caller's frame.
+                    if (!isRegister(instruction.a) || !isRegister(instruction.b) || instruction.b + module.functions[instruction.c].parameters.size() > function.registers)
+                    {
+                        invalid(function, i, "uses a register outside its frame");
+                    }
+                    break;
+                case RETURN_VOID:
+                    break;
+                default:
+                    invalid(function, i, "has an unknown opcode");
+                }
+            }
+
+            if (function.code.empty())
+            {
+                throw std::invalid_argument("Invalid bytecode: " + function.name + " has no code.");
+            }
+            bytecode::Opcode last = function.code.back().opcode;
+            if (last != bytecode::Opcode::RETURN && last != bytecode::Opcode::RETURN_VOID && last != bytecode::Opcode::JUMP)
+            {
+                throw std::invalid_argument("Invalid bytecode: " + function.name + " does not end with a return or jump.");
+            }
+        }
+
+        for (const bytecode::Function &function : module.functions)
+        {
+            checkKinds(module, function);
+        }
+    }
+
+    void write(std::ostream &out, const bytecode::Module &module)
+    {
+        out.write(magic, sizeof(magic));
+        writeU16(out, version);
+
+        writeU32(out, static_cast<std::uint32_t>(module.strings.size()));
+        for (const std::string &string : module.strings)
+        {
+            writeString(out, string);
+        }
+
+        writeU32(out, static_cast<std::uint32_t>(module.functions.size()));
+        for (const bytecode::Function &function : module.functions)
+        {
+            writeString(out, function.name);
+            writeU16(out, static_cast<std::uint16_t>(function.parameters.size()));
+            for (bytecode::Kind kind : function.parameters)
+            {
+                writeU16(out, static_cast<std::uint16_t>(kind));
+            }
+            writeU16(out, static_cast<std::uint16_t>(function.result));
+            writeU16(out, function.registers);
+            writeU32(out, static_cast<std::uint32_t>(function.code.size()));
+            for (const bytecode::Instruction &instruction : function.code)
+            {
+                writeU16(out, static_cast<std::uint16_t>(instruction.opcode));
+                writeU16(out, instruction.a);
+                writeU16(out, instruction.b);
+                writeU32(out, static_cast<std::uint32_t>(instruction.c));
+            }
+        }
+
+        writeU32(out, static_cast<std::uint32_t>(module.main));
+    }
+
+    bytecode::Module read(std::istream &in)
+    {
+        char header[sizeof(magic)];
+        readBytes(in, header, sizeof(header));
+        if (!bytecode::isBytecode(std::string_view(header, sizeof(header))))
+        {
+            throw std::invalid_argument("Invalid bytecode: missing ANBC header.");
+        }
+        std::uint16_t fileVersion = readU16(in);
+        if (fileVersion != version)
+        {
+            throw std::invalid_argument("Invalid bytecode: unsupported version " + std::to_string(fileVersion) + ".");
+        }
+
+        bytecode::Module module;
+        std::uint32_t strings = readU32(in);
+        for (std::uint32_t i = 0; i < strings; i++)
+        {
+            module.strings.push_back(readString(in));
+        }
+
+        std::uint32_t functions = readU32(in);
+        for (std::uint32_t i = 0; i < functions; i++)
+        {
+            bytecode::Function function;
+            function.name = readString(in);
+            std::uint16_t parameters = readU16(in);
+            for (std::uint16_t j = 0; j < parameters; j++)
+            {
+                function.parameters.push_back(readKind(in));
+            }
+            function.result = readKind(in);
+            function.registers = readU16(in);
+            std::uint32_t instructions = readU32(in);
+            for (std::uint32_t j = 0; j < instructions; j++)
+            {
+                bytecode::Instruction instruction;
+                std::uint16_t opcode = readU16(in);
+                if (opcode >= static_cast<std::uint16_t>(bytecode::Opcode::COUNT))
+                {
+                    invalid(function, j, "has an unknown opcode");
+                }
+                instruction.opcode = static_cast<bytecode::Opcode>(opcode);
+                instruction.a = readU16(in);
+                instruction.b = readU16(in);
+                instruction.c = static_cast<std::int32_t>(readU32(in));
+                function.code.push_back(instruction);
+            }
+            module.functions.push_back(std::move(function));
+        }
+        module.main = static_cast<std::int32_t>(readU32(in));
+
+        bytecode::validate(module);
+        return module;
+    }
+
+    bool isBytecode(std::string_view contents)
+    {
+        return contents.substr(0, sizeof(magic)) == std::string_view(magic, sizeof(magic));
+    }
+}
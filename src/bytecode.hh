@@ -0,0 +1,108 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/parser.hh"
+
+namespace bytecode
+{
+    // R[x] is register x of the current call frame. Integers and booleans are
+    // 32-bit, strings are immutable.
+    enum class Opcode : std::uint16_t
+    {
+        // R[a] = c
+        LOAD_INTEGER,
+        // R[a] = strings[c]
+        LOAD_STRING,
+        // R[a] = R[b]
+        MOVE,
+        // R[a] = R[b] op R[c]
+        ADD,
+        SUBTRACT,
+        MULTIPLY,
+        LESS_THAN,
+        GREATER_THAN,
+        EQUALS,
+        CONCAT,
+        // R[a] = R[b] + c. Fuses loading an integer literal into an add or subtract.
+        ADD_INTEGER,
+        // Jumps to instruction c.
+        JUMP,
+        JUMP_IF_FALSE,
+        // Fuse a comparison with the branch of the if or while it controls:
+        // jumps to instruction c unless R[a] op R[b].
+        JUMP_IF_NOT_LESS_THAN,
+        JUMP_IF_NOT_GREATER_THAN,
+        JUMP_IF_NOT_EQUAL,
+        // R[a] = functions[c](R[b], R[b + 1], ...). The callee's frame starts at R[b].
+        CALL,
+        RETURN,
+        RETURN_VOID,
+        PRINT_INTEGER,
+        PRINT_STRING,
+        COUNT
+    };
+
+    // What a register holds. Booleans are integers. NONE is a register nothing has
+    // been written to, or one that holds different kinds on different paths.
+    enum class Kind : std::uint16_t
+    {
+        NONE,
+        INTEGER,
+        STRING,
+        COUNT
+    };
+
+    class Instruction
+    {
+    public:
+        bytecode::Opcode opcode;
+        std::uint16_t a = 0;
+        std::uint16_t b = 0;
+        std::int32_t c = 0;
+    };
+
+    class Function
+    {
+    public:
+        std::string name;
+        // Arguments arrive in the first parameters.size() registers.
+        std::vector<bytecode::Kind> parameters;
+        // NONE for functions that return nothing.
+        bytecode::Kind result = bytecode::Kind::NONE;
+        // Size of the call frame, arguments included.
+        std::uint16_t registers = 0;
+        std::vector<bytecode::Instruction> code;
+    };
+
+    class Module
+    {
+    public:
+        std::vector<std::string> strings;
+        std::vector<bytecode::Function> functions;
+        std::int32_t main = -1;
+    };
+
+    // Lowers a parsed program without errors. Every variable gets a register for the
+    // lifetime of its scope, and temporaries are reused from one statement to the next.
+    bytecode::Module lower(const parser::Program&);
+
+    // Checks everything the interpreter relies on without checking it again: opcodes,
+    // registers, constants and jump targets are in range, no function can run off
+    // the end of its code, and on every path to an instruction the registers it
+    // reads hold the kinds it expects.
+    void validate(const bytecode::Module&);
+
+    // The file format is little-endian, and starts with "ANBC" and a version.
+    void write(std::ostream&, const bytecode::Module&);
+    bytecode::Module read(std::istream&);
+    bool isBytecode(std::string_view contents);
+}
+
+#endif // BYTECODE_H
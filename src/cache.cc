@@ -0,0 +1,323 @@
+#include "src/cache.hh"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/SHA256.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+#include <link.h>
+#endif
+
+#ifndef ANCHOR_VERSION
+#define ANCHOR_VERSION "unknown"
+#endif
+
+namespace cache
+{
+    namespace
+    {
+        // Bump when the layout of cached artifacts changes.
+        constexpr std::string_view format = "1";
+
+        void update(llvm::SHA256 &hash, std::string_view part)
+        {
+            // Length-prefixed, so moving bytes from one part to the next changes the key.
+            std::string length = std::to_string(part.size()) + ":";
+            hash.update(llvm::StringRef(length));
+            hash.update(llvm::StringRef(part.data(), part.size()));
+        }
+
+        // Holds the running total size of the entries, so storing need not scan the
+        // directory.
+        constexpr std::string_view usageFile = "usage";
+
+        bool isTemporary(const std::filesystem::path &path)
+        {
+            return path.filename().string().find(".tmp.") != std::string::npos;
+        }
+
+        // The GNU build ID the linker stamped on the executable, which changes
+        // whenever its code does. Empty when it has none, or off Linux.
+        std::string buildId()
+        {
+            std::string id;
+#ifdef __linux__
+            dl_iterate_phdr(
+                [](dl_phdr_info *info, std::size_t, void *data)
+                {
+                    for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++)
+                    {
+                        const ElfW(Phdr) &segment = info->dlpi_phdr[i];
+                        if (segment.p_type != PT_NOTE)
+                        {
+                            continue;
+                        }
+
+                        std::size_t alignment = segment.p_align == 8 ? 8 : 4;
+                        auto align = [alignment](std::size_t size)
+                        {
+                            return (size + alignment - 1) & ~(alignment - 1);
+                        };
+                        const char *note = reinterpret_cast<const char *>(info->dlpi_addr + segment.p_vaddr);
+                        const char *end = note + segment.p_memsz;
+                        while (note + sizeof(ElfW(Nhdr)) <= end)
+                        {
+                            const auto *header = reinterpret_cast<const ElfW(Nhdr) *>(note);
+                            const char *name = note + sizeof(ElfW(Nhdr));
+                            const char *description = name + align(header->n_namesz);
+                            if (header->n_type == NT_GNU_BUILD_ID && header->n_namesz == 4 && std::memcmp(name, "GNU", 4) == 0)
+                            {
+                                static_cast<std::string *>(data)->assign(description, header->n_descsz);
+                                return 1;
+                            }
+                            note = description + align(header->n_descsz);
+                        }
+                    }
+                    // The executable comes first; the shared libraries after it do not matter.
+                    return 1;
+                },
+                &id);
+#endif
+            return id;
+        }
+
+        // Identifies the compiler binary, so a rebuilt one never reuses what an older
+        // one made. Falls back to the executable's size and modification time.
+        const std::string &compilerBuild()
+        {
+            static const std::string build = []
+            {
+                std::string id = buildId();
+                if (!id.empty())
+                {
+                    return id;
+                }
+
+                static int anchor;
+                std::filesystem::path executable = llvm::sys::fs::getMainExecutable(nullptr, &anchor);
+                std::error_code error;
+                std::uintmax_t size = std::filesystem::file_size(executable, error);
+                if (error)
+                {
+                    return id;
+                }
+                auto modified = std::filesystem::last_write_time(executable, error);
+                if (error)
+                {
+                    return id;
+                }
+                return std::to_string(size) + "." + std::to_string(modified.time_since_epoch().count());
+            }();
+            return build;
+        }
+    }
+
+    std::string key(std::string_view source, compiler::OptimizationLevel optimizationLevel, std::string_view artifact)
+    {
+        llvm::SHA256 hash;
+        update(hash, format);
+        update(hash, ANCHOR_VERSION);
+        update(hash, compilerBuild());
+        update(hash, LLVM_VERSION_STRING);
+        update(hash, compiler::targetTriple());
+        update(hash, std::to_string(static_cast<int>(optimizationLevel)));
+        update(hash, artifact);
+        update(hash, source);
+        return llvm::toHex(hash.final(), true);
+    }
+
+    std::filesystem::path defaultDirectory()
+    {
+        if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0')
+        {
+            return std::filesystem::path(xdg) / "anchor";
+        }
+        if (const char *home = std::getenv("HOME"); home != nullptr && *home != '\0')
+        {
+            return std::filesystem::path(home) / ".cache" / "anchor";
+        }
+        return {};
+    }
+
+    Cache::Cache(std::filesystem::path directory, std::uintmax_t capacity) : directory(std::move(directory)), capacity(capacity)
+    {
+    }
+
+    std::optional<std::string> Cache::read(const std::string &key)
+    {
+        std::filesystem::path entry = this->directory / key;
+        std::ifstream in(entry, std::ios::binary);
+        if (!in)
+        {
+            return std::nullopt;
+        }
+
+        std::error_code error;
+        std::string contents;
+        contents.resize(std::filesystem::file_size(entry, error));
+        if (error || !in.read(contents.data(), static_cast<std::streamsize>(contents.size())))
+        {
+            return std::nullopt;
+        }
+        std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+        return contents;
+    }
+
+    bool Cache::fetch(const std::string &key, const std::filesystem::path &destination)
+    {
+        std::filesystem::path entry = this->directory / key;
+        std::error_code error;
+        std::filesystem::copy_file(entry, destination, std::filesystem::copy_options::overwrite_existing, error);
+        if (error)
+        {
+            return false;
+        }
+        std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+        return true;
+    }
+
+    void Cache::store(const std::string &key, std::string_view contents)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(this->directory, error);
+        std::filesystem::path temporary = this->temporaryPath(key);
+        {
+            std::ofstream out(temporary, std::ios::binary);
+            if (!out || !out.write(contents.data(), static_cast<std::streamsize>(contents.size())))
+            {
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+        this->commit(temporary, key);
+    }
+
+    void Cache::storeFile(const std::string &key, const std::filesystem::path &source)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(this->directory, error);
+        std::filesystem::path temporary = this->temporaryPath(key);
+        if (!std::filesystem::copy_file(source, temporary, std::filesystem::copy_options::overwrite_existing, error))
+        {
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+        this->commit(temporary, key);
+    }
+
+    std::filesystem::path Cache::begin(const std::string &key)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(this->directory, error);
+        return this->temporaryPath(key);
+    }
+
+    std::filesystem::path Cache::temporaryPath(const std::string &key) const
+    {
+        static std::atomic<unsigned> counter = 0;
+        return this->directory / (key + ".tmp." + std::to_string(getpid()) + "." + std::to_string(counter++));
+    }
+
+    void Cache::commit(const std::filesystem::path &temporary, const std::string &key)
+    {
+        std::error_code error;
+        std::uintmax_t size = std::filesystem::file_size(temporary, error);
+        if (!error)
+        {
+            std::filesystem::rename(temporary, this->directory / key, error);
+        }
+        if (error)
+        {
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+
+        // Entries that replace one with the same key, or that other processes store
+        // at the same time, make the total drift. Evicting scans the directory and
+        // sets it right.
+        std::optional<std::uintmax_t> usage = this->readUsage();
+        if (!usage.has_value() || *usage + size > this->capacity)
+        {
+            this->evict();
+            return;
+        }
+        this->writeUsage(*usage + size);
+    }
+
+    std::optional<std::uintmax_t> Cache::readUsage() const
+    {
+        std::ifstream in(this->directory / usageFile);
+        std::uintmax_t usage = 0;
+        if (!(in >> usage))
+        {
+            return std::nullopt;
+        }
+        return usage;
+    }
+
+    void Cache::writeUsage(std::uintmax_t usage)
+    {
+        std::error_code error;
+        std::filesystem::path temporary = this->temporaryPath(std::string(usageFile));
+        {
+            std::ofstream out(temporary);
+            if (!out || !(out << usage))
+            {
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+        std::filesystem::rename(temporary, this->directory / usageFile, error);
+        if (error)
+        {
+            std::filesystem::remove(temporary, error);
+        }
+    }
+
+    void Cache::evict()
+    {
+        std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::directory_entry>> entries;
+        std::uintmax_t total = 0;
+
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(this->directory, error))
+        {
+            if (!entry.is_regular_file(error) || isTemporary(entry.path()) || entry.path().filename() == usageFile)
+            {
+                continue;
+            }
+            total += entry.file_size(error);
+            entries.emplace_back(entry.last_write_time(error), entry);
+        }
+        if (total <= this->capacity)
+        {
+            this->writeUsage(total);
+            return;
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const auto &left, const auto &right)
+                  { return left.first < right.first; });
+        for (const auto &[lastUsed, entry] : entries)
+        {
+            if (total <= this->capacity)
+            {
+                break;
+            }
+            std::uintmax_t size = entry.file_size(error);
+            if (std::filesystem::remove(entry.path(), error))
+            {
+                total -= size;
+            }
+        }
+        this->writeUsage(total);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "src/compiler.hh"
+
+namespace cache
+{
+    constexpr std::uintmax_t defaultCapacity = 256 * 1024 * 1024;
+
+    // SHA-256 over the source and everything that changes what the compiler makes
+    // of it: the anchor and LLVM versions, the build of the compiler binary, the
+    // optimization level, the target and the kind of artifact.
+    std::string key(std::string_view source, compiler::OptimizationLevel, std::string_view artifact);
+
+    // $XDG_CACHE_HOME/anchor or ~/.cache/anchor, or empty when neither is set.
+    std::filesystem::path defaultDirectory();
+
+    // A directory of artifacts named by their key. Entries are written to a
+    // temporary file and renamed into place, so concurrent compilers never see a
+    // partial one. Hits refresh an entry's modification time. Storing adds to a
+    // running total of the entries' sizes, and once that outgrows the capacity
+    // scans the directory and evicts the least recently used entries.
+    // Failing to read or write the cache is never an error; it is only a miss.
+    class Cache
+    {
+    private:
+        std::filesystem::path directory;
+        std::uintmax_t capacity;
+
+        std::filesystem::path temporaryPath(const std::string &key) const;
+        std::optional<std::uintmax_t> readUsage() const;
+        void writeUsage(std::uintmax_t usage);
+
+    public:
+        explicit Cache(std::filesystem::path directory, std::uintmax_t capacity = cache::defaultCapacity);
+
+        std::optional<std::string> read(const std::string &key);
+        // Copies the entry to destination. Returns false on a miss.
+        bool fetch(const std::string &key, const std::filesystem::path &destination);
+
+        void store(const std::string &key, std::string_view contents);
+        void storeFile(const std::string &key, const std::filesystem::path &source);
+        // For an artifact cached while it is written elsewhere: write the entry to
+        // the path begin returns, then commit it, or remove the file to give up.
+        std::filesystem::path begin(const std::string &key);
+        void commit(const std::filesystem::path &temporary, const std::string &key);
+        void evict();
+    };
+}
+
+#endif // CACHE_H
@@ -0,0 +1,58 @@
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "options.hh"
+#include "protocol.hh"
+
+// Takes the same arguments as main, and has the compile server run them. Nothing
+// here depends on LLVM, so it starts in a fraction of the time main does.
+int main(int argc, char *argv[])
+{
+    std::string socketPath = protocol::defaultSocketPath();
+    int first = 1;
+    if (argc > 1 && std::string(argv[1]).starts_with("--socket="))
+    {
+        socketPath = std::string(argv[1]).substr(std::string("--socket=").length());
+        first = 2;
+    }
+
+    protocol::Request request;
+    request.args.assign(argv + first, argv + argc);
+    request.workingDirectory = std::filesystem::current_path().string();
+
+    // The server would only report the same mistake, after a round trip.
+    anchor::Options options;
+    try
+    {
+        argv[first - 1] = argv[0];
+        options = anchor::parseOptions(argc - first + 1, argv + first - 1);
+    }
+    catch (std::invalid_argument &e)
+    {
+        std::cerr << e.what() << '\n'
+                  << "Usage: anchor_client [--socket=path] [main options] [file.anchor]\n";
+        return 1;
+    }
+    if (options.input.empty())
+    {
+        for (std::string line; std::getline(std::cin, line);)
+        {
+            request.input += line + '\n';
+        }
+    }
+
+    try
+    {
+        protocol::Response response = protocol::send(socketPath, request);
+        std::cout.write(response.out.data(), static_cast<std::streamsize>(response.out.size()));
+        std::cerr.write(response.err.data(), static_cast<std::streamsize>(response.err.size()));
+        return response.exitCode;
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
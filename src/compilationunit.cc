@@ -0,0 +1,39 @@
+#include "src/compilationunit.hh"
+
+namespace anchor
+{
+    CompilationUnit::CompilationUnit(std::string source) : source(std::move(source))
+    {
+    }
+
+    bool CompilationUnit::hasErrors() const
+    {
+        return !this->diagnostics.empty();
+    }
+
+    void lex(anchor::CompilationUnit &unit)
+    {
+        try
+        {
+            unit.tokens = lexer::lex(unit.source);
+        }
+        catch (lexer::InvalidTokenException &ite)
+        {
+            unit.tokens.clear();
+            unit.diagnostics.emplace_back(ite.what(), ite.location, ite.location);
+        }
+    }
+
+    void parse(anchor::CompilationUnit &unit)
+    {
+        if (unit.tokens.empty())
+        {
+            unit.program = parser::Program();
+            return;
+        }
+
+        parser::Parser parser(unit.tokens, unit.importer);
+        unit.program = parser.parse();
+        unit.diagnostics.insert(unit.diagnostics.end(), unit.program.errors.begin(), unit.program.errors.end());
+    }
+}
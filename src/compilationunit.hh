@@ -0,0 +1,48 @@
+#ifndef COMPILATION_UNIT_H
+#define COMPILATION_UNIT_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "src/lexer.hh"
+#include "src/parser.hh"
+
+namespace compiler
+{
+    class Compiler;
+}
+
+namespace anchor
+{
+    // Owns everything produced for one source file. Each stage borrows the unit and
+    // moves its result into it, so nothing proportional to the source is copied
+    // between stages.
+    class CompilationUnit
+    {
+    public:
+        std::string source;
+        std::deque<lexer::Token> tokens;
+        parser::Program program;
+        std::vector<parser::ErrorLog> diagnostics;
+        // Resolves the unit's imports while it is parsed. See modules::Importer.
+        parser::Importer importer;
+        // A warm compiler to reset and compile the unit with, instead of creating
+        // one. It must be at the level the unit is compiled at. Not used when
+        // compiling in partitions or running the unit.
+        compiler::Compiler *compiler = nullptr;
+
+        explicit CompilationUnit(std::string source);
+        CompilationUnit(const CompilationUnit&) = delete;
+        CompilationUnit& operator=(const CompilationUnit&) = delete;
+        CompilationUnit(CompilationUnit&&) = default;
+        CompilationUnit& operator=(CompilationUnit&&) = default;
+
+        bool hasErrors() const;
+    };
+
+    void lex(anchor::CompilationUnit&);
+    void parse(anchor::CompilationUnit&);
+}
+
+#endif // COMPILATION_UNIT_H
@@ -1,45 +1,258 @@
 #include "src/compiler.hh"
-#include "llvm/IR/ValueSymbolTable.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/TargetSelect.h"
+#if LLVM_VERSION_MAJOR >= 17
+#include "llvm/TargetParser/Host.h"
+#else
+#include "llvm/Support/Host.h"
+#endif
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Linker/Linker.h"
+
+#include <algorithm>
+#include <mutex>
 
 namespace compiler
 {
-    Compiler::Compiler()
+    namespace
+    {
+        bool isAssignedIn(const std::shared_ptr<parser::Expr> &expr, const parser::Stmt *declaration)
+        {
+            if (expr->type == parser::ExprType::ASSIGNMENT)
+            {
+                auto assignment = std::static_pointer_cast<parser::VarAssignmentExpr>(expr);
+                return assignment->declaration == declaration || isAssignedIn(assignment->expr, declaration);
+            }
+            else if (expr->type == parser::ExprType::BINARY_OP)
+            {
+                auto binaryOperation = std::static_pointer_cast<parser::BinaryOperation>(expr);
+                return isAssignedIn(binaryOperation->left, declaration) || isAssignedIn(binaryOperation->right, declaration);
+            }
+            else if (expr->type == parser::ExprType::FUNCTION)
+            {
+                auto functionExpr = std::static_pointer_cast<parser::FunctionExpr>(expr);
+                return std::any_of(functionExpr->args.begin(), functionExpr->args.end(), [&declaration](const auto &arg)
+                                   { return isAssignedIn(arg, declaration); });
+            }
+            return false;
+        }
+
+        bool isAssignedIn(const std::vector<std::shared_ptr<parser::Stmt>> &stmts, const parser::Stmt *declaration)
+        {
+            for (const auto &stmt : stmts)
+            {
+                bool assigned = false;
+                if (stmt->type == parser::StmtType::EXPR)
+                {
+                    assigned = isAssignedIn(std::static_pointer_cast<parser::ExprStmt>(stmt)->expr, declaration);
+                }
+                else if (stmt->type == parser::StmtType::RETURN)
+                {
+                    assigned = isAssignedIn(std::static_pointer_cast<parser::ReturnStmt>(stmt)->expr, declaration);
+                }
+                else if (stmt->type == parser::StmtType::PRINT)
+                {
+                    assigned = isAssignedIn(std::static_pointer_cast<parser::PrintStmt>(stmt)->expr, declaration);
+                }
+                else if (stmt->type == parser::StmtType::IF)
+                {
+                    auto ifStmt = std::static_pointer_cast<parser::IfStmt>(stmt);
+                    assigned = isAssignedIn(ifStmt->condition, declaration) || isAssignedIn(ifStmt->stmts, declaration);
+                }
+                else if (stmt->type == parser::StmtType::WHILE)
+                {
+                    auto whileStmt = std::static_pointer_cast<parser::WhileStmt>(stmt);
+                    assigned = isAssignedIn(whileStmt->condition, declaration) || isAssignedIn(whileStmt->stmts, declaration);
+                }
+
+                if (assigned)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::unique_ptr<llvm::TargetMachine> createTargetMachine(compiler::OptimizationLevel optimizationLevel)
+        {
+            compiler::initializeNativeTarget();
+
+            std::string triple = compiler::targetTriple();
+            std::string error;
+            const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, error);
+            if (target == nullptr)
+            {
+                throw std::runtime_error("Could not find target for triple " + triple + ": " + error);
+            }
+
+#if LLVM_VERSION_MAJOR >= 18
+            llvm::CodeGenOptLevel codeGenLevel = optimizationLevel == compiler::OptimizationLevel::O0 ? llvm::CodeGenOptLevel::None : llvm::CodeGenOptLevel::Default;
+#else
+            llvm::CodeGenOpt::Level codeGenLevel = optimizationLevel == compiler::OptimizationLevel::O0 ? llvm::CodeGenOpt::None : llvm::CodeGenOpt::Default;
+#endif
+            return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(triple, "generic", "", llvm::TargetOptions(), llvm::Reloc::PIC_, {}, codeGenLevel));
+        }
+
+        // Every module is laid out for the host, whatever its optimization level, so
+        // the layout is worked out once per process rather than once per Compiler.
+        const llvm::DataLayout &hostDataLayout()
+        {
+            static const llvm::DataLayout dataLayout = createTargetMachine(compiler::OptimizationLevel::O0)->createDataLayout();
+            return dataLayout;
+        }
+    }
+
+    Compiler::Compiler(compiler::OptimizationLevel optimizationLevel) : optimizationLevel(optimizationLevel)
     {
         this->context = std::make_unique<llvm::LLVMContext>();
-        this->compiling = std::make_unique<llvm::Module>("anchor", *this->context);
+#if LLVM_VERSION_MAJOR < 15
+        this->context->enableOpaquePointers();
+#endif
+#ifdef NDEBUG
+        // Value names only make the IR easier to read. Variables are no longer looked up by them.
+        this->context->setDiscardValueNames(true);
+#endif
         this->builder = std::make_unique<llvm::IRBuilder<>>(*this->context);
+        this->entryBuilder = std::make_unique<llvm::IRBuilder<>>(*this->context);
+
+        this->genAnchorStringStructType();
+        this->startModule();
+    }
+
+    void Compiler::startModule()
+    {
+        this->compiling = std::make_unique<llvm::Module>("anchor", *this->context);
+        this->compiling->setTargetTriple(compiler::targetTriple());
+        this->compiling->setDataLayout(hostDataLayout());
 
         this->declarePrintFunction();
         this->declareMallocFunction();
         this->declareFreeFunction();
-        this->declareMemCpyFunction();
-        this->genAnchorStringStructType();
+    }
+
+    void Compiler::reset()
+    {
+        if (this->context == nullptr)
+        {
+            throw std::runtime_error("Cannot reset a compiler after releasing its module.");
+        }
+
+        this->constantStrings.clear();
+        this->variables.clear();
+        this->scopes.clear();
+        this->elsewhere.clear();
+        this->signatures = nullptr;
+        this->globals = nullptr;
+        this->tiering = compiler::Tiering::NONE;
+        this->tierUpThreshold = 0;
+        this->tierUpIdentifier.clear();
+        this->builder->ClearInsertionPoint();
+        this->entryBuilder->ClearInsertionPoint();
+
+        this->startModule();
+    }
+
+    compiler::OptimizationLevel Compiler::getOptimizationLevel() const
+    {
+        return this->optimizationLevel;
+    }
+
+    void initializeNativeTarget()
+    {
+        static std::once_flag nativeTargetInitialized;
+        std::call_once(nativeTargetInitialized, []()
+                       { llvm::InitializeNativeTarget(); });
+    }
+
+    void initializeNativeAsmPrinter()
+    {
+        compiler::initializeNativeTarget();
+
+        static std::once_flag nativeAsmPrinterInitialized;
+        std::call_once(nativeAsmPrinterInitialized, []()
+                       { llvm::InitializeNativeTargetAsmPrinter(); });
+    }
+
+    std::string targetTriple()
+    {
+        return llvm::sys::getProcessTriple();
+    }
+
+    llvm::TargetMachine *Compiler::getTargetMachine()
+    {
+        if (this->targetMachine == nullptr)
+        {
+            this->targetMachine = createTargetMachine(this->optimizationLevel);
+        }
+        return this->targetMachine.get();
+    }
+
+    void Compiler::optimize()
+    {
+        if (this->optimizationLevel == compiler::OptimizationLevel::O0)
+        {
+            return;
+        }
+
+        std::string errors;
+        llvm::raw_string_ostream errorStream(errors);
+        if (llvm::verifyModule(*this->compiling, &errorStream))
+        {
+            throw std::runtime_error("Generated invalid module: " + errorStream.str());
+        }
+
+        llvm::LoopAnalysisManager loopAnalysisManager;
+        llvm::FunctionAnalysisManager functionAnalysisManager;
+        llvm::CGSCCAnalysisManager cgsccAnalysisManager;
+        llvm::ModuleAnalysisManager moduleAnalysisManager;
+
+        llvm::PassBuilder passBuilder(this->getTargetMachine());
+        passBuilder.registerModuleAnalyses(moduleAnalysisManager);
+        passBuilder.registerCGSCCAnalyses(cgsccAnalysisManager);
+        passBuilder.registerFunctionAnalyses(functionAnalysisManager);
+        passBuilder.registerLoopAnalyses(loopAnalysisManager);
+        passBuilder.crossRegisterProxies(loopAnalysisManager, functionAnalysisManager, cgsccAnalysisManager, moduleAnalysisManager);
+
+        llvm::OptimizationLevel level = llvm::OptimizationLevel::O1;
+        if (this->optimizationLevel == compiler::OptimizationLevel::O2)
+        {
+            level = llvm::OptimizationLevel::O2;
+        }
+        else if (this->optimizationLevel == compiler::OptimizationLevel::O3)
+        {
+            level = llvm::OptimizationLevel::O3;
+        }
+
+        llvm::ModulePassManager modulePassManager = passBuilder.buildPerModuleDefaultPipeline(level);
+        modulePassManager.run(*this->compiling, moduleAnalysisManager);
     }
 
     void Compiler::declarePrintFunction()
     {
-        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getInt32Ty(*this->context), true);
+        llvm::Type *format = llvm::Type::getInt8PtrTy(*this->context);
+        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getInt32Ty(*this->context), {format}, true);
         llvm::Function::Create(functionReturnType, llvm::Function::ExternalLinkage, "printf", this->compiling.get());
     }
 
     void Compiler::declareMallocFunction()
     {
-        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getInt32PtrTy(*this->context), true);
+        llvm::Type *size = llvm::Type::getInt64Ty(*this->context);
+        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getInt8PtrTy(*this->context), {size}, false);
         llvm::Function::Create(functionReturnType, llvm::Function::ExternalLinkage, "malloc", this->compiling.get());
     }
 
     void Compiler::declareFreeFunction()
     {
-        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getVoidTy(*this->context), true);
+        llvm::Type *allocated = llvm::Type::getInt8PtrTy(*this->context);
+        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getVoidTy(*this->context), {allocated}, false);
         llvm::Function::Create(functionReturnType, llvm::Function::ExternalLinkage, "free", this->compiling.get());
     }
 
-    void Compiler::declareMemCpyFunction()
-    {
-        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getVoidTy(*this->context), true);
-        llvm::Function::Create(functionReturnType, llvm::Function::ExternalLinkage, "memcpy", this->compiling.get());
-    }
-
     void Compiler::genAnchorStringStructType()
     {
         llvm::Type *characterBufferPointer = llvm::Type::getInt8PtrTy(*this->context);
@@ -47,50 +260,280 @@ namespace compiler
         this->anchorStringStructType = llvm::StructType::create(std::vector<llvm::Type *>{characterBufferPointer, numCharsCurrentlyInBuffer});
     }
 
+    // Every stack slot lives in the entry block of the function being compiled, after
+    // the allocas already there. A slot is then allocated once per call rather than
+    // once per loop iteration, and mem2reg/SROA are able to promote it.
+    llvm::AllocaInst *Compiler::createEntryBlockAlloca(llvm::Type *type, const std::string &name)
+    {
+        llvm::BasicBlock &entry = this->builder->GetInsertBlock()->getParent()->getEntryBlock();
+        llvm::BasicBlock::iterator insertionPoint = entry.begin();
+        while (insertionPoint != entry.end() && llvm::isa<llvm::AllocaInst>(*insertionPoint))
+        {
+            insertionPoint++;
+        }
+
+        this->entryBuilder->SetInsertPoint(&entry, insertionPoint);
+        return this->entryBuilder->CreateAlloca(type, nullptr, name);
+    }
+
     llvm::Value *Compiler::get32BitInteger(int value)
     {
         return llvm::ConstantInt::getIntegerValue(llvm::Type::getInt32Ty(*this->context), llvm::APInt(32, value));
     }
 
-    llvm::Value *Compiler::getAnchorString(const std::string &literal)
+    // String literals and format strings are interned by content, so each distinct
+    // one becomes a single private global no matter how often it is evaluated.
+    llvm::Constant *Compiler::getConstantString(const std::string &contents)
     {
-        llvm::Value *source = this->builder->CreateGlobalStringPtr(llvm::StringRef(literal), "", 0U, this->compiling.get());
+        auto [entry, inserted] = this->constantStrings.try_emplace(contents, nullptr);
+        if (inserted)
+        {
+            entry->second = this->builder->CreateGlobalStringPtr(llvm::StringRef(contents), "", 0U, this->compiling.get());
+        }
+        return entry->second;
+    }
 
-        llvm::StructType *structType = this->anchorStringStructType;
-        llvm::Value *anchorString = this->builder->CreateAlloca(structType);
+    llvm::Value *Compiler::getAnchorString(const std::string &literal)
+    {
+        llvm::Value *source = this->getConstantString(literal);
 
         llvm::Value *size = this->get32BitInteger(static_cast<int>(literal.length() + 1));
         llvm::Value *allocated = this->malloc(size);
-
-        llvm::Value *stringBuffer = this->builder->CreateStructGEP(structType, anchorString, 0);
-
         this->memcpy(allocated, source, size);
-        this->builder->CreateStore(allocated, stringBuffer);
 
-        llvm::Value *sizePointer = this->builder->CreateStructGEP(structType, anchorString, 1);
-        this->builder->CreateStore(size, sizePointer);
-        return anchorString;
+        return this->makeAnchorString(allocated, size);
+    }
+
+    llvm::Value *Compiler::makeAnchorString(llvm::Value *buffer, llvm::Value *size)
+    {
+        llvm::Value *anchorString = llvm::UndefValue::get(this->anchorStringStructType);
+        anchorString = this->builder->CreateInsertValue(anchorString, buffer, 0);
+        return this->builder->CreateInsertValue(anchorString, size, 1);
     }
 
     llvm::Value *Compiler::malloc(llvm::Value *size)
     {
         llvm::Function *malloc = this->compiling->getFunction("malloc");
-        llvm::Value *allocated = this->builder->CreateCall(malloc, std::vector<llvm::Value *>{size});
+        llvm::Value *extendedSize = this->builder->CreateZExt(size, llvm::Type::getInt64Ty(*this->context));
+        llvm::Value *allocated = this->builder->CreateCall(malloc, std::vector<llvm::Value *>{extendedSize});
         return allocated;
     }
 
     void Compiler::memcpy(llvm::Value *destination, llvm::Value *source, llvm::Value *size)
     {
-        llvm::Function *memcpy = this->compiling->getFunction("memcpy");
-        this->builder->CreateCall(memcpy, std::vector<llvm::Value *>{destination, source, size});
+        // The intrinsic lets the optimizer turn small constant-size copies into plain loads and stores.
+        llvm::Value *extendedSize = this->builder->CreateZExt(size, llvm::Type::getInt64Ty(*this->context));
+        this->builder->CreateMemCpy(destination, llvm::MaybeAlign(1), source, llvm::MaybeAlign(1), extendedSize);
     }
 
     void Compiler::compile(llvm::raw_ostream &outs, const parser::Program &program)
+    {
+        this->compile(program);
+        this->print(outs);
+    }
+
+    void Compiler::compile(const parser::Program &program)
     {
         this->compile(program.stmts);
+        this->optimize();
+    }
+
+    void Compiler::compileBaselineTier(const parser::Program &program, int threshold)
+    {
+        this->tiering = compiler::Tiering::BASELINE;
+        this->tierUpThreshold = threshold;
+
+        llvm::Type *pointer = llvm::Type::getInt8PtrTy(*this->context);
+        new llvm::GlobalVariable(*this->compiling, llvm::Type::getInt8Ty(*this->context), false, llvm::GlobalValue::ExternalLinkage, nullptr, "anchor.tiering");
+        llvm::FunctionType *tierUpType = llvm::FunctionType::get(llvm::Type::getVoidTy(*this->context), {pointer, pointer}, false);
+        llvm::Function::Create(tierUpType, llvm::Function::ExternalLinkage, "anchor.tierUp", this->compiling.get());
+
+        this->compile(program);
+    }
+
+    void Compiler::compileOptimizedTier(const parser::Program &program, const std::string &identifier)
+    {
+        this->tiering = compiler::Tiering::OPTIMIZED;
+        this->tierUpIdentifier = identifier;
+
+        // Every other function is only called through its entry pointer, which needs
+        // nothing more than the signature.
+        std::shared_ptr<parser::FunctionStmt> hot;
+        for (const auto &stmt : program.stmts)
+        {
+            if (stmt->type != parser::StmtType::FUNCTION)
+            {
+                continue;
+            }
+
+            auto functionStmt = std::static_pointer_cast<parser::FunctionStmt>(stmt);
+            if (functionStmt->identifier == identifier)
+            {
+                hot = functionStmt;
+            }
+            else
+            {
+                this->declareTieredEntry(this->getFunctionWithNamedParams(functionStmt), false);
+            }
+        }
+
+        if (hot == nullptr)
+        {
+            throw std::invalid_argument("Cannot compile optimized tier of unknown function " + identifier + ".");
+        }
+        this->compile(hot);
+        this->optimize();
+    }
+
+    void Compiler::compilePartition(const parser::Program &program, std::size_t first, std::size_t last)
+    {
+        std::vector<std::shared_ptr<parser::FunctionStmt>> defining;
+        std::size_t index = 0;
+        for (const auto &stmt : program.stmts)
+        {
+            if (stmt->type == parser::StmtType::IMPORT)
+            {
+                this->compile(std::static_pointer_cast<parser::ImportStmt>(stmt));
+                continue;
+            }
+            if (stmt->type != parser::StmtType::FUNCTION)
+            {
+                continue;
+            }
+
+            auto functionStmt = std::static_pointer_cast<parser::FunctionStmt>(stmt);
+            if (index >= first && index < last)
+            {
+                defining.push_back(functionStmt);
+            }
+            else
+            {
+                this->elsewhere.emplace(functionStmt->identifier, functionStmt);
+            }
+            index++;
+        }
+
+        for (const auto &functionStmt : defining)
+        {
+            this->compile(functionStmt);
+        }
+        this->optimize();
+    }
+
+    void Compiler::link(llvm::MemoryBufferRef bitcode)
+    {
+        llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(bitcode, *this->context);
+        if (!module)
+        {
+            throw std::runtime_error("Could not read " + bitcode.getBufferIdentifier().str() + ": " + llvm::toString(module.takeError()));
+        }
+        if (llvm::Linker::linkModules(*this->compiling, std::move(*module)))
+        {
+            throw std::runtime_error("Could not link " + bitcode.getBufferIdentifier().str() + ".");
+        }
+    }
+
+    void Compiler::declareElsewhere(const compiler::Signatures &signatures)
+    {
+        this->signatures = &signatures;
+    }
+
+    void Compiler::compileNext(std::shared_ptr<parser::Stmt> stmt)
+    {
+        this->compile(std::move(stmt));
+    }
+
+    void Compiler::finish()
+    {
+        this->optimize();
+    }
+
+    void Compiler::defineGlobal(const parser::VarDeclStmt &declaration, const std::string &name)
+    {
+        llvm::Type *type = this->getType(declaration.variableType);
+        llvm::Constant *initializer = llvm::Constant::getNullValue(type);
+        if (declaration.variableType == parser::Type::STRING)
+        {
+            // Empty, like a local string, though in constant memory rather than a buffer of its own.
+            llvm::Constant *size = llvm::ConstantInt::get(llvm::Type::getInt32Ty(*this->context), 1);
+            initializer = llvm::ConstantStruct::get(this->anchorStringStructType, {this->getConstantString(""), size});
+        }
+
+        // Never in a scope, so it stays declared for every statement the module compiles.
+        this->variables[&declaration] = new llvm::GlobalVariable(*this->compiling, type, false, llvm::GlobalValue::ExternalLinkage, initializer, name);
+    }
+
+    void Compiler::declareGlobals(const compiler::Globals &globals)
+    {
+        this->globals = &globals;
+    }
+
+    void Compiler::declareTieredEntry(llvm::Function *function, bool defined)
+    {
+        llvm::Type *pointer = llvm::Type::getInt8PtrTy(*this->context);
+        llvm::Constant *initializer = defined ? function : nullptr;
+        auto *entry = new llvm::GlobalVariable(*this->compiling, pointer, false, llvm::GlobalValue::ExternalLinkage, initializer, function->getName() + ".entry");
+        entry->setAlignment(llvm::Align(8));
+
+        if (defined)
+        {
+            llvm::Type *counter = llvm::Type::getInt32Ty(*this->context);
+            new llvm::GlobalVariable(*this->compiling, counter, false, llvm::GlobalValue::ExternalLinkage, llvm::ConstantInt::get(counter, 0), function->getName() + ".calls");
+        }
+    }
+
+    void Compiler::countTieredExecution(llvm::Function *function)
+    {
+        llvm::GlobalVariable *counter = this->compiling->getNamedGlobal((function->getName() + ".calls").str());
+        llvm::Value *previous = this->builder->CreateAtomicRMW(llvm::AtomicRMWInst::Add, counter, this->get32BitInteger(1), llvm::MaybeAlign(4), llvm::AtomicOrdering::Monotonic);
+        llvm::Value *hot = this->builder->CreateICmpEQ(previous, this->get32BitInteger(this->tierUpThreshold - 1));
+
+        llvm::BasicBlock *tierUp = llvm::BasicBlock::Create(*this->context, "tierUp", function);
+        llvm::BasicBlock *body = llvm::BasicBlock::Create(*this->context, "body", function);
+        this->builder->CreateCondBr(hot, tierUp, body);
+
+        this->builder->SetInsertPoint(tierUp);
+        llvm::Value *runtime = this->compiling->getNamedGlobal("anchor.tiering");
+        this->builder->CreateCall(this->compiling->getFunction("anchor.tierUp"), {runtime, this->getConstantString(function->getName().str())});
+        this->builder->CreateBr(body);
+
+        this->builder->SetInsertPoint(body);
+    }
+
+    void Compiler::print(llvm::raw_ostream &outs)
+    {
         this->compiling->print(outs, nullptr);
     }
 
+    std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>> Compiler::release()
+    {
+        return {std::move(this->context), std::move(this->compiling)};
+    }
+
+    void Compiler::writeBitcode(llvm::raw_ostream &outs)
+    {
+        llvm::WriteBitcodeToFile(*this->compiling, outs);
+    }
+
+    void Compiler::emitObject(llvm::raw_pwrite_stream &outs)
+    {
+        compiler::initializeNativeAsmPrinter();
+
+        // Code generation still runs on the legacy pass manager.
+        llvm::legacy::PassManager passManager;
+#if LLVM_VERSION_MAJOR >= 18
+        llvm::CodeGenFileType fileType = llvm::CodeGenFileType::ObjectFile;
+#else
+        llvm::CodeGenFileType fileType = llvm::CGFT_ObjectFile;
+#endif
+        if (this->getTargetMachine()->addPassesToEmitFile(passManager, outs, nullptr, fileType))
+        {
+            throw std::runtime_error("Target " + this->compiling->getTargetTriple() + " cannot emit object files.");
+        }
+        passManager.run(*this->compiling);
+        outs.flush();
+    }
+
     void Compiler::compile(std::shared_ptr<parser::Stmt> stmt)
     {
         using enum parser::StmtType;
@@ -129,6 +572,21 @@ namespace compiler
             std::shared_ptr<parser::WhileStmt> whileStmt = std::static_pointer_cast<parser::WhileStmt>(stmt);
             this->compile(whileStmt);
         }
+        else if (stmt->type == IMPORT)
+        {
+            std::shared_ptr<parser::ImportStmt> importStmt = std::static_pointer_cast<parser::ImportStmt>(stmt);
+            this->compile(importStmt);
+        }
+    }
+
+    // Imported functions are defined in the library's own object. Each is declared
+    // here the first time it is called.
+    void Compiler::compile(std::shared_ptr<parser::ImportStmt> importStmt)
+    {
+        for (const auto &declaration : importStmt->declarations)
+        {
+            this->elsewhere.emplace(declaration->identifier, declaration);
+        }
     }
 
     void Compiler::compile(std::shared_ptr<parser::FunctionStmt> functionStmt)
@@ -140,7 +598,37 @@ namespace compiler
         llvm::BasicBlock *functionBlock = llvm::BasicBlock::Create(*this->context, "", function);
         this->builder->SetInsertPoint(functionBlock);
 
+        if (this->tiering == compiler::Tiering::BASELINE)
+        {
+            this->declareTieredEntry(function, true);
+            this->countTieredExecution(function);
+        }
+        else if (this->tiering == compiler::Tiering::OPTIMIZED)
+        {
+            function->setName(functionStmt->identifier + ".tier2");
+        }
+
+        this->pushScope();
+
+        // Arguments arrive in registers. Only those the body assigns to need a stack slot.
+        for (std::size_t i = 0; i < functionStmt->args.size(); i++)
+        {
+            const auto &astArg = functionStmt->args[i];
+            llvm::Argument *llvmArg = function->getArg(i);
+            if (isAssignedIn(functionStmt->stmts, astArg.get()))
+            {
+                llvm::Value *slot = this->createEntryBlockAlloca(llvmArg->getType(), astArg->identifier + ".addr");
+                this->builder->CreateStore(llvmArg, slot);
+                this->declare(astArg.get(), slot);
+            }
+            else
+            {
+                this->declare(astArg.get(), llvmArg);
+            }
+        }
+
         this->compile(functionStmt->stmts);
+        this->popScope();
 
         if (functionStmt->returnType == parser::Type::VOID)
         {
@@ -166,20 +654,8 @@ namespace compiler
     llvm::FunctionType *Compiler::functionType(std::shared_ptr<parser::FunctionStmt> functionStmt)
     {
         std::vector<llvm::Type *> args = this->functionStmtArgTypes(functionStmt->args);
-
-        llvm::FunctionType *functionReturnType = llvm::FunctionType::get(llvm::Type::getInt32Ty(*this->context), args, true);
-        if (functionStmt->returnType == parser::Type::STRING)
-        {
-            llvm::Type *returnType = llvm::FunctionType::getInt32PtrTy(*this->context);
-            functionReturnType = llvm::FunctionType::get(returnType, args, false);
-        }
-        else if (functionStmt->returnType == parser::Type::VOID)
-        {
-            llvm::Type *returnType = llvm::FunctionType::getVoidTy(*this->context);
-            functionReturnType = llvm::FunctionType::get(returnType, args, false);
-        }
-
-        return functionReturnType;
+        llvm::Type *returnType = this->getType(functionStmt->returnType);
+        return llvm::FunctionType::get(returnType, args, false);
     }
 
     std::vector<llvm::Type *> Compiler::functionStmtArgTypes(const std::vector<std::shared_ptr<parser::FunctionArgStmt>> &args)
@@ -187,11 +663,35 @@ namespace compiler
         std::vector<llvm::Type *> compiledArgs;
         for (const auto &arg : args)
         {
-            compiledArgs.push_back(llvm::Type::getInt64PtrTy(*this->context));
+            compiledArgs.push_back(this->getType(arg->returnType));
         }
         return compiledArgs;
     }
 
+    llvm::Type *Compiler::getType(parser::Type type)
+    {
+        if (type == parser::Type::INTEGER)
+        {
+            return llvm::Type::getInt32Ty(*this->context);
+        }
+        else if (type == parser::Type::BOOLEAN)
+        {
+            return llvm::Type::getInt1Ty(*this->context);
+        }
+        else if (type == parser::Type::STRING)
+        {
+            return this->anchorStringStructType;
+        }
+        else if (type == parser::Type::VOID)
+        {
+            return llvm::Type::getVoidTy(*this->context);
+        }
+        else
+        {
+            throw std::invalid_argument("Cannot compile unknown type " + parser::tostring(type) + ".");
+        }
+    }
+
     void Compiler::compile(const Body &body)
     {
         for (const auto &stmt : body)
@@ -205,19 +705,18 @@ namespace compiler
         std::vector<llvm::Value *> args;
         if (stmt->expr->returnType == parser::Type::STRING)
         {
-            args.push_back(this->builder->CreateGlobalStringPtr(llvm::StringRef("%s"), "", 0U, this->compiling.get()));
+            args.push_back(this->getConstantString("%s"));
         }
         else if (stmt->expr->returnType == parser::Type::INTEGER || stmt->expr->returnType == parser::Type::BOOLEAN)
         {
-            args.push_back(this->builder->CreateGlobalStringPtr(llvm::StringRef("%d")));
+            args.push_back(this->getConstantString("%d"));
         }
 
         llvm::Value *expr = this->compile(stmt->expr);
 
         if (stmt->expr->returnType == parser::Type::STRING)
         {
-            llvm::Value *stringLiteralPointer = this->builder->CreateStructGEP(this->anchorStringStructType, expr, 0);
-            llvm::Value *stringLiteral = this->builder->CreateLoad(llvm::Type::getInt8PtrTy(*this->context), stringLiteralPointer);
+            llvm::Value *stringLiteral = this->builder->CreateExtractValue(expr, 0);
 
             args.push_back(stringLiteral);
             llvm::Function *printf = this->compiling->getFunction("printf");
@@ -333,39 +832,73 @@ namespace compiler
 
     llvm::Value *Compiler::compile(std::shared_ptr<parser::FunctionExpr> functionExpr)
     {
-        llvm::Function *function = this->compiling->getFunction(llvm::StringRef(functionExpr->identifier));
-
         std::vector<llvm::Value *> args;
         for (const auto &arg : functionExpr->args)
         {
-            llvm::Value *value = this->compile(arg);
-            llvm::Value *stackAllocation = this->builder->CreateAlloca(llvm::Type::getInt32Ty(*this->context));
-            this->builder->CreateStore(value, stackAllocation);
-            args.push_back(stackAllocation);
+            args.push_back(this->compile(arg));
+        }
+
+        if (this->tiering == compiler::Tiering::OPTIMIZED && functionExpr->identifier == this->tierUpIdentifier)
+        {
+            // Recursion stays inside the optimized tier and can be inlined.
+            return this->builder->CreateCall(this->compiling->getFunction(functionExpr->identifier + ".tier2"), args);
         }
 
-        return this->builder->CreateCall(function, args);
+        llvm::Function *function = this->compiling->getFunction(llvm::StringRef(functionExpr->identifier));
+        if (function == nullptr)
+        {
+            auto declaration = this->elsewhere.find(functionExpr->identifier);
+            if (declaration != this->elsewhere.end())
+            {
+                function = this->getFunctionWithNamedParams(declaration->second);
+            }
+            else if (this->signatures != nullptr)
+            {
+                auto signature = this->signatures->find(functionExpr->identifier);
+                if (signature != this->signatures->end())
+                {
+                    function = this->getFunctionWithNamedParams(signature->second);
+                }
+            }
+        }
+        if (function == nullptr)
+        {
+            throw std::invalid_argument("Cannot compile call to unknown function " + functionExpr->identifier + ".");
+        }
+        if (this->tiering == compiler::Tiering::NONE)
+        {
+            return this->builder->CreateCall(function, args);
+        }
+
+        // The runtime may replace the target from another thread at any time.
+        llvm::GlobalVariable *entry = this->compiling->getNamedGlobal(functionExpr->identifier + ".entry");
+        llvm::LoadInst *target = this->builder->CreateAlignedLoad(llvm::Type::getInt8PtrTy(*this->context), entry, llvm::MaybeAlign(8));
+        target->setAtomic(llvm::AtomicOrdering::Acquire);
+        return this->builder->CreateCall(function->getFunctionType(), target, args);
     }
 
     void Compiler::compile(std::shared_ptr<parser::VarDeclStmt> varDeclStmt)
     {
         if (varDeclStmt->variableType == parser::Type::INTEGER)
         {
-            llvm::Value *value = this->builder->CreateAlloca(llvm::Type::getInt32Ty(*this->context), nullptr, varDeclStmt->identifier);
+            llvm::Value *value = this->createEntryBlockAlloca(llvm::Type::getInt32Ty(*this->context), varDeclStmt->identifier);
             llvm::Value *zero = llvm::ConstantInt::getIntegerValue(llvm::Type::getInt32Ty(*this->context), llvm::APInt(32, 0));
             this->builder->CreateStore(zero, value);
+            this->declare(varDeclStmt.get(), value);
         }
         else if (varDeclStmt->variableType == parser::Type::STRING)
         {
             llvm::Value *emptyString = this->getAnchorString("");
-            llvm::Value *value = this->builder->CreateAlloca(llvm::Type::getInt32PtrTy(*this->context), nullptr, varDeclStmt->identifier);
+            llvm::Value *value = this->createEntryBlockAlloca(this->anchorStringStructType, varDeclStmt->identifier);
             this->builder->CreateStore(emptyString, value);
+            this->declare(varDeclStmt.get(), value);
         }
         else if (varDeclStmt->variableType == parser::Type::BOOLEAN)
         {
-            llvm::Value *value = this->builder->CreateAlloca(llvm::Type::getInt1Ty(*this->context), nullptr, varDeclStmt->identifier);
+            llvm::Value *value = this->createEntryBlockAlloca(llvm::Type::getInt1Ty(*this->context), varDeclStmt->identifier);
             llvm::Value *zero = llvm::ConstantInt::getBool(llvm::Type::getInt1Ty(*this->context), false);
             this->builder->CreateStore(zero, value);
+            this->declare(varDeclStmt.get(), value);
         }
     }
 
@@ -376,29 +909,17 @@ namespace compiler
 
     llvm::Value *Compiler::compile(std::shared_ptr<parser::VarExpr> varExpr)
     {
-        llvm::BasicBlock *bb = this->builder->GetInsertBlock();
-        llvm::Value *value = bb->getValueSymbolTable()->lookup(llvm::StringRef(varExpr->identifier));
-
-        if (varExpr->returnType == parser::Type::BOOLEAN)
+        llvm::Value *value = this->lookup(varExpr->declaration, varExpr->identifier);
+        if (!llvm::isa<llvm::AllocaInst>(value) && !llvm::isa<llvm::GlobalVariable>(value))
         {
-            return this->builder->CreateLoad(llvm::Type::getInt1Ty(*this->context), value);
+            return value;
         }
-        else if (varExpr->returnType == parser::Type::INTEGER)
-        {
-            return this->builder->CreateLoad(llvm::Type::getInt32Ty(*this->context), value);
-        }
-        else if (varExpr->returnType == parser::Type::STRING)
-        {
-            return this->builder->CreateLoad(llvm::Type::getInt8PtrTy(*this->context), value);
-        }
-        else if (varExpr->returnType == parser::Type::VOID)
-        {
-            return this->builder->CreateLoad(llvm::Type::getVoidTy(*this->context), value);
-        }
-        else
+
+        if (varExpr->returnType == parser::Type::NOT_FOUND)
         {
             throw std::invalid_argument("Cannot compile variable expression with unknown type.");
         }
+        return this->builder->CreateLoad(this->getType(varExpr->returnType), value);
     }
 
     llvm::Value *Compiler::concat(llvm::Value *lhs, llvm::Value *rhs)
@@ -412,31 +933,19 @@ namespace compiler
         llvm::Value *concatSize = this->builder->CreateSub(concatSizeWithNullTerminators, one);
         llvm::Value *allocated = this->malloc(concatSize);
 
-        llvm::Value *anchorString = this->builder->CreateAlloca(this->anchorStringStructType);
-        llvm::Value *anchorStringCharBufferPointer = this->builder->CreateStructGEP(this->anchorStringStructType, anchorString, 0);
-
-        llvm::Value *lhsCharBufferPointer = this->builder->CreateStructGEP(this->anchorStringStructType, lhs, 0);
-        llvm::Value *lhsCharBuffer = this->builder->CreateLoad(llvm::Type::getInt8PtrTy(*this->context), lhsCharBufferPointer);
-
-        llvm::Value *rhsCharBufferPointer = this->builder->CreateStructGEP(this->anchorStringStructType, rhs, 0);
-        llvm::Value *rhsCharBuffer = this->builder->CreateLoad(llvm::Type::getInt8PtrTy(*this->context), rhsCharBufferPointer);
+        llvm::Value *lhsCharBuffer = this->builder->CreateExtractValue(lhs, 0);
+        llvm::Value *rhsCharBuffer = this->builder->CreateExtractValue(rhs, 0);
 
         llvm::Value *endOfLhs = this->builder->CreateInBoundsGEP(llvm::Type::getInt8Ty(*this->context), allocated, std::vector<llvm::Value *>{this->builder->CreateSub(lhsSize, one)});
         this->memcpy(allocated, lhsCharBuffer, this->builder->CreateSub(lhsSize, one));
         this->memcpy(endOfLhs, rhsCharBuffer, rhsSize);
 
-        this->builder->CreateStore(allocated, anchorStringCharBufferPointer);
-
-        llvm::Value *anchorStringCharLength = this->builder->CreateStructGEP(this->anchorStringStructType, anchorString, 1);
-        this->builder->CreateStore(concatSize, anchorStringCharLength);
-        return anchorString;
+        return this->makeAnchorString(allocated, concatSize);
     }
 
     llvm::Value *Compiler::getAnchorStringSize(llvm::Value *anchorString)
     {
-        llvm::Value *pointerToSize = this->builder->CreateStructGEP(this->anchorStringStructType, anchorString, 1);
-        llvm::Value *size = this->builder->CreateLoad(llvm::Type::getInt32Ty(*this->context), pointerToSize);
-        return size;
+        return this->builder->CreateExtractValue(anchorString, 1);
     }
 
     llvm::Value *Compiler::compile(std::shared_ptr<parser::BooleanLiteralExpr> booleanLiteralExpr)
@@ -455,8 +964,10 @@ namespace compiler
         this->builder->CreateCondBr(condition, then, end);
 
         this->builder->SetInsertPoint(then);
+        this->pushScope();
         this->compile(ifStmt->stmts);
-        this->builder->CreateBr(end);
+        this->popScope();
+        this->branchIfUnterminated(end);
 
         this->builder->SetInsertPoint(end);
     }
@@ -476,16 +987,76 @@ namespace compiler
         this->builder->CreateCondBr(condition, body, end);
 
         this->builder->SetInsertPoint(body);
+        this->pushScope();
         this->compile(whileStmt->stmts);
-        this->builder->CreateBr(whileLoopStart);
+        this->popScope();
+
+        // A function that loops for long is as hot as one called often, though only
+        // its later calls reach the optimized code.
+        llvm::Function *function = prev->getParent();
+        if (this->tiering == compiler::Tiering::BASELINE && function->getName() != "main" && this->builder->GetInsertBlock()->getTerminator() == nullptr)
+        {
+            this->countTieredExecution(function);
+        }
+        this->branchIfUnterminated(whileLoopStart);
 
         this->builder->SetInsertPoint(end);
     }
 
+    void Compiler::pushScope()
+    {
+        this->scopes.emplace_back();
+    }
+
+    void Compiler::popScope()
+    {
+        for (const parser::Stmt *declaration : this->scopes.back())
+        {
+            this->variables.erase(declaration);
+        }
+        this->scopes.pop_back();
+    }
+
+    void Compiler::declare(const parser::Stmt *declaration, llvm::Value *value)
+    {
+        this->variables[declaration] = value;
+        this->scopes.back().push_back(declaration);
+    }
+
+    llvm::Value *Compiler::lookup(const parser::Stmt *declaration, const std::string &identifier)
+    {
+        auto found = this->variables.find(declaration);
+        if (found != this->variables.end())
+        {
+            return found->second;
+        }
+
+        if (this->globals != nullptr)
+        {
+            auto global = this->globals->find(declaration);
+            if (global != this->globals->end())
+            {
+                // Defined by the module that compiled the declaration.
+                llvm::Type *type = this->getType(static_cast<const parser::VarDeclStmt *>(declaration)->variableType);
+                llvm::Value *value = new llvm::GlobalVariable(*this->compiling, type, false, llvm::GlobalValue::ExternalLinkage, nullptr, global->second);
+                this->variables.emplace(declaration, value);
+                return value;
+            }
+        }
+        throw std::invalid_argument("Cannot compile reference to undeclared variable " + identifier + ".");
+    }
+
+    void Compiler::branchIfUnterminated(llvm::BasicBlock *destination)
+    {
+        if (this->builder->GetInsertBlock()->getTerminator() == nullptr)
+        {
+            this->builder->CreateBr(destination);
+        }
+    }
+
     llvm::Value *Compiler::compile(std::shared_ptr<parser::VarAssignmentExpr> varAssignmentExpr)
     {
-        llvm::BasicBlock *bb = this->builder->GetInsertBlock();
-        llvm::Value *value = bb->getValueSymbolTable()->lookup(llvm::StringRef(varAssignmentExpr->identifier));
+        llvm::Value *value = this->lookup(varAssignmentExpr->declaration, varAssignmentExpr->identifier);
         llvm::Value *rhs = this->compile(varAssignmentExpr->expr);
         return this->builder->CreateStore(rhs, value);
     }
@@ -7,26 +7,91 @@
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Value.h"
 #include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/MemoryBufferRef.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "src/parser.hh"
 
 namespace compiler {
+    // Registers the host target with LLVM. Safe to call from any thread, any number of times.
+    void initializeNativeTarget();
+    // Registers the host's assembly printer as well, which emitting machine code
+    // needs and generating IR does not. Safe to call like initializeNativeTarget.
+    void initializeNativeAsmPrinter();
+    // The triple every Compiler generates code for.
+    std::string targetTriple();
+
+    enum class OptimizationLevel
+    {
+        O0,
+        O1,
+        O2,
+        O3
+    };
+
+    // Tiered code calls anchor functions through a "<name>.entry" pointer, so the
+    // runtime can swap in an optimized version while the program is running.
+    enum class Tiering
+    {
+        NONE,
+        // Counts calls and loop iterations in "<name>.calls" and reports hot functions
+        // to anchor.tierUp.
+        BASELINE,
+        // A single function, named "<name>.tier2", linked against a running baseline.
+        OPTIMIZED
+    };
+
+    // Functions defined in another module, by name. Only their signatures are used.
+    using Signatures = std::unordered_map<std::string, std::shared_ptr<parser::FunctionStmt>>;
+
+    // Top-level variables defined in another module, by their declaration, with the
+    // name of the global holding each. Every declaration is a parser::VarDeclStmt.
+    using Globals = std::unordered_map<const parser::Stmt*, std::string>;
+
     class Compiler {
     
     private:
         std::unique_ptr<llvm::LLVMContext> context;
         std::unique_ptr<llvm::Module> compiling; 
         std::unique_ptr<llvm::IRBuilder<>> builder;
+        std::unique_ptr<llvm::IRBuilder<>> entryBuilder;
+        // Created the first time the module is optimized or emitted as an object, so
+        // a compile to IR or bitcode never pays for one.
+        std::unique_ptr<llvm::TargetMachine> targetMachine;
+        compiler::OptimizationLevel optimizationLevel;
 
         llvm::StructType* anchorStringStructType;
+        llvm::StringMap<llvm::Constant*> constantStrings;
+
+        // Declarations are resolved by the parser, so a variable is found by the
+        // address of its VarDeclStmt or FunctionArgStmt rather than by its name.
+        std::unordered_map<const parser::Stmt*, llvm::Value*> variables;
+        std::vector<std::vector<const parser::Stmt*>> scopes;
+
+        compiler::Tiering tiering = compiler::Tiering::NONE;
+        int tierUpThreshold = 0;
+        std::string tierUpIdentifier;
+
+        // Functions another partition or an imported library defines, declared here
+        // the first time one is called.
+        compiler::Signatures elsewhere;
+        // Consulted after elsewhere. Borrowed from the caller of declareElsewhere.
+        const compiler::Signatures* signatures = nullptr;
+        const compiler::Globals* globals = nullptr;
 
         void compile(std::shared_ptr<parser::FunctionStmt> functionStmt);
         llvm::Function* getFunctionWithNamedParams(std::shared_ptr<parser::FunctionStmt> functionStmt);
         llvm::FunctionType* functionType(std::shared_ptr<parser::FunctionStmt> functionStmt);
+        void declareTieredEntry(llvm::Function* function, bool defined);
+        void countTieredExecution(llvm::Function* function);
         std::vector<llvm::Type*> functionStmtArgTypes(const std::vector<std::shared_ptr<parser::FunctionArgStmt>>& args);
 
         void compile(std::shared_ptr<parser::PrintStmt> printStmt);
@@ -36,6 +101,7 @@ namespace compiler {
         void compile(std::shared_ptr<parser::IfStmt> ifStmt);
         void compile(std::shared_ptr<parser::WhileStmt> ifStmt);
         void compile(std::shared_ptr<parser::ExprStmt> exprStmt);
+        void compile(std::shared_ptr<parser::ImportStmt> importStmt);
 
         llvm::Value* compile(std::shared_ptr<parser::Expr> expr);
         llvm::Value* compile(std::shared_ptr<parser::StringLiteral> stringLiteral);
@@ -48,22 +114,79 @@ namespace compiler {
     
         using Body = std::vector<std::shared_ptr<parser::Stmt>>;
         void compile(const Body& functionStmt);
+        void branchIfUnterminated(llvm::BasicBlock* destination);
+
+        void pushScope();
+        void popScope();
+        void declare(const parser::Stmt* declaration, llvm::Value* value);
+        llvm::Value* lookup(const parser::Stmt* declaration, const std::string& identifier);
     
         void declarePrintFunction();
         void declareMallocFunction();
         void declareFreeFunction();
-        void declareMemCpyFunction();
         void genAnchorStringStructType();
+        llvm::TargetMachine* getTargetMachine();
+        void startModule();
+        void optimize();
 
+        llvm::AllocaInst* createEntryBlockAlloca(llvm::Type* type, const std::string& name = "");
         llvm::Value* get32BitInteger(int value);
+        llvm::Constant* getConstantString(const std::string& contents);
+        llvm::Type* getType(parser::Type type);
         llvm::Value* getAnchorString(const std::string& literal);
+        llvm::Value* makeAnchorString(llvm::Value* buffer, llvm::Value* size);
         llvm::Value* getAnchorStringSize(llvm::Value* anchorString);
         llvm::Value* concat(llvm::Value* lhs, llvm::Value* rhs);
         llvm::Value* malloc(llvm::Value* size);
         void memcpy(llvm::Value* destination, llvm::Value* source, llvm::Value* size);
     public:
-        Compiler();
+        explicit Compiler(compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
         void compile(llvm::raw_ostream&, const parser::Program&);
+
+        // Generates and optimizes the module without printing it.
+        void compile(const parser::Program&);
+        void print(llvm::raw_ostream&);
+        void writeBitcode(llvm::raw_ostream&);
+        void emitObject(llvm::raw_pwrite_stream&);
+
+        // Compiles the program as the baseline tier. A function whose calls and loop
+        // iterations add up to threshold reports itself to the runtime. Loops in main
+        // are not counted, since main is only ever entered once.
+        void compileBaselineTier(const parser::Program&, int threshold);
+        // Compiles only the named function, as "<identifier>.tier2", to be linked into
+        // a JIT already running the baseline tier of the same program.
+        void compileOptimizedTier(const parser::Program&, const std::string& identifier);
+
+        // Compiles only the functions numbered [first, last) in the order the program
+        // defines them. Calls to the others become declarations, to be resolved by
+        // linking with the modules that compiled them.
+        void compilePartition(const parser::Program&, std::size_t first, std::size_t last);
+        // Links in a module another Compiler wrote as bitcode. It is not optimized again.
+        void link(llvm::MemoryBufferRef bitcode);
+
+        // Compile a program one top-level statement at a time, for a caller that
+        // parses it a statement at a time and lets each go once it is compiled. Calls
+        // to a function in signatures, which must outlive the compiler, become
+        // declarations. finish optimizes the module.
+        void declareElsewhere(const compiler::Signatures& signatures);
+        void compileNext(std::shared_ptr<parser::Stmt> stmt);
+        void finish();
+        // Hold top-level variables in globals, for a caller that compiles each
+        // statement of a session into a module of its own. defineGlobal defines one in
+        // this module. A variable in globals, which must outlive the compiler, is
+        // declared the first time a statement uses it.
+        void defineGlobal(const parser::VarDeclStmt& declaration, const std::string& name);
+        void declareGlobals(const compiler::Globals& globals);
+
+        // Discards the module and starts an empty one, so that one compiler, with its
+        // context and target machine, can compile program after program. Types and
+        // constants the old module used stay in the context.
+        void reset();
+        compiler::OptimizationLevel getOptimizationLevel() const;
+
+        // Hands the module, and the context that owns its types, to the caller. The
+        // compiler must not be used afterwards.
+        std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>> release();
     };
 
 }
@@ -0,0 +1,88 @@
+#include "src/compilerpool.hh"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace compiler
+{
+    CompilerPool::Lease::Lease(compiler::CompilerPool *pool, Entry entry) : pool(pool), entry(std::move(entry))
+    {
+    }
+
+    CompilerPool::Lease::~Lease()
+    {
+        if (this->pool != nullptr)
+        {
+            this->pool->release(std::move(this->entry));
+        }
+    }
+
+    CompilerPool::Lease::Lease(Lease &&other) noexcept : pool(other.pool), entry(std::move(other.entry))
+    {
+        other.pool = nullptr;
+    }
+
+    compiler::Compiler &CompilerPool::Lease::get()
+    {
+        return *this->entry.compiler;
+    }
+
+    CompilerPool::CompilerPool(unsigned maximumUses) : maximumUses(maximumUses)
+    {
+        if (maximumUses == 0)
+        {
+            throw std::invalid_argument("Cannot pool compilers that may never be used.");
+        }
+    }
+
+    CompilerPool::Lease CompilerPool::acquire(compiler::OptimizationLevel optimizationLevel)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            std::vector<Entry> &entries = this->idle[optimizationLevel];
+            if (!entries.empty())
+            {
+                Entry entry = std::move(entries.back());
+                entries.pop_back();
+                return Lease(this, std::move(entry));
+            }
+        }
+
+        Entry entry;
+        entry.compiler = std::make_unique<compiler::Compiler>(optimizationLevel);
+        return Lease(this, std::move(entry));
+    }
+
+    void CompilerPool::warm(compiler::OptimizationLevel optimizationLevel, std::size_t count)
+    {
+        std::vector<Entry> created(count);
+        for (Entry &entry : created)
+        {
+            entry.compiler = std::make_unique<compiler::Compiler>(optimizationLevel);
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::vector<Entry> &entries = this->idle[optimizationLevel];
+        std::move(created.begin(), created.end(), std::back_inserter(entries));
+    }
+
+    std::size_t CompilerPool::idleCount(compiler::OptimizationLevel optimizationLevel)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->idle[optimizationLevel].size();
+    }
+
+    void CompilerPool::release(Entry entry)
+    {
+        entry.uses++;
+        if (entry.uses >= this->maximumUses)
+        {
+            return;
+        }
+
+        compiler::OptimizationLevel optimizationLevel = entry.compiler->getOptimizationLevel();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->idle[optimizationLevel].push_back(std::move(entry));
+    }
+}
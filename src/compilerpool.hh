@@ -0,0 +1,65 @@
+#ifndef COMPILER_POOL_H
+#define COMPILER_POOL_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "src/compiler.hh"
+
+namespace compiler
+{
+    constexpr unsigned defaultMaximumUses = 256;
+
+    // Compilers kept warm between programs, so that each program only pays for a
+    // new module rather than a new context and target machine. A context keeps
+    // every type and constant the modules compiled in it needed, so a compiler is
+    // replaced after maximumUses programs.
+    class CompilerPool
+    {
+    private:
+        class Entry
+        {
+        public:
+            std::unique_ptr<compiler::Compiler> compiler;
+            unsigned uses = 0;
+        };
+
+        std::mutex mutex;
+        std::map<compiler::OptimizationLevel, std::vector<Entry>> idle;
+        unsigned maximumUses;
+
+        void release(Entry entry);
+
+    public:
+        // A compiler borrowed from the pool, and given back when the lease ends.
+        class Lease
+        {
+        private:
+            compiler::CompilerPool *pool;
+            Entry entry;
+
+        public:
+            Lease(compiler::CompilerPool *pool, Entry entry);
+            ~Lease();
+            Lease(Lease &&other) noexcept;
+            Lease(const Lease &) = delete;
+            Lease &operator=(const Lease &) = delete;
+            Lease &operator=(Lease &&) = delete;
+
+            compiler::Compiler &get();
+        };
+
+        explicit CompilerPool(unsigned maximumUses = compiler::defaultMaximumUses);
+
+        // Creates a compiler when none at the level is idle.
+        compiler::CompilerPool::Lease acquire(compiler::OptimizationLevel);
+        // Creates compilers ahead of the first programs that need them.
+        void warm(compiler::OptimizationLevel, std::size_t count);
+        std::size_t idleCount(compiler::OptimizationLevel);
+    };
+}
+
+#endif // COMPILER_POOL_H
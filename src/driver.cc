@@ -0,0 +1,541 @@
+#include "src/driver.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/anchor.hh"
+#include "src/cache.hh"
+#include "src/compilerpool.hh"
+#include "src/modules.hh"
+#include "src/jit.hh"
+#include "src/options.hh"
+#include "src/repl.hh"
+#include "src/tiering.hh"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_os_ostream.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace driver
+{
+    namespace
+    {
+        std::string emitName(const anchor::Options &options)
+        {
+            switch (options.emit)
+            {
+            case anchor::Emit::LLVM_IR:
+                return "llvm";
+            case anchor::Emit::BITCODE:
+                return "bc";
+            case anchor::Emit::OBJECT:
+                return "object";
+            case anchor::Emit::EXECUTABLE:
+            {
+                // The linker is part of what makes an executable.
+                const char *cc = std::getenv("CC");
+                return std::string("executable ") + (cc != nullptr ? cc : "cc");
+            }
+            }
+            return "";
+        }
+
+        std::string artifactName(const anchor::Options &options)
+        {
+            // Partitioning changes the output, the number of threads does not.
+            return emitName(options) + (options.codegenThreads > 0 ? " partitioned" : "") + (options.stream ? " streamed" : "");
+        }
+
+        std::optional<cache::Cache> openCache(const anchor::Options &options)
+        {
+            if (!options.cache || options.run)
+            {
+                return std::nullopt;
+            }
+
+            std::filesystem::path directory = options.cacheDirectory.empty() ? cache::defaultDirectory() : std::filesystem::path(options.cacheDirectory);
+            if (directory.empty())
+            {
+                return std::nullopt;
+            }
+            return cache::Cache(directory);
+        }
+
+        void makeExecutable(const std::string &path)
+        {
+            using std::filesystem::perms;
+            std::filesystem::permissions(path, perms::owner_exec | perms::group_exec | perms::others_exec, std::filesystem::perm_options::add);
+        }
+
+        std::string resolve(const driver::Environment &environment, const std::string &path)
+        {
+            if (path.empty() || environment.workingDirectory.empty())
+            {
+                return path;
+            }
+            return (environment.workingDirectory / path).string();
+        }
+
+        void report(const anchor::CompilationUnit &unit, std::ostream &err)
+        {
+            for (const parser::ErrorLog &errorLog : unit.diagnostics)
+            {
+                err << errorLog.getMessage() << '\n';
+            }
+        }
+
+        // Writes everything to two streams at once, so that an artifact can be cached
+        // while it is written out rather than copied afterwards.
+        class TeeStream : public llvm::raw_ostream
+        {
+        private:
+            llvm::raw_ostream &first;
+            llvm::raw_ostream &second;
+            std::uint64_t position = 0;
+
+            void write_impl(const char *data, std::size_t size) override
+            {
+                this->first.write(data, size);
+                this->second.write(data, size);
+                this->position += size;
+            }
+
+            std::uint64_t current_pos() const override
+            {
+                return this->position;
+            }
+
+        public:
+            TeeStream(llvm::raw_ostream &first, llvm::raw_ostream &second) : first(first), second(second)
+            {
+            }
+
+            ~TeeStream() override
+            {
+                this->flush();
+            }
+        };
+
+        // Closes the stream and reports whether everything written reached the file.
+        bool close(llvm::raw_fd_ostream &stream)
+        {
+            stream.close();
+            bool written = !stream.has_error();
+            stream.clear_error();
+            return written;
+        }
+
+        // Streams IR or bitcode straight into the output file, or standard output,
+        // and into the cache, without holding the whole module's text in memory.
+        int writeModule(const anchor::Options &options, anchor::CompilationUnit &unit, std::optional<cache::Cache> &artifacts, const std::string &key, driver::Environment &environment)
+        {
+            std::error_code error;
+            std::optional<llvm::raw_fd_ostream> file;
+            std::optional<llvm::raw_os_ostream> console;
+            if (!options.output.empty())
+            {
+                file.emplace(options.output, error, llvm::sys::fs::OF_None);
+                if (error)
+                {
+                    file->clear_error();
+                    environment.err << "Could not open " << options.output << " for writing." << std::endl;
+                    return 1;
+                }
+            }
+            else
+            {
+                console.emplace(environment.out);
+            }
+            llvm::raw_ostream &destination = file.has_value() ? static_cast<llvm::raw_ostream &>(*file) : *console;
+
+            std::filesystem::path entry;
+            std::optional<llvm::raw_fd_ostream> cached;
+            if (artifacts.has_value())
+            {
+                entry = artifacts->begin(key);
+                cached.emplace(entry.string(), error, llvm::sys::fs::OF_None);
+                if (error)
+                {
+                    // Not being able to cache is only a miss next time.
+                    cached->clear_error();
+                    cached.reset();
+                }
+            }
+
+            std::string errors;
+            {
+                std::optional<TeeStream> tee;
+                if (cached.has_value())
+                {
+                    tee.emplace(destination, *cached);
+                }
+                llvm::raw_ostream &out = tee.has_value() ? static_cast<llvm::raw_ostream &>(*tee) : destination;
+
+                try
+                {
+                    if (options.stream)
+                    {
+                        errors = anchor::compileStreamingToIR(unit, out, options.optimizationLevel);
+                    }
+                    else
+                    {
+                        errors = options.emit == anchor::Emit::LLVM_IR ? anchor::compileToIR(unit, out, options.optimizationLevel, options.codegenThreads) : anchor::compileToBitcode(unit, out, options.optimizationLevel, options.codegenThreads);
+                    }
+                }
+                catch (...)
+                {
+                    if (cached.has_value())
+                    {
+                        close(*cached);
+                        std::filesystem::remove(entry, error);
+                    }
+                    throw;
+                }
+                // IR on standard output has always ended in a newline.
+                if (!unit.hasErrors() && options.emit == anchor::Emit::LLVM_IR && options.output.empty())
+                {
+                    out << '\n';
+                }
+            }
+
+            bool cacheable = cached.has_value() && close(*cached) && !unit.hasErrors();
+            if (cacheable)
+            {
+                artifacts->commit(entry, key);
+            }
+            else if (cached.has_value())
+            {
+                std::filesystem::remove(entry, error);
+            }
+
+            if (unit.hasErrors() && options.emit == anchor::Emit::LLVM_IR && options.output.empty() && !options.stream)
+            {
+                // Diagnostics take the place of the IR, as they always have. Streamed
+                // IR may have been written in part already, so it fails instead.
+                destination << errors << '\n';
+                return 0;
+            }
+            if (unit.hasErrors())
+            {
+                if (file.has_value())
+                {
+                    close(*file);
+                    std::filesystem::remove(options.output, error);
+                }
+                report(unit, environment.err);
+                return 1;
+            }
+            if (file.has_value() && !close(*file))
+            {
+                environment.err << "Could not write " << options.output << "." << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+
+        int runRepl(const anchor::Options &options, driver::Environment &environment)
+        {
+            if (!environment.canRun)
+            {
+                environment.err << "Cannot run programs here, compile them instead.\n";
+                return 1;
+            }
+
+            try
+            {
+                jit::Jit jit(options.optimizationLevel);
+                repl::Repl repl(jit, options.optimizationLevel);
+                repl.run(environment.in, environment.out, environment.err, environment.interactive);
+                return 0;
+            }
+            catch (std::runtime_error &e)
+            {
+                environment.err << e.what() << '\n';
+                return 1;
+            }
+        }
+
+        // Compiles options.input, or standard input, as main always has.
+        int compileInput(const anchor::Options &options, driver::Environment &environment)
+        {
+            std::string input = "";
+            if (options.input.empty())
+            {
+                for (std::string line; std::getline(environment.in, line);)
+                {
+                    input += line + '\n';
+                }
+            }
+            else
+            {
+                if (!std::filesystem::exists(options.input))
+                {
+                    environment.out << "Could not find file with name " << options.input << std::endl;
+                    return 1;
+                }
+
+                std::error_code error;
+                std::uintmax_t size = std::filesystem::file_size(options.input, error);
+                std::ifstream t(options.input, std::ios::binary);
+                if (!error)
+                {
+                    input.resize(size);
+                }
+                if (error || !t || !t.read(input.data(), static_cast<std::streamsize>(input.size())))
+                {
+                    environment.out << "Could not read file " << options.input << std::endl;
+                    return 1;
+                }
+            }
+            // Imports in standard input resolve against the working directory.
+            std::filesystem::path importingFile = options.input.empty() && !environment.workingDirectory.empty() ? environment.workingDirectory / "-" : std::filesystem::path(options.input);
+
+            if (options.run)
+            {
+                if (!environment.canRun)
+                {
+                    environment.err << "Cannot run programs here, compile them instead.\n";
+                    return 1;
+                }
+
+                try
+                {
+                    anchor::CompilationUnit unit(std::move(input));
+                    std::optional<int> exitCode;
+                    if (options.tiered)
+                    {
+                        exitCode = anchor::runTiered(unit, tiering::defaultThreshold);
+                    }
+                    else if (options.lazy)
+                    {
+                        exitCode = anchor::runLazy(unit, options.optimizationLevel);
+                    }
+                    else if (options.backend == anchor::Backend::X86)
+                    {
+                        exitCode = anchor::runX86(unit);
+                    }
+                    else
+                    {
+                        exitCode = anchor::run(unit, options.optimizationLevel, options.codegenThreads);
+                    }
+                    report(unit, environment.err);
+                    return exitCode.value_or(1);
+                }
+                catch (std::runtime_error &e)
+                {
+                    environment.err << e.what() << '\n';
+                    return 1;
+                }
+                catch (std::invalid_argument &e)
+                {
+                    // A program the x86 backend cannot compile.
+                    environment.err << e.what() << '\n';
+                    return 1;
+                }
+            }
+
+            // A warm build is a hash of the source and a copy out of the cache.
+            std::optional<cache::Cache> artifacts = openCache(options);
+            modules::Importer importer(artifacts.has_value() ? &*artifacts : nullptr);
+            std::string key = artifacts.has_value() ? cache::key(importer.fingerprint(input, importingFile), options.optimizationLevel, artifactName(options)) : "";
+            if (artifacts.has_value() && options.output.empty())
+            {
+                if (std::optional<std::string> cached = artifacts->read(key))
+                {
+                    environment.out.write(cached->data(), static_cast<std::streamsize>(cached->size()));
+                    return 0;
+                }
+            }
+            else if (artifacts.has_value() && artifacts->fetch(key, options.output))
+            {
+                if (options.emit == anchor::Emit::EXECUTABLE)
+                {
+                    makeExecutable(options.output);
+                }
+                return 0;
+            }
+
+            std::optional<compiler::CompilerPool::Lease> lease;
+            if (environment.compilers != nullptr && options.codegenThreads == 0 && !options.stream)
+            {
+                lease.emplace(environment.compilers->acquire(options.optimizationLevel));
+            }
+            anchor::CompilationUnit unit(std::move(input));
+            unit.importer = importer.forFile(importingFile);
+            unit.compiler = lease.has_value() ? &lease->get() : nullptr;
+
+            if (options.emit == anchor::Emit::LLVM_IR || options.emit == anchor::Emit::BITCODE)
+            {
+                return writeModule(options, unit, artifacts, key, environment);
+            }
+
+            try
+            {
+                std::string errors;
+                if (options.stream)
+                {
+                    errors = anchor::compileStreamingToExecutable(unit, options.output, options.optimizationLevel, &importer);
+                }
+                else
+                {
+                    errors = options.emit == anchor::Emit::OBJECT ? anchor::compileToObject(unit, options.output, options.optimizationLevel, options.codegenThreads) : anchor::compileToExecutable(unit, options.output, options.optimizationLevel, options.codegenThreads, &importer);
+                }
+                if (!errors.empty())
+                {
+                    environment.err << errors;
+                    return 1;
+                }
+
+                if (artifacts.has_value())
+                {
+                    artifacts->storeFile(key, options.output);
+                }
+            }
+            catch (std::runtime_error &e)
+            {
+                environment.err << e.what() << '\n';
+                return 1;
+            }
+
+            return 0;
+        }
+
+        std::string batchOutput(const anchor::Options &options, const std::string &input)
+        {
+            std::string name = std::filesystem::path(input).stem().string();
+            switch (options.emit)
+            {
+            case anchor::Emit::LLVM_IR:
+                name += ".ll";
+                break;
+            case anchor::Emit::BITCODE:
+                name += ".bc";
+                break;
+            case anchor::Emit::OBJECT:
+                name += ".o";
+                break;
+            case anchor::Emit::EXECUTABLE:
+                break;
+            }
+            return (std::filesystem::path(options.output) / name).string();
+        }
+
+        // Compiles every input on options.jobs threads, each input as compileInput
+        // would on its own with a compiler of its own. What each one prints is held
+        // back and printed in the order the inputs were given.
+        int compileBatch(const anchor::Options &options, driver::Environment &environment)
+        {
+            std::map<std::string, std::string> outputs;
+            for (const std::string &input : options.inputs)
+            {
+                auto [existing, inserted] = outputs.emplace(batchOutput(options, input), input);
+                if (!inserted)
+                {
+                    environment.err << "Cannot compile both " << existing->second << " and " << input << " to " << existing->first << ".\n";
+                    return 1;
+                }
+            }
+
+            std::error_code error;
+            std::filesystem::create_directories(options.output, error);
+            if (error)
+            {
+                environment.err << "Could not create directory " << options.output << ": " << error.message() << '\n';
+                return 1;
+            }
+
+            class Result
+            {
+            public:
+                std::ostringstream out;
+                std::ostringstream err;
+                int exitCode = 0;
+            };
+            std::vector<Result> results(options.inputs.size());
+            std::atomic<std::size_t> next = 0;
+            auto work = [&]()
+            {
+                for (std::size_t i = next++; i < options.inputs.size(); i = next++)
+                {
+                    anchor::Options single = options;
+                    single.input = options.inputs[i];
+                    single.inputs = {options.inputs[i]};
+                    single.output = batchOutput(options, options.inputs[i]);
+                    single.jobs = 0;
+
+                    std::istringstream in;
+                    driver::Environment file(environment.workingDirectory, in, results[i].out, results[i].err);
+                    file.compilers = environment.compilers;
+                    try
+                    {
+                        results[i].exitCode = compileInput(single, file);
+                    }
+                    catch (std::exception &e)
+                    {
+                        results[i].err << e.what() << '\n';
+                        results[i].exitCode = 1;
+                    }
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for (unsigned i = 1; i < std::min<std::size_t>(options.jobs, options.inputs.size()); i++)
+            {
+                threads.emplace_back(work);
+            }
+            work();
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+
+            int exitCode = 0;
+            for (Result &result : results)
+            {
+                environment.out << result.out.str();
+                environment.err << result.err.str();
+                exitCode = std::max(exitCode, result.exitCode);
+            }
+            return exitCode;
+        }
+    }
+
+    Environment::Environment(std::filesystem::path workingDirectory, std::istream &in, std::ostream &out, std::ostream &err) : workingDirectory(std::move(workingDirectory)), in(in), out(out), err(err)
+    {
+    }
+
+    int run(int argc, const char *const argv[], driver::Environment &environment)
+    {
+        anchor::Options options;
+        try
+        {
+            options = anchor::parseOptions(argc, argv);
+        }
+        catch (std::invalid_argument &e)
+        {
+            environment.err << e.what() << '\n'
+                            << anchor::usage();
+            return 1;
+        }
+        for (std::string &input : options.inputs)
+        {
+            input = resolve(environment, input);
+        }
+        options.input = resolve(environment, options.input);
+        options.output = resolve(environment, options.output);
+        options.cacheDirectory = resolve(environment, options.cacheDirectory);
+
+        if (options.repl)
+        {
+            return runRepl(options, environment);
+        }
+        return options.jobs > 0 ? compileBatch(options, environment) : compileInput(options, environment);
+    }
+}
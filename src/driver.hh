@@ -0,0 +1,41 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <filesystem>
+#include <istream>
+#include <ostream>
+
+namespace compiler
+{
+    class CompilerPool;
+}
+
+namespace driver
+{
+    // Where a command line runs: the process itself for main, or a client of the
+    // compile server.
+    class Environment
+    {
+    public:
+        // Relative paths on the command line are resolved against it.
+        std::filesystem::path workingDirectory;
+        // Read for the source when no input file is given.
+        std::istream &in;
+        std::ostream &out;
+        std::ostream &err;
+        // Compilers to borrow instead of creating one per compile.
+        compiler::CompilerPool *compilers = nullptr;
+        // Running a program prints to this process's standard output, and a crash
+        // would take the process down with it, so a server refuses to.
+        bool canRun = true;
+        // Standard input is a terminal, so a REPL prompts for each line.
+        bool interactive = false;
+
+        Environment(std::filesystem::path workingDirectory, std::istream &in, std::ostream &out, std::ostream &err);
+    };
+
+    // Everything main does for a command line. Returns its exit code.
+    int run(int argc, const char *const argv[], driver::Environment &);
+}
+
+#endif // DRIVER_H
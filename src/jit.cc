@@ -0,0 +1,211 @@
+#include "src/jit.hh"
+
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/Mangling.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace jit
+{
+    namespace
+    {
+        template <typename T>
+        T unwrap(llvm::Expected<T> expected, const std::string &action)
+        {
+            if (!expected)
+            {
+                throw std::runtime_error("Could not " + action + ": " + llvm::toString(expected.takeError()));
+            }
+            return std::move(*expected);
+        }
+
+        void check(llvm::Error error, const std::string &action)
+        {
+            if (error)
+            {
+                throw std::runtime_error("Could not " + action + ": " + llvm::toString(std::move(error)));
+            }
+        }
+
+#if LLVM_VERSION_MAJOR >= 17
+        llvm::orc::ExecutorAddr toAddress(void *pointer)
+        {
+            return llvm::orc::ExecutorAddr::fromPtr(pointer);
+        }
+#else
+        llvm::JITTargetAddress toAddress(void *pointer)
+        {
+            return llvm::pointerToJITTargetAddress(pointer);
+        }
+#endif
+
+        // Called in place of a function that could not be compiled on its first call.
+        // The session has reported why already.
+        void failLazyCall()
+        {
+            std::fflush(stdout);
+            std::abort();
+        }
+
+        // Stands for the body of one function until something looks it up, usually a
+        // stub on its first call, then builds its module and compiles it.
+        class FunctionMaterializationUnit : public llvm::orc::MaterializationUnit
+        {
+        private:
+            llvm::orc::IRLayer &layer;
+            std::string name;
+            std::shared_ptr<const jit::Jit::Materialize> materializeModule;
+
+            void materialize(std::unique_ptr<llvm::orc::MaterializationResponsibility> responsibility) override
+            {
+                std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>> compiled;
+                try
+                {
+                    compiled = (*this->materializeModule)(this->name);
+                }
+                catch (std::exception &e)
+                {
+                    responsibility->getExecutionSession().reportError(llvm::make_error<llvm::StringError>("Could not compile " + this->name + ": " + e.what(), llvm::inconvertibleErrorCode()));
+                    responsibility->failMaterialization();
+                    return;
+                }
+
+                llvm::orc::ThreadSafeModule threadSafeModule(std::move(compiled.second), std::move(compiled.first));
+                this->layer.emit(std::move(responsibility), std::move(threadSafeModule));
+            }
+
+            void discard(const llvm::orc::JITDylib &, const llvm::orc::SymbolStringPtr &) override
+            {
+            }
+
+        public:
+            FunctionMaterializationUnit(llvm::orc::IRLayer &layer, llvm::orc::SymbolStringPtr symbol, std::string name, std::shared_ptr<const jit::Jit::Materialize> materializeModule)
+                : llvm::orc::MaterializationUnit(Interface(llvm::orc::SymbolFlagsMap{{std::move(symbol), llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable}}, nullptr)),
+                  layer(layer), name(std::move(name)), materializeModule(std::move(materializeModule))
+            {
+            }
+
+            llvm::StringRef getName() const override
+            {
+                return this->name;
+            }
+        };
+    }
+
+    Jit::Jit(compiler::OptimizationLevel optimizationLevel)
+    {
+        compiler::initializeNativeAsmPrinter();
+
+        auto targetMachineBuilder = unwrap(llvm::orc::JITTargetMachineBuilder::detectHost(), "detect host target");
+#if LLVM_VERSION_MAJOR >= 18
+        targetMachineBuilder.setCodeGenOptLevel(optimizationLevel == compiler::OptimizationLevel::O0 ? llvm::CodeGenOptLevel::None : llvm::CodeGenOptLevel::Default);
+#else
+        targetMachineBuilder.setCodeGenOptLevel(optimizationLevel == compiler::OptimizationLevel::O0 ? llvm::CodeGenOpt::None : llvm::CodeGenOpt::Default);
+#endif
+        this->lljit = unwrap(llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(std::move(targetMachineBuilder)).create(), "create JIT");
+
+        char globalPrefix = this->lljit->getDataLayout().getGlobalPrefix();
+        auto generator = unwrap(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(globalPrefix), "search host process for symbols");
+        this->lljit->getMainJITDylib().addGenerator(std::move(generator));
+    }
+
+    void Jit::add(std::unique_ptr<llvm::LLVMContext> context, std::unique_ptr<llvm::Module> module)
+    {
+        llvm::orc::ThreadSafeModule threadSafeModule(std::move(module), std::move(context));
+        check(this->lljit->addIRModule(std::move(threadSafeModule)), "add module to JIT");
+    }
+
+    void Jit::addLazy(const std::vector<std::string> &names, Materialize materialize)
+    {
+        llvm::orc::ExecutionSession &session = this->lljit->getExecutionSession();
+        llvm::orc::JITDylib &main = this->lljit->getMainJITDylib();
+        this->createStubs();
+        if (this->bodies == nullptr)
+        {
+            this->bodies = &session.createBareJITDylib("anchor.bodies");
+            this->bodies->setLinkOrder(llvm::orc::makeJITDylibSearchOrder({&main}), false);
+        }
+
+        // Each function gets a unit of its own. ORC splits a unit covering many
+        // symbols every time one of them is looked up, which costs a pass over the rest.
+        auto shared = std::make_shared<const Materialize>(std::move(materialize));
+        llvm::orc::MangleAndInterner mangle(session, this->lljit->getDataLayout());
+        llvm::JITSymbolFlags flags = llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+        for (const std::string &name : names)
+        {
+            llvm::orc::SymbolStringPtr symbol = mangle(name);
+            check(this->bodies->define(std::make_unique<FunctionMaterializationUnit>(this->lljit->getIRTransformLayer(), symbol, name, shared)), "define " + name);
+            llvm::orc::SymbolAliasMap alias{{symbol, llvm::orc::SymbolAliasMapEntry(symbol, flags)}};
+            check(main.define(llvm::orc::lazyReexports(*this->lazyCallThrough, *this->stubs, *this->bodies, std::move(alias))), "define stub for " + name);
+        }
+    }
+
+    void Jit::rebind(const std::string &name, const std::string &implementation)
+    {
+        void *address = this->lookup(implementation);
+        this->createStubs();
+        if (this->stubs->findStub(name, false).getAddress())
+        {
+            check(this->stubs->updatePointer(name, toAddress(address)), "rebind " + name);
+            return;
+        }
+
+        check(this->stubs->createStub(name, toAddress(address), llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable), "create stub for " + name);
+#if LLVM_VERSION_MAJOR >= 17
+        this->define(name, this->stubs->findStub(name, false).getAddress().toPtr<void *>());
+#else
+        this->define(name, llvm::jitTargetAddressToPointer<void *>(this->stubs->findStub(name, false).getAddress()));
+#endif
+    }
+
+    void Jit::createStubs()
+    {
+        if (this->stubs != nullptr)
+        {
+            return;
+        }
+
+        const llvm::Triple &triple = this->lljit->getTargetTriple();
+        this->lazyCallThrough = unwrap(llvm::orc::createLocalLazyCallThroughManager(triple, this->lljit->getExecutionSession(), toAddress(reinterpret_cast<void *>(&failLazyCall))), "create lazy call-through manager");
+        auto createStubs = llvm::orc::createLocalIndirectStubsManagerBuilder(triple);
+        if (!createStubs)
+        {
+            throw std::runtime_error("Could not create stubs for " + triple.str() + ".");
+        }
+        this->stubs = createStubs();
+    }
+
+    void Jit::define(const std::string &name, void *address)
+    {
+        llvm::orc::MangleAndInterner mangle(this->lljit->getExecutionSession(), this->lljit->getDataLayout());
+#if LLVM_VERSION_MAJOR >= 17
+        llvm::orc::ExecutorSymbolDef symbol(toAddress(address), llvm::JITSymbolFlags::Exported);
+#else
+        llvm::JITEvaluatedSymbol symbol(toAddress(address), llvm::JITSymbolFlags::Exported);
+#endif
+        check(this->lljit->getMainJITDylib().define(llvm::orc::absoluteSymbols({{mangle(name), symbol}})), "define " + name);
+    }
+
+    void *Jit::lookup(const std::string &name)
+    {
+        auto symbol = unwrap(this->lljit->lookup(name), "find " + name);
+#if LLVM_VERSION_MAJOR >= 15
+        return symbol.toPtr<void *>();
+#else
+        return reinterpret_cast<void *>(symbol.getAddress());
+#endif
+    }
+
+    int Jit::runMain()
+    {
+        auto main = reinterpret_cast<int (*)()>(this->lookup("main"));
+        int exitCode = main();
+        // The program printed through this process' stdio buffers.
+        std::fflush(stdout);
+        return exitCode;
+    }
+}
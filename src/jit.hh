@@ -0,0 +1,58 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "src/compiler.hh"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/LazyReexports.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+namespace jit
+{
+    // Compiles modules to native code in this process with ORC. Calls to libc
+    // (printf, malloc, ...) resolve to the host process' own symbols. Machine code
+    // is generated at the same level as the compiler that produced the modules.
+    class Jit
+    {
+    public:
+        // Builds the module defining the named function, and nothing else it exports.
+        using Materialize = std::function<std::pair<std::unique_ptr<llvm::LLVMContext>, std::unique_ptr<llvm::Module>>(const std::string &name)>;
+
+    private:
+        std::unique_ptr<llvm::orc::LLJIT> lljit;
+        // Created by the first addLazy or rebind. Lazy bodies live in a JITDylib of their own, so a
+        // body calls the others through their stubs and never pulls one in.
+        std::unique_ptr<llvm::orc::LazyCallThroughManager> lazyCallThrough;
+        std::unique_ptr<llvm::orc::IndirectStubsManager> stubs;
+        llvm::orc::JITDylib *bodies = nullptr;
+
+        void createStubs();
+
+    public:
+        explicit Jit(compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+
+        void add(std::unique_ptr<llvm::LLVMContext> context, std::unique_ptr<llvm::Module> module);
+        // Defines each name as a stub and compiles nothing. The first call through a
+        // stub builds the function's module with materialize, on the calling thread,
+        // compiles it and points the stub at it, so later calls cost an indirect jump.
+        void addLazy(const std::vector<std::string> &names, Materialize materialize);
+        // Points name at implementation, a function added already, through a stub
+        // created the first time name is bound. Code compiled before or after calls
+        // whatever name was bound to last, so a function is replaced without
+        // recompiling its callers.
+        void rebind(const std::string &name, const std::string &implementation);
+        // Binds a symbol to a host function, taking precedence over the process' own definition.
+        void define(const std::string& name, void* address);
+        void* lookup(const std::string& name);
+        int runMain();
+    };
+}
+
+#endif // JIT_H
@@ -0,0 +1,564 @@
+#include "json.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace json
+{
+    Value::Value() : type(ValueType::NUL)
+    {
+    }
+
+    Value::Value(std::nullptr_t) : type(ValueType::NUL)
+    {
+    }
+
+    Value::Value(bool boolean) : type(ValueType::BOOLEAN), boolean(boolean)
+    {
+    }
+
+    Value::Value(int number) : type(ValueType::NUMBER), number(number)
+    {
+    }
+
+    Value::Value(double number) : type(ValueType::NUMBER), number(number)
+    {
+    }
+
+    Value::Value(const char *string) : type(ValueType::STRING), string(string)
+    {
+    }
+
+    Value::Value(std::string string) : type(ValueType::STRING), string(std::move(string))
+    {
+    }
+
+    Value::Value(std::vector<json::Value> array) : type(ValueType::ARRAY), array(std::move(array))
+    {
+    }
+
+    Value::Value(std::map<std::string, json::Value> object) : type(ValueType::OBJECT), object(std::move(object))
+    {
+    }
+
+    json::Value Value::makeObject()
+    {
+        return json::Value(std::map<std::string, json::Value>());
+    }
+
+    json::Value Value::makeArray()
+    {
+        return json::Value(std::vector<json::Value>());
+    }
+
+    json::ValueType Value::getType() const
+    {
+        return this->type;
+    }
+
+    bool Value::isNull() const
+    {
+        return this->type == ValueType::NUL;
+    }
+
+    bool Value::isNumber() const
+    {
+        return this->type == ValueType::NUMBER;
+    }
+
+    bool Value::isString() const
+    {
+        return this->type == ValueType::STRING;
+    }
+
+    bool Value::isObject() const
+    {
+        return this->type == ValueType::OBJECT;
+    }
+
+    bool Value::asBoolean() const
+    {
+        if (this->type != ValueType::BOOLEAN)
+        {
+            throw std::invalid_argument("JSON value is not a boolean.");
+        }
+        return this->boolean;
+    }
+
+    double Value::asNumber() const
+    {
+        if (this->type != ValueType::NUMBER)
+        {
+            throw std::invalid_argument("JSON value is not a number.");
+        }
+        return this->number;
+    }
+
+    int Value::asInteger() const
+    {
+        return static_cast<int>(this->asNumber());
+    }
+
+    const std::string &Value::asString() const
+    {
+        if (this->type != ValueType::STRING)
+        {
+            throw std::invalid_argument("JSON value is not a string.");
+        }
+        return this->string;
+    }
+
+    const std::vector<json::Value> &Value::asArray() const
+    {
+        if (this->type != ValueType::ARRAY)
+        {
+            throw std::invalid_argument("JSON value is not an array.");
+        }
+        return this->array;
+    }
+
+    const std::map<std::string, json::Value> &Value::asObject() const
+    {
+        if (this->type != ValueType::OBJECT)
+        {
+            throw std::invalid_argument("JSON value is not an object.");
+        }
+        return this->object;
+    }
+
+    bool Value::contains(const std::string &key) const
+    {
+        return this->type == ValueType::OBJECT && this->object.contains(key);
+    }
+
+    const json::Value &Value::operator[](const std::string &key) const
+    {
+        static const json::Value null;
+        if (!this->contains(key))
+        {
+            return null;
+        }
+        return this->object.at(key);
+    }
+
+    json::Value &Value::operator[](const std::string &key)
+    {
+        if (this->type == ValueType::NUL)
+        {
+            this->type = ValueType::OBJECT;
+        }
+        if (this->type != ValueType::OBJECT)
+        {
+            throw std::invalid_argument("Cannot index into JSON value that is not an object with key [" + key + "].");
+        }
+        return this->object[key];
+    }
+
+    void Value::push_back(json::Value value)
+    {
+        if (this->type == ValueType::NUL)
+        {
+            this->type = ValueType::ARRAY;
+        }
+        if (this->type != ValueType::ARRAY)
+        {
+            throw std::invalid_argument("Cannot append to JSON value that is not an array.");
+        }
+        this->array.push_back(std::move(value));
+    }
+
+    static void dumpString(const std::string &string, std::string &out)
+    {
+        out += '"';
+        for (const char c : string)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            case '\b':
+                out += "\\b";
+                break;
+            case '\f':
+                out += "\\f";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[7];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        out += '"';
+    }
+
+    static void dump(const json::Value &value, std::string &out)
+    {
+        using enum json::ValueType;
+        if (value.getType() == NUL)
+        {
+            out += "null";
+        }
+        else if (value.getType() == BOOLEAN)
+        {
+            out += value.asBoolean() ? "true" : "false";
+        }
+        else if (value.getType() == NUMBER)
+        {
+            double number = value.asNumber();
+            if (std::floor(number) == number && std::fabs(number) < 1e15)
+            {
+                out += std::to_string(static_cast<long long>(number));
+            }
+            else
+            {
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%.17g", number);
+                out += buffer;
+            }
+        }
+        else if (value.getType() == STRING)
+        {
+            dumpString(value.asString(), out);
+        }
+        else if (value.getType() == ARRAY)
+        {
+            out += '[';
+            bool first = true;
+            for (const auto &element : value.asArray())
+            {
+                if (!first)
+                {
+                    out += ',';
+                }
+                first = false;
+                dump(element, out);
+            }
+            out += ']';
+        }
+        else if (value.getType() == OBJECT)
+        {
+            out += '{';
+            bool first = true;
+            for (const auto &[key, element] : value.asObject())
+            {
+                if (!first)
+                {
+                    out += ',';
+                }
+                first = false;
+                dumpString(key, out);
+                out += ':';
+                dump(element, out);
+            }
+            out += '}';
+        }
+    }
+
+    std::string Value::dump() const
+    {
+        std::string out;
+        json::dump(*this, out);
+        return out;
+    }
+
+    bool Value::operator==(const json::Value &that) const
+    {
+        return this->type == that.type &&
+               this->boolean == that.boolean &&
+               this->number == that.number &&
+               this->string == that.string &&
+               this->array == that.array &&
+               this->object == that.object;
+    }
+
+    ParseException::ParseException(const std::string &message, std::size_t position)
+        : std::invalid_argument(message + " at position " + std::to_string(position) + "."), position(position)
+    {
+    }
+
+    class Reader
+    {
+    private:
+        const std::string &source;
+        std::size_t position = 0;
+
+        char peek() const
+        {
+            return this->position < this->source.length() ? this->source[this->position] : '\0';
+        }
+
+        void skipWhitespace()
+        {
+            while (this->peek() == ' ' || this->peek() == '\n' || this->peek() == '\r' || this->peek() == '\t')
+            {
+                this->position++;
+            }
+        }
+
+        void expect(const std::string &literal)
+        {
+            if (this->source.compare(this->position, literal.length(), literal) != 0)
+            {
+                throw json::ParseException("Expected \"" + literal + "\"", this->position);
+            }
+            this->position += literal.length();
+        }
+
+        static void appendUtf8(unsigned int codePoint, std::string &out)
+        {
+            if (codePoint < 0x80)
+            {
+                out += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        unsigned int readHex4()
+        {
+            if (this->position + 4 > this->source.length())
+            {
+                throw json::ParseException("Truncated unicode escape", this->position);
+            }
+            unsigned int codeUnit = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = this->source[this->position++];
+                codeUnit <<= 4;
+                if (c >= '0' && c <= '9')
+                {
+                    codeUnit |= c - '0';
+                }
+                else if (c >= 'a' && c <= 'f')
+                {
+                    codeUnit |= c - 'a' + 10;
+                }
+                else if (c >= 'A' && c <= 'F')
+                {
+                    codeUnit |= c - 'A' + 10;
+                }
+                else
+                {
+                    throw json::ParseException("Invalid unicode escape", this->position - 1);
+                }
+            }
+            return codeUnit;
+        }
+
+        std::string readString()
+        {
+            this->expect("\"");
+            std::string out;
+            while (true)
+            {
+                if (this->position >= this->source.length())
+                {
+                    throw json::ParseException("Unterminated string", this->position);
+                }
+
+                char c = this->source[this->position++];
+                if (c == '"')
+                {
+                    return out;
+                }
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+
+                char escaped = this->peek();
+                this->position++;
+                switch (escaped)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    out += escaped;
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'u':
+                {
+                    unsigned int codePoint = this->readHex4();
+                    if (codePoint >= 0xD800 && codePoint <= 0xDBFF && this->source.compare(this->position, 2, "\\u") == 0)
+                    {
+                        this->position += 2;
+                        unsigned int low = this->readHex4();
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(codePoint, out);
+                    break;
+                }
+                default:
+                    throw json::ParseException("Invalid escape sequence", this->position - 1);
+                }
+            }
+        }
+
+        json::Value readNumber()
+        {
+            const char *begin = this->source.c_str() + this->position;
+            char *end = nullptr;
+            double number = std::strtod(begin, &end);
+            if (end == begin)
+            {
+                throw json::ParseException("Invalid number", this->position);
+            }
+            this->position += end - begin;
+            return json::Value(number);
+        }
+
+    public:
+        explicit Reader(const std::string &source) : source(source)
+        {
+        }
+
+        json::Value readValue()
+        {
+            this->skipWhitespace();
+            char c = this->peek();
+            if (c == '{')
+            {
+                this->position++;
+                json::Value object = json::Value::makeObject();
+                this->skipWhitespace();
+                if (this->peek() == '}')
+                {
+                    this->position++;
+                    return object;
+                }
+                while (true)
+                {
+                    this->skipWhitespace();
+                    std::string key = this->readString();
+                    this->skipWhitespace();
+                    this->expect(":");
+                    object[key] = this->readValue();
+                    this->skipWhitespace();
+                    if (this->peek() == ',')
+                    {
+                        this->position++;
+                        continue;
+                    }
+                    this->expect("}");
+                    return object;
+                }
+            }
+            else if (c == '[')
+            {
+                this->position++;
+                json::Value array = json::Value::makeArray();
+                this->skipWhitespace();
+                if (this->peek() == ']')
+                {
+                    this->position++;
+                    return array;
+                }
+                while (true)
+                {
+                    array.push_back(this->readValue());
+                    this->skipWhitespace();
+                    if (this->peek() == ',')
+                    {
+                        this->position++;
+                        continue;
+                    }
+                    this->expect("]");
+                    return array;
+                }
+            }
+            else if (c == '"')
+            {
+                return json::Value(this->readString());
+            }
+            else if (c == 't')
+            {
+                this->expect("true");
+                return json::Value(true);
+            }
+            else if (c == 'f')
+            {
+                this->expect("false");
+                return json::Value(false);
+            }
+            else if (c == 'n')
+            {
+                this->expect("null");
+                return json::Value();
+            }
+            else if (c == '-' || (c >= '0' && c <= '9'))
+            {
+                return this->readNumber();
+            }
+            throw json::ParseException("Unexpected character", this->position);
+        }
+
+        void expectEnd()
+        {
+            this->skipWhitespace();
+            if (this->position != this->source.length())
+            {
+                throw json::ParseException("Trailing characters", this->position);
+            }
+        }
+    };
+
+    json::Value parse(const std::string &source)
+    {
+        json::Reader reader(source);
+        json::Value value = reader.readValue();
+        reader.expectEnd();
+        return value;
+    }
+}
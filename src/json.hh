@@ -0,0 +1,78 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace json
+{
+    enum class ValueType
+    {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT
+    };
+
+    class Value
+    {
+    private:
+        json::ValueType type;
+        bool boolean = false;
+        double number = 0;
+        std::string string;
+        std::vector<json::Value> array;
+        std::map<std::string, json::Value> object;
+
+    public:
+        Value();
+        Value(std::nullptr_t);
+        Value(bool);
+        Value(int);
+        Value(double);
+        Value(const char*);
+        Value(std::string);
+        Value(std::vector<json::Value>);
+        Value(std::map<std::string, json::Value>);
+
+        static json::Value makeObject();
+        static json::Value makeArray();
+
+        json::ValueType getType() const;
+        bool isNull() const;
+        bool isNumber() const;
+        bool isString() const;
+        bool isObject() const;
+
+        bool asBoolean() const;
+        double asNumber() const;
+        int asInteger() const;
+        const std::string& asString() const;
+        const std::vector<json::Value>& asArray() const;
+        const std::map<std::string, json::Value>& asObject() const;
+
+        bool contains(const std::string&) const;
+        const json::Value& operator[](const std::string&) const;
+        json::Value& operator[](const std::string&);
+        void push_back(json::Value);
+
+        std::string dump() const;
+        bool operator==(const json::Value&) const;
+    };
+
+    class ParseException : public std::invalid_argument
+    {
+    public:
+        std::size_t position;
+        ParseException(const std::string& message, std::size_t position);
+    };
+
+    json::Value parse(const std::string&);
+}
+
+#endif // JSON_H
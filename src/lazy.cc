@@ -0,0 +1,45 @@
+#include "src/lazy.hh"
+
+namespace lazy
+{
+    LazyJit::LazyJit(jit::Jit &jit, const parser::Program &program, compiler::OptimizationLevel optimizationLevel) : jit(jit), optimizationLevel(optimizationLevel)
+    {
+        std::vector<std::string> names;
+        for (const auto &stmt : program.stmts)
+        {
+            if (stmt->type == parser::StmtType::FUNCTION)
+            {
+                auto functionStmt = std::static_pointer_cast<parser::FunctionStmt>(stmt);
+                this->functions.emplace(functionStmt->identifier, functionStmt);
+                names.push_back(functionStmt->identifier);
+            }
+            else if (stmt->type == parser::StmtType::IMPORT)
+            {
+                // Imported functions are declared like any other defined elsewhere.
+                for (const auto &declaration : std::static_pointer_cast<parser::ImportStmt>(stmt)->declarations)
+                {
+                    this->functions.emplace(declaration->identifier, declaration);
+                }
+            }
+        }
+
+        this->jit.addLazy(names, [this](const std::string &name)
+                          {
+                              compiler::Compiler compiler(this->optimizationLevel);
+                              compiler.declareElsewhere(this->functions);
+                              compiler.compileNext(this->functions.at(name));
+                              compiler.finish();
+                              this->compiled.push_back(name);
+                              return compiler.release(); });
+    }
+
+    int LazyJit::runMain()
+    {
+        return this->jit.runMain();
+    }
+
+    std::vector<std::string> LazyJit::getCompiled() const
+    {
+        return this->compiled;
+    }
+}
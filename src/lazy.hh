@@ -0,0 +1,42 @@
+#ifndef LAZY_H
+#define LAZY_H
+
+#include <string>
+#include <vector>
+
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/parser.hh"
+
+namespace lazy
+{
+    // Runs a program with each function compiled from its tree the first time it is
+    // called, into a module of its own, through jit::Jit::addLazy. Nothing is
+    // compiled up front, so the time to first output follows the code the program
+    // runs rather than its size, and functions it never calls are never compiled.
+    //
+    // A function only knows the others by their signatures and calls them through
+    // stubs, so calls between functions are never inlined, whatever the level.
+    class LazyJit
+    {
+    private:
+        jit::Jit &jit;
+        compiler::OptimizationLevel optimizationLevel;
+        compiler::Signatures functions;
+        std::vector<std::string> compiled;
+
+    public:
+        // Functions are compiled as the program calls them, so the LazyJit must
+        // outlive every call into the JIT.
+        LazyJit(jit::Jit &jit, const parser::Program &program, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+
+        LazyJit(const LazyJit &) = delete;
+        LazyJit &operator=(const LazyJit &) = delete;
+
+        int runMain();
+        // The functions compiled so far, in the order they were first called.
+        std::vector<std::string> getCompiled() const;
+    };
+}
+
+#endif // LAZY_H
@@ -39,9 +39,10 @@ bool lexer::Location::operator!=(const Location &that) const
 
 std::string lexer::tostring(lexer::TokenType tokenType)
 {
-    static std::map<lexer::TokenType, std::string> map;
-    if (map.empty())
+    // Built once, before any caller sees it, so threads may look names up concurrently.
+    static const std::map<lexer::TokenType, std::string> map = []()
     {
+        std::map<lexer::TokenType, std::string> map;
         map[lexer::TokenType::INTEGER_TYPE] = "INTEGER_TYPE";
         map[lexer::TokenType::INTEGER] = "INTEGER";
         map[lexer::TokenType::IDENTIFIER] = "IDENTIFIER";
@@ -59,13 +60,32 @@ std::string lexer::tostring(lexer::TokenType tokenType)
         map[lexer::TokenType::RETURN] = "RETURN";
         map[lexer::TokenType::PRINT] = "PRINT";
         map[lexer::TokenType::STRING] = "STRING";
-    }
+        map[lexer::TokenType::BOOLEAN_TYPE] = "BOOLEAN_TYPE";
+        map[lexer::TokenType::STRING_TYPE] = "STRING_TYPE";
+        map[lexer::TokenType::VOID_TYPE] = "VOID_TYPE";
+        map[lexer::TokenType::LESS_THAN_SIGN] = "LESS_THAN_SIGN";
+        map[lexer::TokenType::GREATER_THAN_SIGN] = "GREATER_THAN_SIGN";
+        map[lexer::TokenType::DOUBLE_EQUALS] = "DOUBLE_EQUALS";
+        map[lexer::TokenType::END_OF_STREAM] = "END_OF_STREAM";
+        map[lexer::TokenType::TRUE] = "TRUE";
+        map[lexer::TokenType::FALSE] = "FALSE";
+        map[lexer::TokenType::IF] = "IF";
+        map[lexer::TokenType::WHILE] = "WHILE";
+        map[lexer::TokenType::IMPORT] = "IMPORT";
+        return map;
+    }();
+
+    auto name = map.find(tokenType);
+    return name != map.end() ? name->second : "";
+}
 
-    return map[tokenType];
+lexer::InvalidTokenException::InvalidTokenException(const std::string &message, const lexer::Location &location)
+    : std::invalid_argument(message), location(location)
+{
 }
 
 lexer::Token::Token(TokenType tokenType, std::string raw, Location start, Location end)
-    : tokenType(tokenType), raw(raw), start(start), end(end)
+    : tokenType(tokenType), raw(std::move(raw)), start(start), end(end)
 {
 }
 
@@ -74,7 +94,7 @@ lexer::TokenType lexer::Token::getTokenType() const
     return this->tokenType;
 }
 
-std::string lexer::Token::getRaw() const
+const std::string &lexer::Token::getRaw() const
 {
     return this->raw;
 }
@@ -97,7 +117,7 @@ bool lexer::Token::operator==(const Token &that) const
            this->end == that.end;
 }
 
-lexer::Lexer::Lexer(std::string source)
+lexer::Lexer::Lexer(std::string_view source)
 {
     this->position = 0;
     this->currentLine = 1;
@@ -195,7 +215,7 @@ lexer::Token lexer::Lexer::next()
             lexer::Location(this->currentLine, this->currentColumn - 1));
     }
 
-    throw std::invalid_argument("Lexer could not parse character at " + std::to_string(this->position));
+    throw lexer::InvalidTokenException("Lexer could not parse character at " + std::to_string(this->position), lexer::Location(this->currentLine, this->currentColumn));
 }
 
 lexer::Token lexer::Lexer::parseEquals()
@@ -248,7 +268,7 @@ lexer::Token lexer::Lexer::parseSingleCharacterTokenType(lexer::TokenType tokenT
 
     return lexer::Token(
         tokenType,
-        raw,
+        std::move(raw),
         start,
         lexer::Location(this->currentLine, this->currentColumn - 1));
 }
@@ -266,7 +286,7 @@ lexer::Token lexer::Lexer::parseNumber()
     lexer::Location end(this->currentLine, this->currentColumn - 1);
     return lexer::Token(
         lexer::TokenType::INTEGER,
-        raw,
+        std::move(raw),
         start,
         end);
 }
@@ -278,6 +298,10 @@ lexer::Token lexer::Lexer::parseRawStringLiteral()
     std::string raw(1, this->popChar());
     while (this->peekChar() != '"')
     {
+        if (static_cast<std::size_t>(this->position) >= this->source.length())
+        {
+            throw lexer::InvalidTokenException("Unterminated string literal at line " + std::to_string(start.getRow()) + ", column " + std::to_string(start.getColumn()) + ".", start);
+        }
         raw += this->popChar();
     }
     // should be a ""
@@ -286,7 +310,7 @@ lexer::Token lexer::Lexer::parseRawStringLiteral()
     lexer::Location end(this->currentLine, this->currentColumn - 1);
     return lexer::Token(
         lexer::TokenType::STRING,
-        raw,
+        std::move(raw),
         start,
         end);
 }
@@ -304,55 +328,59 @@ lexer::Token lexer::Lexer::parseKeywordOrIdentifier()
     lexer::Location end(this->currentLine, this->currentColumn - 1);
     if ("val" == raw)
     {
-        return lexer::Token(lexer::TokenType::VAL, raw, start, end);
+        return lexer::Token(lexer::TokenType::VAL, std::move(raw), start, end);
     }
     else if ("return" == raw)
     {
-        return lexer::Token(lexer::TokenType::RETURN, raw, start, end);
+        return lexer::Token(lexer::TokenType::RETURN, std::move(raw), start, end);
     }
     else if ("function" == raw)
     {
-        return lexer::Token(lexer::TokenType::FUNCTION, raw, start, end);
+        return lexer::Token(lexer::TokenType::FUNCTION, std::move(raw), start, end);
     }
     else if ("print" == raw)
     {
-        return lexer::Token(lexer::TokenType::PRINT, raw, start, end);
+        return lexer::Token(lexer::TokenType::PRINT, std::move(raw), start, end);
     }
     else if ("integer" == raw)
     {
-        return lexer::Token(lexer::TokenType::INTEGER_TYPE, raw, start, end);
+        return lexer::Token(lexer::TokenType::INTEGER_TYPE, std::move(raw), start, end);
     }
     else if ("boolean" == raw)
     {
-        return lexer::Token(lexer::TokenType::BOOLEAN_TYPE, raw, start, end);
+        return lexer::Token(lexer::TokenType::BOOLEAN_TYPE, std::move(raw), start, end);
     }
     else if ("string" == raw)
     {
-        return lexer::Token(lexer::TokenType::STRING_TYPE, raw, start, end);
+        return lexer::Token(lexer::TokenType::STRING_TYPE, std::move(raw), start, end);
     }
     else if ("void" == raw)
     {
-        return lexer::Token(lexer::TokenType::VOID_TYPE, raw, start, end);
+        return lexer::Token(lexer::TokenType::VOID_TYPE, std::move(raw), start, end);
     }
     else if ("true" == raw)
     {
-        return lexer::Token(lexer::TokenType::TRUE, raw, start, end);
+        return lexer::Token(lexer::TokenType::TRUE, std::move(raw), start, end);
     }
     else if ("false" == raw)
     {
-        return lexer::Token(lexer::TokenType::FALSE, raw, start, end);
+        return lexer::Token(lexer::TokenType::FALSE, std::move(raw), start, end);
     }
     else if ("if" == raw)
     {
-        return lexer::Token(lexer::TokenType::IF, raw, start, end);
+        return lexer::Token(lexer::TokenType::IF, std::move(raw), start, end);
     }
     else if ("while" == raw)
     {
-        return lexer::Token(lexer::TokenType::WHILE, raw, start, end);
+        return lexer::Token(lexer::TokenType::WHILE, std::move(raw), start, end);
+    }
+    else if ("import" == raw)
+    {
+        return lexer::Token(lexer::TokenType::IMPORT, std::move(raw), start, end);
     }
     else
     {
-        return lexer::Token(lexer::TokenType::IDENTIFIER, raw, start, end);
+        return lexer::Token(lexer::TokenType::IDENTIFIER, std::move(raw), start, end);
     }
 }
 
@@ -366,6 +394,10 @@ char lexer::Lexer::popChar()
 
 char lexer::Lexer::peekChar()
 {
+    if (static_cast<std::size_t>(this->position) >= this->source.length())
+    {
+        return '\0';
+    }
     return this->source[this->position];
 }
 
@@ -390,9 +422,9 @@ namespace lexer
         return lengthIncludingNullTerminator != this->position;
     }
 
-    std::deque<Token> lex(std::string a)
+    std::deque<Token> lex(std::string_view source)
     {
-        lexer::Lexer lexer(a);
+        lexer::Lexer lexer(source);
         std::deque<Token> tokens;
         while (lexer.hasNext())
         {
@@ -2,17 +2,19 @@
 #define LEXER_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <deque>
+#include <stdexcept>
 
 namespace lexer
 {
     class Location
     {
     private:
-        const int row;
-        const int column;
+        int row;
+        int column;
 
     public:
         Location(int, int);
@@ -53,23 +55,32 @@ namespace lexer
         TRUE,
         FALSE,
         IF,
-        WHILE
+        WHILE,
+        IMPORT
     };
 
     std::string tostring(lexer::TokenType tokenType);
 
+    class InvalidTokenException : public std::invalid_argument
+    {
+    public:
+        lexer::Location location;
+
+        InvalidTokenException(const std::string& message, const lexer::Location& location);
+    };
+
     class Token
     {
     private:
-        const lexer::TokenType tokenType;
-        const std::string raw;
-        const lexer::Location start;
-        const lexer::Location end;
+        lexer::TokenType tokenType;
+        std::string raw;
+        lexer::Location start;
+        lexer::Location end;
 
     public:
         Token(TokenType tokenType, std::string raw, Location start, Location end);
         lexer::TokenType getTokenType() const;
-        std::string getRaw() const;
+        const std::string& getRaw() const;
         lexer::Location getStart() const;
         lexer::Location getEnd() const;
 
@@ -82,7 +93,7 @@ namespace lexer
         int position;
         int currentLine;
         int currentColumn;
-        std::string source;
+        std::string_view source;
 
         void chewUpWhitespace();
 
@@ -101,12 +112,13 @@ namespace lexer
         char peekChar();
 
     public:
-        Lexer(std::string);
+        // The source is borrowed, not copied, and must outlive the lexer.
+        explicit Lexer(std::string_view);
         lexer::Token next();
         bool hasNext();
     };
 
-    std::deque<lexer::Token> lex(std::string);
+    std::deque<lexer::Token> lex(std::string_view);
 }
 
 
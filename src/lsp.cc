@@ -0,0 +1,344 @@
+#include "src/lsp.hh"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+
+namespace lsp
+{
+    namespace ErrorCode
+    {
+        constexpr int PARSE_ERROR = -32700;
+        constexpr int INVALID_REQUEST = -32600;
+        constexpr int METHOD_NOT_FOUND = -32601;
+        constexpr int INVALID_PARAMS = -32602;
+    }
+
+    // Positions are treated as byte offsets into the line. Anchor sources are ASCII,
+    // so this matches the UTF-16 code units the protocol specifies.
+    static std::size_t toOffset(const std::string &text, const json::Value &position)
+    {
+        int line = position["line"].asInteger();
+        int character = position["character"].asInteger();
+
+        std::size_t offset = 0;
+        for (int i = 0; i < line; i++)
+        {
+            std::size_t newline = text.find('\n', offset);
+            if (newline == std::string::npos)
+            {
+                return text.length();
+            }
+            offset = newline + 1;
+        }
+
+        std::size_t endOfLine = text.find('\n', offset);
+        if (endOfLine == std::string::npos)
+        {
+            endOfLine = text.length();
+        }
+        return std::min(offset + static_cast<std::size_t>(character), endOfLine);
+    }
+
+    void Document::applyChange(const json::Value &change)
+    {
+        if (!change.contains("range"))
+        {
+            this->unit.source = change["text"].asString();
+            return;
+        }
+
+        const json::Value &range = change["range"];
+        std::size_t start = toOffset(this->unit.source, range["start"]);
+        std::size_t end = toOffset(this->unit.source, range["end"]);
+        if (end < start)
+        {
+            throw std::invalid_argument("Cannot apply change where range end is before range start.");
+        }
+        this->unit.source.replace(start, end - start, change["text"].asString());
+    }
+
+    void Document::analyze()
+    {
+        this->unit.diagnostics.clear();
+        anchor::lex(this->unit);
+        anchor::parse(this->unit);
+    }
+
+    std::optional<std::string> readMessage(std::istream &in)
+    {
+        // Anything bigger is not a document an editor would send.
+        constexpr std::size_t maxContentLength = 64 * 1024 * 1024;
+
+        std::size_t contentLength = 0;
+        bool sawContentLength = false;
+
+        std::string header;
+        while (std::getline(in, header))
+        {
+            if (!header.empty() && header.back() == '\r')
+            {
+                header.pop_back();
+            }
+
+            if (header.empty())
+            {
+                if (!sawContentLength)
+                {
+                    continue;
+                }
+                sawContentLength = false;
+
+                if (contentLength > maxContentLength)
+                {
+                    // Skip the content without holding it, and read the next message.
+                    in.ignore(static_cast<std::streamsize>(std::min<std::size_t>(contentLength, std::numeric_limits<std::streamsize>::max())));
+                    continue;
+                }
+
+                std::string content(contentLength, '\0');
+                in.read(content.data(), static_cast<std::streamsize>(contentLength));
+                if (static_cast<std::size_t>(in.gcount()) != contentLength)
+                {
+                    return std::nullopt;
+                }
+                return content;
+            }
+
+            const std::string contentLengthHeader = "Content-Length:";
+            // After a message that was skipped for a bad length, the next header
+            // follows its content on the same line.
+            std::size_t name = header.find(contentLengthHeader);
+            if (name != std::string::npos)
+            {
+                // A value that is not a number leaves the header unseen.
+                std::size_t start = header.find_first_not_of(" \t", name + contentLengthHeader.length());
+                const char *first = header.data() + std::min(start, header.length());
+                const char *last = header.data() + header.length();
+                auto [end, error] = std::from_chars(first, last, contentLength);
+                sawContentLength = error == std::errc() && end == last;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void writeMessage(std::ostream &out, const std::string &content)
+    {
+        out << "Content-Length: " << content.length() << "\r\n\r\n"
+            << content;
+        out.flush();
+    }
+
+    Server::Server(std::ostream &out) : out(out)
+    {
+    }
+
+    void Server::handle(const std::string &message)
+    {
+        json::Value parsed;
+        try
+        {
+            parsed = json::parse(message);
+        }
+        catch (json::ParseException &pe)
+        {
+            this->respondError(json::Value(), ErrorCode::PARSE_ERROR, pe.what());
+            return;
+        }
+
+        const json::Value &request = parsed;
+        if (!request.isObject() || !request["method"].isString())
+        {
+            this->respondError(request["id"], ErrorCode::INVALID_REQUEST, "Message did not contain a method.");
+            return;
+        }
+
+        const json::Value &id = request["id"];
+        try
+        {
+            this->dispatch(request["method"].asString(), id, request["params"]);
+        }
+        catch (std::invalid_argument &e)
+        {
+            if (request.contains("id"))
+            {
+                this->respondError(id, ErrorCode::INVALID_PARAMS, e.what());
+            }
+        }
+    }
+
+    void Server::dispatch(const std::string &method, const json::Value &id, const json::Value &params)
+    {
+        const bool isRequest = !id.isNull();
+
+        if (method == "exit")
+        {
+            this->exited = true;
+            return;
+        }
+
+        if (this->shutdownRequested && isRequest)
+        {
+            this->respondError(id, ErrorCode::INVALID_REQUEST, "Server is shutting down.");
+            return;
+        }
+
+        if (method == "initialize")
+        {
+            this->respond(id, this->initialize());
+        }
+        else if (method == "shutdown")
+        {
+            this->shutdownRequested = true;
+            this->respond(id, json::Value());
+        }
+        else if (method == "textDocument/didOpen")
+        {
+            this->didOpen(params);
+        }
+        else if (method == "textDocument/didChange")
+        {
+            this->didChange(params);
+        }
+        else if (method == "textDocument/didClose")
+        {
+            this->didClose(params);
+        }
+        else if (isRequest)
+        {
+            this->respondError(id, ErrorCode::METHOD_NOT_FOUND, "Unsupported method " + method + ".");
+        }
+    }
+
+    json::Value Server::initialize()
+    {
+        json::Value textDocumentSync = json::Value::makeObject();
+        textDocumentSync["openClose"] = true;
+        // Incremental, so editors only send the edited range on every keystroke.
+        textDocumentSync["change"] = 2;
+
+        json::Value result = json::Value::makeObject();
+        result["capabilities"]["textDocumentSync"] = textDocumentSync;
+        result["serverInfo"]["name"] = "anchor-lsp";
+        return result;
+    }
+
+    void Server::didOpen(const json::Value &params)
+    {
+        const json::Value &textDocument = params["textDocument"];
+
+        lsp::Document &document = this->documents[textDocument["uri"].asString()];
+        document.uri = textDocument["uri"].asString();
+        document.version = textDocument["version"].asInteger();
+        document.unit.source = textDocument["text"].asString();
+
+        document.analyze();
+        this->publishDiagnostics(document);
+    }
+
+    void Server::didChange(const json::Value &params)
+    {
+        const json::Value &textDocument = params["textDocument"];
+        auto found = this->documents.find(textDocument["uri"].asString());
+        if (found == this->documents.end())
+        {
+            throw std::invalid_argument("Cannot change document " + textDocument["uri"].asString() + " that was never opened.");
+        }
+
+        lsp::Document &document = found->second;
+        for (const json::Value &change : params["contentChanges"].asArray())
+        {
+            document.applyChange(change);
+        }
+        document.version = textDocument["version"].asInteger();
+
+        document.analyze();
+        this->publishDiagnostics(document);
+    }
+
+    void Server::didClose(const json::Value &params)
+    {
+        std::string uri = params["textDocument"]["uri"].asString();
+        this->documents.erase(uri);
+
+        json::Value cleared = json::Value::makeObject();
+        cleared["uri"] = uri;
+        cleared["diagnostics"] = json::Value::makeArray();
+        this->notify("textDocument/publishDiagnostics", cleared);
+    }
+
+    void Server::publishDiagnostics(const lsp::Document &document)
+    {
+        auto toPosition = [](const lexer::Location &location, int columnOffset)
+        {
+            json::Value position = json::Value::makeObject();
+            position["line"] = std::max(location.getRow() - 1, 0);
+            position["character"] = std::max(location.getColumn() - columnOffset, 0);
+            return position;
+        };
+
+        json::Value diagnostics = json::Value::makeArray();
+        for (const parser::ErrorLog &diagnostic : document.unit.diagnostics)
+        {
+            json::Value published = json::Value::makeObject();
+            // Lexer columns are 1-based and inclusive, protocol ranges are 0-based with an exclusive end.
+            published["range"]["start"] = toPosition(diagnostic.getStart(), 1);
+            published["range"]["end"] = toPosition(diagnostic.getEnd(), 0);
+            published["severity"] = 1;
+            published["source"] = "anchor";
+            published["message"] = diagnostic.getMessage();
+            diagnostics.push_back(published);
+        }
+
+        json::Value params = json::Value::makeObject();
+        params["uri"] = document.uri;
+        params["version"] = document.version;
+        params["diagnostics"] = diagnostics;
+        this->notify("textDocument/publishDiagnostics", params);
+    }
+
+    void Server::respond(const json::Value &id, json::Value result)
+    {
+        json::Value response = json::Value::makeObject();
+        response["jsonrpc"] = "2.0";
+        response["id"] = id;
+        response["result"] = std::move(result);
+        lsp::writeMessage(this->out, response.dump());
+    }
+
+    void Server::respondError(const json::Value &id, int code, const std::string &message)
+    {
+        json::Value response = json::Value::makeObject();
+        response["jsonrpc"] = "2.0";
+        response["id"] = id;
+        response["error"]["code"] = code;
+        response["error"]["message"] = message;
+        lsp::writeMessage(this->out, response.dump());
+    }
+
+    void Server::notify(const std::string &method, json::Value params)
+    {
+        json::Value notification = json::Value::makeObject();
+        notification["jsonrpc"] = "2.0";
+        notification["method"] = method;
+        notification["params"] = std::move(params);
+        lsp::writeMessage(this->out, notification.dump());
+    }
+
+    bool Server::hasExited() const
+    {
+        return this->exited;
+    }
+
+    int Server::exitCode() const
+    {
+        return this->shutdownRequested ? 0 : 1;
+    }
+
+    const lsp::Document *Server::getDocument(const std::string &uri) const
+    {
+        auto found = this->documents.find(uri);
+        return found == this->documents.end() ? nullptr : &found->second;
+    }
+}
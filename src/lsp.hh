@@ -0,0 +1,58 @@
+#ifndef LSP_H
+#define LSP_H
+
+#include <istream>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "src/compilationunit.hh"
+#include "src/json.hh"
+
+namespace lsp
+{
+    class Document
+    {
+    public:
+        std::string uri;
+        int version = 0;
+        anchor::CompilationUnit unit{""};
+
+        void applyChange(const json::Value& change);
+        void analyze();
+    };
+
+    std::optional<std::string> readMessage(std::istream&);
+    void writeMessage(std::ostream&, const std::string&);
+
+    class Server
+    {
+    private:
+        std::ostream& out;
+        std::map<std::string, lsp::Document> documents;
+        bool shutdownRequested = false;
+        bool exited = false;
+
+        void dispatch(const std::string& method, const json::Value& id, const json::Value& params);
+        json::Value initialize();
+        void didOpen(const json::Value& params);
+        void didChange(const json::Value& params);
+        void didClose(const json::Value& params);
+        void publishDiagnostics(const lsp::Document&);
+
+        void respond(const json::Value& id, json::Value result);
+        void respondError(const json::Value& id, int code, const std::string& message);
+        void notify(const std::string& method, json::Value params);
+
+    public:
+        explicit Server(std::ostream&);
+
+        void handle(const std::string& message);
+        bool hasExited() const;
+        int exitCode() const;
+        const lsp::Document* getDocument(const std::string& uri) const;
+    };
+}
+
+#endif // LSP_H
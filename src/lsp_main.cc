@@ -0,0 +1,21 @@
+#include <iostream>
+
+#include "lsp.hh"
+
+int main()
+{
+    std::ios::sync_with_stdio(false);
+
+    lsp::Server server(std::cout);
+    while (!server.hasExited())
+    {
+        std::optional<std::string> message = lsp::readMessage(std::cin);
+        if (!message)
+        {
+            break;
+        }
+        server.handle(*message);
+    }
+
+    return server.exitCode();
+}
@@ -1,37 +1,13 @@
-#include <iostream>
-#include <string>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
+#include <iostream>
+
+#include <unistd.h>
 
-#include "anchor.hh"
+#include "driver.hh"
 
 int main(int argc, char *argv[])
 {
-    std::string input = "";
-    if (argc == 1)
-    {
-        for (std::string line; std::getline(std::cin, line);)
-        {
-            input += line + '\n';
-        }
-    }
-    else
-    {
-        if (!std::filesystem::exists(argv[1])) 
-        {
-            std::cout << "Could not find file with name " << argv[1] << std::endl;
-            return 1;
-        }
-
-        std::ifstream t(argv[1]);
-        std::stringstream buffer;
-        buffer << t.rdbuf();
-        input = buffer.str();
-    }
-
-    std::string llvmOutput = anchor::compile(input);
-    std::cout << llvmOutput << std::endl;
-
-    return 0;
-}
\ No newline at end of file
+    driver::Environment environment(std::filesystem::current_path(), std::cin, std::cout, std::cerr);
+    environment.interactive = isatty(STDIN_FILENO);
+    return driver::run(argc, argv, environment);
+}
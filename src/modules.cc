@@ -0,0 +1,447 @@
+#include "src/modules.hh"
+
+#include "src/compilationunit.hh"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace modules
+{
+    namespace
+    {
+        constexpr char magic[] = {'A', 'N', 'B', 'I'};
+        constexpr std::uint16_t version = 1;
+
+        void writeU16(std::ostream &out, std::uint16_t value)
+        {
+            char bytes[] = {static_cast<char>(value & 0xFF), static_cast<char>(value >> 8)};
+            out.write(bytes, sizeof(bytes));
+        }
+
+        void writeU32(std::ostream &out, std::uint32_t value)
+        {
+            char bytes[] = {static_cast<char>(value & 0xFF), static_cast<char>((value >> 8) & 0xFF), static_cast<char>((value >> 16) & 0xFF), static_cast<char>(value >> 24)};
+            out.write(bytes, sizeof(bytes));
+        }
+
+        void writeString(std::ostream &out, const std::string &value)
+        {
+            writeU32(out, static_cast<std::uint32_t>(value.size()));
+            out.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+
+        void readBytes(std::istream &in, char *bytes, std::size_t size)
+        {
+            if (!in.read(bytes, static_cast<std::streamsize>(size)))
+            {
+                throw std::invalid_argument("Invalid interface: unexpected end of file.");
+            }
+        }
+
+        std::uint16_t readU16(std::istream &in)
+        {
+            unsigned char bytes[2];
+            readBytes(in, reinterpret_cast<char *>(bytes), sizeof(bytes));
+            return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+        }
+
+        std::uint32_t readU32(std::istream &in)
+        {
+            unsigned char bytes[4];
+            readBytes(in, reinterpret_cast<char *>(bytes), sizeof(bytes));
+            return static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8) | (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+        }
+
+        std::string readString(std::istream &in)
+        {
+            std::uint32_t size = readU32(in);
+            std::string value;
+            // Grow as bytes actually arrive, so a corrupt size cannot allocate gigabytes.
+            char buffer[4096];
+            while (value.size() < size)
+            {
+                std::size_t chunk = std::min<std::size_t>(sizeof(buffer), size - value.size());
+                readBytes(in, buffer, chunk);
+                value.append(buffer, chunk);
+            }
+            return value;
+        }
+
+        parser::Type readType(std::istream &in, bool allowVoid)
+        {
+            std::uint16_t type = readU16(in);
+            if (type >= static_cast<std::uint16_t>(parser::Type::NOT_FOUND) || (!allowVoid && type == static_cast<std::uint16_t>(parser::Type::VOID)))
+            {
+                throw std::invalid_argument("Invalid interface: unknown type " + std::to_string(type) + ".");
+            }
+            return static_cast<parser::Type>(type);
+        }
+
+        std::filesystem::path resolve(const std::filesystem::path &importingFile, const std::string &path)
+        {
+            std::filesystem::path directory = importingFile.empty() ? std::filesystem::current_path() : std::filesystem::absolute(importingFile).parent_path();
+            return std::filesystem::weakly_canonical(directory / path);
+        }
+
+        std::optional<std::string> readFile(const std::filesystem::path &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+            {
+                return std::nullopt;
+            }
+            std::stringstream contents;
+            contents << in.rdbuf();
+            return contents.str();
+        }
+    }
+
+    modules::Interface extract(const parser::Program &program)
+    {
+        modules::Interface exported;
+        for (const auto &stmt : program.stmts)
+        {
+            if (stmt->type == parser::StmtType::IMPORT)
+            {
+                exported.imports.push_back(std::static_pointer_cast<parser::ImportStmt>(stmt)->path);
+            }
+            else if (stmt->type == parser::StmtType::FUNCTION)
+            {
+                auto functionStmt = std::static_pointer_cast<parser::FunctionStmt>(stmt);
+                auto declaration = std::make_shared<parser::FunctionStmt>();
+                declaration->type = parser::StmtType::FUNCTION;
+                declaration->identifier = functionStmt->identifier;
+                declaration->args = functionStmt->args;
+                declaration->returnType = functionStmt->returnType;
+                exported.functions.push_back(std::move(declaration));
+            }
+        }
+        return exported;
+    }
+
+    void write(std::ostream &out, const modules::Interface &exported)
+    {
+        out.write(magic, sizeof(magic));
+        writeU16(out, version);
+
+        writeU32(out, static_cast<std::uint32_t>(exported.imports.size()));
+        for (const std::string &path : exported.imports)
+        {
+            writeString(out, path);
+        }
+
+        writeU32(out, static_cast<std::uint32_t>(exported.functions.size()));
+        for (const auto &function : exported.functions)
+        {
+            writeString(out, function->identifier);
+            writeU16(out, static_cast<std::uint16_t>(function->returnType));
+            writeU16(out, static_cast<std::uint16_t>(function->args.size()));
+            for (const auto &arg : function->args)
+            {
+                writeString(out, arg->identifier);
+                writeU16(out, static_cast<std::uint16_t>(arg->returnType));
+            }
+        }
+    }
+
+    modules::Interface read(std::istream &in)
+    {
+        char header[sizeof(magic)];
+        readBytes(in, header, sizeof(header));
+        if (std::string_view(header, sizeof(header)) != std::string_view(magic, sizeof(magic)))
+        {
+            throw std::invalid_argument("Invalid interface: missing ANBI header.");
+        }
+        std::uint16_t fileVersion = readU16(in);
+        if (fileVersion != version)
+        {
+            throw std::invalid_argument("Invalid interface: unsupported version " + std::to_string(fileVersion) + ".");
+        }
+
+        modules::Interface exported;
+        std::uint32_t imports = readU32(in);
+        for (std::uint32_t i = 0; i < imports; i++)
+        {
+            exported.imports.push_back(readString(in));
+        }
+
+        std::uint32_t functions = readU32(in);
+        for (std::uint32_t i = 0; i < functions; i++)
+        {
+            auto function = std::make_shared<parser::FunctionStmt>();
+            function->type = parser::StmtType::FUNCTION;
+            function->identifier = readString(in);
+            function->returnType = readType(in, true);
+            std::uint16_t args = readU16(in);
+            for (std::uint16_t j = 0; j < args; j++)
+            {
+                auto arg = std::make_shared<parser::FunctionArgStmt>();
+                arg->type = parser::StmtType::FUNCTION_ARG;
+                arg->identifier = readString(in);
+                arg->returnType = readType(in, false);
+                function->args.push_back(std::move(arg));
+            }
+            exported.functions.push_back(std::move(function));
+        }
+        return exported;
+    }
+
+    Importer::Importer(cache::Cache *cache) : cache(cache)
+    {
+    }
+
+    Importer::~Importer()
+    {
+        // Builds use the rest of the importer, so none may outlive it.
+        for (Library *library : this->loadOrder)
+        {
+            if (library->object.valid())
+            {
+                library->object.wait();
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<parser::FunctionStmt>> Importer::import(const std::filesystem::path &importingFile, const std::string &path)
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
+        return this->load(resolve(importingFile, path)).exported.functions;
+    }
+
+    parser::Importer Importer::forFile(const std::filesystem::path &importingFile)
+    {
+        return [this, importingFile](const std::string &path)
+        {
+            return this->import(importingFile, path);
+        };
+    }
+
+    Importer::Library &Importer::load(const std::filesystem::path &path)
+    {
+        auto found = this->libraries.find(path);
+        if (found != this->libraries.end())
+        {
+            return *found->second;
+        }
+
+        if (std::find(this->resolving.begin(), this->resolving.end(), path) != this->resolving.end())
+        {
+            std::string cycle;
+            for (auto resolved = std::find(this->resolving.begin(), this->resolving.end(), path); resolved != this->resolving.end(); resolved++)
+            {
+                cycle += resolved->filename().string() + " -> ";
+            }
+            throw std::runtime_error("Cannot import " + path.filename().string() + ", it imports itself: " + cycle + path.filename().string() + ".");
+        }
+
+        std::optional<std::string> source = readFile(path);
+        if (!source.has_value())
+        {
+            throw std::runtime_error("Could not find library " + path.string() + ".");
+        }
+
+        auto library = std::make_unique<Library>();
+        library->path = path;
+        library->source = std::move(*source);
+
+        this->resolving.push_back(path);
+        try
+        {
+            // An interface only depends on the library's own source.
+            std::string key = cache::key(library->source, compiler::OptimizationLevel::O0, "interface");
+            std::optional<std::string> cached = this->cache != nullptr ? this->cache->read(key) : std::nullopt;
+            bool hit = false;
+            if (cached.has_value())
+            {
+                try
+                {
+                    std::istringstream in(std::move(*cached));
+                    library->exported = modules::read(in);
+                    hit = true;
+                }
+                catch (std::invalid_argument &)
+                {
+                }
+            }
+
+            if (hit)
+            {
+                // Parsing would have loaded these.
+                for (const std::string &imported : library->exported.imports)
+                {
+                    this->load(resolve(path, imported));
+                }
+            }
+            else
+            {
+                library->exported = this->parseInterface(path, library->source);
+                if (this->cache != nullptr)
+                {
+                    std::ostringstream out;
+                    modules::write(out, library->exported);
+                    this->cache->store(key, out.str());
+                }
+            }
+        }
+        catch (...)
+        {
+            this->resolving.pop_back();
+            throw;
+        }
+        this->resolving.pop_back();
+
+        Library &loaded = *library;
+        this->libraries.emplace(path, std::move(library));
+        this->loadOrder.push_back(&loaded);
+        if (this->objectLevel.has_value())
+        {
+            std::string objectPath = this->objectPrefix + "." + std::to_string(this->loadOrder.size() - 1) + ".o";
+            loaded.object = std::async(std::launch::async, [this, &loaded, objectPath]()
+                                       { return this->buildObject(loaded, objectPath); });
+        }
+        return loaded;
+    }
+
+    modules::Interface Importer::parseInterface(const std::filesystem::path &path, const std::string &source)
+    {
+        anchor::CompilationUnit unit(source);
+        unit.importer = this->forFile(path);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            throw std::runtime_error("Cannot import " + path.filename().string() + ": " + unit.diagnostics.front().getMessage());
+        }
+
+        modules::Interface exported = modules::extract(unit.program);
+        for (const auto &function : exported.functions)
+        {
+            if (function->identifier == "main")
+            {
+                throw std::runtime_error("Cannot import " + path.filename().string() + ", libraries cannot define main.");
+            }
+        }
+        return exported;
+    }
+
+    std::string Importer::buildObject(const Library &library, const std::string &objectPath)
+    {
+        std::string key = cache::key(this->fingerprint(library.source, library.path), *this->objectLevel, "object");
+        if (this->cache != nullptr && this->cache->fetch(key, objectPath))
+        {
+            return objectPath;
+        }
+
+        anchor::CompilationUnit unit(library.source);
+        unit.importer = this->forFile(library.path);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            throw std::runtime_error("Cannot compile " + library.path.filename().string() + ": " + unit.diagnostics.front().getMessage());
+        }
+
+        compiler::Compiler compiler(*this->objectLevel);
+        compiler.compile(unit.program);
+        {
+            std::error_code error;
+            llvm::raw_fd_ostream object(objectPath, error, llvm::sys::fs::OF_None);
+            if (error)
+            {
+                throw std::runtime_error("Could not open " + objectPath + " for writing: " + error.message());
+            }
+            compiler.emitObject(object);
+        }
+
+        if (this->cache != nullptr)
+        {
+            this->cache->storeFile(key, objectPath);
+        }
+        return objectPath;
+    }
+
+    void Importer::buildObjects(const std::string &prefix, compiler::OptimizationLevel optimizationLevel)
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
+        this->objectPrefix = prefix;
+        this->objectLevel = optimizationLevel;
+    }
+
+    std::vector<std::string> Importer::objects()
+    {
+        std::vector<Library *> libraries;
+        {
+            std::lock_guard<std::recursive_mutex> lock(this->mutex);
+            libraries = this->loadOrder;
+        }
+
+        std::vector<std::string> objectPaths;
+        for (Library *library : libraries)
+        {
+            if (library->object.valid())
+            {
+                objectPaths.push_back(library->object.get());
+            }
+        }
+        return objectPaths;
+    }
+
+    std::string Importer::fingerprint(const std::string &source, const std::filesystem::path &file)
+    {
+        std::lock_guard<std::recursive_mutex> lock(this->mutex);
+        std::vector<std::filesystem::path> visiting;
+        return this->fingerprint(source, file, visiting);
+    }
+
+    std::string Importer::fingerprint(const std::string &source, const std::filesystem::path &file, std::vector<std::filesystem::path> &visiting)
+    {
+        // Most programs import nothing and need not be lexed to find out.
+        if (source.find("import") == std::string::npos)
+        {
+            return source;
+        }
+
+        std::deque<lexer::Token> tokens;
+        try
+        {
+            tokens = lexer::lex(source);
+        }
+        catch (lexer::InvalidTokenException &)
+        {
+            return source;
+        }
+
+        std::string fingerprint = source;
+        for (std::size_t i = 0; i + 1 < tokens.size(); i++)
+        {
+            if (tokens[i].getTokenType() != lexer::TokenType::IMPORT || tokens[i + 1].getTokenType() != lexer::TokenType::STRING)
+            {
+                continue;
+            }
+
+            const std::string &raw = tokens[i + 1].getRaw();
+            std::filesystem::path path = resolve(file, raw.substr(1, raw.length() - 2));
+            // A cycle is an error, reported when the source is parsed.
+            if (std::find(visiting.begin(), visiting.end(), path) != visiting.end())
+            {
+                continue;
+            }
+
+            auto memoized = this->fingerprints.find(path);
+            if (memoized == this->fingerprints.end())
+            {
+                std::optional<std::string> library = readFile(path);
+                visiting.push_back(path);
+                std::string digest = library.has_value() ? cache::key(this->fingerprint(*library, path, visiting), compiler::OptimizationLevel::O0, "library") : "missing";
+                visiting.pop_back();
+                memoized = this->fingerprints.emplace(path, std::move(digest)).first;
+            }
+            fingerprint += '\0' + path.string() + '\0' + memoized->second;
+        }
+        return fingerprint;
+    }
+}
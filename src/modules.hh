@@ -0,0 +1,102 @@
+#ifndef MODULES_H
+#define MODULES_H
+
+#include <filesystem>
+#include <future>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "src/cache.hh"
+#include "src/compiler.hh"
+#include "src/parser.hh"
+
+namespace modules
+{
+    // What an importing file needs to know about a library: the signature of every
+    // function it defines, and the libraries it imports in turn.
+    class Interface
+    {
+    public:
+        // As written in the library, relative to its directory.
+        std::vector<std::string> imports;
+        // Declarations only. Their bodies are empty.
+        std::vector<std::shared_ptr<parser::FunctionStmt>> functions;
+    };
+
+    // Every function a library exports. Libraries cannot define main.
+    modules::Interface extract(const parser::Program&);
+
+    // The file format is little-endian, and starts with "ANBI" and a version.
+    void write(std::ostream&, const modules::Interface&);
+    modules::Interface read(std::istream&);
+
+    // Resolves imports against the directory of the importing file, and loads each
+    // library once, however many files import it. A library's interface comes from
+    // the cache when its source has not changed since it was last built, and is
+    // otherwise extracted by parsing it, never by compiling it.
+    //
+    // When building objects, every library reached is also compiled to an object
+    // of its own on a thread of its own as soon as it is found, while the importing
+    // file is still being parsed. Those objects are cached too, so a library is
+    // compiled once per change rather than once per program that uses it.
+    class Importer
+    {
+    private:
+        class Library
+        {
+        public:
+            std::filesystem::path path;
+            std::string source;
+            modules::Interface exported;
+            std::future<std::string> object;
+        };
+
+        cache::Cache *cache;
+        std::optional<compiler::OptimizationLevel> objectLevel;
+        std::string objectPrefix;
+
+        // Parsing a library imports its own libraries, on the same thread.
+        std::recursive_mutex mutex;
+        std::map<std::filesystem::path, std::unique_ptr<Library>> libraries;
+        std::vector<Library *> loadOrder;
+        std::vector<std::filesystem::path> resolving;
+        std::map<std::filesystem::path, std::string> fingerprints;
+
+        Library &load(const std::filesystem::path &path);
+        modules::Interface parseInterface(const std::filesystem::path &path, const std::string &source);
+        std::string buildObject(const Library &library, const std::string &objectPath);
+        std::string fingerprint(const std::string &source, const std::filesystem::path &file, std::vector<std::filesystem::path> &visiting);
+
+    public:
+        explicit Importer(cache::Cache *cache = nullptr);
+        ~Importer();
+
+        Importer(const Importer &) = delete;
+        Importer &operator=(const Importer &) = delete;
+
+        // Returns the library's exported functions. Throws std::runtime_error if it
+        // cannot be read, does not parse, or imports itself.
+        std::vector<std::shared_ptr<parser::FunctionStmt>> import(const std::filesystem::path &importingFile, const std::string &path);
+        // An importer for a unit read from importingFile, or from the working
+        // directory when it is empty.
+        parser::Importer forFile(const std::filesystem::path &importingFile);
+
+        // Compiles libraries found from now on to "<prefix>.<n>.o". Call before parsing.
+        void buildObjects(const std::string &prefix, compiler::OptimizationLevel optimizationLevel);
+        // Waits for every library's object and returns them in the order the
+        // libraries were loaded. Rethrows the first failure.
+        std::vector<std::string> objects();
+
+        // The source together with the source of every library it imports,
+        // directly or not, for keying anything compiled from it.
+        std::string fingerprint(const std::string &source, const std::filesystem::path &file);
+    };
+}
+
+#endif // MODULES_H
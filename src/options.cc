@@ -0,0 +1,221 @@
+#include "src/options.hh"
+#include "src/x86.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <stdexcept>
+
+namespace anchor
+{
+    anchor::Options parseOptions(int argc, const char *const argv[])
+    {
+        anchor::Options options;
+        std::optional<anchor::Emit> emit;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "-O0")
+            {
+                options.optimizationLevel = compiler::OptimizationLevel::O0;
+            }
+            else if (arg == "-O1")
+            {
+                options.optimizationLevel = compiler::OptimizationLevel::O1;
+            }
+            else if (arg == "-O2")
+            {
+                options.optimizationLevel = compiler::OptimizationLevel::O2;
+            }
+            else if (arg == "-O3")
+            {
+                options.optimizationLevel = compiler::OptimizationLevel::O3;
+            }
+            else if (arg == "--run")
+            {
+                options.run = true;
+            }
+            else if (arg == "--tiered")
+            {
+                options.run = true;
+                options.tiered = true;
+            }
+            else if (arg == "--lazy")
+            {
+                options.run = true;
+                options.lazy = true;
+            }
+            else if (arg == "-c")
+            {
+                emit = anchor::Emit::OBJECT;
+            }
+            else if (arg == "--emit=llvm")
+            {
+                emit = anchor::Emit::LLVM_IR;
+            }
+            else if (arg == "--emit=bc")
+            {
+                emit = anchor::Emit::BITCODE;
+            }
+            else if (arg.starts_with("--cache-dir="))
+            {
+                options.cacheDirectory = arg.substr(std::string("--cache-dir=").length());
+                if (options.cacheDirectory.empty())
+                {
+                    throw std::invalid_argument("Expected a directory after --cache-dir=.");
+                }
+            }
+            else if (arg.starts_with("--codegen-threads="))
+            {
+                std::string threads = arg.substr(std::string("--codegen-threads=").length());
+                if (threads.empty() || threads.length() > 4 || !std::all_of(threads.begin(), threads.end(), ::isdigit) || std::stoi(threads) == 0)
+                {
+                    throw std::invalid_argument("Expected a number of threads from 1 to 9999 after --codegen-threads=.");
+                }
+                options.codegenThreads = static_cast<unsigned>(std::stoi(threads));
+            }
+            else if (arg == "-j" || (arg.starts_with("-j") && arg.length() > 2))
+            {
+                std::string jobs = arg == "-j" ? (i + 1 < argc ? argv[++i] : "") : arg.substr(2);
+                if (jobs.empty() || jobs.length() > 4 || !std::all_of(jobs.begin(), jobs.end(), ::isdigit) || std::stoi(jobs) == 0)
+                {
+                    throw std::invalid_argument("Expected a number of jobs from 1 to 9999 after -j.");
+                }
+                options.jobs = static_cast<unsigned>(std::stoi(jobs));
+            }
+            else if (arg == "--backend=llvm")
+            {
+                options.backend = anchor::Backend::LLVM;
+            }
+            else if (arg == "--backend=x86")
+            {
+                options.backend = anchor::Backend::X86;
+            }
+            else if (arg == "--repl")
+            {
+                options.repl = true;
+            }
+            else if (arg == "--stream")
+            {
+                options.stream = true;
+            }
+            else if (arg == "--no-cache")
+            {
+                options.cache = false;
+            }
+            else if (arg == "-o")
+            {
+                if (i + 1 == argc)
+                {
+                    throw std::invalid_argument("Expected a file name after -o.");
+                }
+                options.output = argv[++i];
+            }
+            else if (arg.length() > 1 && arg[0] == '-')
+            {
+                throw std::invalid_argument("Unknown option " + arg + ".");
+            }
+            else
+            {
+                options.inputs.push_back(arg);
+            }
+        }
+
+        if (options.inputs.size() > 1 && options.jobs == 0)
+        {
+            throw std::invalid_argument("Expected a single input file, but found " + options.inputs[0] + " and " + options.inputs[1] + ".");
+        }
+        options.input = options.inputs.empty() ? "" : options.inputs[0];
+        std::string runFlag = options.lazy ? "--lazy" : options.tiered ? "--tiered" : "--run";
+
+        if (options.run && (emit.has_value() || !options.output.empty()))
+        {
+            throw std::invalid_argument(runFlag + " cannot be combined with -c, -o or --emit.");
+        }
+
+        if (options.jobs > 0 && options.run)
+        {
+            throw std::invalid_argument(runFlag + " cannot be combined with -j.");
+        }
+
+        if (options.jobs > 0 && options.inputs.empty())
+        {
+            throw std::invalid_argument("Expected input files with -j, standard input cannot be compiled in a batch.");
+        }
+
+        if (options.jobs > 0 && options.output.empty())
+        {
+            throw std::invalid_argument("Expected an output directory with -o and -j.");
+        }
+
+        if (options.stream && options.run)
+        {
+            throw std::invalid_argument(runFlag + " cannot be combined with --stream.");
+        }
+
+        if (options.stream && (emit == anchor::Emit::OBJECT || emit == anchor::Emit::BITCODE))
+        {
+            throw std::invalid_argument("--stream writes textual IR or executables, it cannot be combined with -c or --emit=bc.");
+        }
+
+        if (options.stream && options.codegenThreads > 0)
+        {
+            throw std::invalid_argument("--stream cannot be combined with --codegen-threads.");
+        }
+
+        if (options.tiered && options.codegenThreads > 0)
+        {
+            throw std::invalid_argument("--tiered cannot be combined with --codegen-threads.");
+        }
+
+        if (options.lazy && options.tiered)
+        {
+            throw std::invalid_argument("--lazy cannot be combined with --tiered.");
+        }
+
+        if (options.lazy && options.codegenThreads > 0)
+        {
+            throw std::invalid_argument("--lazy cannot be combined with --codegen-threads.");
+        }
+
+        if (options.backend == anchor::Backend::X86 && (!options.run || options.tiered || options.lazy || options.codegenThreads > 0))
+        {
+            throw std::invalid_argument("--backend=x86 only runs programs, with --run and without --tiered, --lazy or --codegen-threads.");
+        }
+
+        if (options.backend == anchor::Backend::X86 && !x86::isHost)
+        {
+            throw std::invalid_argument("--backend=x86 only runs on x86-64 hosts.");
+        }
+
+        if (options.repl && (options.run || emit.has_value() || !options.output.empty() || !options.inputs.empty() || options.codegenThreads > 0 || options.stream || options.jobs > 0))
+        {
+            throw std::invalid_argument("--repl reads statements from standard input, it only combines with -O0, -O1, -O2 and -O3.");
+        }
+
+        if (!options.cache && !options.cacheDirectory.empty())
+        {
+            throw std::invalid_argument("--cache-dir cannot be combined with --no-cache.");
+        }
+
+        if (emit == anchor::Emit::OBJECT && options.output.empty())
+        {
+            throw std::invalid_argument("Expected -o with -c.");
+        }
+
+        if (emit.has_value())
+        {
+            options.emit = *emit;
+        }
+        else if (!options.output.empty())
+        {
+            options.emit = anchor::Emit::EXECUTABLE;
+        }
+        return options;
+    }
+
+    std::string usage()
+    {
+        return "Usage: main [-O0|-O1|-O2|-O3] [--run|--tiered|--lazy|--repl|-c|--emit=llvm|--emit=bc] [-o output] [--codegen-threads=n|--stream] [--backend=llvm|--backend=x86] [-j n] [--cache-dir=dir|--no-cache] [file.anchor...]\n";
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <string>
+#include <vector>
+
+#include "src/compiler.hh"
+
+namespace anchor
+{
+    enum class Emit
+    {
+        LLVM_IR,
+        BITCODE,
+        OBJECT,
+        EXECUTABLE
+    };
+
+    enum class Backend
+    {
+        LLVM,
+        // x86::compile, straight to machine code. Only runs programs.
+        X86
+    };
+
+    class Options
+    {
+    public:
+        // Empty when the source should be read from standard input.
+        std::string input;
+        // Every input file, input being the first. Only a batch has more than one.
+        std::vector<std::string> inputs;
+        compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0;
+        // IR and bitcode go to standard output unless -o is given. Objects and executables need it.
+        anchor::Emit emit = anchor::Emit::LLVM_IR;
+        std::string output;
+        // JIT-compile and run the program instead of writing any output.
+        bool run = false;
+        // Run with tiering::TieredJit. Implies run.
+        bool tiered = false;
+        // Run with lazy::LazyJit, compiling each function on its first call. Implies run.
+        bool lazy = false;
+        anchor::Backend backend = anchor::Backend::LLVM;
+        // Compile with parallel::PartitionedCompiler on this many threads. 0 compiles
+        // the whole program as one module on the main thread.
+        unsigned codegenThreads = 0;
+        // Compile every input at once on this many threads, each with a compiler of
+        // its own, into the directory given by -o. 0 compiles the single input.
+        unsigned jobs = 0;
+        // Read statements from standard input and run each with repl::Repl.
+        bool repl = false;
+        // Compile with streaming::StreamingCompiler, a chunk of functions at a time,
+        // into textual IR or an executable.
+        bool stream = false;
+        // Where compiled artifacts are cached. Empty means cache::defaultDirectory().
+        std::string cacheDirectory;
+        bool cache = true;
+    };
+
+    anchor::Options parseOptions(int argc, const char *const argv[]);
+    std::string usage();
+}
+
+#endif // OPTIONS_H
@@ -0,0 +1,136 @@
+#include "src/parallel.hh"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+namespace parallel
+{
+    PartitionedCompiler::PartitionedCompiler(compiler::OptimizationLevel optimizationLevel, unsigned threads, std::size_t partitionSize) : optimizationLevel(optimizationLevel), threads(std::max(threads, 1U)), partitionSize(std::max<std::size_t>(partitionSize, 1))
+    {
+    }
+
+    // Runs work on every partition from first onwards, with this thread as one of the
+    // workers. The first failure, in partition order, is rethrown once all have finished.
+    void PartitionedCompiler::forEachPartition(std::size_t first, const std::function<void(std::size_t)> &work)
+    {
+        std::size_t count = this->partitions.size();
+        std::atomic<std::size_t> next = first;
+        std::vector<std::exception_ptr> failures(count);
+        auto worker = [&]()
+        {
+            for (std::size_t i = next++; i < count; i = next++)
+            {
+                try
+                {
+                    work(i);
+                }
+                catch (...)
+                {
+                    failures[i] = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        std::size_t helpers = std::min<std::size_t>(this->threads, count - std::min(first, count));
+        for (std::size_t i = 1; i < helpers; i++)
+        {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread &thread : pool)
+        {
+            thread.join();
+        }
+
+        for (const std::exception_ptr &failure : failures)
+        {
+            if (failure)
+            {
+                std::rethrow_exception(failure);
+            }
+        }
+    }
+
+    void PartitionedCompiler::compile(const parser::Program &program)
+    {
+        std::size_t functions = std::count_if(program.stmts.begin(), program.stmts.end(), [](const auto &stmt)
+                                              { return stmt->type == parser::StmtType::FUNCTION; });
+        // Even a program without functions gets a module.
+        std::size_t count = std::max<std::size_t>((functions + this->partitionSize - 1) / this->partitionSize, 1);
+
+        this->partitions.clear();
+        this->partitions.resize(count);
+        this->forEachPartition(0, [&](std::size_t i)
+                               {
+                                   auto partition = std::make_unique<compiler::Compiler>(this->optimizationLevel);
+                                   partition->compilePartition(program, i * this->partitionSize, (i + 1) * this->partitionSize);
+                                   this->partitions[i] = std::move(partition); });
+    }
+
+    std::size_t PartitionedCompiler::size() const
+    {
+        return this->partitions.size();
+    }
+
+    compiler::Compiler &PartitionedCompiler::link()
+    {
+        if (this->partitions.empty())
+        {
+            throw std::runtime_error("Cannot link partitions before compiling them.");
+        }
+
+        // Modules can only be linked within one context, so the others cross over as
+        // bitcode. Writing it is the expensive half and happens in parallel.
+        std::vector<llvm::SmallVector<char, 0>> bitcode(this->partitions.size());
+        this->forEachPartition(1, [&](std::size_t i)
+                               {
+                                   llvm::raw_svector_ostream out(bitcode[i]);
+                                   this->partitions[i]->writeBitcode(out);
+                                   this->partitions[i].reset(); });
+
+        compiler::Compiler &linked = *this->partitions.front();
+        for (std::size_t i = 1; i < bitcode.size(); i++)
+        {
+            std::string identifier = "partition " + std::to_string(i);
+            linked.link(llvm::MemoryBufferRef(llvm::StringRef(bitcode[i].data(), bitcode[i].size()), identifier));
+            bitcode[i] = {};
+        }
+        this->partitions.resize(1);
+        return linked;
+    }
+
+    void PartitionedCompiler::emitObjects(const std::vector<std::string> &objectPaths)
+    {
+        if (objectPaths.size() != this->partitions.size())
+        {
+            throw std::invalid_argument("Expected " + std::to_string(this->partitions.size()) + " object paths, one per partition.");
+        }
+
+        this->forEachPartition(0, [&](std::size_t i)
+                               {
+                                   std::error_code error;
+                                   llvm::raw_fd_ostream object(objectPaths[i], error, llvm::sys::fs::OF_None);
+                                   if (error)
+                                   {
+                                       throw std::runtime_error("Could not open " + objectPaths[i] + " for writing: " + error.message());
+                                   }
+                                   this->partitions[i]->emitObject(object); });
+    }
+
+    void PartitionedCompiler::addTo(jit::Jit &jit)
+    {
+        for (std::unique_ptr<compiler::Compiler> &partition : this->partitions)
+        {
+            auto [context, module] = partition->release();
+            jit.add(std::move(context), std::move(module));
+        }
+        this->partitions.clear();
+    }
+}
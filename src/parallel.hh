@@ -0,0 +1,49 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/parser.hh"
+
+namespace parallel
+{
+    constexpr std::size_t defaultPartitionSize = 256;
+
+    // Splits a program's functions, in the order they are defined, into partitions
+    // of partitionSize and compiles and optimizes each with its own
+    // compiler::Compiler, and so its own context and module, on a pool of threads.
+    // The partitions depend only on the program, never on the number of threads, so
+    // neither does the output. A call across partitions cannot be inlined.
+    class PartitionedCompiler
+    {
+    private:
+        compiler::OptimizationLevel optimizationLevel;
+        unsigned threads;
+        std::size_t partitionSize;
+        std::vector<std::unique_ptr<compiler::Compiler>> partitions;
+
+        void forEachPartition(std::size_t first, const std::function<void(std::size_t)> &work);
+
+    public:
+        PartitionedCompiler(compiler::OptimizationLevel optimizationLevel, unsigned threads, std::size_t partitionSize = parallel::defaultPartitionSize);
+
+        void compile(const parser::Program &program);
+        std::size_t size() const;
+
+        // Links every partition, in order, into the first and returns it. The other
+        // partitions are gone afterwards.
+        compiler::Compiler &link();
+        // Writes partition i to objectPaths[i], one partition per thread.
+        void emitObjects(const std::vector<std::string> &objectPaths);
+        // Adds every partition to the JIT as a module of its own.
+        void addTo(jit::Jit &jit);
+    };
+}
+
+#endif // PARALLEL_H
@@ -17,17 +17,20 @@ namespace parser
 {
     std::string tostring(parser::Type type)
     {
-        static std::map<parser::Type, std::string> map;
-        if (map.empty())
+        // Built once, before any caller sees it, so threads may look names up concurrently.
+        static const std::map<parser::Type, std::string> map = []()
         {
+            std::map<parser::Type, std::string> map;
             using enum parser::Type;
             map[VOID] = "VOID";
             map[INTEGER] = "INTEGER";
             map[STRING] = "STRING";
             map[BOOLEAN] = "BOOLEAN";
-        }
+            return map;
+        }();
 
-        return map[type];
+        auto name = map.find(type);
+        return name != map.end() ? name->second : "";
     }
 
     ReturnStmt::ReturnStmt(std::shared_ptr<Expr> expr) : expr(std::move(expr))
@@ -84,7 +87,11 @@ namespace parser
     {
     }
 
-    ErrorLog::ErrorLog(const std::string &message) : message(message)
+    ErrorLog::ErrorLog(const std::string &message) : message(message), start(1, 1), end(1, 1)
+    {
+    }
+
+    ErrorLog::ErrorLog(const std::string &message, const lexer::Location &start, const lexer::Location &end) : message(message), start(start), end(end)
     {
     }
 
@@ -103,6 +110,16 @@ namespace parser
         return this->message;
     }
 
+    lexer::Location ErrorLog::getStart() const
+    {
+        return this->start;
+    }
+
+    lexer::Location ErrorLog::getEnd() const
+    {
+        return this->end;
+    }
+
     bool Program::isSyntacticallyCorrect() const
     {
         return this->errors.empty();
@@ -132,6 +149,30 @@ namespace parser
         return parser::Type::NOT_FOUND;
     }
     
+    void Context::setDeclaration(const std::string &identifier, const parser::Stmt *declaration)
+    {
+        this->varIdToDeclaration[identifier] = declaration;
+    }
+
+    const parser::Stmt *Context::getDeclaration(const std::string &identifier)
+    {
+        Context *iterator = this;
+        while (iterator != nullptr)
+        {
+            if (iterator->varIdToDeclaration.contains(identifier))
+            {
+                return iterator->varIdToDeclaration[identifier];
+            }
+            iterator = iterator->parent;
+        }
+        return nullptr;
+    }
+
+    bool Context::isGlobal() const
+    {
+        return this->parent == nullptr;
+    }
+
     void Context::setFunctionType(const std::string& identifier, parser::Type type)
     {
         this->functionIdToType[identifier] = type;
@@ -151,22 +192,66 @@ namespace parser
         return parser::Type::NOT_FOUND;
     }
 
-    Parser::Parser(const std::deque<lexer::Token> &tokens) : tokens(tokens)
+    Parser::Parser(const std::deque<lexer::Token> &tokens, parser::Importer importer) : importer(std::move(importer)), tokens(tokens)
+    {
+    }
+
+    Parser::Parser(lexer::Lexer &lexer, parser::Importer importer) : importer(std::move(importer)), lexing(&lexer), buffered(std::in_place), tokens(*this->buffered)
     {
     }
 
     parser::Program Parser::parse()
     {
         std::vector<std::shared_ptr<Stmt>> stmts;
-        while (this->peek().getTokenType() != lexer::TokenType::END_OF_STREAM && !this->tokens.empty())
+        while (std::shared_ptr<Stmt> stmt = this->next())
         {
-            stmts.push_back(this->stmt());
+            stmts.push_back(std::move(stmt));
         }
 
-        this->compiling.stmts = stmts;
-        return compiling;
+        this->compiling.stmts = std::move(stmts);
+        return std::move(this->compiling);
     };
 
+    std::shared_ptr<Stmt> Parser::next()
+    {
+        if (this->lexing != nullptr)
+        {
+            // Nothing refers to the tokens of statements already returned.
+            this->buffered->erase(this->buffered->begin(), this->buffered->begin() + static_cast<std::ptrdiff_t>(this->position));
+            this->position = 0;
+            this->fill(0);
+        }
+
+        if (this->tokens.empty() || this->peek().getTokenType() == lexer::TokenType::END_OF_STREAM)
+        {
+            return nullptr;
+        }
+        return this->stmt();
+    }
+
+    const std::vector<parser::ErrorLog> &Parser::errors() const
+    {
+        return this->compiling.errors;
+    }
+
+    void Parser::readFrom(lexer::Lexer &lexer)
+    {
+        if (this->lexing == nullptr)
+        {
+            throw std::invalid_argument("Cannot read from a lexer with a parser over tokens lexed up front.");
+        }
+
+        this->lexing = &lexer;
+        this->buffered->clear();
+        this->position = 0;
+        this->compiling.errors.clear();
+    }
+
+    parser::Context &Parser::getContext()
+    {
+        return this->context;
+    }
+
     std::shared_ptr<Stmt> Parser::stmt()
     {
         using enum lexer::TokenType;
@@ -179,7 +264,7 @@ namespace parser
         {
             while (true)
             {
-                lexer::Token popped = this->pop();
+                const lexer::Token &popped = this->pop();
                 if (popped.getTokenType() == SEMICOLON || popped.getTokenType() == END_OF_STREAM)
                 {
                     break;
@@ -187,7 +272,7 @@ namespace parser
             }
         };
 
-        lexer::Token maybeReturnOrFunctionDefinition = this->peek();
+        const lexer::Token &maybeReturnOrFunctionDefinition = this->peek();
 
         try
         {
@@ -215,6 +300,10 @@ namespace parser
             {
                 return this->functionStmt();
             }
+            else if (maybeReturnOrFunctionDefinition.getTokenType() == IMPORT)
+            {
+                return this->importStmt();
+            }
             else
             {
                 return this->varAssignmentStmtOrExpr();
@@ -222,7 +311,7 @@ namespace parser
         }
         catch (parser::InvalidSyntaxException &ise)
         {
-            this->compiling.errors.emplace_back(ise.what());
+            this->compiling.errors.emplace_back(ise.what(), ise.offender.getStart(), ise.offender.getEnd());
             std::shared_ptr<Stmt> badStmt = std::make_shared<parser::BadStmt>(ise.offender, ise.expected, ise.what());
             badStmt->type = parser::StmtType::BAD;
 
@@ -239,33 +328,78 @@ namespace parser
         parser::Type returnType = this->parseReturnType();
         std::string identifier = this->identifier();
 
-        parser::Context parent = this->context;
+        parser::Context parent = std::move(this->context);
         this->context = parser::Context();
         this->context.setParent(&parent);
 
-        std::vector<std::shared_ptr<parser::FunctionArgStmt>> args = this->args();
-
         auto functionStmt = std::make_shared<parser::FunctionStmt>();
+        try
+        {
+            functionStmt->args = this->args();
+            functionStmt->stmts = this->block();
+        }
+        catch (...)
+        {
+            this->context = std::move(parent);
+            throw;
+        }
         functionStmt->type = parser::StmtType::FUNCTION;
         functionStmt->returnType = returnType;
-        functionStmt->stmts = this->block();
         functionStmt->identifier = identifier;
-        functionStmt->args = args;
 
-        this->context = parent;
+        this->context = std::move(parent);
         this->context.setFunctionType(functionStmt->identifier, functionStmt->returnType);
 
         this->consume(lexer::TokenType::SEMICOLON);
         return functionStmt;
     }
 
+    std::shared_ptr<Stmt> Parser::importStmt()
+    {
+        const lexer::Token &keyword = this->pop();
+        const lexer::Token &path = this->peek();
+        this->consume(lexer::TokenType::STRING);
+        this->consume(lexer::TokenType::SEMICOLON);
+
+        auto importStmt = std::make_shared<parser::ImportStmt>();
+        importStmt->type = parser::StmtType::IMPORT;
+        importStmt->path = path.getRaw().substr(1, path.getRaw().length() - 2);
+
+        if (!this->context.isGlobal())
+        {
+            this->compiling.errors.emplace_back("Cannot import " + importStmt->path + " inside a function at line " + std::to_string(keyword.getStart().getRow()) + ", imports belong at the top level of a file.", keyword.getStart(), keyword.getEnd());
+            return importStmt;
+        }
+        if (!this->importer)
+        {
+            this->compiling.errors.emplace_back("Cannot import " + importStmt->path + ", imports are not supported here.", path.getStart(), path.getEnd());
+            return importStmt;
+        }
+
+        try
+        {
+            importStmt->declarations = this->importer(importStmt->path);
+        }
+        catch (std::runtime_error &e)
+        {
+            this->compiling.errors.emplace_back(e.what(), path.getStart(), path.getEnd());
+            return importStmt;
+        }
+
+        for (const auto &declaration : importStmt->declarations)
+        {
+            this->context.setFunctionType(declaration->identifier, declaration->returnType);
+        }
+        return importStmt;
+    }
+
     std::shared_ptr<Stmt> Parser::printStmt()
     {
         this->consume(lexer::TokenType::PRINT);
 
         this->consume(lexer::TokenType::LEFT_PAREN);
 
-        lexer::Token peeked = this->peek();
+        const lexer::Token &peeked = this->peek();
         std::shared_ptr<parser::Expr> expr = this->expr();
         auto printStmt = std::make_shared<parser::PrintStmt>(expr);
         printStmt->type = parser::StmtType::PRINT;
@@ -275,7 +409,7 @@ namespace parser
 
         if (parser::Expr::hasTypeError(expr))
         {
-            this->compiling.errors.emplace_back(parser::Expr::getTypeErrorMessage(peeked, expr));
+            this->compiling.errors.emplace_back(parser::Expr::getTypeErrorMessage(peeked, expr), peeked.getStart(), peeked.getEnd());
         }
 
         return printStmt;
@@ -338,13 +472,14 @@ namespace parser
         varDeclStmt->variableType = type;
 
         this->context.setType(varDeclStmt->identifier, varDeclStmt->variableType);
+        this->context.setDeclaration(varDeclStmt->identifier, varDeclStmt.get());
 
         return varDeclStmt;
     }
 
     std::shared_ptr<Stmt> Parser::varAssignmentStmtOrExpr()
     {
-        lexer::Token peeked = this->peek();
+        const lexer::Token &peeked = this->peek();
         std::shared_ptr<parser::Expr> expr = this->expr();
 
         std::shared_ptr<parser::ExprStmt> exprStmt = std::make_unique<parser::ExprStmt>();
@@ -355,7 +490,7 @@ namespace parser
 
         if (parser::Expr::hasTypeError(expr))
         {
-            this->compiling.errors.emplace_back(parser::Expr::getTypeErrorMessage(peeked, expr));
+            this->compiling.errors.emplace_back(parser::Expr::getTypeErrorMessage(peeked, expr), peeked.getStart(), peeked.getEnd());
         }
 
         return exprStmt;
@@ -403,7 +538,7 @@ namespace parser
 
     std::string Parser::identifier()
     {
-        lexer::Token token = this->pop();
+        const lexer::Token &token = this->pop();
         if (token.getTokenType() != lexer::TokenType::IDENTIFIER)
         {
             throw parser::InvalidSyntaxException(token, std::vector<lexer::TokenType>{lexer::TokenType::IDENTIFIER});
@@ -414,7 +549,7 @@ namespace parser
     parser::Type Parser::type()
     {
         using enum lexer::TokenType;
-        lexer::Token variableType = this->pop();
+        const lexer::Token &variableType = this->pop();
         if (variableType.getTokenType() == INTEGER_TYPE)
         {
             return parser::Type::INTEGER;
@@ -458,6 +593,7 @@ namespace parser
             arg->returnType = type;
 
             this->context.setType(arg->identifier, arg->returnType);
+            this->context.setDeclaration(arg->identifier, arg.get());
 
             args.push_back(arg);
 
@@ -477,16 +613,16 @@ namespace parser
         this->consume(LEFT_BRACKET);
         std::vector<std::shared_ptr<Stmt>> stmts;
 
-        parser::Context parent = this->context;
+        parser::Context parent = std::move(this->context);
 
         this->context = parser::Context();
         this->context.setParent(&parent);
-        while (this->peek().getTokenType() != RIGHT_BRACKET)
+        while (this->peek().getTokenType() != RIGHT_BRACKET && this->peek().getTokenType() != END_OF_STREAM)
         {
             stmts.push_back(this->stmt());
         }
 
-        this->context = parent;
+        this->context = std::move(parent);
 
         this->consume(RIGHT_BRACKET);
         return stmts;
@@ -494,7 +630,7 @@ namespace parser
 
     void Parser::consume(lexer::TokenType tokenType)
     {
-        lexer::Token consumed = this->peek();
+        const lexer::Token &consumed = this->peek();
         if (consumed.getTokenType() != tokenType)
         {
             throw parser::InvalidSyntaxException(consumed, std::vector<lexer::TokenType>{tokenType});
@@ -505,16 +641,39 @@ namespace parser
         }
     }
 
-    lexer::Token Parser::pop()
+    // Lexes until the token at index is buffered, or the source runs out. Pushing
+    // onto a deque leaves references to the tokens already there intact.
+    void Parser::fill(std::size_t index)
+    {
+        if (this->lexing == nullptr)
+        {
+            return;
+        }
+        while (this->buffered->size() <= index && this->lexing->hasNext())
+        {
+            this->buffered->push_back(this->lexing->next());
+        }
+    }
+
+    const lexer::Token &Parser::pop()
     {
-        lexer::Token token = this->peek();
-        this->tokens.pop_front();
+        const lexer::Token &token = this->peek();
+        this->fill(this->position + 1);
+        if (this->position + 1 < this->tokens.size())
+        {
+            this->position++;
+        }
         return token;
     }
 
-    lexer::Token Parser::peek()
+    const lexer::Token &Parser::peek()
     {
-        return this->tokens.front();
+        this->fill(this->position);
+        if (this->tokens.empty())
+        {
+            throw std::invalid_argument("Cannot peek at token from empty token stream.");
+        }
+        return this->tokens[this->position];
     }
 
     std::shared_ptr<parser::Expr> Parser::expr()
@@ -532,7 +691,7 @@ namespace parser
             return tokenType == LESS_THAN_SIGN || tokenType == GREATER_THAN_SIGN || tokenType == DOUBLE_EQUALS;
         };
 
-        lexer::Token peeked = this->peek();
+        const lexer::Token &peeked = this->peek();
 
         std::shared_ptr<parser::Expr> lhs;
         if (peeked.getTokenType() == STRING)
@@ -552,8 +711,12 @@ namespace parser
         {
             lhs = this->parseBoolean();
         }
+        else
+        {
+            throw parser::InvalidSyntaxException(peeked, std::vector<lexer::TokenType>{STRING, IDENTIFIER, INTEGER, TRUE, FALSE});
+        }
 
-        lexer::Token rhsPeek = this->peek();
+        const lexer::Token &rhsPeek = this->peek();
         if (isBinaryOp(rhsPeek.getTokenType()))
         {
             auto binaryOperation = std::make_shared<parser::BinaryOperation>();
@@ -589,7 +752,7 @@ namespace parser
 
     std::shared_ptr<parser::Expr> Parser::parseStringLiteral()
     {
-        lexer::Token popped = this->pop();
+        const lexer::Token &popped = this->pop();
         auto stringLiteral = std::make_shared<parser::StringLiteral>();
         stringLiteral->literal = popped.getRaw().substr(1, popped.getRaw().length() - 2);
         stringLiteral->type = parser::ExprType::STRING_LITERAL;
@@ -631,6 +794,7 @@ namespace parser
             auto varAssignmentExpr = std::make_shared<parser::VarAssignmentExpr>();
             varAssignmentExpr->type = parser::ExprType::ASSIGNMENT;
             varAssignmentExpr->returnType = this->context.getType(identifier);
+            varAssignmentExpr->declaration = this->context.getDeclaration(identifier);
             varAssignmentExpr->expr = this->expr();
             varAssignmentExpr->identifier = identifier;
 
@@ -641,6 +805,7 @@ namespace parser
             auto varExpr = std::make_shared<parser::VarExpr>();
             varExpr->identifier = identifier;
             varExpr->returnType = this->context.getType(identifier);
+            varExpr->declaration = this->context.getDeclaration(identifier);
             varExpr->type = parser::ExprType::VAR;
             return std::static_pointer_cast<parser::Expr>(varExpr);
         }
@@ -648,7 +813,7 @@ namespace parser
 
     std::shared_ptr<parser::Expr> Parser::parseInteger()
     {
-        lexer::Token integerToken = this->pop();
+        const lexer::Token &integerToken = this->pop();
         std::string intAsString = integerToken.getRaw();
 
         auto integerLiteral = std::make_shared<parser::IntegerLiteral>();
@@ -661,7 +826,7 @@ namespace parser
     std::shared_ptr<parser::Expr> Parser::parseBoolean()
     {
         using enum lexer::TokenType;
-        lexer::Token booleanPrimitive = this->pop();
+        const lexer::Token &booleanPrimitive = this->pop();
 
         auto booleanLiteralExpr = std::make_shared<parser::BooleanLiteralExpr>();
         booleanLiteralExpr->type = parser::ExprType::BOOLEAN;
@@ -685,7 +850,7 @@ namespace parser
 
     parser::Operation Parser::parseOperation()
     {
-        lexer::Token operation = this->pop();
+        const lexer::Token &operation = this->pop();
 
         if (operation.getTokenType() == lexer::TokenType::PLUS_SIGN)
         {
@@ -4,7 +4,9 @@
 #include "lexer.hh"
 #include <vector>
 #include <deque>
+#include <functional>
 #include <memory>
+#include <optional>
 
 namespace parser
 {
@@ -18,6 +20,7 @@ namespace parser
         FUNCTION_ARG,
         IF,
         WHILE,
+        IMPORT,
         BAD
     };
 
@@ -76,6 +79,7 @@ namespace parser
     {
     public:
         std::string identifier;
+        const parser::Stmt* declaration = nullptr;
     };
 
     class FunctionArgStmt : public Stmt
@@ -94,6 +98,19 @@ namespace parser
         parser::Type returnType;
     };
 
+    // import "lib.anchor"; Declares every function the library exports.
+    class ImportStmt : public Stmt
+    {
+    public:
+        std::string path;
+        // Signatures only. Their bodies are empty and never compiled.
+        std::vector<std::shared_ptr<parser::FunctionStmt>> declarations;
+    };
+
+    // Returns the functions the library at path exports, or throws
+    // std::runtime_error when it cannot be imported.
+    using Importer = std::function<std::vector<std::shared_ptr<parser::FunctionStmt>>(const std::string& path)>;
+
     class IfStmt : public Stmt
     {
     public:
@@ -119,6 +136,7 @@ namespace parser
     {
     public:
         std::string identifier;
+        const parser::Stmt* declaration = nullptr;
         std::shared_ptr<parser::Expr> expr;
     };
 
@@ -214,10 +232,15 @@ namespace parser
     {
     private:
         std::string message;
+        lexer::Location start;
+        lexer::Location end;
 
     public:
         explicit ErrorLog(const std::string&);
+        ErrorLog(const std::string&, const lexer::Location& start, const lexer::Location& end);
         std::string getMessage() const;
+        lexer::Location getStart() const;
+        lexer::Location getEnd() const;
     };
 
     class Program : public Stmt
@@ -237,14 +260,19 @@ namespace parser
     class Context {
     private:
         std::map<std::string, parser::Type> varIdToVarType;
+        std::map<std::string, const parser::Stmt*> varIdToDeclaration;
         std::map<std::string, parser::Type> functionIdToType;
         parser::Context* parent = nullptr;
     public:
         void setParent(parser::Context* parent);
+        bool isGlobal() const;
 
         void setType(const std::string&, parser::Type);
         parser::Type getType(const std::string&);
 
+        void setDeclaration(const std::string&, const parser::Stmt*);
+        const parser::Stmt* getDeclaration(const std::string&);
+
         void setFunctionType(const std::string&, parser::Type);
         parser::Type getFunctionType(const std::string&);
     };
@@ -253,8 +281,15 @@ namespace parser
     {
     private:
         parser::Context context;
+        parser::Importer importer;
 
-        std::deque<lexer::Token> tokens;
+        // Set when tokens are lexed as the parser reaches them rather than up front.
+        // They are then buffered here, and dropped once their statement is parsed.
+        lexer::Lexer* lexing = nullptr;
+        std::optional<std::deque<lexer::Token>> buffered;
+
+        const std::deque<lexer::Token>& tokens;
+        std::size_t position = 0;
         parser::Program compiling;
 
         std::vector<std::shared_ptr<parser::FunctionArgStmt>> args();
@@ -264,6 +299,7 @@ namespace parser
         std::vector<std::shared_ptr<Stmt>> block();
         std::shared_ptr<Stmt> stmt();
         std::shared_ptr<Stmt> functionStmt();
+        std::shared_ptr<Stmt> importStmt();
         std::shared_ptr<Stmt> printStmt();
         std::shared_ptr<Stmt> ifStmt();
         std::shared_ptr<Stmt> whileStmt();
@@ -278,13 +314,33 @@ namespace parser
         std::shared_ptr<parser::Expr> parseBoolean();
         parser::Operation parseOperation();
 
-        lexer::Token peek();
-        lexer::Token pop();
+        void fill(std::size_t index);
+        const lexer::Token& peek();
+        const lexer::Token& pop();
         void consume(lexer::TokenType);
 
     public:
-        explicit Parser(const std::deque<lexer::Token>&);
+        // Tokens are borrowed, not copied, and must outlive the parser.
+        // Without an importer, every import is an error.
+        explicit Parser(const std::deque<lexer::Token>&, parser::Importer importer = nullptr);
+        explicit Parser(std::deque<lexer::Token>&&) = delete;
+        // Lexes the source a statement at a time. The lexer is borrowed and must
+        // outlive the parser. Throws lexer::InvalidTokenException from next or parse
+        // when the source cannot be lexed.
+        explicit Parser(lexer::Lexer&, parser::Importer importer = nullptr);
         parser::Program parse();
+
+        // Parses one top-level statement, or returns nullptr at the end of the
+        // tokens. Nothing is kept of it, so a statement's tree lives only as long as
+        // the caller holds on to it. Errors collect in errors().
+        std::shared_ptr<Stmt> next();
+        const std::vector<parser::ErrorLog>& errors() const;
+        // Parses on from another lexer, keeping the context of every statement parsed
+        // so far, as a REPL does an input at a time. Clears errors(). Only a parser
+        // constructed from a lexer can switch to another.
+        void readFrom(lexer::Lexer&);
+        // Everything declared at the top level so far.
+        parser::Context& getContext();
     };
 };
 
@@ -0,0 +1,302 @@
+#include "src/protocol.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace protocol
+{
+    namespace
+    {
+        // Large enough for any source or object, small enough that a corrupt length
+        // is caught before allocating for it.
+        constexpr std::uint32_t maximumLength = 1u << 30;
+
+        // A peer that went away is an error on send, not a signal that ends the
+        // process. Linux says so per call, macOS and the BSDs per socket.
+#ifdef MSG_NOSIGNAL
+        constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+        constexpr int sendFlags = 0;
+#endif
+
+        // Keeps the socket from leaking into processes the server or client starts,
+        // and from raising SIGPIPE where sends cannot ask not to. Closes it on failure.
+        int configure(int fd)
+        {
+            bool configured = ::fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+#ifdef SO_NOSIGPIPE
+            int on = 1;
+            configured = configured && ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on)) == 0;
+#endif
+            if (!configured)
+            {
+                int error = errno;
+                ::close(fd);
+                errno = error;
+                return -1;
+            }
+            return fd;
+        }
+
+        int createSocket()
+        {
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || configure(fd) < 0)
+            {
+                throw std::runtime_error(std::string("Could not create a socket: ") + std::strerror(errno));
+            }
+            return fd;
+        }
+
+        // Returns false when the peer closed the connection before the first byte.
+        bool readExactly(int fd, char *data, std::size_t size)
+        {
+            std::size_t done = 0;
+            while (done < size)
+            {
+                ssize_t count = ::recv(fd, data + done, size - done, 0);
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (count < 0)
+                {
+                    throw std::runtime_error(std::string("Could not read from the compile server connection: ") + std::strerror(errno));
+                }
+                if (count == 0)
+                {
+                    if (done == 0)
+                    {
+                        return false;
+                    }
+                    throw std::runtime_error("The compile server connection closed in the middle of a message.");
+                }
+                done += static_cast<std::size_t>(count);
+            }
+            return true;
+        }
+
+        void writeExactly(int fd, const char *data, std::size_t size)
+        {
+            std::size_t done = 0;
+            while (done < size)
+            {
+                ssize_t count = ::send(fd, data + done, size - done, sendFlags);
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (count < 0)
+                {
+                    throw std::runtime_error(std::string("Could not write to the compile server connection: ") + std::strerror(errno));
+                }
+                done += static_cast<std::size_t>(count);
+            }
+        }
+
+        void writeNumber(std::string &buffer, std::uint32_t number)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                buffer.push_back(static_cast<char>((number >> (8 * i)) & 0xff));
+            }
+        }
+
+        void writeString(std::string &buffer, const std::string &string)
+        {
+            if (string.size() > maximumLength)
+            {
+                throw std::runtime_error("Cannot send " + std::to_string(string.size()) + " bytes to the compile server in one message.");
+            }
+            writeNumber(buffer, static_cast<std::uint32_t>(string.size()));
+            buffer += string;
+        }
+
+        std::optional<std::uint32_t> readNumber(int fd)
+        {
+            unsigned char bytes[4];
+            if (!readExactly(fd, reinterpret_cast<char *>(bytes), sizeof(bytes)))
+            {
+                return std::nullopt;
+            }
+            return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 | static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+        }
+
+        std::uint32_t expectNumber(int fd)
+        {
+            std::optional<std::uint32_t> number = readNumber(fd);
+            if (!number.has_value())
+            {
+                throw std::runtime_error("The compile server connection closed in the middle of a message.");
+            }
+            return *number;
+        }
+
+        std::string readString(int fd)
+        {
+            std::uint32_t length = expectNumber(fd);
+            if (length > maximumLength)
+            {
+                throw std::runtime_error("Received a string of " + std::to_string(length) + " bytes from the compile server connection, which is more than any message holds.");
+            }
+            std::string string(length, '\0');
+            if (length > 0 && !readExactly(fd, string.data(), length))
+            {
+                throw std::runtime_error("The compile server connection closed in the middle of a message.");
+            }
+            return string;
+        }
+
+        sockaddr_un address(const std::string &socketPath)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+            {
+                throw std::invalid_argument("Cannot use " + socketPath + " as a socket, its path must be from 1 to " + std::to_string(sizeof(address.sun_path) - 1) + " bytes long.");
+            }
+            std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+            return address;
+        }
+
+        // Returns a connected socket, or -1 with the reason in error.
+        int tryConnect(const sockaddr_un &server, int &error)
+        {
+            int fd = createSocket();
+            if (::connect(fd, reinterpret_cast<const sockaddr *>(&server), sizeof(server)) != 0)
+            {
+                error = errno;
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+    }
+
+    std::string defaultSocketPath()
+    {
+        if (const char *runtime = std::getenv("XDG_RUNTIME_DIR"); runtime != nullptr && *runtime != '\0')
+        {
+            return std::string(runtime) + "/anchor.sock";
+        }
+        return "/tmp/anchor-" + std::to_string(::getuid()) + ".sock";
+    }
+
+    void writeRequest(int fd, const protocol::Request &request)
+    {
+        std::string buffer;
+        writeNumber(buffer, static_cast<std::uint32_t>(request.args.size()));
+        for (const std::string &arg : request.args)
+        {
+            writeString(buffer, arg);
+        }
+        writeString(buffer, request.workingDirectory);
+        writeString(buffer, request.input);
+        writeExactly(fd, buffer.data(), buffer.size());
+    }
+
+    std::optional<protocol::Request> readRequest(int fd)
+    {
+        std::optional<std::uint32_t> count = readNumber(fd);
+        if (!count.has_value())
+        {
+            return std::nullopt;
+        }
+
+        protocol::Request request;
+        for (std::uint32_t i = 0; i < *count; i++)
+        {
+            request.args.push_back(readString(fd));
+        }
+        request.workingDirectory = readString(fd);
+        request.input = readString(fd);
+        return request;
+    }
+
+    void writeResponse(int fd, const protocol::Response &response)
+    {
+        std::string buffer;
+        writeNumber(buffer, static_cast<std::uint32_t>(response.exitCode));
+        writeString(buffer, response.out);
+        writeString(buffer, response.err);
+        writeExactly(fd, buffer.data(), buffer.size());
+    }
+
+    protocol::Response readResponse(int fd)
+    {
+        protocol::Response response;
+        response.exitCode = static_cast<int>(expectNumber(fd));
+        response.out = readString(fd);
+        response.err = readString(fd);
+        return response;
+    }
+
+    int listen(const std::string &socketPath)
+    {
+        sockaddr_un listening = address(socketPath);
+
+        // A socket file nobody answers on is left over from a server that died.
+        int error = 0;
+        int running = tryConnect(listening, error);
+        if (running >= 0)
+        {
+            ::close(running);
+            throw std::runtime_error("A compile server is already listening on " + socketPath + ".");
+        }
+        if (error == ECONNREFUSED)
+        {
+            ::unlink(socketPath.c_str());
+        }
+
+        int fd = createSocket();
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&listening), sizeof(listening)) != 0 || ::listen(fd, SOMAXCONN) != 0)
+        {
+            error = errno;
+            ::close(fd);
+            throw std::runtime_error("Could not listen on " + socketPath + ": " + std::strerror(error));
+        }
+        return fd;
+    }
+
+    int accept(int listening)
+    {
+        int fd = ::accept(listening, nullptr, nullptr);
+        return fd < 0 ? fd : configure(fd);
+    }
+
+    int connect(const std::string &socketPath)
+    {
+        int error = 0;
+        int fd = tryConnect(address(socketPath), error);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Could not connect to the compile server on " + socketPath + ": " + std::strerror(error));
+        }
+        return fd;
+    }
+
+    protocol::Response send(const std::string &socketPath, const protocol::Request &request)
+    {
+        int fd = protocol::connect(socketPath);
+        try
+        {
+            protocol::writeRequest(fd, request);
+            protocol::Response response = protocol::readResponse(fd);
+            ::close(fd);
+            return response;
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+    }
+}
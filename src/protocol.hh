@@ -0,0 +1,58 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// What the compile server and its clients say to each other over a Unix domain
+// socket. Numbers are sent as little-endian 32-bit integers, and strings as their
+// length followed by their bytes. A connection carries any number of requests,
+// each answered before the next is read. Nothing here depends on LLVM, so
+// clients start as fast as any small process.
+namespace protocol
+{
+    // One command line, as main would have been given it.
+    class Request
+    {
+    public:
+        // Without the program name.
+        std::vector<std::string> args;
+        std::string workingDirectory;
+        // Standard input, when no input file is given.
+        std::string input;
+    };
+
+    class Response
+    {
+    public:
+        int exitCode = 0;
+        std::string out;
+        std::string err;
+    };
+
+    // $XDG_RUNTIME_DIR/anchor.sock, or /tmp/anchor-<uid>.sock when it is not set.
+    std::string defaultSocketPath();
+
+    // Each throws std::runtime_error when the peer goes away mid-message.
+    void writeRequest(int fd, const protocol::Request &);
+    // Nothing when the peer closed the connection between requests.
+    std::optional<protocol::Request> readRequest(int fd);
+    void writeResponse(int fd, const protocol::Response &);
+    protocol::Response readResponse(int fd);
+
+    // Returns a listening socket. Throws std::invalid_argument when the path is
+    // too long for a socket address, and std::runtime_error when a server is
+    // already listening there or the socket cannot be bound.
+    int listen(const std::string &socketPath);
+    // Returns the next connection to a listening socket, or -1 with the reason in
+    // errno.
+    int accept(int listening);
+    // Returns a connected socket. Throws std::runtime_error when nothing listens.
+    int connect(const std::string &socketPath);
+
+    // Connects, sends the request and waits for its response.
+    protocol::Response send(const std::string &socketPath, const protocol::Request &);
+}
+
+#endif // PROTOCOL_H
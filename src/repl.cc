@@ -0,0 +1,262 @@
+#include "src/repl.hh"
+
+#include <cstdio>
+#include <stdexcept>
+
+namespace repl
+{
+    namespace
+    {
+        bool containsReturn(const std::vector<std::shared_ptr<parser::Stmt>> &stmts)
+        {
+            for (const auto &stmt : stmts)
+            {
+                if (stmt->type == parser::StmtType::RETURN)
+                {
+                    return true;
+                }
+                if (stmt->type == parser::StmtType::IF && containsReturn(std::static_pointer_cast<parser::IfStmt>(stmt)->stmts))
+                {
+                    return true;
+                }
+                if (stmt->type == parser::StmtType::WHILE && containsReturn(std::static_pointer_cast<parser::WhileStmt>(stmt)->stmts))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool sameSignature(const parser::FunctionStmt &defined, const parser::FunctionStmt &redefined)
+        {
+            if (defined.returnType != redefined.returnType || defined.args.size() != redefined.args.size())
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < defined.args.size(); i++)
+            {
+                if (defined.args[i]->returnType != redefined.args[i]->returnType)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    bool isComplete(std::string_view source)
+    {
+        std::deque<lexer::Token> tokens;
+        try
+        {
+            tokens = lexer::lex(source);
+        }
+        catch (lexer::InvalidTokenException &)
+        {
+            return true;
+        }
+
+        int depth = 0;
+        lexer::TokenType last = lexer::TokenType::END_OF_STREAM;
+        for (const lexer::Token &token : tokens)
+        {
+            lexer::TokenType tokenType = token.getTokenType();
+            if (tokenType == lexer::TokenType::LEFT_BRACKET || tokenType == lexer::TokenType::LEFT_PAREN)
+            {
+                depth++;
+            }
+            else if (tokenType == lexer::TokenType::RIGHT_BRACKET || tokenType == lexer::TokenType::RIGHT_PAREN)
+            {
+                depth--;
+            }
+            if (tokenType != lexer::TokenType::END_OF_STREAM)
+            {
+                last = tokenType;
+            }
+        }
+        return depth <= 0 && last == lexer::TokenType::SEMICOLON;
+    }
+
+    Repl::Repl(jit::Jit &jit, compiler::OptimizationLevel optimizationLevel) : jit(jit), optimizationLevel(optimizationLevel), lexer(this->source), parser(this->lexer)
+    {
+    }
+
+    std::string Repl::evaluate(const std::string &input)
+    {
+        this->source = input;
+        this->lexer = lexer::Lexer(this->source);
+        this->parser.readFrom(this->lexer);
+
+        try
+        {
+            while (std::shared_ptr<parser::Stmt> stmt = this->parser.next())
+            {
+                if (!this->parser.errors().empty())
+                {
+                    if (stmt->type == parser::StmtType::FUNCTION)
+                    {
+                        this->forget(std::static_pointer_cast<parser::FunctionStmt>(stmt)->identifier);
+                    }
+
+                    std::string messages;
+                    for (const parser::ErrorLog &error : this->parser.errors())
+                    {
+                        messages += error.getMessage() + '\n';
+                    }
+                    return messages;
+                }
+
+                if (stmt->type == parser::StmtType::FUNCTION)
+                {
+                    this->define(std::static_pointer_cast<parser::FunctionStmt>(stmt));
+                }
+                else if (stmt->type == parser::StmtType::VAR_DECL)
+                {
+                    this->declare(std::static_pointer_cast<parser::VarDeclStmt>(stmt));
+                }
+                else
+                {
+                    this->execute(stmt);
+                }
+            }
+        }
+        catch (std::invalid_argument &e)
+        {
+            return std::string(e.what()) + '\n';
+        }
+        catch (std::runtime_error &e)
+        {
+            return std::string(e.what()) + '\n';
+        }
+        return "";
+    }
+
+    void Repl::run(std::istream &in, std::ostream &out, std::ostream &err, bool prompt)
+    {
+        std::string input;
+        while (true)
+        {
+            if (prompt)
+            {
+                out << (input.empty() ? "> " : "... ") << std::flush;
+            }
+
+            std::string line;
+            if (!std::getline(in, line))
+            {
+                break;
+            }
+            input += line + '\n';
+            if (input.find_first_not_of(" \t\r\n") == std::string::npos)
+            {
+                input.clear();
+            }
+            else if (isComplete(input))
+            {
+                err << this->evaluate(input);
+                input.clear();
+            }
+        }
+
+        // Whatever is left is reported as the statement it fails to be.
+        if (!input.empty())
+        {
+            err << this->evaluate(input);
+        }
+        if (prompt)
+        {
+            out << '\n';
+        }
+    }
+
+    std::unique_ptr<compiler::Compiler> Repl::startModule()
+    {
+        auto compiler = std::make_unique<compiler::Compiler>(this->optimizationLevel);
+        compiler->declareElsewhere(this->functions);
+        compiler->declareGlobals(this->globals);
+        return compiler;
+    }
+
+    // Names are never reused, so nothing compiled before is ever redefined.
+    std::string Repl::nextName(const std::string &prefix)
+    {
+        return prefix + "." + std::to_string(this->modules++);
+    }
+
+    void Repl::add(compiler::Compiler &compiler)
+    {
+        compiler.finish();
+        auto [context, module] = compiler.release();
+        this->jit.add(std::move(context), std::move(module));
+    }
+
+    void Repl::forget(const std::string &identifier)
+    {
+        auto defined = this->functions.find(identifier);
+        this->parser.getContext().setFunctionType(identifier, defined != this->functions.end() ? defined->second->returnType : parser::Type::NOT_FOUND);
+    }
+
+    void Repl::define(std::shared_ptr<parser::FunctionStmt> functionStmt)
+    {
+        auto defined = this->functions.find(functionStmt->identifier);
+        if (defined != this->functions.end() && !sameSignature(*defined->second, *functionStmt))
+        {
+            this->forget(functionStmt->identifier);
+            throw std::invalid_argument("Cannot redefine " + functionStmt->identifier + " with another signature, code compiled already calls it with the old one.");
+        }
+
+        std::unique_ptr<compiler::Compiler> compiler = this->startModule();
+        try
+        {
+            compiler->compileNext(functionStmt);
+            compiler->finish();
+        }
+        catch (...)
+        {
+            this->forget(functionStmt->identifier);
+            throw;
+        }
+        auto [context, module] = compiler->release();
+
+        // Recursive calls stay within this definition. Every other call goes through the stub.
+        std::string implementation = this->nextName(functionStmt->identifier);
+        module->getFunction(functionStmt->identifier)->setName(implementation);
+        this->jit.add(std::move(context), std::move(module));
+        this->jit.rebind(functionStmt->identifier, implementation);
+        this->functions.insert_or_assign(functionStmt->identifier, std::move(functionStmt));
+    }
+
+    void Repl::declare(std::shared_ptr<parser::VarDeclStmt> varDeclStmt)
+    {
+        std::unique_ptr<compiler::Compiler> compiler = this->startModule();
+        std::string name = this->nextName(varDeclStmt->identifier);
+        compiler->defineGlobal(*varDeclStmt, name);
+        this->add(*compiler);
+
+        this->globals.emplace(varDeclStmt.get(), std::move(name));
+        this->declarations.push_back(std::move(varDeclStmt));
+    }
+
+    void Repl::execute(std::shared_ptr<parser::Stmt> stmt)
+    {
+        if (containsReturn({stmt}))
+        {
+            throw std::invalid_argument("Cannot return outside a function.");
+        }
+
+        auto wrapper = std::make_shared<parser::FunctionStmt>();
+        wrapper->type = parser::StmtType::FUNCTION;
+        wrapper->identifier = this->nextName("repl");
+        wrapper->returnType = parser::Type::VOID;
+        wrapper->stmts.push_back(std::move(stmt));
+
+        std::unique_ptr<compiler::Compiler> compiler = this->startModule();
+        compiler->compileNext(wrapper);
+        this->add(*compiler);
+
+        auto run = reinterpret_cast<void (*)()>(this->jit.lookup(wrapper->identifier));
+        run();
+        // The statement printed through this process' stdio buffers.
+        std::fflush(stdout);
+    }
+}
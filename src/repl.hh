@@ -0,0 +1,79 @@
+#ifndef REPL_H
+#define REPL_H
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/lexer.hh"
+#include "src/parser.hh"
+
+namespace repl
+{
+    // True once source holds whole statements: every brace and parenthesis it opens
+    // is closed, and it ends in a semicolon. Source that cannot be lexed counts as
+    // complete, so its diagnostic is reported rather than waited on.
+    bool isComplete(std::string_view source);
+
+    // Runs anchor an input at a time in one JIT session that lasts as long as the
+    // Repl. Each input is parsed against the context of every input before it, and
+    // each of its statements is compiled into a module of its own and added to the
+    // session, so an input costs the same however long the session has run.
+    //
+    // A function is compiled under a name of its own and bound to its real name
+    // with jit::Jit::rebind. Redefining it rebinds every caller without
+    // recompiling one, so the new definition must keep the old signature. A
+    // top-level variable lives in a global. Any other statement is wrapped in a
+    // function of its own and runs at once.
+    class Repl
+    {
+    private:
+        jit::Jit &jit;
+        compiler::OptimizationLevel optimizationLevel;
+
+        std::string source;
+        lexer::Lexer lexer;
+        parser::Parser parser;
+
+        // The latest definition of every function, for the signatures calls use.
+        compiler::Signatures functions;
+        // The parser's context refers to top-level declarations by address, so they
+        // are kept for the whole session.
+        std::vector<std::shared_ptr<parser::VarDeclStmt>> declarations;
+        compiler::Globals globals;
+        std::size_t modules = 0;
+
+        std::unique_ptr<compiler::Compiler> startModule();
+        std::string nextName(const std::string &prefix);
+        void add(compiler::Compiler &compiler);
+        // The parser takes a definition's return type as soon as it reads it. Puts
+        // back the one from the last definition that compiled, if any.
+        void forget(const std::string &identifier);
+        void define(std::shared_ptr<parser::FunctionStmt> functionStmt);
+        void declare(std::shared_ptr<parser::VarDeclStmt> varDeclStmt);
+        void execute(std::shared_ptr<parser::Stmt> stmt);
+
+    public:
+        explicit Repl(jit::Jit &jit, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+
+        Repl(const Repl &) = delete;
+        Repl &operator=(const Repl &) = delete;
+
+        // Parses, compiles and runs each statement of input in turn. Stops at the
+        // first one with diagnostics, or that cannot be compiled, and returns its
+        // messages a line each. The statements before it have run.
+        std::string evaluate(const std::string &input);
+        // Evaluates what in holds, an input of whole statements at a time, until it
+        // ends. Prompts for each line on out when prompt is set, and writes
+        // diagnostics to err.
+        void run(std::istream &in, std::ostream &out, std::ostream &err, bool prompt);
+    };
+}
+
+#endif // REPL_H
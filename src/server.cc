@@ -0,0 +1,164 @@
+#include "src/server.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "src/driver.hh"
+
+namespace server
+{
+    unsigned defaultThreads()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    Server::Server(std::string socketPath, unsigned threads) : socketPath(std::move(socketPath)), threads(threads)
+    {
+        if (threads == 0)
+        {
+            throw std::invalid_argument("Cannot serve requests on 0 threads.");
+        }
+
+        this->compilers.warm(compiler::OptimizationLevel::O0, threads);
+
+        this->listening = protocol::listen(this->socketPath);
+    }
+
+    Server::~Server()
+    {
+        ::close(this->listening);
+        ::unlink(this->socketPath.c_str());
+    }
+
+    void Server::run()
+    {
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < this->threads; i++)
+        {
+            workers.emplace_back(&Server::work, this);
+        }
+
+        while (true)
+        {
+            int connection = protocol::accept(this->listening);
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->stopping)
+            {
+                if (connection >= 0)
+                {
+                    ::close(connection);
+                }
+                break;
+            }
+            if (connection < 0)
+            {
+                // A client that gave up before being accepted is not the server's problem.
+                continue;
+            }
+            this->waiting.push_back(connection);
+            this->ready.notify_one();
+        }
+
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    void Server::stop()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        // Wakes the accept loop, and every worker waiting for another request on
+        // a connection, without dropping a request already read.
+        ::shutdown(this->listening, SHUT_RDWR);
+        for (int connection : this->connected)
+        {
+            ::shutdown(connection, SHUT_RD);
+        }
+        this->ready.notify_all();
+    }
+
+    void Server::work()
+    {
+        while (true)
+        {
+            int connection;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->ready.wait(lock, [this]()
+                                 { return this->stopping || !this->waiting.empty(); });
+                if (this->waiting.empty())
+                {
+                    return;
+                }
+                connection = this->waiting.front();
+                this->waiting.pop_front();
+                this->connected.insert(connection);
+                if (this->stopping)
+                {
+                    ::shutdown(connection, SHUT_RD);
+                }
+            }
+
+            this->serve(connection);
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->connected.erase(connection);
+            ::close(connection);
+        }
+    }
+
+    void Server::serve(int connection)
+    {
+        try
+        {
+            while (std::optional<protocol::Request> request = protocol::readRequest(connection))
+            {
+                protocol::writeResponse(connection, this->handle(*request));
+            }
+        }
+        catch (std::runtime_error &)
+        {
+            // The client went away or sent something that is not a request. Either
+            // way there is no one to tell.
+        }
+    }
+
+    protocol::Response Server::handle(const protocol::Request &request)
+    {
+        std::istringstream in(request.input);
+        std::ostringstream out;
+        std::ostringstream err;
+        driver::Environment environment(request.workingDirectory, in, out, err);
+        environment.compilers = &this->compilers;
+        environment.canRun = false;
+
+        std::vector<const char *> argv{"anchor"};
+        for (const std::string &arg : request.args)
+        {
+            argv.push_back(arg.c_str());
+        }
+
+        protocol::Response response;
+        try
+        {
+            response.exitCode = driver::run(static_cast<int>(argv.size()), argv.data(), environment);
+        }
+        catch (std::exception &e)
+        {
+            err << e.what() << '\n';
+            response.exitCode = 1;
+        }
+        response.out = out.str();
+        response.err = err.str();
+        return response;
+    }
+}
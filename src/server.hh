@@ -0,0 +1,61 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "src/compilerpool.hh"
+#include "src/protocol.hh"
+
+namespace server
+{
+    unsigned defaultThreads();
+
+    // Answers protocol::Requests on a Unix domain socket by running them through
+    // driver::run, as main would, on a pool of threads that share warm compilers.
+    // The process, LLVM's initialization and the compilers outlive every request,
+    // so a client pays only for connecting and compiling.
+    //
+    // Requests cannot run programs, and imports and cached artifacts are resolved
+    // against the client's working directory rather than the server's.
+    class Server
+    {
+    private:
+        std::string socketPath;
+        int listening;
+        unsigned threads;
+        compiler::CompilerPool compilers;
+
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<int> waiting;
+        std::set<int> connected;
+        bool stopping = false;
+
+        void work();
+        void serve(int connection);
+
+    public:
+        // Listens straight away, so clients can connect before run is called.
+        // Throws like protocol::listen.
+        explicit Server(std::string socketPath, unsigned threads = server::defaultThreads());
+        ~Server();
+
+        Server(const Server &) = delete;
+        Server &operator=(const Server &) = delete;
+
+        // Accepts connections until stop is called, then waits for the requests
+        // already read to be answered.
+        void run();
+        // May be called from any thread, before or during run.
+        void stop();
+
+        protocol::Response handle(const protocol::Request &);
+    };
+}
+
+#endif // SERVER_H
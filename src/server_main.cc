@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cctype>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "protocol.hh"
+#include "server.hh"
+
+// Serves compile requests from anchor_client until interrupted or terminated.
+int main(int argc, char *argv[])
+{
+    std::string socketPath = protocol::defaultSocketPath();
+    unsigned threads = server::defaultThreads();
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        std::string count = arg.starts_with("--threads=") ? arg.substr(std::string("--threads=").length()) : "";
+        if (arg.starts_with("--socket=") && arg.length() > std::string("--socket=").length())
+        {
+            socketPath = arg.substr(std::string("--socket=").length());
+        }
+        else if (!count.empty() && count.length() <= 4 && std::all_of(count.begin(), count.end(), ::isdigit) && std::stoi(count) > 0)
+        {
+            threads = static_cast<unsigned>(std::stoi(count));
+        }
+        else
+        {
+            std::cerr << "Usage: anchor_server [--socket=path] [--threads=n]\n";
+            return 1;
+        }
+    }
+
+    // Signals are taken on a thread of their own, which can safely stop the server.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try
+    {
+        server::Server server(socketPath, threads);
+        std::thread waiter([&server, &signals]()
+                           {
+                               int signal;
+                               sigwait(&signals, &signal);
+                               server.stop(); });
+        waiter.detach();
+
+        std::cerr << "Listening on " << socketPath << " with " << threads << " threads.\n";
+        server.run();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include "src/streaming.hh"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/ModuleSlotTracker.h"
+#include "llvm/IR/TypeFinder.h"
+
+#include <algorithm>
+#include <optional>
+
+#include "src/lexer.hh"
+#include "src/parser.hh"
+
+namespace streaming
+{
+    StreamingCompiler::StreamingCompiler(compiler::OptimizationLevel optimizationLevel, Emit emit, std::size_t chunkSize) : optimizationLevel(optimizationLevel), chunkSize(std::max<std::size_t>(chunkSize, 1)), emit(std::move(emit))
+    {
+    }
+
+    void StreamingCompiler::compile(anchor::CompilationUnit &unit)
+    {
+        unit.tokens.clear();
+        unit.program = parser::Program();
+        this->signatures.clear();
+        this->chunk.reset();
+        this->functions = 0;
+        this->chunks = 0;
+
+        lexer::Lexer lexer(unit.source);
+        parser::Parser parser(lexer, unit.importer);
+        std::optional<parser::ErrorLog> invalidToken;
+        try
+        {
+            while (std::shared_ptr<parser::Stmt> stmt = parser.next())
+            {
+                if (parser.errors().empty())
+                {
+                    this->add(std::move(stmt));
+                }
+            }
+        }
+        catch (lexer::InvalidTokenException &ite)
+        {
+            invalidToken.emplace(ite.what(), ite.location, ite.location);
+        }
+
+        unit.diagnostics.insert(unit.diagnostics.end(), parser.errors().begin(), parser.errors().end());
+        if (invalidToken.has_value())
+        {
+            unit.diagnostics.push_back(*invalidToken);
+        }
+
+        if (unit.hasErrors())
+        {
+            this->chunk.reset();
+        }
+        else if (this->chunk != nullptr || this->chunks == 0)
+        {
+            this->flush();
+        }
+        this->signatures.clear();
+    }
+
+    std::size_t StreamingCompiler::size() const
+    {
+        return this->chunks;
+    }
+
+    void StreamingCompiler::add(std::shared_ptr<parser::Stmt> stmt)
+    {
+        if (stmt->type == parser::StmtType::IMPORT)
+        {
+            for (const auto &declaration : std::static_pointer_cast<parser::ImportStmt>(stmt)->declarations)
+            {
+                this->signatures.emplace(declaration->identifier, declaration);
+            }
+            return;
+        }
+
+        if (this->chunk == nullptr)
+        {
+            this->chunk = std::make_unique<compiler::Compiler>(this->optimizationLevel);
+            this->chunk->declareElsewhere(this->signatures);
+        }
+        this->chunk->compileNext(stmt);
+
+        if (stmt->type != parser::StmtType::FUNCTION)
+        {
+            return;
+        }
+
+        // Later chunks only need to know how to call it.
+        auto functionStmt = std::static_pointer_cast<parser::FunctionStmt>(stmt);
+        auto signature = std::make_shared<parser::FunctionStmt>();
+        signature->type = parser::StmtType::FUNCTION;
+        signature->identifier = functionStmt->identifier;
+        signature->args = functionStmt->args;
+        signature->returnType = functionStmt->returnType;
+        this->signatures.emplace(signature->identifier, std::move(signature));
+
+        if (++this->functions == this->chunkSize)
+        {
+            this->flush();
+        }
+    }
+
+    void StreamingCompiler::flush()
+    {
+        if (this->chunk == nullptr)
+        {
+            this->chunk = std::make_unique<compiler::Compiler>(this->optimizationLevel);
+        }
+        this->chunk->finish();
+        this->emit(*this->chunk);
+        this->chunk.reset();
+        this->functions = 0;
+        this->chunks++;
+    }
+
+    IRWriter::IRWriter(llvm::raw_ostream &out) : out(out)
+    {
+    }
+
+    void IRWriter::write(llvm::Module &chunk)
+    {
+        if (this->chunks == 0)
+        {
+            this->out << "; ModuleID = '" << chunk.getModuleIdentifier() << "'\n";
+            this->out << "source_filename = \"";
+            llvm::printEscapedString(chunk.getSourceFileName(), this->out);
+            this->out << "\"\n";
+            this->out << "target datalayout = \"" << chunk.getDataLayoutStr() << "\"\n";
+            this->out << "target triple = \"" << chunk.getTargetTriple() << "\"\n";
+        }
+
+        // Unnamed types and globals are numbered per module, so they are named
+        // here, the same way in every chunk for types and uniquely for globals.
+        bool printed = false;
+        llvm::TypeFinder structTypes;
+        structTypes.run(chunk, false);
+        for (llvm::StructType *type : structTypes)
+        {
+            if (!type->hasName())
+            {
+                type->setName("anchor.type");
+            }
+            if (this->types.insert(type->getName().str()).second)
+            {
+                this->out << (printed ? "" : "\n");
+                type->print(this->out);
+                this->out << '\n';
+                printed = true;
+            }
+        }
+
+        std::size_t index = 0;
+        printed = false;
+        for (llvm::GlobalVariable &global : chunk.globals())
+        {
+            if (global.hasLocalLinkage())
+            {
+                global.setName("chunk" + std::to_string(this->chunks) + "." + std::to_string(index++));
+            }
+        }
+
+        llvm::LLVMContext &context = chunk.getContext();
+        for (llvm::Function &function : chunk)
+        {
+            function.setAttributes(function.getAttributes().removeFnAttributes(context));
+            for (llvm::BasicBlock &block : function)
+            {
+                for (llvm::Instruction &instruction : block)
+                {
+                    if (auto *call = llvm::dyn_cast<llvm::CallBase>(&instruction))
+                    {
+                        call->setAttributes(call->getAttributes().removeFnAttributes(context));
+                    }
+                }
+            }
+        }
+
+        // Function::print would number the module's slots again for every function.
+        llvm::ModuleSlotTracker tracker(&chunk);
+        for (llvm::GlobalVariable &global : chunk.globals())
+        {
+            this->out << (printed ? "" : "\n");
+            global.print(this->out, tracker);
+            this->out << '\n';
+            printed = true;
+        }
+
+        for (llvm::Function &function : chunk)
+        {
+            std::string name = function.getName().str();
+            if (function.isDeclaration())
+            {
+                // An earlier chunk's functions are defined already.
+                if (!this->defined.contains(name) && !this->declarations.contains(name))
+                {
+                    std::string declaration;
+                    llvm::raw_string_ostream declarationStream(declaration);
+                    function.llvm::Value::print(declarationStream, tracker);
+                    declarationStream.flush();
+                    this->declarations.emplace(name, std::move(declaration));
+                }
+                continue;
+            }
+
+            this->defined.insert(std::move(name));
+            this->out << '\n';
+            function.llvm::Value::print(this->out, tracker);
+        }
+        this->chunks++;
+    }
+
+    void IRWriter::finish()
+    {
+        for (const auto &[name, declaration] : this->declarations)
+        {
+            if (!this->defined.contains(name))
+            {
+                this->out << '\n'
+                          << declaration;
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "src/compilationunit.hh"
+#include "src/compiler.hh"
+#include "src/parallel.hh"
+
+namespace streaming
+{
+    constexpr std::size_t defaultChunkSize = parallel::defaultPartitionSize;
+
+    // Compiles a source as it is lexed and parsed, one top-level statement at a
+    // time, without ever holding all of its tokens, its tree or its module.
+    //
+    // A function's tree is let go as soon as it has been lowered, and only its
+    // signature is kept. Functions are lowered into a chunk of chunkSize, with a
+    // compiler::Compiler, and so a context and module, of its own. A full chunk is
+    // optimized, handed to emit and destroyed before the next one starts. Peak
+    // memory then follows the chunk size rather than the size of the program.
+    //
+    // Like a partition of parallel::PartitionedCompiler, a chunk calls functions
+    // of earlier chunks through declarations, so those calls cannot be inlined.
+    class StreamingCompiler
+    {
+    public:
+        using Emit = std::function<void(compiler::Compiler &)>;
+
+    private:
+        compiler::OptimizationLevel optimizationLevel;
+        std::size_t chunkSize;
+        Emit emit;
+
+        compiler::Signatures signatures;
+        std::unique_ptr<compiler::Compiler> chunk;
+        std::size_t functions = 0;
+        std::size_t chunks = 0;
+
+        void add(std::shared_ptr<parser::Stmt> stmt);
+        void flush();
+
+    public:
+        StreamingCompiler(compiler::OptimizationLevel optimizationLevel, Emit emit, std::size_t chunkSize = streaming::defaultChunkSize);
+
+        // Lexes, parses and compiles unit.source, leaving unit.tokens and
+        // unit.program empty. Once a diagnostic is found nothing more is compiled or
+        // emitted, though the rest of the source is still parsed for diagnostics.
+        // Chunks emitted before it stay emitted. Even a program without functions
+        // is emitted as one chunk.
+        void compile(anchor::CompilationUnit &unit);
+        // The number of chunks emitted so far.
+        std::size_t size() const;
+    };
+
+    // Prints the chunks of one program as a single module of textual IR, a chunk at
+    // a time. Each chunk's definitions are printed as they arrive, and the
+    // declarations no chunk defines once the last has been written.
+    //
+    // Function attributes are printed as attribute groups numbered per module, so
+    // chunks drop those the optimizer inferred. Parameter and return attributes are
+    // kept. Private globals are renamed to be unique across chunks.
+    class IRWriter
+    {
+    private:
+        llvm::raw_ostream &out;
+        std::size_t chunks = 0;
+        std::set<std::string> types;
+        std::set<std::string> defined;
+        std::map<std::string, std::string> declarations;
+
+    public:
+        explicit IRWriter(llvm::raw_ostream &out);
+
+        void write(llvm::Module &chunk);
+        void finish();
+    };
+}
+
+#endif // STREAMING_H
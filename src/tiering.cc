@@ -0,0 +1,130 @@
+#include "src/tiering.hh"
+
+#include <atomic>
+
+namespace tiering
+{
+    namespace
+    {
+        void tierUp(tiering::TieredJit *runtime, const char *identifier)
+        {
+            runtime->tierUp(identifier);
+        }
+    }
+
+    TieredJit::TieredJit(jit::Jit &baseline, const parser::Program &program, int threshold, bool background) : baseline(baseline), program(program), threshold(threshold), background(background)
+    {
+    }
+
+    TieredJit::~TieredJit()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->wakeup.notify_all();
+        if (this->worker.joinable())
+        {
+            this->worker.join();
+        }
+    }
+
+    int TieredJit::runMain()
+    {
+        compiler::Compiler compiler(compiler::OptimizationLevel::O0);
+        compiler.compileBaselineTier(this->program, this->threshold);
+
+        this->baseline.define("anchor.tiering", this);
+        this->baseline.define("anchor.tierUp", reinterpret_cast<void *>(&tiering::tierUp));
+        auto [context, module] = compiler.release();
+        this->baseline.add(std::move(context), std::move(module));
+
+        if (this->background)
+        {
+            this->worker = std::thread(&TieredJit::work, this);
+        }
+        return this->baseline.runMain();
+    }
+
+    void TieredJit::tierUp(const std::string &identifier)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->reported.insert(identifier).second)
+            {
+                return;
+            }
+        }
+
+        if (!this->background)
+        {
+            this->promote(identifier);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->hot.push_back(identifier);
+        }
+        this->wakeup.notify_one();
+    }
+
+    void TieredJit::work()
+    {
+        while (true)
+        {
+            std::string identifier;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->wakeup.wait(lock, [this]()
+                                  { return this->stopping || !this->hot.empty(); });
+                if (this->stopping)
+                {
+                    return;
+                }
+                identifier = std::move(this->hot.front());
+                this->hot.pop_front();
+            }
+
+            try
+            {
+                this->promote(identifier);
+            }
+            catch (std::exception &)
+            {
+                // The baseline code is still correct, so the program carries on using it.
+            }
+        }
+    }
+
+    void TieredJit::promote(const std::string &identifier)
+    {
+        compiler::Compiler compiler(compiler::OptimizationLevel::O2);
+        compiler.compileOptimizedTier(this->program, identifier);
+        auto [context, module] = compiler.release();
+
+        // Entry pointers, and any host functions the baseline has overridden, live in the baseline JIT.
+        for (const llvm::GlobalValue &global : module->global_values())
+        {
+            std::string name = global.getName().str();
+            if (global.isDeclaration() && !global.getName().startswith("llvm.") && this->bridged.insert(name).second)
+            {
+                this->optimizing.define(name, this->baseline.lookup(name));
+            }
+        }
+        this->optimizing.add(std::move(context), std::move(module));
+
+        void *optimized = this->optimizing.lookup(identifier + ".tier2");
+        auto *entry = static_cast<std::atomic<void *> *>(this->baseline.lookup(identifier + ".entry"));
+        entry->store(optimized, std::memory_order_release);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->promoted.push_back(identifier);
+    }
+
+    std::vector<std::string> TieredJit::getPromoted()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->promoted;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef TIERING_H
+#define TIERING_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "src/jit.hh"
+#include "src/parser.hh"
+
+namespace tiering
+{
+    constexpr int defaultThreshold = 1000;
+
+    // Runs a program in two tiers. Every function starts out compiled at -O0 with a
+    // counter of its calls and loop iterations, in the given JIT. A function whose
+    // counter reaches threshold is recompiled at -O2, by default on a background thread, into a second JIT whose
+    // external symbols resolve to the baseline's. Its entry pointer is then swapped
+    // so later calls reach the optimized code. Frames already running keep their
+    // baseline code, since there is no on-stack replacement.
+    class TieredJit
+    {
+    private:
+        jit::Jit &baseline;
+        jit::Jit optimizing{compiler::OptimizationLevel::O2};
+        std::unordered_set<std::string> bridged;
+        const parser::Program &program;
+        int threshold;
+        bool background;
+
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        std::deque<std::string> hot;
+        // Every function reported so far. Its counter wraps around and reports it
+        // again after 2^32 more calls.
+        std::unordered_set<std::string> reported;
+        std::vector<std::string> promoted;
+        bool stopping = false;
+
+        void work();
+        void promote(const std::string &identifier);
+
+    public:
+        TieredJit(jit::Jit &baseline, const parser::Program &program, int threshold = tiering::defaultThreshold, bool background = true);
+        ~TieredJit();
+
+        TieredJit(const TieredJit &) = delete;
+        TieredJit &operator=(const TieredJit &) = delete;
+
+        int runMain();
+        // Called by baseline code, through anchor.tierUp, when a function becomes hot.
+        // Only the first report of each function promotes it.
+        void tierUp(const std::string &identifier);
+        std::vector<std::string> getPromoted();
+    };
+}
+
+#endif // TIERING_H
@@ -1,5 +1,8 @@
 #include "util.hh"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace util 
 {
     std::string join(std::vector<std::string>::iterator begin, std::vector<std::string>::iterator end, std::string delim)
@@ -0,0 +1,286 @@
+#include "src/vm.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// GCC and Clang can jump straight from one handler to the next through a table of
+// label addresses, which gives every handler its own indirect branch to predict.
+#if defined(__GNUC__)
+#define ANCHOR_COMPUTED_GOTO 1
+#else
+#define ANCHOR_COMPUTED_GOTO 0
+#endif
+
+namespace vm
+{
+    namespace
+    {
+        constexpr std::size_t arenaChunkSize = 64 * 1024;
+        constexpr std::size_t maxFrames = 1 << 18;
+
+        class Frame
+        {
+        public:
+            const bytecode::Function *function;
+            const bytecode::Instruction *returnAddress;
+            std::size_t base;
+        };
+
+        // Integer arithmetic wraps, as it does in the compiled code.
+        std::int32_t add(std::int32_t left, std::int32_t right)
+        {
+            return static_cast<std::int32_t>(static_cast<std::uint32_t>(left) + static_cast<std::uint32_t>(right));
+        }
+
+        std::int32_t subtract(std::int32_t left, std::int32_t right)
+        {
+            return static_cast<std::int32_t>(static_cast<std::uint32_t>(left) - static_cast<std::uint32_t>(right));
+        }
+
+        std::int32_t multiply(std::int32_t left, std::int32_t right)
+        {
+            return static_cast<std::int32_t>(static_cast<std::uint32_t>(left) * static_cast<std::uint32_t>(right));
+        }
+    }
+
+    Machine::Machine(const bytecode::Module &module, std::ostream &out) : module(module), out(out)
+    {
+    }
+
+    char *Machine::allocate(std::size_t size)
+    {
+        if (size > this->arenaRemaining)
+        {
+            std::size_t chunk = std::max(size, arenaChunkSize);
+            this->arena.emplace_back(new char[chunk]);
+            this->arenaNext = this->arena.back().get();
+            this->arenaRemaining = chunk;
+        }
+
+        char *allocated = this->arenaNext;
+        this->arenaNext += size;
+        this->arenaRemaining -= size;
+        return allocated;
+    }
+
+    int Machine::runMain()
+    {
+        const bytecode::Function *function = &this->module.functions[this->module.main];
+        const bytecode::Instruction *code = function->code.data();
+        const bytecode::Instruction *pc = code;
+        std::vector<Frame> frames;
+        std::size_t base = 0;
+
+        this->registers.resize(std::max<std::size_t>(this->registers.size(), std::max<std::size_t>(function->registers, 256)));
+        vm::Value *r = this->registers.data();
+
+#if ANCHOR_COMPUTED_GOTO
+        // In the same order as bytecode::Opcode.
+        static const void *const dispatch[] = {
+            &&LOAD_INTEGER,
+            &&LOAD_STRING,
+            &&MOVE,
+            &&ADD,
+            &&SUBTRACT,
+            &&MULTIPLY,
+            &&LESS_THAN,
+            &&GREATER_THAN,
+            &&EQUALS,
+            &&CONCAT,
+            &&ADD_INTEGER,
+            &&JUMP,
+            &&JUMP_IF_FALSE,
+            &&JUMP_IF_NOT_LESS_THAN,
+            &&JUMP_IF_NOT_GREATER_THAN,
+            &&JUMP_IF_NOT_EQUAL,
+            &&CALL,
+            &&RETURN,
+            &&RETURN_VOID,
+            &&PRINT_INTEGER,
+            &&PRINT_STRING,
+        };
+        static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == static_cast<std::size_t>(bytecode::Opcode::COUNT));
+#define VM_CASE(name) name:
+#define VM_DISPATCH() goto *dispatch[static_cast<std::size_t>(pc->opcode)]
+        VM_DISPATCH();
+#else
+#define VM_CASE(name) case bytecode::Opcode::name:
+#define VM_DISPATCH() continue
+        for (;;)
+        {
+            switch (pc->opcode)
+            {
+#endif
+#define VM_NEXT() \
+    ++pc;         \
+    VM_DISPATCH()
+
+        VM_CASE(LOAD_INTEGER)
+        {
+            r[pc->a].integer = pc->c;
+            VM_NEXT();
+        }
+        VM_CASE(LOAD_STRING)
+        {
+            const std::string &string = this->module.strings[pc->c];
+            r[pc->a] = vm::Value{string.c_str(), static_cast<std::int32_t>(string.size() + 1)};
+            VM_NEXT();
+        }
+        VM_CASE(MOVE)
+        {
+            r[pc->a] = r[pc->b];
+            VM_NEXT();
+        }
+        VM_CASE(ADD)
+        {
+            r[pc->a].integer = add(r[pc->b].integer, r[pc->c].integer);
+            VM_NEXT();
+        }
+        VM_CASE(SUBTRACT)
+        {
+            r[pc->a].integer = subtract(r[pc->b].integer, r[pc->c].integer);
+            VM_NEXT();
+        }
+        VM_CASE(MULTIPLY)
+        {
+            r[pc->a].integer = multiply(r[pc->b].integer, r[pc->c].integer);
+            VM_NEXT();
+        }
+        VM_CASE(LESS_THAN)
+        {
+            r[pc->a].integer = r[pc->b].integer < r[pc->c].integer;
+            VM_NEXT();
+        }
+        VM_CASE(GREATER_THAN)
+        {
+            r[pc->a].integer = r[pc->b].integer > r[pc->c].integer;
+            VM_NEXT();
+        }
+        VM_CASE(EQUALS)
+        {
+            r[pc->a].integer = r[pc->b].integer == r[pc->c].integer;
+            VM_NEXT();
+        }
+        VM_CASE(CONCAT)
+        {
+            const vm::Value &left = r[pc->b];
+            const vm::Value &right = r[pc->c];
+            std::size_t leftLength = static_cast<std::size_t>(left.integer) - 1;
+            std::int32_t size = left.integer + right.integer - 1;
+
+            char *characters = this->allocate(static_cast<std::size_t>(size));
+            std::memcpy(characters, left.characters, leftLength);
+            std::memcpy(characters + leftLength, right.characters, static_cast<std::size_t>(right.integer));
+            r[pc->a] = vm::Value{characters, size};
+            VM_NEXT();
+        }
+        VM_CASE(ADD_INTEGER)
+        {
+            r[pc->a].integer = add(r[pc->b].integer, pc->c);
+            VM_NEXT();
+        }
+        VM_CASE(JUMP)
+        {
+            pc = code + pc->c;
+            VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_FALSE)
+        {
+            pc = r[pc->a].integer == 0 ? code + pc->c : pc + 1;
+            VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_NOT_LESS_THAN)
+        {
+            pc = r[pc->a].integer < r[pc->b].integer ? pc + 1 : code + pc->c;
+            VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_NOT_GREATER_THAN)
+        {
+            pc = r[pc->a].integer > r[pc->b].integer ? pc + 1 : code + pc->c;
+            VM_DISPATCH();
+        }
+        VM_CASE(JUMP_IF_NOT_EQUAL)
+        {
+            pc = r[pc->a].integer == r[pc->b].integer ? pc + 1 : code + pc->c;
+            VM_DISPATCH();
+        }
+        VM_CASE(CALL)
+        {
+            const bytecode::Function *callee = &this->module.functions[pc->c];
+            std::size_t calleeBase = base + pc->b;
+            if (calleeBase + callee->registers > this->registers.size())
+            {
+                this->registers.resize(std::max(this->registers.size() * 2, calleeBase + callee->registers));
+            }
+            if (frames.size() == maxFrames)
+            {
+                throw std::runtime_error("Call stack overflow in " + callee->name + ".");
+            }
+
+            frames.push_back(Frame{function, pc, base});
+            function = callee;
+            code = function->code.data();
+            pc = code;
+            base = calleeBase;
+            r = this->registers.data() + base;
+            VM_DISPATCH();
+        }
+        VM_CASE(RETURN)
+        {
+            vm::Value result = r[pc->a];
+            if (frames.empty())
+            {
+                this->out.flush();
+                return result.integer;
+            }
+
+            const Frame &caller = frames.back();
+            function = caller.function;
+            code = function->code.data();
+            pc = caller.returnAddress;
+            base = caller.base;
+            frames.pop_back();
+            r = this->registers.data() + base;
+            r[pc->a] = result;
+            VM_NEXT();
+        }
+        VM_CASE(RETURN_VOID)
+        {
+            if (frames.empty())
+            {
+                this->out.flush();
+                return 0;
+            }
+
+            const Frame &caller = frames.back();
+            function = caller.function;
+            code = function->code.data();
+            pc = caller.returnAddress;
+            base = caller.base;
+            frames.pop_back();
+            r = this->registers.data() + base;
+            VM_NEXT();
+        }
+        VM_CASE(PRINT_INTEGER)
+        {
+            this->out << r[pc->a].integer;
+            VM_NEXT();
+        }
+        VM_CASE(PRINT_STRING)
+        {
+            this->out << r[pc->a].characters;
+            VM_NEXT();
+        }
+
+#if !ANCHOR_COMPUTED_GOTO
+            default:
+                throw std::runtime_error("Cannot interpret unknown opcode.");
+            }
+        }
+#endif
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef VM_CASE
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef VM_H
+#define VM_H
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "src/bytecode.hh"
+
+namespace vm
+{
+    // One register. Integers and booleans live in integer. A string is its
+    // null-terminated characters and, in integer, its size including the
+    // terminator, the same layout the compiled code uses.
+    class Value
+    {
+    public:
+        const char *characters = nullptr;
+        std::int32_t integer = 0;
+    };
+
+    // Interprets a validated bytecode::Module. Strings built while running live in
+    // an arena owned by the machine, literals point into the module, so the module
+    // must outlive it.
+    class Machine
+    {
+    private:
+        const bytecode::Module &module;
+        std::ostream &out;
+        std::vector<vm::Value> registers;
+        std::vector<std::unique_ptr<char[]>> arena;
+        std::size_t arenaRemaining = 0;
+        char *arenaNext = nullptr;
+
+        char *allocate(std::size_t size);
+
+    public:
+        Machine(const bytecode::Module &module, std::ostream &out);
+
+        // Returns what main returned, or 0 if it did not return a value.
+        int runMain();
+    };
+}
+
+#endif // VM_H
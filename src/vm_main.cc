@@ -0,0 +1,92 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "bytecode.hh"
+#include "compilationunit.hh"
+#include "vm.hh"
+
+// Runs a program, or a file it was precompiled to with -o, on the bytecode VM.
+// Nothing here depends on LLVM.
+int main(int argc, char *argv[])
+{
+    std::ios::sync_with_stdio(false);
+
+    std::string input;
+    std::string output;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (input.empty() && !arg.starts_with("-"))
+        {
+            input = arg;
+        }
+        else
+        {
+            std::cerr << "Usage: anchor_vm [-o output.anchorbc] file.anchor|file.anchorbc\n";
+            return 1;
+        }
+    }
+
+    if (input.empty() || !std::filesystem::exists(input))
+    {
+        std::cerr << "Could not find file with name " << input << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(input, std::ios::binary);
+    std::string contents;
+    contents.resize(std::filesystem::file_size(input));
+    file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+
+    try
+    {
+        bytecode::Module module;
+        if (bytecode::isBytecode(contents))
+        {
+            std::istringstream in(std::move(contents));
+            module = bytecode::read(in);
+        }
+        else
+        {
+            anchor::CompilationUnit unit(std::move(contents));
+            anchor::lex(unit);
+            anchor::parse(unit);
+            if (unit.hasErrors())
+            {
+                for (const parser::ErrorLog &errorLog : unit.diagnostics)
+                {
+                    std::cerr << errorLog.getMessage() << '\n';
+                }
+                return 1;
+            }
+            module = bytecode::lower(unit.program);
+        }
+
+        if (!output.empty())
+        {
+            std::ofstream out(output, std::ios::binary);
+            if (!out)
+            {
+                std::cerr << "Could not open " << output << " for writing." << std::endl;
+                return 1;
+            }
+            bytecode::write(out, module);
+            return 0;
+        }
+
+        vm::Machine machine(module, std::cout);
+        return machine.runMain();
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
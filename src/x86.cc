@@ -0,0 +1,852 @@
+#include "src/x86.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace x86
+{
+    namespace
+    {
+        enum class Register : std::uint8_t
+        {
+            RAX,
+            RCX,
+            RDX,
+            RBX,
+            RSP,
+            RBP,
+            RSI,
+            RDI,
+            R8,
+            R9
+        };
+
+        constexpr Register argumentRegisters[] = {Register::RDI, Register::RSI, Register::RDX, Register::RCX, Register::R8, Register::R9};
+
+        // Condition codes, as setcc and jcc encode them.
+        constexpr std::uint8_t EQUAL = 0x4;
+        constexpr std::uint8_t LESS = 0xC;
+        constexpr std::uint8_t GREATER = 0xF;
+
+        // Encodes the few instructions the generator needs. Integers and booleans are
+        // 32-bit, pointers and stack slots 64-bit, and memory is only ever addressed
+        // as a 32-bit displacement from rbp, rsp or rip.
+        class Assembler
+        {
+        private:
+            static std::uint8_t number(Register reg)
+            {
+                return static_cast<std::uint8_t>(reg);
+            }
+
+            static std::uint8_t modrm(std::uint8_t mod, std::uint8_t reg, std::uint8_t rm)
+            {
+                return static_cast<std::uint8_t>((mod << 6) | ((reg & 7) << 3) | (rm & 7));
+            }
+
+            void rex(bool wide, std::uint8_t reg, std::uint8_t rm)
+            {
+                auto prefix = static_cast<std::uint8_t>(0x40 | (wide ? 0x8 : 0) | ((reg & 8) >> 1) | ((rm & 8) >> 3));
+                if (prefix != 0x40)
+                {
+                    this->byte(prefix);
+                }
+            }
+
+            void memory(Register reg, Register base, std::int32_t displacement)
+            {
+                this->byte(modrm(2, number(reg), number(base)));
+                if (base == Register::RSP)
+                {
+                    this->byte(0x24);
+                }
+                this->int32(displacement);
+            }
+
+            // Emits a placeholder for a displacement or address the caller patches.
+            std::size_t placeholder()
+            {
+                std::size_t at = this->bytes.size();
+                this->int32(0);
+                return at;
+            }
+
+        public:
+            std::vector<std::uint8_t> bytes;
+
+            std::size_t here() const
+            {
+                return this->bytes.size();
+            }
+
+            void byte(std::uint8_t value)
+            {
+                this->bytes.push_back(value);
+            }
+
+            void int32(std::int32_t value)
+            {
+                auto bits = static_cast<std::uint32_t>(value);
+                for (int i = 0; i < 4; i++)
+                {
+                    this->byte(static_cast<std::uint8_t>(bits >> (8 * i)));
+                }
+            }
+
+            void patch(std::size_t at, std::int32_t value)
+            {
+                auto bits = static_cast<std::uint32_t>(value);
+                for (int i = 0; i < 4; i++)
+                {
+                    this->bytes[at + i] = static_cast<std::uint8_t>(bits >> (8 * i));
+                }
+            }
+
+            // Points the rel32 at at to target.
+            void patchRelative(std::size_t at, std::size_t target)
+            {
+                this->patch(at, static_cast<std::int32_t>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(at + 4)));
+            }
+
+            // push rbp; mov rbp, rsp; sub rsp, <frame>. Returns where the frame size goes.
+            std::size_t prologue()
+            {
+                this->byte(0x55);
+                this->bytes.insert(this->bytes.end(), {0x48, 0x89, 0xE5, 0x48, 0x81, 0xEC});
+                return this->placeholder();
+            }
+
+            // leave; ret
+            void epilogue()
+            {
+                this->byte(0xC9);
+                this->byte(0xC3);
+            }
+
+            // mov reg, [base + displacement]
+            void load(Register reg, Register base, std::int32_t displacement, bool wide = true)
+            {
+                this->rex(wide, number(reg), number(base));
+                this->byte(0x8B);
+                this->memory(reg, base, displacement);
+            }
+
+            // mov [base + displacement], reg
+            void store(Register base, std::int32_t displacement, Register reg)
+            {
+                this->rex(true, number(reg), number(base));
+                this->byte(0x89);
+                this->memory(reg, base, displacement);
+            }
+
+            // mov to, from
+            void move(Register to, Register from, bool wide = true)
+            {
+                this->rex(wide, number(from), number(to));
+                this->byte(0x89);
+                this->byte(modrm(3, number(from), number(to)));
+            }
+
+            // mov reg, value
+            void moveImmediate(Register reg, std::int32_t value)
+            {
+                this->rex(false, 0, number(reg));
+                this->byte(static_cast<std::uint8_t>(0xB8 + (number(reg) & 7)));
+                this->int32(value);
+            }
+
+            // add, sub, cmp, test or xor to, from, by their opcode.
+            void arithmetic(std::uint8_t opcode, Register to, Register from, bool wide = false)
+            {
+                this->rex(wide, number(from), number(to));
+                this->byte(opcode);
+                this->byte(modrm(3, number(from), number(to)));
+            }
+
+            // imul to, from
+            void multiply(Register to, Register from)
+            {
+                this->rex(false, number(to), number(from));
+                this->byte(0x0F);
+                this->byte(0xAF);
+                this->byte(modrm(3, number(to), number(from)));
+            }
+
+            // and reg, 1
+            void lowBit(Register reg)
+            {
+                this->rex(false, 0, number(reg));
+                this->byte(0x83);
+                this->byte(modrm(3, 4, number(reg)));
+                this->byte(1);
+            }
+
+            // sub reg, 1
+            void decrement(Register reg)
+            {
+                this->rex(false, 0, number(reg));
+                this->byte(0x83);
+                this->byte(modrm(3, 5, number(reg)));
+                this->byte(1);
+            }
+
+            // setcc al; movzx eax, al
+            void setFromFlags(std::uint8_t condition)
+            {
+                this->bytes.insert(this->bytes.end(), {0x0F, static_cast<std::uint8_t>(0x90 | condition), 0xC0, 0x0F, 0xB6, 0xC0});
+            }
+
+            // lea reg, [rip + <displacement>]. Returns where the displacement goes.
+            std::size_t loadAddress(Register reg)
+            {
+                this->rex(true, number(reg), 0);
+                this->byte(0x8D);
+                this->byte(modrm(0, number(reg), 5));
+                return this->placeholder();
+            }
+
+            // call <rel32>
+            std::size_t call()
+            {
+                this->byte(0xE8);
+                return this->placeholder();
+            }
+
+            // call [rip + <displacement>]
+            std::size_t callIndirect()
+            {
+                this->byte(0xFF);
+                this->byte(0x15);
+                return this->placeholder();
+            }
+
+            // jmp <rel32>
+            std::size_t jump()
+            {
+                this->byte(0xE9);
+                return this->placeholder();
+            }
+
+            // jz <rel32>
+            std::size_t jumpIfZero()
+            {
+                this->byte(0x0F);
+                this->byte(0x84);
+                return this->placeholder();
+            }
+        };
+
+        // Where an argument travels: from its first register on, or at an offset in
+        // the stack argument area when the registers left cannot hold all of it.
+        class Location
+        {
+        public:
+            int firstRegister = -1;
+            std::int32_t offset = 0;
+        };
+
+        bool isString(parser::Type type)
+        {
+            return type == parser::Type::STRING;
+        }
+
+        std::int32_t slotSize(parser::Type type)
+        {
+            return isString(type) ? 16 : 8;
+        }
+
+        // Classifies arguments as System V does: an integer or boolean takes one
+        // register, a string two, and an argument that does not fit goes on the stack
+        // whole while later ones may still take the registers left.
+        std::vector<x86::Location> place(const std::vector<std::shared_ptr<parser::FunctionArgStmt>> &args, std::int32_t &stackSize)
+        {
+            std::vector<x86::Location> locations;
+            int nextRegister = 0;
+            stackSize = 0;
+            for (const auto &arg : args)
+            {
+                int needed = isString(arg->returnType) ? 2 : 1;
+                x86::Location location;
+                if (nextRegister + needed <= static_cast<int>(std::size(argumentRegisters)))
+                {
+                    location.firstRegister = nextRegister;
+                    nextRegister += needed;
+                }
+                else
+                {
+                    location.offset = stackSize;
+                    stackSize += slotSize(arg->returnType);
+                }
+                locations.push_back(location);
+            }
+            return locations;
+        }
+
+        class Generator
+        {
+        private:
+            x86::Assembler code;
+            std::unordered_map<std::string, std::shared_ptr<parser::FunctionStmt>> functionStmts;
+            std::unordered_map<std::string, std::size_t> functions;
+            // Displacements to patch once everything they refer to has been placed.
+            std::vector<std::pair<std::size_t, std::string>> calls;
+            std::vector<std::pair<std::size_t, std::size_t>> stringUses;
+            std::vector<std::pair<std::size_t, std::size_t>> importUses;
+            std::vector<std::string> strings;
+            std::unordered_map<std::string, std::size_t> stringIndices;
+            std::vector<std::string> imports;
+            std::unordered_map<std::string, std::size_t> importIndices;
+
+            // Variables by their declaration, as offsets from rbp.
+            std::unordered_map<const parser::Stmt *, std::int32_t> variables;
+            // Variables occupy the slots in the locals bytes below rbp, temporaries the
+            // ones from there down to used.
+            std::int32_t locals = 0;
+            std::int32_t used = 0;
+            std::int32_t deepest = 0;
+            std::int32_t outgoing = 0;
+
+            std::int32_t allocate(parser::Type type)
+            {
+                this->used += slotSize(type);
+                this->deepest = std::max(this->deepest, this->used);
+                return -this->used;
+            }
+
+            std::int32_t lookup(const parser::Stmt *declaration, const std::string &identifier)
+            {
+                auto found = this->variables.find(declaration);
+                if (found == this->variables.end())
+                {
+                    throw std::invalid_argument("Cannot compile reference to undeclared variable " + identifier + ".");
+                }
+                return found->second;
+            }
+
+            static std::size_t intern(const std::string &name, std::vector<std::string> &names, std::unordered_map<std::string, std::size_t> &indices)
+            {
+                auto [entry, inserted] = indices.try_emplace(name, names.size());
+                if (inserted)
+                {
+                    names.push_back(name);
+                }
+                return entry->second;
+            }
+
+            void loadString(x86::Register reg, const std::string &contents)
+            {
+                this->stringUses.emplace_back(this->code.loadAddress(reg), intern(contents, this->strings, this->stringIndices));
+            }
+
+            // Clobbers every register the System V convention lets a callee clobber.
+            void callImport(const std::string &name)
+            {
+                this->importUses.emplace_back(this->code.callIndirect(), intern(name, this->imports, this->importIndices));
+            }
+
+            void store(std::int32_t slot, parser::Type type)
+            {
+                this->code.store(x86::Register::RBP, slot, x86::Register::RAX);
+                if (isString(type))
+                {
+                    this->code.store(x86::Register::RBP, slot + 8, x86::Register::RDX);
+                }
+            }
+
+            void load(std::int32_t slot, parser::Type type)
+            {
+                this->code.load(x86::Register::RAX, x86::Register::RBP, slot);
+                if (isString(type))
+                {
+                    this->code.load(x86::Register::RDX, x86::Register::RBP, slot + 8, false);
+                }
+            }
+
+            void generate(const std::shared_ptr<parser::FunctionStmt> &functionStmt)
+            {
+                this->functions[functionStmt->identifier] = this->code.here();
+                this->variables.clear();
+                this->locals = 0;
+                this->used = 0;
+                this->deepest = 0;
+                this->outgoing = 0;
+
+                std::size_t frame = this->code.prologue();
+
+                // Arguments in registers are spilled to slots, those on the stack stay
+                // where the caller put them, above the return address and saved rbp.
+                // LLVM passes a boolean as an i1, whose bits above the lowest are
+                // undefined, so booleans are cut down to that bit in a slot of their own.
+                std::int32_t stackSize = 0;
+                std::vector<x86::Location> locations = place(functionStmt->args, stackSize);
+                for (std::size_t i = 0; i < functionStmt->args.size(); i++)
+                {
+                    const auto &arg = functionStmt->args[i];
+                    bool isBoolean = arg->returnType == parser::Type::BOOLEAN;
+                    if (locations[i].firstRegister < 0 && !isBoolean)
+                    {
+                        this->variables[arg.get()] = 16 + locations[i].offset;
+                        continue;
+                    }
+
+                    std::int32_t slot = this->allocate(arg->returnType);
+                    if (locations[i].firstRegister < 0)
+                    {
+                        this->code.load(x86::Register::RAX, x86::Register::RBP, 16 + locations[i].offset, false);
+                        this->code.lowBit(x86::Register::RAX);
+                        this->code.store(x86::Register::RBP, slot, x86::Register::RAX);
+                        this->variables[arg.get()] = slot;
+                        continue;
+                    }
+                    if (isBoolean)
+                    {
+                        this->code.lowBit(argumentRegisters[locations[i].firstRegister]);
+                    }
+                    this->code.store(x86::Register::RBP, slot, argumentRegisters[locations[i].firstRegister]);
+                    if (isString(arg->returnType))
+                    {
+                        this->code.store(x86::Register::RBP, slot + 8, argumentRegisters[locations[i].firstRegister + 1]);
+                    }
+                    this->variables[arg.get()] = slot;
+                }
+                this->locals = this->used;
+
+                this->generate(functionStmt->stmts);
+                this->code.epilogue();
+
+                // Calls need rsp 16-byte aligned, and it already is once rbp is pushed.
+                std::int32_t size = this->deepest + this->outgoing;
+                this->code.patch(frame, (size + 15) / 16 * 16);
+            }
+
+            void generate(const std::vector<std::shared_ptr<parser::Stmt>> &stmts)
+            {
+                std::int32_t scope = this->locals;
+                for (const auto &stmt : stmts)
+                {
+                    this->generate(stmt);
+                    this->used = this->locals;
+                }
+                this->locals = scope;
+                this->used = scope;
+            }
+
+            void generate(const std::shared_ptr<parser::Stmt> &stmt)
+            {
+                using enum parser::StmtType;
+                if (stmt->type == VAR_DECL)
+                {
+                    auto varDeclStmt = std::static_pointer_cast<parser::VarDeclStmt>(stmt);
+                    if (isString(varDeclStmt->variableType))
+                    {
+                        this->newString("");
+                    }
+                    else
+                    {
+                        this->code.arithmetic(0x31, x86::Register::RAX, x86::Register::RAX);
+                    }
+                    std::int32_t slot = this->allocate(varDeclStmt->variableType);
+                    this->store(slot, varDeclStmt->variableType);
+                    this->variables[stmt.get()] = slot;
+                    this->locals = this->used;
+                }
+                else if (stmt->type == PRINT)
+                {
+                    auto printStmt = std::static_pointer_cast<parser::PrintStmt>(stmt);
+                    this->generate(printStmt->expr);
+                    bool printsString = isString(printStmt->expr->returnType);
+                    this->code.move(x86::Register::RSI, x86::Register::RAX, printsString);
+                    this->loadString(x86::Register::RDI, printsString ? "%s" : "%d");
+                    // No vector registers carry arguments to the variadic call.
+                    this->code.arithmetic(0x31, x86::Register::RAX, x86::Register::RAX);
+                    this->callImport("printf");
+                }
+                else if (stmt->type == RETURN)
+                {
+                    this->generate(std::static_pointer_cast<parser::ReturnStmt>(stmt)->expr);
+                    this->code.epilogue();
+                }
+                else if (stmt->type == EXPR)
+                {
+                    this->generate(std::static_pointer_cast<parser::ExprStmt>(stmt)->expr);
+                }
+                else if (stmt->type == IF)
+                {
+                    auto ifStmt = std::static_pointer_cast<parser::IfStmt>(stmt);
+                    std::size_t exit = this->branchIfFalse(ifStmt->condition);
+                    this->generate(ifStmt->stmts);
+                    this->code.patchRelative(exit, this->code.here());
+                }
+                else if (stmt->type == WHILE)
+                {
+                    auto whileStmt = std::static_pointer_cast<parser::WhileStmt>(stmt);
+                    std::size_t start = this->code.here();
+                    std::size_t exit = this->branchIfFalse(whileStmt->condition);
+                    this->generate(whileStmt->stmts);
+                    this->code.patchRelative(this->code.jump(), start);
+                    this->code.patchRelative(exit, this->code.here());
+                }
+                else
+                {
+                    throw std::invalid_argument("Cannot compile statement outside of a function.");
+                }
+            }
+
+            // Emits a jump, to be patched by the caller, taken when the condition is false.
+            std::size_t branchIfFalse(const std::shared_ptr<parser::Expr> &condition)
+            {
+                this->generate(condition);
+                this->used = this->locals;
+                this->code.arithmetic(0x85, x86::Register::RAX, x86::Register::RAX);
+                return this->code.jumpIfZero();
+            }
+
+            // Leaves the value in eax, or a string's characters in rax and its size,
+            // terminator included, in edx.
+            void generate(const std::shared_ptr<parser::Expr> &expr)
+            {
+                using enum parser::ExprType;
+                if (expr->type == INTEGER_LITERAL)
+                {
+                    this->code.moveImmediate(x86::Register::RAX, std::static_pointer_cast<parser::IntegerLiteral>(expr)->integer);
+                }
+                else if (expr->type == BOOLEAN)
+                {
+                    this->code.moveImmediate(x86::Register::RAX, std::static_pointer_cast<parser::BooleanLiteralExpr>(expr)->value ? 1 : 0);
+                }
+                else if (expr->type == STRING_LITERAL)
+                {
+                    this->newString(std::static_pointer_cast<parser::StringLiteral>(expr)->literal);
+                }
+                else if (expr->type == VAR)
+                {
+                    auto varExpr = std::static_pointer_cast<parser::VarExpr>(expr);
+                    this->load(this->lookup(varExpr->declaration, varExpr->identifier), varExpr->returnType);
+                }
+                else if (expr->type == ASSIGNMENT)
+                {
+                    auto assignment = std::static_pointer_cast<parser::VarAssignmentExpr>(expr);
+                    std::int32_t slot = this->lookup(assignment->declaration, assignment->identifier);
+                    this->generate(assignment->expr);
+                    this->store(slot, assignment->expr->returnType);
+                }
+                else if (expr->type == BINARY_OP)
+                {
+                    this->generate(std::static_pointer_cast<parser::BinaryOperation>(expr));
+                }
+                else if (expr->type == FUNCTION)
+                {
+                    this->generate(std::static_pointer_cast<parser::FunctionExpr>(expr));
+                }
+                else
+                {
+                    throw std::invalid_argument("Unsupported expression type.");
+                }
+            }
+
+            // A string of its own on the heap, like every string the LLVM backend makes.
+            void newString(const std::string &literal)
+            {
+                auto size = static_cast<std::int32_t>(literal.length() + 1);
+                this->code.moveImmediate(x86::Register::RDI, size);
+                this->callImport("malloc");
+                this->code.move(x86::Register::RDI, x86::Register::RAX);
+                this->loadString(x86::Register::RSI, literal);
+                this->code.moveImmediate(x86::Register::RDX, size);
+                // Returns the buffer, in rax.
+                this->callImport("memcpy");
+                this->code.moveImmediate(x86::Register::RDX, size);
+            }
+
+            void generate(const std::shared_ptr<parser::BinaryOperation> &binaryOp)
+            {
+                if (binaryOp->returnType == parser::Type::STRING)
+                {
+                    this->generate(binaryOp->left);
+                    std::int32_t left = this->allocate(parser::Type::STRING);
+                    this->store(left, parser::Type::STRING);
+                    this->generate(binaryOp->right);
+                    std::int32_t right = this->allocate(parser::Type::STRING);
+                    this->store(right, parser::Type::STRING);
+                    this->concat(left, right);
+                    return;
+                }
+                if (isString(binaryOp->left->returnType))
+                {
+                    throw std::invalid_argument("Cannot compile comparison of strings.");
+                }
+
+                this->generate(binaryOp->left);
+                std::int32_t left = this->allocate(parser::Type::INTEGER);
+                this->store(left, parser::Type::INTEGER);
+                this->generate(binaryOp->right);
+                this->code.move(x86::Register::RCX, x86::Register::RAX);
+                this->code.load(x86::Register::RAX, x86::Register::RBP, left);
+
+                switch (binaryOp->operation)
+                {
+                case parser::Operation::ADD:
+                    this->code.arithmetic(0x01, x86::Register::RAX, x86::Register::RCX);
+                    break;
+                case parser::Operation::SUBTRACT:
+                    this->code.arithmetic(0x29, x86::Register::RAX, x86::Register::RCX);
+                    break;
+                case parser::Operation::MULTIPLICATION:
+                    this->code.multiply(x86::Register::RAX, x86::Register::RCX);
+                    break;
+                case parser::Operation::LESS_THAN:
+                    this->code.arithmetic(0x39, x86::Register::RAX, x86::Register::RCX);
+                    this->code.setFromFlags(LESS);
+                    break;
+                case parser::Operation::GREATER_THAN:
+                    this->code.arithmetic(0x39, x86::Register::RAX, x86::Register::RCX);
+                    this->code.setFromFlags(GREATER);
+                    break;
+                case parser::Operation::EQUALS:
+                    this->code.arithmetic(0x39, x86::Register::RAX, x86::Register::RCX);
+                    this->code.setFromFlags(EQUAL);
+                    break;
+                default:
+                    throw std::invalid_argument("Unsupported parser::Operation");
+                }
+            }
+
+            // Copies both strings, but for the left one's terminator, into a new one.
+            void concat(std::int32_t left, std::int32_t right)
+            {
+                std::int32_t result = this->allocate(parser::Type::STRING);
+                this->code.load(x86::Register::RCX, x86::Register::RBP, left + 8, false);
+                this->code.load(x86::Register::RAX, x86::Register::RBP, right + 8, false);
+                this->code.arithmetic(0x01, x86::Register::RAX, x86::Register::RCX);
+                this->code.decrement(x86::Register::RAX);
+                this->code.store(x86::Register::RBP, result + 8, x86::Register::RAX);
+                this->code.move(x86::Register::RDI, x86::Register::RAX, false);
+                this->callImport("malloc");
+                this->code.store(x86::Register::RBP, result, x86::Register::RAX);
+
+                this->code.move(x86::Register::RDI, x86::Register::RAX);
+                this->code.load(x86::Register::RSI, x86::Register::RBP, left);
+                this->code.load(x86::Register::RDX, x86::Register::RBP, left + 8, false);
+                this->code.decrement(x86::Register::RDX);
+                this->callImport("memcpy");
+
+                this->code.load(x86::Register::RDI, x86::Register::RBP, result);
+                this->code.load(x86::Register::RCX, x86::Register::RBP, left + 8, false);
+                this->code.decrement(x86::Register::RCX);
+                this->code.arithmetic(0x01, x86::Register::RDI, x86::Register::RCX, true);
+                this->code.load(x86::Register::RSI, x86::Register::RBP, right);
+                this->code.load(x86::Register::RDX, x86::Register::RBP, right + 8, false);
+                this->callImport("memcpy");
+
+                this->load(result, parser::Type::STRING);
+            }
+
+            void generate(const std::shared_ptr<parser::FunctionExpr> &functionExpr)
+            {
+                auto callee = this->functionStmts.find(functionExpr->identifier);
+                if (callee == this->functionStmts.end())
+                {
+                    throw std::invalid_argument("Cannot compile call to unknown function " + functionExpr->identifier + ".");
+                }
+                const auto &params = callee->second->args;
+                if (params.size() != functionExpr->args.size())
+                {
+                    throw std::invalid_argument("Cannot compile call to " + functionExpr->identifier + " with " + std::to_string(functionExpr->args.size()) + " arguments.");
+                }
+
+                // Every argument is evaluated before any is moved into place, since
+                // evaluating one may call another function.
+                std::vector<std::int32_t> slots;
+                for (std::size_t i = 0; i < params.size(); i++)
+                {
+                    this->generate(functionExpr->args[i]);
+                    slots.push_back(this->allocate(params[i]->returnType));
+                    this->store(slots.back(), params[i]->returnType);
+                }
+
+                std::int32_t stackSize = 0;
+                std::vector<x86::Location> locations = place(params, stackSize);
+                this->outgoing = std::max(this->outgoing, stackSize);
+                for (std::size_t i = 0; i < params.size(); i++)
+                {
+                    int words = isString(params[i]->returnType) ? 2 : 1;
+                    for (int word = 0; word < words; word++)
+                    {
+                        if (locations[i].firstRegister >= 0)
+                        {
+                            this->code.load(argumentRegisters[locations[i].firstRegister + word], x86::Register::RBP, slots[i] + 8 * word);
+                        }
+                        else
+                        {
+                            this->code.load(x86::Register::RAX, x86::Register::RBP, slots[i] + 8 * word);
+                            this->code.store(x86::Register::RSP, locations[i].offset + 8 * word, x86::Register::RAX);
+                        }
+                    }
+                }
+                this->calls.emplace_back(this->code.call(), functionExpr->identifier);
+                if (callee->second->returnType == parser::Type::BOOLEAN)
+                {
+                    this->code.lowBit(x86::Register::RAX);
+                }
+            }
+
+        public:
+            x86::Code compile(const parser::Program &program)
+            {
+                std::vector<std::shared_ptr<parser::FunctionStmt>> defining;
+                for (const auto &stmt : program.stmts)
+                {
+                    if (stmt->type == parser::StmtType::IMPORT)
+                    {
+                        throw std::invalid_argument("Cannot compile import of " + std::static_pointer_cast<parser::ImportStmt>(stmt)->path + ", libraries are only compiled with LLVM.");
+                    }
+                    if (stmt->type != parser::StmtType::FUNCTION)
+                    {
+                        throw std::invalid_argument("Cannot compile statement outside of a function.");
+                    }
+
+                    auto functionStmt = std::static_pointer_cast<parser::FunctionStmt>(stmt);
+                    if (!this->functionStmts.emplace(functionStmt->identifier, functionStmt).second)
+                    {
+                        throw std::invalid_argument("Cannot compile second definition of function " + functionStmt->identifier + ".");
+                    }
+                    defining.push_back(functionStmt);
+                }
+
+                for (const auto &functionStmt : defining)
+                {
+                    this->generate(functionStmt);
+                }
+                for (const auto &[at, identifier] : this->calls)
+                {
+                    this->code.patchRelative(at, this->functions.at(identifier));
+                }
+
+                std::vector<std::size_t> stringOffsets;
+                for (const std::string &contents : this->strings)
+                {
+                    stringOffsets.push_back(this->code.here());
+                    this->code.bytes.insert(this->code.bytes.end(), contents.begin(), contents.end());
+                    this->code.byte(0);
+                }
+                for (const auto &[at, index] : this->stringUses)
+                {
+                    this->code.patchRelative(at, stringOffsets[index]);
+                }
+
+                while (this->code.here() % 8 != 0)
+                {
+                    this->code.byte(0);
+                }
+                std::size_t importTable = this->code.here();
+                this->code.bytes.resize(importTable + 8 * this->imports.size());
+                for (const auto &[at, index] : this->importUses)
+                {
+                    this->code.patchRelative(at, importTable + 8 * index);
+                }
+
+                x86::Code compiled;
+                compiled.bytes = std::move(this->code.bytes);
+                compiled.functions = std::move(this->functions);
+                compiled.importTable = importTable;
+                compiled.imports = std::move(this->imports);
+                return compiled;
+            }
+        };
+    }
+
+    x86::Code compile(const parser::Program &program)
+    {
+        return x86::Generator().compile(program);
+    }
+
+    Jit::~Jit()
+    {
+        for (const auto &[address, size] : this->mappings)
+        {
+            munmap(address, size);
+        }
+    }
+
+    void Jit::define(const std::string &name, void *address)
+    {
+        this->symbols[name] = address;
+    }
+
+    void *Jit::resolve(const std::string &name)
+    {
+        auto defined = this->symbols.find(name);
+        if (defined != this->symbols.end())
+        {
+            return defined->second;
+        }
+
+        void *address = dlsym(RTLD_DEFAULT, name.c_str());
+        if (address == nullptr)
+        {
+            throw std::runtime_error("Could not resolve " + name + " in this process.");
+        }
+        return address;
+    }
+
+    void Jit::add(const x86::Code &code)
+    {
+        if (code.bytes.empty())
+        {
+            return;
+        }
+
+        auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t size = (code.bytes.size() + pageSize - 1) / pageSize * pageSize;
+        void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map " + std::to_string(size) + " bytes for machine code.");
+        }
+        this->mappings.emplace_back(mapped, size);
+
+        auto *base = static_cast<std::uint8_t *>(mapped);
+        std::memcpy(base, code.bytes.data(), code.bytes.size());
+        for (std::size_t i = 0; i < code.imports.size(); i++)
+        {
+            void *address = this->resolve(code.imports[i]);
+            std::memcpy(base + code.importTable + 8 * i, &address, sizeof(address));
+        }
+        // Never writable and executable at once.
+        if (mprotect(mapped, size, PROT_READ | PROT_EXEC) != 0)
+        {
+            throw std::runtime_error("Could not make machine code executable.");
+        }
+
+        for (const auto &[name, offset] : code.functions)
+        {
+            this->functions[name] = base + offset;
+        }
+    }
+
+    void *Jit::lookup(const std::string &name)
+    {
+        auto found = this->functions.find(name);
+        if (found == this->functions.end())
+        {
+            throw std::runtime_error("Could not find function " + name + ".");
+        }
+        return found->second;
+    }
+
+    int Jit::runMain()
+    {
+        auto main = reinterpret_cast<int (*)()>(this->lookup("main"));
+        int exitCode = main();
+        // The program printed through this process' stdio buffers.
+        std::fflush(stdout);
+        return exitCode;
+    }
+}
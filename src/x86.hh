@@ -0,0 +1,75 @@
+#ifndef X86_H
+#define X86_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/parser.hh"
+
+namespace x86
+{
+    // Whether this process runs on x86-64, the only host the code can run on.
+#if defined(__x86_64__) || defined(_M_X64)
+    constexpr bool isHost = true;
+#else
+    constexpr bool isHost = false;
+#endif
+
+    // Machine code for a whole program, position independent: the functions, then
+    // the string literals, then a table of eight-byte addresses, one per import,
+    // for the loader to fill in. Functions follow the System V calling convention.
+    // A string is passed and returned as the {i8*, i32} struct the LLVM backend
+    // uses, so either backend's functions can call the other's. Booleans are
+    // returned as 0 or 1 in eax, and only the lowest bit of one received, as an
+    // argument or from a call, is read, since LLVM defines no other bit of an i1.
+    class Code
+    {
+    public:
+        std::vector<std::uint8_t> bytes;
+        // Where each function starts in bytes.
+        std::unordered_map<std::string, std::size_t> functions;
+        std::size_t importTable = 0;
+        // The libc functions the code calls, in the order of their table entries.
+        std::vector<std::string> imports;
+    };
+
+    // Compiles a parsed program without errors straight to machine code, in one
+    // pass over its tree and without LLVM. Every variable and temporary has a stack
+    // slot of its own, and a value is only held in registers from one statement of
+    // the tree to the next. Throws std::invalid_argument for what only the LLVM
+    // backend compiles: imports, statements outside functions and comparisons of
+    // strings.
+    x86::Code compile(const parser::Program&);
+
+    // Loads code into executable memory in this process. Imports resolve to host
+    // functions bound with define, or else to the process' own symbols.
+    class Jit
+    {
+    private:
+        std::unordered_map<std::string, void*> symbols;
+        std::unordered_map<std::string, void*> functions;
+        std::vector<std::pair<void*, std::size_t>> mappings;
+
+        void* resolve(const std::string& name);
+
+    public:
+        Jit() = default;
+        ~Jit();
+
+        Jit(const Jit&) = delete;
+        Jit& operator=(const Jit&) = delete;
+
+        // Binds a symbol to a host function for code added afterwards, taking
+        // precedence over the process' own definition.
+        void define(const std::string& name, void* address);
+        void add(const x86::Code& code);
+        void* lookup(const std::string& name);
+        int runMain();
+    };
+}
+
+#endif // X86_H
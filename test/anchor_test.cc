@@ -1,48 +1,33 @@
 #include <gtest/gtest.h>
 #include "src/anchor.hh"
+#include "test/jit_fixture.hh"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include <filesystem>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <stdio.h>
+#include <thread>
+#include <unistd.h>
 
-std::string runAnchor(const std::string& llvmAnchor)
-{
-    static int counter = 0;
-    std::string filename = "/tmp/" + std::to_string(counter) + ".test.anchor";
-    std::cout << filename << std::endl;
-    counter++;
-    std::ofstream testFile(filename);
-
-    testFile << llvmAnchor;
-    testFile.close();
-
-    std::string anchorRunCommand = "/usr/local/opt/llvm/bin/lli " + filename;
-    std::cout << anchorRunCommand << std::endl;
+using AnchorTest = JitFixture;
+// Tests of what only the LLVM backend makes, which ctest does not run again
+// against the x86 backend.
+using AnchorLlvmTest = JitFixture;
 
-    char path[PATH_MAX];
-    FILE *fp = popen(anchorRunCommand.c_str(), "r");
-    if (fp == NULL)
-    {
-        return "Could not open subprocess to run anchor.";
-    }
-
-    std::string output = "";
-    while (fgets(path, PATH_MAX, fp) != NULL)
-    {
-        output += std::string(path);
-    }
-
-    int status = pclose(fp);
-    if (status)
-    {
-        return std::to_string(status) + " was returned from run anchor command";
-    }
-    else
-    {
-        return output;
-    }
+std::string optimizedWorkload(const std::string& name, const std::string& function)
+{
+    std::ifstream workload(std::string(ANCHOR_BENCH_WORKLOADS_DIR) + "/" + name);
+    std::stringstream sourceCode;
+    sourceCode << workload.rdbuf();
+
+    std::string llvmAnchor = anchor::compile(sourceCode.str(), compiler::OptimizationLevel::O2);
+    std::size_t start = llvmAnchor.find("@" + function + "(");
+    start = llvmAnchor.rfind("define", start);
+    return llvmAnchor.substr(start, llvmAnchor.find("\n}\n", start) - start);
 }
 
-TEST(AnchorTest, ItShouldBeAbleToPrintHelloWorld)
+TEST_F(AnchorTest, ItShouldBeAbleToPrintHelloWorld)
 {
     std::string sourceCode =
         R"(function integer main() {
@@ -50,12 +35,11 @@ TEST(AnchorTest, ItShouldBeAbleToPrintHelloWorld)
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "Hello, World!");
 }
 
-TEST(AnchorTest, ItShouldPrintStringThatIsNotHelloWorld)
+TEST_F(AnchorTest, ItShouldPrintStringThatIsNotHelloWorld)
 {
     std::string sourceCode =
         R"(function integer main() {
@@ -63,12 +47,11 @@ TEST(AnchorTest, ItShouldPrintStringThatIsNotHelloWorld)
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "This is another test string!");
 }
 
-TEST(AnchorTest, ItShouldPrintInteger)
+TEST_F(AnchorTest, ItShouldPrintInteger)
 {
     std::string sourceCode =
         R"(function integer main() {
@@ -76,12 +59,11 @@ TEST(AnchorTest, ItShouldPrintInteger)
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "5");
 }
 
-TEST(AnchorTest, ItShouldPrintResultOfSimpleAddition)
+TEST_F(AnchorTest, ItShouldPrintResultOfSimpleAddition)
 {
     std::string sourceCode =
         R"(function integer main() {
@@ -89,12 +71,11 @@ TEST(AnchorTest, ItShouldPrintResultOfSimpleAddition)
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "8");
 }
 
-TEST(AnchorTest, ItShouldPrintResultOfSimpleSubtraction)
+TEST_F(AnchorTest, ItShouldPrintResultOfSimpleSubtraction)
 {
     std::string sourceCode =
         R"(function integer main() {
@@ -102,12 +83,11 @@ TEST(AnchorTest, ItShouldPrintResultOfSimpleSubtraction)
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldPrintResultOfSimpleMultiplication)
+TEST_F(AnchorTest, ItShouldPrintResultOfSimpleMultiplication)
 {
     std::string sourceCode =
         R"(function integer main() {
@@ -115,12 +95,11 @@ TEST(AnchorTest, ItShouldPrintResultOfSimpleMultiplication)
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "15");
 }
 
-TEST(AnchorTest, ItShouldPrintResultOfFunctionWithNonComplexInteger)
+TEST_F(AnchorTest, ItShouldPrintResultOfFunctionWithNonComplexInteger)
 {
     std::string sourceCode = R"(
 
@@ -133,12 +112,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "1");
 }
 
-TEST(AnchorTest, ItShouldPrintResultOfFunctionWithAnotherFunctionCall)
+TEST_F(AnchorTest, ItShouldPrintResultOfFunctionWithAnotherFunctionCall)
 {
     std::string sourceCode = R"(
 
@@ -155,12 +133,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldPrintResultOfFunctionAddedWithConstantOnLeftSide)
+TEST_F(AnchorTest, ItShouldPrintResultOfFunctionAddedWithConstantOnLeftSide)
 {
     std::string sourceCode = R"(
 
@@ -177,12 +154,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "5");
 }
 
-TEST(AnchorTest, ItShouldPrintResultOfFunctionAddedWithConstantOnRightSide)
+TEST_F(AnchorTest, ItShouldPrintResultOfFunctionAddedWithConstantOnRightSide)
 {
     std::string sourceCode = R"(
 
@@ -200,12 +176,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "In Bar5");
 }
 
-TEST(AnchorTest, ItShouldUseVariableToHoldIntegerAndPrint)
+TEST_F(AnchorTest, ItShouldUseVariableToHoldIntegerAndPrint)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -215,12 +190,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "5");
 }
 
-TEST(AnchorTest, ItShouldUseLocalVarInAnotherFunction)
+TEST_F(AnchorTest, ItShouldUseLocalVarInAnotherFunction)
 {
     std::string sourceCode = R"(
 
@@ -237,12 +211,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "8");
 }
 
-TEST(AnchorTest, ItShouldUseTwoLocalVarsInAdditionStmt)
+TEST_F(AnchorTest, ItShouldUseTwoLocalVarsInAdditionStmt)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -255,12 +228,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "9");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToUseOneArgFunction)
+TEST_F(AnchorTest, ItShouldBeAbleToUseOneArgFunction)
 {
     std::string sourceCode = R"(
 
@@ -276,12 +248,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "15");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToUseTwoArgFunctions)
+TEST_F(AnchorTest, ItShouldBeAbleToUseTwoArgFunctions)
 {
     std::string sourceCode = R"(
 
@@ -297,12 +268,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "20");
 }
 
-TEST(AnchorTest, ItShouldPrintTrueExpression)
+TEST_F(AnchorTest, ItShouldPrintTrueExpression)
 {
     std::string sourceCode = R"(
 
@@ -311,12 +281,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "1");
 }
 
-TEST(AnchorTest, ItShouldPrintFalseExpression)
+TEST_F(AnchorTest, ItShouldPrintFalseExpression)
 {
     std::string sourceCode = R"(
 
@@ -325,12 +294,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "0");
 }
 
-TEST(AnchorTest, ItShouldDeclAndAssignBooleanToTrue)
+TEST_F(AnchorTest, ItShouldDeclAndAssignBooleanToTrue)
 {
     std::string sourceCode = R"(
 
@@ -341,13 +309,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::cout << llvmAnchor << std::endl;
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "1");
 }
 
-TEST(AnchorTest, ItShouldDeclAndAssignBooleanToFalse)
+TEST_F(AnchorTest, ItShouldDeclAndAssignBooleanToFalse)
 {
     std::string sourceCode = R"(
 
@@ -358,12 +324,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "0");
 }
 
-TEST(AnchorTest, ItShouldRunLessThanBooleanExpression)
+TEST_F(AnchorTest, ItShouldRunLessThanBooleanExpression)
 {
     std::string sourceCode = R"(
 
@@ -372,12 +337,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "1");
 }
 
-TEST(AnchorTest, ItShouldTakeIfBranchIfConditionSuccessful)
+TEST_F(AnchorTest, ItShouldTakeIfBranchIfConditionSuccessful)
 {
     std::string sourceCode = R"(
 
@@ -389,12 +353,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldTakeIfBranchIfConditionNotSuccessful)
+TEST_F(AnchorTest, ItShouldTakeIfBranchIfConditionNotSuccessful)
 {
     std::string sourceCode = R"(
 
@@ -406,12 +369,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "");
 }
 
-TEST(AnchorTest, ItShouldTakeWhileLoopWhileConditionTrue)
+TEST_F(AnchorTest, ItShouldTakeWhileLoopWhileConditionTrue)
 {
     std::string sourceCode = R"(
 
@@ -426,12 +388,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "012");
 }
 
-TEST(AnchorTest, ItShouldDoFunctionCallWithWhileLoopInIt)
+TEST_F(AnchorTest, ItShouldDoFunctionCallWithWhileLoopInIt)
 {
     std::string sourceCode = R"(
 
@@ -452,12 +413,59 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "3");
 }
 
-TEST(AnchorTest, ItShouldUseIfStmtWithGreaterThan)
+TEST_F(AnchorTest, ItShouldUseConstantStackInLongRunningLoop)
+{
+    std::string sourceCode = R"(
+
+function integer add(integer a, integer b) {
+    return a + b;
+};
+
+function integer main() {
+    integer i;
+    integer sum;
+    string greeting;
+    i = 0;
+    sum = 0;
+    while (i < 1000000) {
+        sum = add(sum, 1);
+        greeting = "Hello, " + "World!";
+        i = i + 1;
+    };
+    print(sum);
+    return 0;
+};)";
+
+    std::string output = this->run(sourceCode);
+    EXPECT_EQ(output, "1000000");
+}
+
+TEST_F(AnchorLlvmTest, ItShouldPlaceAllAllocasInEntryBlock)
+{
+    std::string sourceCode = R"(
+
+function integer main() {
+    integer i;
+    i = 0;
+    while (i < 3) {
+        string greeting;
+        greeting = "Hello, " + "World!";
+        i = i + 1;
+    };
+    return 0;
+};)";
+
+    std::string llvmAnchor = anchor::compile(sourceCode);
+    std::size_t firstBranch = llvmAnchor.find(" br ");
+    ASSERT_NE(std::string::npos, firstBranch);
+    EXPECT_EQ(std::string::npos, llvmAnchor.find("alloca", firstBranch));
+}
+
+TEST_F(AnchorTest, ItShouldUseIfStmtWithGreaterThan)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -468,12 +476,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldUseDoubleEqualsOnTrue)
+TEST_F(AnchorTest, ItShouldUseDoubleEqualsOnTrue)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -484,12 +491,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldUseDoubleEqualsOnFalse)
+TEST_F(AnchorTest, ItShouldUseDoubleEqualsOnFalse)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -500,12 +506,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "");
 }
 
-TEST(AnchorTest, ItShouldDoStringVarDeclAndAssign)
+TEST_F(AnchorTest, ItShouldDoStringVarDeclAndAssign)
 {
     std::string sourceCode = R"(
 
@@ -526,12 +531,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "Hello, World!20");
 }
 
-TEST(AnchorTest, ItShouldSeePrintStatementFromVoidFunction)
+TEST_F(AnchorTest, ItShouldSeePrintStatementFromVoidFunction)
 {
     std::string sourceCode = R"(
 function void bar() {
@@ -543,12 +547,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "Hello, World!");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateTwoStrings)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateTwoStrings)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -563,12 +566,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "23");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateTwoStringsWhenRhsIsEmpty)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateTwoStringsWhenRhsIsEmpty)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -583,12 +585,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateTwoStringsWhenLhsIsEmpty)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateTwoStringsWhenLhsIsEmpty)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -603,12 +604,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateTwoStringsWhenBothAreEmpty)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateTwoStringsWhenBothAreEmpty)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -623,12 +623,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateIntoVariable)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateIntoVariable)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -646,12 +645,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "23");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateWithThreeStrings)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateWithThreeStrings)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -672,12 +670,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "234");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateTwoLiterals)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateTwoLiterals)
 {
     std::string sourceCode = R"(
 function integer main() {
@@ -688,12 +685,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "23");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatenateTwoLiteralsWithinAFunction)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatenateTwoLiteralsWithinAFunction)
 {
     std::string sourceCode = R"(
 
@@ -706,12 +702,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "23");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToReturnAStringFromAFunction)
+TEST_F(AnchorTest, ItShouldBeAbleToReturnAStringFromAFunction)
 {
     std::string sourceCode = R"(
 
@@ -726,12 +721,11 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "2");
 }
 
-TEST(AnchorTest, ItShouldBeAbleToConcatStringInReturnStmt)
+TEST_F(AnchorTest, ItShouldBeAbleToConcatStringInReturnStmt)
 {
     std::string sourceCode = R"(
 
@@ -746,12 +740,110 @@ function integer main() {
     return 0;
 };)";
 
-    std::string llvmAnchor = anchor::compile(sourceCode);
-    std::string output = runAnchor(llvmAnchor);
+    std::string output = this->run(sourceCode);
     EXPECT_EQ(output, "23");
 }
 
-TEST(AnchorTest, ItShouldThrowCompileTimeErrorIfAddingStringAndIntTypes)
+TEST_F(AnchorTest, ItShouldPassStringArgumentByValue)
+{
+    std::string sourceCode = R"(
+
+function string greet(string name) {
+    return "Hello, " + name;
+};
+
+function integer main() {
+    print(greet("World") + "!");
+    return 0;
+};)";
+
+    std::string output = this->run(sourceCode);
+    EXPECT_EQ(output, "Hello, World!");
+}
+
+TEST_F(AnchorTest, ItShouldPassBooleanArgumentByValue)
+{
+    std::string sourceCode = R"(
+
+function void maybePrint(boolean enabled, integer value) {
+    if (enabled) {
+        print(value);
+    };
+};
+
+function integer main() {
+    maybePrint(true, 1);
+    maybePrint(false, 2);
+    maybePrint(3 > 2, 3);
+    return 0;
+};)";
+
+    std::string output = this->run(sourceCode);
+    EXPECT_EQ(output, "13");
+}
+
+TEST_F(AnchorTest, ItShouldAllowAssigningToArgument)
+{
+    std::string sourceCode = R"(
+
+function integer countDown(integer n) {
+    integer steps;
+    steps = 0;
+    while (n > 0) {
+        n = n - 1;
+        steps = steps + 1;
+    };
+    return steps;
+};
+
+function integer main() {
+    print(countDown(5));
+    return 0;
+};)";
+
+    std::string output = this->run(sourceCode);
+    EXPECT_EQ(output, "5");
+}
+
+TEST_F(AnchorTest, ItShouldRecurseWithIntegerArguments)
+{
+    std::string sourceCode = R"(
+
+function integer fib(integer n) {
+    if (n < 2) {
+        return n;
+    };
+    return fib(n - 1) + fib(n - 2);
+};
+
+function integer main() {
+    print(fib(20));
+    return 0;
+};)";
+
+    std::string output = this->run(sourceCode);
+    EXPECT_EQ(output, "6765");
+}
+
+TEST_F(AnchorLlvmTest, ItShouldNotSpillArgumentsThatAreOnlyRead)
+{
+    std::string sourceCode = R"(
+
+function integer add(integer a, integer b) {
+    return a + b;
+};
+
+function integer main() {
+    print(add(1, 2));
+    return 0;
+};)";
+
+    std::string llvmAnchor = anchor::compile(sourceCode);
+    EXPECT_NE(std::string::npos, llvmAnchor.find("define i32 @add(i32 "));
+    EXPECT_EQ(std::string::npos, llvmAnchor.find("alloca"));
+}
+
+TEST_F(AnchorLlvmTest, ItShouldThrowCompileTimeErrorIfAddingStringAndIntTypes)
 {
     std::string sourceCode = R"(
 
@@ -769,7 +861,7 @@ function integer main() {
     EXPECT_EQ(llvmAnchor, "Type Error: Expression at line 9, column 12 had STRING on left, INTEGER on right.\n");
 }
 
-TEST(AnchorTest, ItShouldThrowCompileTimeErrorIfAssigningIntegerOntoString)
+TEST_F(AnchorLlvmTest, ItShouldThrowCompileTimeErrorIfAssigningIntegerOntoString)
 {
     std::string sourceCode = R"(
 
@@ -780,4 +872,299 @@ function integer main() {
 };)";
     std::string llvmAnchor = anchor::compile(sourceCode);
     EXPECT_EQ(llvmAnchor, "Type Error: Expression at line 5, column 5 had STRING on left, INTEGER on right.\n");
-}
\ No newline at end of file
+}
+TEST_F(AnchorLlvmTest, ItShouldInlineSmallFunctionsInOptimizedWorkload)
+{
+    std::string main = optimizedWorkload("calls.anchor", "main");
+    EXPECT_EQ(std::string::npos, main.find("@add("));
+    EXPECT_EQ(std::string::npos, main.find("@scale("));
+
+    main = optimizedWorkload("strings.anchor", "main");
+    EXPECT_EQ(std::string::npos, main.find("@greet("));
+}
+
+TEST_F(AnchorLlvmTest, ItShouldFoldConstantSizeMemcpyInOptimizedWorkload)
+{
+    std::string main = optimizedWorkload("strings.anchor", "main");
+    // Copying "Hello, " (8 bytes with its terminator) and "!" (2 bytes) each fits
+    // in one integer store once the prototype is recognized as a builtin.
+    EXPECT_NE(std::string::npos, main.find("store i64"));
+    EXPECT_NE(std::string::npos, main.find("store i16"));
+    EXPECT_EQ(std::string::npos, main.find("i64 8, i1 false"));
+    EXPECT_EQ(std::string::npos, main.find("i64 2, i1 false"));
+    EXPECT_EQ(std::string::npos, main.find("(...) @malloc"));
+}
+
+TEST_F(AnchorTest, ItShouldEmitEachFormatStringOnce)
+{
+    std::string sourceCode = R"(
+function integer main() {
+    print(1);
+    print(2);
+    print("a");
+    print("b");
+    print(3);
+    return 0;
+};)";
+
+    std::string llvmAnchor = anchor::compile(sourceCode);
+    EXPECT_EQ(llvmAnchor.find(R"(c"%d\00")"), llvmAnchor.rfind(R"(c"%d\00")"));
+    EXPECT_EQ(llvmAnchor.find(R"(c"%s\00")"), llvmAnchor.rfind(R"(c"%s\00")"));
+    EXPECT_EQ("12ab3", this->run(sourceCode));
+}
+
+TEST_F(AnchorTest, ItShouldShareGlobalForRepeatedStringLiteral)
+{
+    std::string sourceCode = R"(
+function string hello() {
+    return "Hello";
+};
+
+function integer main() {
+    string a;
+    a = "Hello" + hello();
+    print(a + "Hello");
+    return 0;
+};)";
+
+    std::string llvmAnchor = anchor::compile(sourceCode);
+    EXPECT_NE(std::string::npos, llvmAnchor.find(R"(c"Hello\00")"));
+    EXPECT_EQ(llvmAnchor.find(R"(c"Hello\00")"), llvmAnchor.rfind(R"(c"Hello\00")"));
+    EXPECT_EQ("HelloHelloHello", this->run(sourceCode));
+}
+
+TEST_F(AnchorTest, ItShouldShadowVariableInNestedBlock)
+{
+    std::string sourceCode = R"(
+function integer main() {
+    integer x;
+    x = 1;
+    if (true) {
+        integer x;
+        x = 2;
+        print(x);
+    };
+    print(x);
+    return 0;
+};)";
+
+    std::string output = this->run(sourceCode);
+    EXPECT_EQ(output, "21");
+}
+
+TEST_F(AnchorTest, ItShouldKeepSiblingBlockVariablesWithSameNameApart)
+{
+    std::string sourceCode = R"(
+function integer main() {
+    if (true) {
+        integer y;
+        y = 3;
+        print(y);
+    };
+    if (true) {
+        string y;
+        y = "s";
+        print(y);
+    };
+    return 0;
+};)";
+
+    std::string output = this->run(sourceCode, compiler::OptimizationLevel::O1);
+    EXPECT_EQ(output, "3s");
+}
+
+// Writes objects and executables into a directory of the test's own, so the
+// tests never see each other's files.
+class AnchorNativeTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path directory;
+
+    void SetUp() override
+    {
+        const ::testing::TestInfo *test = ::testing::UnitTest::GetInstance()->current_test_info();
+        this->directory = std::filesystem::temp_directory_path() / ("anchor_native_test_" + std::string(test->name()) + "_" + std::to_string(getpid()));
+        std::filesystem::remove_all(this->directory);
+        std::filesystem::create_directories(this->directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(this->directory);
+    }
+};
+
+TEST_F(AnchorNativeTest, ItShouldLinkNativeExecutableFromObject)
+{
+    std::string sourceCode = R"(
+function string greet(string name) {
+    return "Hello, " + name;
+};
+
+function integer main() {
+    print(greet("World"));
+    return 0;
+};)";
+
+    std::string objectPath = this->directory / "greet.o";
+    std::string executablePath = this->directory / "greet";
+
+    anchor::CompilationUnit unit(sourceCode);
+    ASSERT_EQ("", anchor::compileToObject(unit, objectPath, compiler::OptimizationLevel::O2));
+    anchor::link(objectPath, executablePath);
+
+    char buffer[PATH_MAX];
+    FILE *fp = popen(executablePath.c_str(), "r");
+    ASSERT_NE(nullptr, fp);
+    std::string output = "";
+    while (fgets(buffer, PATH_MAX, fp) != NULL)
+    {
+        output += std::string(buffer);
+    }
+    EXPECT_EQ(0, pclose(fp));
+    EXPECT_EQ("Hello, World", output);
+}
+
+TEST_F(AnchorNativeTest, ItShouldRemoveObjectWhenLinkingFails)
+{
+    std::string executablePath = this->directory / "unlinked";
+
+    anchor::CompilationUnit unit("function integer main() {\n    return 0;\n};");
+    EXPECT_THROW(anchor::compileToExecutable(unit, executablePath, compiler::OptimizationLevel::O0, 0, nullptr, "false"), std::runtime_error);
+
+    EXPECT_FALSE(std::filesystem::exists(executablePath + ".o"));
+}
+
+TEST_F(AnchorNativeTest, ItShouldReturnDiagnosticsInsteadOfObject)
+{
+    anchor::CompilationUnit unit("function integer main() { print(\"oops); };");
+
+    std::string errors = anchor::compileToObject(unit, this->directory / "invalid.o");
+
+    EXPECT_EQ("Unterminated string literal at line 1, column 33.\n", errors);
+}
+
+TEST_F(AnchorLlvmTest, ItShouldStreamBitcodeIntoCallerBuffer)
+{
+    std::string sourceCode = R"(
+function integer main() {
+    print("Hello, " + "Bitcode");
+    return 0;
+};)";
+
+    llvm::SmallVector<char, 0> bitcode;
+    ASSERT_EQ("", anchor::compile(sourceCode, bitcode));
+    ASSERT_GT(bitcode.size(), 4);
+    EXPECT_EQ("BC\xC0\xDE", std::string(bitcode.data(), 4));
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+#if LLVM_VERSION_MAJOR < 15
+    context->enableOpaquePointers();
+#endif
+    llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), "bitcode"), *context);
+    ASSERT_TRUE(static_cast<bool>(module)) << llvm::toString(module.takeError());
+    EXPECT_EQ("Hello, Bitcode", this->run(std::move(context), std::move(*module)));
+}
+
+TEST_F(AnchorLlvmTest, ItShouldLeaveBitcodeBufferEmptyOnErrors)
+{
+    llvm::SmallVector<char, 0> bitcode;
+
+    std::string errors = anchor::compile("function integer main() { print(\"oops); };", bitcode);
+
+    EXPECT_EQ("Unterminated string literal at line 1, column 33.\n", errors);
+    EXPECT_TRUE(bitcode.empty());
+}
+
+TEST(AnchorStressTest, ItShouldCompileConcurrentlyFromManyThreads)
+{
+    // Diagnostics name tokens and types, so the lexer's and parser's name tables
+    // are read from every thread too.
+    std::vector<std::string> sources;
+    for (const char *name : {"calls.anchor", "loops.anchor", "recursion.anchor", "strings.anchor"})
+    {
+        std::ifstream workload(std::string(ANCHOR_BENCH_WORKLOADS_DIR) + "/" + name);
+        std::stringstream sourceCode;
+        sourceCode << workload.rdbuf();
+        sources.push_back(sourceCode.str());
+    }
+    sources.push_back("function integer main( {\n};");
+    sources.push_back("function integer main() {\n    integer a;\n    a = \"x\";\n    return 0;\n};");
+
+    std::vector<std::string> expected;
+    for (const std::string &source : sources)
+    {
+        expected.push_back(anchor::compile(source, compiler::OptimizationLevel::O2));
+    }
+
+    constexpr int threadCount = 16;
+    constexpr int rounds = 4;
+    std::vector<std::vector<std::string>> outputs(threadCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 for (int round = 0; round < rounds; round++)
+                                 {
+                                     for (std::size_t i = 0; i < sources.size(); i++)
+                                     {
+                                         // Every thread starts at a different source.
+                                         const std::string &source = sources[(i + t) % sources.size()];
+                                         outputs[t].push_back(anchor::compile(source, compiler::OptimizationLevel::O2));
+                                     }
+                                 } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (int t = 0; t < threadCount; t++)
+    {
+        ASSERT_EQ(rounds * sources.size(), outputs[t].size());
+        for (std::size_t i = 0; i < outputs[t].size(); i++)
+        {
+            EXPECT_EQ(expected[(i + t) % sources.size()], outputs[t][i]) << "thread " << t << ", compile " << i;
+        }
+    }
+}
+
+TEST(AnchorSinkTest, ItShouldStreamIrIntoSink)
+{
+    std::string sourceCode = "function integer main() {\n    print(\"streamed\");\n    return 0;\n};";
+    anchor::CompilationUnit unit(sourceCode);
+    std::string written;
+    llvm::raw_string_ostream sink(written);
+
+    EXPECT_EQ("", anchor::compileToIR(unit, sink, compiler::OptimizationLevel::O2));
+    sink.flush();
+
+    EXPECT_EQ(anchor::compile(sourceCode, compiler::OptimizationLevel::O2), written);
+}
+
+TEST(AnchorSinkTest, ItShouldStreamBitcodeIntoSink)
+{
+    std::string sourceCode = "function integer main() {\n    print(\"streamed\");\n    return 0;\n};";
+    anchor::CompilationUnit unit(sourceCode);
+    llvm::SmallVector<char, 0> written;
+    llvm::raw_svector_ostream sink(written);
+
+    EXPECT_EQ("", anchor::compileToBitcode(unit, sink));
+
+    llvm::SmallVector<char, 0> expected;
+    anchor::compile(sourceCode, expected);
+    EXPECT_EQ(std::string(expected.begin(), expected.end()), std::string(written.begin(), written.end()));
+}
+
+TEST(AnchorSinkTest, ItShouldWriteNothingIntoSinkOnErrors)
+{
+    anchor::CompilationUnit unit("function integer main( {\n};");
+    std::string written;
+    llvm::raw_string_ostream sink(written);
+
+    EXPECT_EQ("Expected: INTEGER_TYPE, BOOLEAN_TYPE at line 1, column 24, but found \"{\".\n", anchor::compileToIR(unit, sink));
+    sink.flush();
+
+    EXPECT_EQ("", written);
+}
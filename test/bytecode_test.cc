@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+#include "src/bytecode.hh"
+#include "src/compilationunit.hh"
+
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+    bytecode::Module lower(const std::string &sourceCode)
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        return bytecode::lower(unit.program);
+    }
+
+    std::vector<bytecode::Opcode> opcodes(const bytecode::Function &function)
+    {
+        std::vector<bytecode::Opcode> opcodes;
+        for (const bytecode::Instruction &instruction : function.code)
+        {
+            opcodes.push_back(instruction.opcode);
+        }
+        return opcodes;
+    }
+
+    const std::string loop = R"(function integer main() {
+    integer i;
+    integer sum;
+    i = 0;
+    sum = 0;
+    while (i < 10) {
+        sum = sum + i;
+        i = i + 1;
+    };
+    print(sum);
+    return 0;
+};)";
+}
+
+TEST(BytecodeTest, ItShouldFuseComparisonIntoLoopBranch)
+{
+    bytecode::Module module = lower(loop);
+
+    std::vector<bytecode::Opcode> main = opcodes(module.functions[module.main]);
+    EXPECT_EQ(1, std::count(main.begin(), main.end(), bytecode::Opcode::JUMP_IF_NOT_LESS_THAN));
+    EXPECT_EQ(0, std::count(main.begin(), main.end(), bytecode::Opcode::LESS_THAN));
+    EXPECT_EQ(0, std::count(main.begin(), main.end(), bytecode::Opcode::JUMP_IF_FALSE));
+}
+
+TEST(BytecodeTest, ItShouldAddIntegerLiteralsWithoutLoadingThem)
+{
+    bytecode::Module module = lower(loop);
+
+    const bytecode::Function &main = module.functions[module.main];
+    auto increment = std::find_if(main.code.begin(), main.code.end(), [](const bytecode::Instruction &instruction)
+                                  { return instruction.opcode == bytecode::Opcode::ADD_INTEGER; });
+    ASSERT_NE(main.code.end(), increment);
+    // i = i + 1 updates i's register in place.
+    EXPECT_EQ(increment->a, increment->b);
+    EXPECT_EQ(1, increment->c);
+    // The two variables, and a temporary for the loop bound.
+    EXPECT_EQ(3, main.registers);
+}
+
+TEST(BytecodeTest, ItShouldEvaluateArgumentsIntoCalleeFrame)
+{
+    bytecode::Module module = lower(R"(function integer add(integer a, integer b) {
+    return a + b;
+};
+
+function integer main() {
+    integer x;
+    x = add(1, 2);
+    return x;
+};)");
+
+    const bytecode::Function &main = module.functions[module.main];
+    ASSERT_EQ(bytecode::Opcode::LOAD_INTEGER, main.code[1].opcode);
+    ASSERT_EQ(bytecode::Opcode::LOAD_INTEGER, main.code[2].opcode);
+    ASSERT_EQ(bytecode::Opcode::CALL, main.code[3].opcode);
+    EXPECT_EQ(main.code[1].a, main.code[3].b);
+    EXPECT_EQ(main.code[1].a + 1, main.code[2].a);
+    // The result goes straight to x.
+    EXPECT_EQ(main.code[0].a, main.code[3].a);
+}
+
+TEST(BytecodeTest, ItShouldInternStringLiterals)
+{
+    bytecode::Module module = lower(R"(function integer main() {
+    print("a");
+    print("a" + "b");
+    return 0;
+};)");
+
+    EXPECT_EQ((std::vector<std::string>{"a", "b"}), module.strings);
+}
+
+TEST(BytecodeTest, ItShouldRoundTripThroughFileFormat)
+{
+    bytecode::Module module = lower(R"(function string greet(string name) {
+    return "Hello, " + name;
+};
+
+function integer main() {
+    print(greet("World"));
+    return 0;
+};)");
+
+    std::stringstream file;
+    bytecode::write(file, module);
+    EXPECT_TRUE(bytecode::isBytecode(file.str()));
+    bytecode::Module read = bytecode::read(file);
+
+    EXPECT_EQ(module.strings, read.strings);
+    EXPECT_EQ(module.main, read.main);
+    ASSERT_EQ(module.functions.size(), read.functions.size());
+    for (std::size_t i = 0; i < module.functions.size(); i++)
+    {
+        EXPECT_EQ(module.functions[i].name, read.functions[i].name);
+        EXPECT_EQ(module.functions[i].parameters, read.functions[i].parameters);
+        EXPECT_EQ(module.functions[i].result, read.functions[i].result);
+        EXPECT_EQ(module.functions[i].registers, read.functions[i].registers);
+        EXPECT_EQ(opcodes(module.functions[i]), opcodes(read.functions[i]));
+    }
+}
+
+TEST(BytecodeTest, ItShouldRejectTruncatedFile)
+{
+    std::stringstream file;
+    bytecode::write(file, lower(loop));
+    std::string truncated = file.str().substr(0, file.str().size() - 3);
+
+    std::istringstream in(truncated);
+    try
+    {
+        bytecode::read(in);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Invalid bytecode: unexpected end of file.", e.what());
+    }
+}
+
+TEST(BytecodeTest, ItShouldRejectJumpOutsideFunction)
+{
+    bytecode::Module module = lower(loop);
+    bytecode::Function &main = module.functions[module.main];
+    main.code.back() = bytecode::Instruction{bytecode::Opcode::JUMP, 0, 0, static_cast<std::int32_t>(main.code.size())};
+
+    try
+    {
+        bytecode::validate(module);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_EQ("Invalid bytecode: instruction " + std::to_string(main.code.size() - 1) + " of main jumps outside its function.", e.what());
+    }
+}
+
+TEST(BytecodeTest, ItShouldRejectOperandsOfWrongKind)
+{
+    auto validate = [](std::vector<bytecode::Instruction> code)
+    {
+        bytecode::Module module;
+        module.strings = {"a"};
+        bytecode::Function main;
+        main.name = "main";
+        main.registers = 2;
+        main.code = std::move(code);
+        module.functions.push_back(main);
+        module.main = 0;
+
+        try
+        {
+            bytecode::validate(module);
+            return std::string();
+        }
+        catch (std::invalid_argument &e)
+        {
+            return std::string(e.what());
+        }
+    };
+
+    // Makes a string's size huge, then concatenates it.
+    std::vector<bytecode::Instruction> overread = {
+        bytecode::Instruction{bytecode::Opcode::LOAD_STRING, 0, 0, 0},
+        bytecode::Instruction{bytecode::Opcode::ADD_INTEGER, 0, 0, 200000000},
+        bytecode::Instruction{bytecode::Opcode::CONCAT, 1, 0, 0},
+        bytecode::Instruction{bytecode::Opcode::RETURN_VOID},
+    };
+    EXPECT_EQ("Invalid bytecode: instruction 1 of main reads a register that does not hold an integer.", validate(overread));
+
+    std::vector<bytecode::Instruction> printInteger = {
+        bytecode::Instruction{bytecode::Opcode::LOAD_INTEGER, 0, 0, 7},
+        bytecode::Instruction{bytecode::Opcode::PRINT_STRING, 0},
+        bytecode::Instruction{bytecode::Opcode::RETURN_VOID},
+    };
+    EXPECT_EQ("Invalid bytecode: instruction 1 of main reads a register that does not hold a string.", validate(printInteger));
+
+    // Nothing has been written to the register yet.
+    std::vector<bytecode::Instruction> printUnwritten = {
+        bytecode::Instruction{bytecode::Opcode::PRINT_STRING, 1},
+        bytecode::Instruction{bytecode::Opcode::RETURN_VOID},
+    };
+    EXPECT_EQ("Invalid bytecode: instruction 0 of main reads a register that does not hold a string.", validate(printUnwritten));
+}
+
+TEST(BytecodeTest, ItShouldRejectRegisterOfDifferentKindsOnTwoPaths)
+{
+    bytecode::Module module = lower(R"(function integer main() {
+    integer i;
+    if (i < 1) {
+        i = 2;
+    };
+    print(i);
+    return 0;
+};)");
+    bytecode::validate(module);
+
+    // Make the if assign a string to i instead, so after it i is either kind.
+    bytecode::Function &main = module.functions[module.main];
+    module.strings.push_back("s");
+    auto assignment = std::find_if(main.code.begin(), main.code.end(), [](const bytecode::Instruction &instruction)
+                                   { return instruction.opcode == bytecode::Opcode::LOAD_INTEGER && instruction.c == 2; });
+    ASSERT_NE(main.code.end(), assignment);
+    *assignment = bytecode::Instruction{bytecode::Opcode::LOAD_STRING, assignment->a, 0, static_cast<std::int32_t>(module.strings.size() - 1)};
+
+    EXPECT_THROW(bytecode::validate(module), std::invalid_argument);
+}
+
+TEST(BytecodeTest, ItShouldRequireMainFunction)
+{
+    EXPECT_THROW(lower(R"(function integer foo() {
+    return 0;
+};)"),
+                 std::invalid_argument);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include "src/cache.hh"
+
+#include <chrono>
+#include <fstream>
+
+class CacheTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path directory;
+
+    void SetUp() override
+    {
+        const ::testing::TestInfo *test = ::testing::UnitTest::GetInstance()->current_test_info();
+        this->directory = std::filesystem::temp_directory_path() / (std::string("anchor_cache_test_") + test->name());
+        std::filesystem::remove_all(this->directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(this->directory);
+    }
+
+    void age(const std::string &key, int minutes)
+    {
+        std::filesystem::last_write_time(this->directory / key, std::filesystem::file_time_type::clock::now() - std::chrono::minutes(minutes));
+    }
+};
+
+TEST_F(CacheTest, ItShouldMissUntilStoredThenHit)
+{
+    cache::Cache testObject(this->directory);
+    std::string key = cache::key("function integer main() { return 0; };", compiler::OptimizationLevel::O2, "llvm");
+
+    EXPECT_FALSE(testObject.read(key).has_value());
+    testObject.store(key, "; ModuleID = 'anchor'");
+
+    EXPECT_EQ("; ModuleID = 'anchor'", testObject.read(key).value());
+}
+
+TEST_F(CacheTest, ItShouldKeySourceLevelAndArtifactSeparately)
+{
+    std::string source = "function integer main() { return 0; };";
+    std::string key = cache::key(source, compiler::OptimizationLevel::O0, "llvm");
+
+    EXPECT_EQ(64, key.size());
+    EXPECT_EQ(key, cache::key(source, compiler::OptimizationLevel::O0, "llvm"));
+    EXPECT_NE(key, cache::key(source + " ", compiler::OptimizationLevel::O0, "llvm"));
+    EXPECT_NE(key, cache::key(source, compiler::OptimizationLevel::O1, "llvm"));
+    EXPECT_NE(key, cache::key(source, compiler::OptimizationLevel::O0, "bc"));
+}
+
+TEST_F(CacheTest, ItShouldCopyCachedFileToDestination)
+{
+    cache::Cache testObject(this->directory);
+    std::filesystem::path built = this->directory / "built.o";
+    std::filesystem::create_directories(this->directory);
+    {
+        std::ofstream out(built, std::ios::binary);
+        out << "object";
+    }
+
+    testObject.storeFile("key", built);
+    std::filesystem::path fetched = this->directory / "fetched.o";
+
+    ASSERT_TRUE(testObject.fetch("key", fetched));
+    EXPECT_FALSE(testObject.fetch("missing", fetched));
+    std::ifstream in(fetched, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ("object", contents);
+}
+
+TEST_F(CacheTest, ItShouldNotLeaveTemporaryFilesBehind)
+{
+    cache::Cache testObject(this->directory);
+
+    testObject.store("first", "1");
+    testObject.store("second", "2");
+    testObject.store("first", "3");
+
+    std::vector<std::string> names;
+    for (const auto &entry : std::filesystem::directory_iterator(this->directory))
+    {
+        names.push_back(entry.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    EXPECT_EQ((std::vector<std::string>{"first", "second", "usage"}), names);
+    EXPECT_EQ("3", testObject.read("first").value());
+}
+
+TEST_F(CacheTest, ItShouldEvictLeastRecentlyUsedEntries)
+{
+    cache::Cache testObject(this->directory, 10);
+
+    testObject.store("a", "aaaa");
+    testObject.store("b", "bbbb");
+    this->age("a", 3);
+    this->age("b", 2);
+    // Reading a makes b the least recently used.
+    ASSERT_TRUE(testObject.read("a").has_value());
+
+    testObject.store("c", "cccc");
+
+    EXPECT_TRUE(testObject.read("a").has_value());
+    EXPECT_FALSE(testObject.read("b").has_value());
+    EXPECT_TRUE(testObject.read("c").has_value());
+}
+
+TEST_F(CacheTest, ItShouldOnlyScanOnceRunningTotalOutgrowsCapacity)
+{
+    cache::Cache testObject(this->directory, 10);
+    auto usage = [this]
+    {
+        std::ifstream in(this->directory / "usage");
+        std::string contents;
+        in >> contents;
+        return contents;
+    };
+
+    testObject.store("a", "aaaa");
+    testObject.store("b", "bbbb");
+    EXPECT_EQ("8", usage());
+
+    // An entry the running total does not know about stays until a store outgrows it.
+    {
+        std::ofstream out(this->directory / "stray", std::ios::binary);
+        out << "ssssssss";
+    }
+    this->age("stray", 5);
+    testObject.store("c", "c");
+    EXPECT_EQ("9", usage());
+    EXPECT_TRUE(std::filesystem::exists(this->directory / "stray"));
+
+    this->age("a", 4);
+    this->age("b", 3);
+    this->age("c", 2);
+    testObject.store("d", "dd");
+    // The scan counts the stray entry, so it takes evicting a as well to fit.
+    EXPECT_FALSE(std::filesystem::exists(this->directory / "stray"));
+    EXPECT_FALSE(testObject.read("a").has_value());
+    EXPECT_EQ("7", usage());
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/compilationunit.hh"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Counts heap allocations made by the current thread while an AllocationCounter is alive.
+    thread_local bool counting = false;
+    thread_local std::size_t allocations = 0;
+    thread_local std::size_t bytes = 0;
+    thread_local std::size_t largest = 0;
+    thread_local std::size_t threshold = SIZE_MAX;
+    thread_local std::size_t allocationsAtLeastThreshold = 0;
+
+    class AllocationCounter
+    {
+    public:
+        explicit AllocationCounter(std::size_t atLeast = SIZE_MAX)
+        {
+            allocations = 0;
+            bytes = 0;
+            largest = 0;
+            threshold = atLeast;
+            allocationsAtLeastThreshold = 0;
+            counting = true;
+        }
+
+        ~AllocationCounter()
+        {
+            counting = false;
+        }
+    };
+
+    std::string generateProgram(int functions)
+    {
+        std::string source;
+        for (int i = 0; i < functions; i++)
+        {
+            source += "function integer f" + std::to_string(i) + R"((integer a, integer b) {
+    integer c;
+    c = a + b * 2;
+    while (c < 100) {
+        c = c + 1;
+    };
+    print("f)" + std::to_string(i) + R"(");
+    return c;
+};
+)";
+        }
+        source += R"(function integer main() {
+    print(f0(1, 2));
+    return 0;
+};
+)";
+        return source;
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    if (counting)
+    {
+        allocations++;
+        bytes += size;
+        largest = std::max(largest, size);
+        if (size >= threshold)
+        {
+            allocationsAtLeastThreshold++;
+        }
+    }
+
+    void *allocated = std::malloc(size == 0 ? 1 : size);
+    if (allocated == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return allocated;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+TEST(CompilationUnitTest, ItShouldNotCopySourceIntoUnitOrLexer)
+{
+    std::string source = generateProgram(500);
+    const char *buffer = source.data();
+
+    anchor::CompilationUnit unit(std::move(source));
+    EXPECT_EQ(buffer, unit.source.data());
+
+    {
+        AllocationCounter counter;
+        anchor::lex(unit);
+    }
+
+    EXPECT_FALSE(unit.tokens.empty());
+    EXPECT_LT(largest, unit.source.size());
+}
+
+TEST(CompilationUnitTest, ItShouldBorrowTokensWhenConstructingParser)
+{
+    anchor::CompilationUnit unit(generateProgram(500));
+    anchor::lex(unit);
+
+    {
+        AllocationCounter counter;
+        parser::Parser borrowing(unit.tokens);
+    }
+
+    EXPECT_EQ(0, allocations);
+}
+
+TEST(CompilationUnitTest, ItShouldNotCopyTokensWhileParsing)
+{
+    anchor::CompilationUnit unit(generateProgram(500));
+
+    std::size_t lexedBytes = 0;
+    {
+        AllocationCounter counter;
+        anchor::lex(unit);
+        lexedBytes = bytes;
+    }
+
+    {
+        AllocationCounter counter;
+        anchor::parse(unit);
+    }
+
+    EXPECT_FALSE(unit.hasErrors());
+    EXPECT_EQ(501, unit.program.stmts.size());
+    // Building the AST allocates, but copying the token stream or any of the
+    // token text would cost at least as much as lexing did.
+    EXPECT_LT(bytes, lexedBytes);
+}
+
+TEST(CompilationUnitTest, ItShouldMoveProgramOutOfParser)
+{
+    anchor::CompilationUnit unit(generateProgram(10));
+    anchor::lex(unit);
+
+    parser::Parser parser(unit.tokens);
+    parser::Program parsed = parser.parse();
+    const std::shared_ptr<parser::Stmt> *stmts = parsed.stmts.data();
+
+    {
+        AllocationCounter counter;
+        unit.program = std::move(parsed);
+    }
+
+    EXPECT_EQ(0, allocations);
+    EXPECT_EQ(stmts, unit.program.stmts.data());
+}
+
+TEST(CompilationUnitTest, ItShouldNotCopyGeneratedIr)
+{
+    std::string expected = anchor::compile(generateProgram(500));
+
+    anchor::CompilationUnit unit(generateProgram(500));
+    std::string ir;
+    {
+        AllocationCounter counter(expected.size());
+        ir = anchor::compile(unit);
+    }
+
+    ASSERT_EQ(expected, ir);
+    // The output string grows geometrically, so only its final buffer is as large
+    // as the IR itself. Any copy of the IR would need a second one.
+    EXPECT_LE(allocationsAtLeastThreshold, 1);
+}
+
+TEST(CompilationUnitTest, ItShouldCollectLexerErrorsAsDiagnostics)
+{
+    anchor::CompilationUnit unit("function integer main() { print(\"oops); };");
+
+    anchor::lex(unit);
+    anchor::parse(unit);
+
+    ASSERT_TRUE(unit.hasErrors());
+    EXPECT_EQ("Unterminated string literal at line 1, column 33.", unit.diagnostics[0].getMessage());
+    EXPECT_TRUE(unit.tokens.empty());
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/driver.hh"
+
+#include <fstream>
+#include <sstream>
+
+class DriverTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path directory;
+    std::ostringstream out;
+    std::ostringstream err;
+
+    void SetUp() override
+    {
+        const ::testing::TestInfo *test = ::testing::UnitTest::GetInstance()->current_test_info();
+        this->directory = std::filesystem::temp_directory_path() / (std::string("anchor_driver_test_") + test->name());
+        std::filesystem::remove_all(this->directory);
+        std::filesystem::create_directories(this->directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(this->directory);
+    }
+
+    void write(const std::string &name, const std::string &source)
+    {
+        std::filesystem::create_directories((this->directory / name).parent_path());
+        std::ofstream file(this->directory / name, std::ios::binary);
+        file << source;
+    }
+
+    std::string read(const std::string &name)
+    {
+        std::ifstream file(this->directory / name, std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    int run(std::vector<const char *> args)
+    {
+        std::istringstream in;
+        driver::Environment environment(this->directory, in, this->out, this->err);
+        args.insert(args.begin(), "main");
+        return driver::run(static_cast<int>(args.size()), args.data(), environment);
+    }
+};
+
+namespace
+{
+    std::string program(int value)
+    {
+        return "function integer main() {\n    print(" + std::to_string(value) + ");\n    return 0;\n};\n";
+    }
+}
+
+TEST_F(DriverTest, ItShouldCompileBatchIntoOutputDirectory)
+{
+    std::vector<const char *> args{"-j", "3", "--no-cache", "-O2", "--emit=llvm", "-o", "out/"};
+    std::vector<std::string> names;
+    for (int i = 0; i < 8; i++)
+    {
+        names.push_back("program" + std::to_string(i) + ".anchor");
+        this->write(names.back(), program(i));
+    }
+    for (const std::string &name : names)
+    {
+        args.push_back(name.c_str());
+    }
+
+    EXPECT_EQ(0, this->run(args)) << this->err.str();
+
+    for (int i = 0; i < 8; i++)
+    {
+        EXPECT_EQ(anchor::compile(program(i), compiler::OptimizationLevel::O2), this->read("out/program" + std::to_string(i) + ".ll"));
+    }
+}
+
+TEST_F(DriverTest, ItShouldCompileRestOfBatchWhenOneInputFails)
+{
+    this->write("good.anchor", program(1));
+    this->write("bad.anchor", "function integer main( {\n};");
+
+    EXPECT_EQ(1, this->run({"-j", "2", "--no-cache", "--emit=bc", "-o", "out", "bad.anchor", "good.anchor"}));
+
+    EXPECT_EQ("Expected: INTEGER_TYPE, BOOLEAN_TYPE at line 1, column 24, but found \"{\".\n", this->err.str());
+    EXPECT_FALSE(std::filesystem::exists(this->directory / "out" / "bad.bc"));
+    EXPECT_EQ("BC\xC0\xDE", this->read("out/good.bc").substr(0, 4));
+}
+
+TEST_F(DriverTest, ItShouldRejectBatchInputsWithSameOutput)
+{
+    this->write("a/program.anchor", program(1));
+    this->write("b/program.anchor", program(2));
+
+    EXPECT_EQ(1, this->run({"-j", "2", "--no-cache", "-c", "-o", "out", "a/program.anchor", "b/program.anchor"}));
+
+    std::string out = (this->directory / "out" / "program.o").string();
+    EXPECT_EQ("Cannot compile both " + (this->directory / "a/program.anchor").string() + " and " + (this->directory / "b/program.anchor").string() + " to " + out + ".\n", this->err.str());
+}
+
+TEST_F(DriverTest, ItShouldResolveInputAgainstWorkingDirectory)
+{
+    this->write("program.anchor", program(7));
+
+    EXPECT_EQ(0, this->run({"--no-cache", "program.anchor"}));
+
+    EXPECT_EQ(anchor::compile(program(7)) + "\n", this->out.str());
+}
+
+TEST_F(DriverTest, ItShouldStreamIrIntoOutputFile)
+{
+    this->write("program.anchor", program(3));
+
+    EXPECT_EQ(0, this->run({"--no-cache", "-O2", "--emit=llvm", "-o", "program.ll", "program.anchor"}));
+
+    EXPECT_EQ("", this->out.str());
+    EXPECT_EQ(anchor::compile(program(3), compiler::OptimizationLevel::O2), this->read("program.ll"));
+}
+
+TEST_F(DriverTest, ItShouldReportInputThatCannotBeRead)
+{
+    std::string folder = (this->directory / "folder").string();
+    std::filesystem::create_directories(folder);
+
+    EXPECT_EQ(1, this->run({"--no-cache", folder.c_str()}));
+
+    EXPECT_EQ("Could not read file " + folder + "\n", this->out.str());
+}
+
+TEST_F(DriverTest, ItShouldRemoveOutputFileOnErrors)
+{
+    this->write("program.anchor", "function integer main( {\n};");
+
+    EXPECT_EQ(1, this->run({"--no-cache", "--emit=bc", "-o", "program.bc", "program.anchor"}));
+
+    EXPECT_FALSE(std::filesystem::exists(this->directory / "program.bc"));
+}
+
+TEST_F(DriverTest, ItShouldCacheModuleWhileStreamingIt)
+{
+    this->write("program.anchor", program(4));
+
+    EXPECT_EQ(0, this->run({"--cache-dir=cache", "program.anchor"}));
+    std::string first = this->out.str();
+    this->out.str("");
+    EXPECT_EQ(0, this->run({"--cache-dir=cache", "program.anchor"}));
+
+    EXPECT_EQ(anchor::compile(program(4)) + "\n", first);
+    EXPECT_EQ(first, this->out.str());
+    std::vector<std::filesystem::path> entries;
+    for (const auto &entry : std::filesystem::directory_iterator(this->directory / "cache"))
+    {
+        // Besides the entries, the cache keeps their running total size.
+        if (entry.path().filename() != "usage")
+        {
+            entries.push_back(entry.path());
+        }
+    }
+    ASSERT_EQ(1, entries.size());
+    EXPECT_EQ(first, this->read("cache/" + entries[0].filename().string()));
+}
+
+TEST_F(DriverTest, ItShouldStreamIrIntoOutputFileAChunkAtATime)
+{
+    this->write("program.anchor", program(5));
+
+    EXPECT_EQ(0, this->run({"--no-cache", "--stream", "-o", "program.ll", "--emit=llvm", "program.anchor"}));
+
+    EXPECT_EQ("", this->out.str());
+    std::string ir = this->read("program.ll");
+    EXPECT_NE(std::string::npos, ir.find("define i32 @main()"));
+    EXPECT_NE(std::string::npos, ir.find("declare i32 @printf(ptr, ...)"));
+}
+
+TEST_F(DriverTest, ItShouldFailStreamedIrOnStandardOutputOnErrors)
+{
+    this->write("program.anchor", "function integer main( {\n};");
+
+    EXPECT_EQ(1, this->run({"--no-cache", "--stream", "program.anchor"}));
+
+    EXPECT_EQ("", this->out.str());
+    EXPECT_EQ("Expected: INTEGER_TYPE, BOOLEAN_TYPE at line 1, column 24, but found \"{\".\n", this->err.str());
+}
@@ -0,0 +1,108 @@
+#include "test/jit_fixture.hh"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include "src/anchor.hh"
+
+namespace
+{
+    thread_local std::string captured;
+
+    int capturePrintf(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        va_list measuring;
+        va_copy(measuring, args);
+        int length = std::vsnprintf(nullptr, 0, format, measuring);
+        va_end(measuring);
+
+        if (length > 0)
+        {
+            std::size_t start = captured.size();
+            captured.resize(start + static_cast<std::size_t>(length) + 1);
+            std::vsnprintf(captured.data() + start, static_cast<std::size_t>(length) + 1, format, args);
+            captured.pop_back();
+        }
+        va_end(args);
+        return length;
+    }
+
+    bool onX86Backend()
+    {
+        const char *backend = std::getenv("ANCHOR_TEST_BACKEND");
+        return backend != nullptr && std::string(backend) == "x86";
+    }
+
+    std::string describe(int exitCode)
+    {
+        if (exitCode != 0)
+        {
+            return std::to_string(exitCode) + " was returned from main";
+        }
+        return captured;
+    }
+}
+
+std::string JitFixture::run(const std::string &sourceCode, compiler::OptimizationLevel optimizationLevel)
+{
+    anchor::CompilationUnit unit(sourceCode);
+    anchor::lex(unit);
+    anchor::parse(unit);
+    if (unit.hasErrors())
+    {
+        return unit.diagnostics[0].getMessage();
+    }
+
+    if (onX86Backend())
+    {
+        x86::Jit jit;
+        this->capture(jit);
+        jit.add(x86::compile(unit.program));
+        return describe(jit.runMain());
+    }
+
+    compiler::Compiler compiler(optimizationLevel);
+    compiler.compile(unit.program);
+    auto [context, module] = compiler.release();
+    return this->run(std::move(context), std::move(module), optimizationLevel);
+}
+
+std::string JitFixture::run(std::unique_ptr<llvm::LLVMContext> context, std::unique_ptr<llvm::Module> module, compiler::OptimizationLevel optimizationLevel)
+{
+    jit::Jit jit(optimizationLevel);
+    this->capture(jit);
+    jit.add(std::move(context), std::move(module));
+
+    return describe(jit.runMain());
+}
+
+void JitFixture::capture(jit::Jit &jit)
+{
+    jit.define("printf", reinterpret_cast<void *>(&capturePrintf));
+    captured.clear();
+}
+
+void JitFixture::capture(x86::Jit &jit)
+{
+    jit.define("printf", reinterpret_cast<void *>(&capturePrintf));
+    captured.clear();
+}
+
+std::string JitFixture::getCaptured()
+{
+    return captured;
+}
+
+std::string generateChain(int functions)
+{
+    std::string source = "function integer f0(integer n) {\n    return n + 1;\n};\n";
+    for (int i = 1; i < functions; i++)
+    {
+        source += "function integer f" + std::to_string(i) + "(integer n) {\n    return f" + std::to_string(i - 1) + "(n) * 2;\n};\n";
+    }
+    source += "function integer main() {\n    print(f" + std::to_string(functions - 1) + "(0));\n    print(\"done\");\n    return 0;\n};\n";
+    return source;
+}
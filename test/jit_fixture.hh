@@ -0,0 +1,37 @@
+#ifndef JIT_FIXTURE_H
+#define JIT_FIXTURE_H
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+#include "src/compiler.hh"
+#include "src/jit.hh"
+#include "src/x86.hh"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+// Runs anchor programs through an in-process JIT and returns what they printed.
+// printf is bound to a capturing replacement in each JIT, and the capture buffer
+// is per thread, so tests never touch the process' stdout and can run in parallel.
+//
+// With ANCHOR_TEST_BACKEND=x86 in the environment, programs given as source run
+// on x86::compile instead, which is how ctest runs the end-to-end tests against
+// both backends.
+class JitFixture : public ::testing::Test
+{
+protected:
+    std::string run(const std::string& sourceCode, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+    std::string run(std::unique_ptr<llvm::LLVMContext> context, std::unique_ptr<llvm::Module> module, compiler::OptimizationLevel optimizationLevel = compiler::OptimizationLevel::O0);
+    // Binds printf in the given JIT to the capture buffer and empties it.
+    void capture(jit::Jit& jit);
+    void capture(x86::Jit& jit);
+    std::string getCaptured();
+};
+
+// A program of functions f0 to f<functions - 1>, each calling the one before it,
+// so most calls cross a partition or chunk. main prints the last one's result and
+// then "done".
+std::string generateChain(int functions);
+
+#endif // JIT_FIXTURE_H
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/jit.hh"
+
+TEST(JitTest, ItShouldReturnExitCodeOfMain)
+{
+    anchor::CompilationUnit unit(R"(function integer main() {
+    return 42;
+};)");
+
+    std::optional<int> exitCode = anchor::run(unit);
+
+    ASSERT_TRUE(exitCode.has_value());
+    EXPECT_EQ(42, *exitCode);
+}
+
+TEST(JitTest, ItShouldCallFunctionsWithArgumentsAtEveryLevel)
+{
+    std::string sourceCode = R"(function integer fib(integer n) {
+    if (n < 2) {
+        return n;
+    };
+    return fib(n - 1) + fib(n - 2);
+};
+
+function integer main() {
+    return fib(10);
+};)";
+
+    for (auto level : {compiler::OptimizationLevel::O0, compiler::OptimizationLevel::O2})
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        EXPECT_EQ(55, anchor::run(unit, level).value());
+    }
+}
+
+TEST(JitTest, ItShouldResolveLibcFromHostProcess)
+{
+    anchor::CompilationUnit unit(R"(function integer main() {
+    string a;
+    a = "Hello, " + "World!";
+    return 7;
+};)");
+
+    EXPECT_EQ(7, anchor::run(unit).value());
+}
+
+TEST(JitTest, ItShouldNotRunUnitWithErrors)
+{
+    anchor::CompilationUnit unit("function integer main() { print(\"oops); };");
+
+    std::optional<int> exitCode = anchor::run(unit);
+
+    EXPECT_FALSE(exitCode.has_value());
+    EXPECT_TRUE(unit.hasErrors());
+}
+
+TEST(JitTest, ItShouldRunModuleReleasedByCompiler)
+{
+    anchor::CompilationUnit unit(R"(function integer main() {
+    return 3 + 4;
+};)");
+    anchor::lex(unit);
+    anchor::parse(unit);
+
+    compiler::Compiler compiler;
+    compiler.compile(unit.program);
+    auto [context, module] = compiler.release();
+
+    jit::Jit testObject;
+    testObject.add(std::move(context), std::move(module));
+
+    EXPECT_EQ(7, testObject.runMain());
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "src/json.hh"
+
+TEST(JsonTest, ItShouldParseNestedObject)
+{
+    json::Value value = json::parse(R"({"id": 1, "params": {"uri": "file:///a.anchor", "list": [true, false, null]}})");
+
+    EXPECT_EQ(1, value["id"].asInteger());
+    EXPECT_EQ("file:///a.anchor", value["params"]["uri"].asString());
+    EXPECT_EQ(3, value["params"]["list"].asArray().size());
+    EXPECT_TRUE(value["params"]["list"].asArray()[0].asBoolean());
+    EXPECT_TRUE(value["params"]["list"].asArray()[2].isNull());
+}
+
+TEST(JsonTest, ItShouldReturnNullForMissingKey)
+{
+    const json::Value value = json::parse(R"({"id": 1})");
+
+    EXPECT_TRUE(value["method"].isNull());
+    EXPECT_FALSE(value.contains("method"));
+}
+
+TEST(JsonTest, ItShouldRoundTripEscapedStrings)
+{
+    json::Value value("line one\n\"quoted\"\ttab\\");
+
+    std::string dumped = value.dump();
+    EXPECT_EQ(R"("line one\n\"quoted\"\ttab\\")", dumped);
+    EXPECT_EQ(value, json::parse(dumped));
+}
+
+TEST(JsonTest, ItShouldDecodeUnicodeEscapes)
+{
+    json::Value value = json::parse(R"("\u0041\u00e9")");
+
+    EXPECT_EQ("A\xC3\xA9", value.asString());
+}
+
+TEST(JsonTest, ItShouldDumpIntegralNumbersWithoutFraction)
+{
+    json::Value value = json::Value::makeObject();
+    value["line"] = 3;
+    value["ratio"] = 0.5;
+
+    EXPECT_EQ(R"({"line":3,"ratio":0.5})", value.dump());
+}
+
+TEST(JsonTest, ItShouldThrowParseExceptionOnTrailingCharacters)
+{
+    try
+    {
+        json::parse("{} x");
+        FAIL() << "Expected json::ParseException to have been thrown.";
+    }
+    catch (json::ParseException &e)
+    {
+        EXPECT_EQ(3, e.position);
+        EXPECT_STREQ("Trailing characters at position 3.", e.what());
+    }
+}
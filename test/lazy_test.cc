@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/lazy.hh"
+#include "test/jit_fixture.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+class LazyTest : public JitFixture
+{
+protected:
+    std::vector<std::string> compiled;
+
+    std::string runLazy(const std::string &sourceCode, compiler::OptimizationLevel level = compiler::OptimizationLevel::O0)
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            return unit.diagnostics[0].getMessage();
+        }
+
+        jit::Jit jit(level);
+        this->capture(jit);
+        lazy::LazyJit lazy(jit, unit.program, level);
+        int exitCode = lazy.runMain();
+        this->compiled = lazy.getCompiled();
+        if (exitCode != 0)
+        {
+            return std::to_string(exitCode) + " was returned from main";
+        }
+        return this->getCaptured();
+    }
+};
+
+TEST_F(LazyTest, ItShouldOnlyCompileFunctionsThatAreCalled)
+{
+    std::string sourceCode = R"(function integer unused(integer n) {
+    return n * 3;
+};
+
+function integer less(integer n) {
+    return n - 2;
+};
+
+function integer twice(integer n) {
+    if (n > 100) {
+        return unused(n);
+    };
+    return n * 2;
+};
+
+function integer main() {
+    print(twice(21));
+    return 0;
+};)";
+
+    EXPECT_EQ("42", this->runLazy(sourceCode));
+    EXPECT_EQ((std::vector<std::string>{"main", "twice"}), this->compiled);
+}
+
+TEST_F(LazyTest, ItShouldCompileRecursiveFunctionOnce)
+{
+    std::string sourceCode = R"(function integer fib(integer n) {
+    if (n < 2) {
+        return n;
+    };
+    return fib(n - 1) + fib(n - 2);
+};
+
+function integer main() {
+    print(fib(20));
+    return 0;
+};)";
+
+    for (compiler::OptimizationLevel level : {compiler::OptimizationLevel::O0, compiler::OptimizationLevel::O2})
+    {
+        EXPECT_EQ("6765", this->runLazy(sourceCode, level));
+        EXPECT_EQ((std::vector<std::string>{"main", "fib"}), this->compiled);
+    }
+}
+
+TEST_F(LazyTest, ItShouldPassStringsBetweenLazilyCompiledFunctions)
+{
+    std::string sourceCode = R"(function string greet(string name) {
+    return "Hello, " + name;
+};
+
+function boolean isShort(string text) {
+    return true;
+};
+
+function integer main() {
+    print(greet("anchor"));
+    if (isShort("anchor")) {
+        print("!");
+    };
+    return 3;
+};)";
+
+    EXPECT_EQ("3 was returned from main", this->runLazy(sourceCode));
+    EXPECT_EQ("Hello, anchor!", this->getCaptured());
+}
+
+TEST_F(LazyTest, ItShouldMatchEagerRunOnEveryWorkload)
+{
+    for (const auto &entry : std::filesystem::directory_iterator(ANCHOR_BENCH_WORKLOADS_DIR))
+    {
+        std::ifstream workload(entry.path());
+        std::stringstream sourceCode;
+        sourceCode << workload.rdbuf();
+
+        for (compiler::OptimizationLevel level : {compiler::OptimizationLevel::O0, compiler::OptimizationLevel::O2})
+        {
+            EXPECT_EQ(this->run(sourceCode.str(), level), this->runLazy(sourceCode.str(), level)) << entry.path();
+        }
+    }
+}
+
+TEST_F(LazyTest, ItShouldThrowWhenProgramHasNoMain)
+{
+    EXPECT_THROW(this->runLazy("function integer helper() {\n    return 1;\n};"), std::runtime_error);
+    EXPECT_TRUE(this->compiled.empty());
+}
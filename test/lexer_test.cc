@@ -337,4 +337,27 @@ TEST(TokenTest, ItShouldBeAbleToStringifyATokenType)
     std::string asString = lexer::tostring(equalsTokenType);
     EXPECT_EQ("EQUALS", asString);
     EXPECT_EQ("SEMICOLON", lexer::tostring(lexer::TokenType::SEMICOLON));
-}
\ No newline at end of file
+}
+TEST(LexerTest, ItShouldThrowInvalidTokenExceptionOnUnterminatedString)
+{
+    try
+    {
+        lexer::lex("print(\"Hello);");
+        FAIL() << "Expected lexer::InvalidTokenException to have been thrown.";
+    }
+    catch (lexer::InvalidTokenException &e)
+    {
+        EXPECT_STREQ("Unterminated string literal at line 1, column 7.", e.what());
+        EXPECT_EQ(lexer::Location(1, 7), e.location);
+    }
+}
+
+TEST(LexerTest, ItShouldReadInImport)
+{
+    std::deque<lexer::Token> tokens = lexer::lex("import \"lib.anchor\";");
+
+    ASSERT_EQ(4, tokens.size());
+    EXPECT_EQ(lexer::Token(lexer::TokenType::IMPORT, "import", lexer::Location(1, 1), lexer::Location(1, 6)), tokens[0]);
+    EXPECT_EQ(lexer::TokenType::STRING, tokens[1].getTokenType());
+    EXPECT_EQ(lexer::TokenType::SEMICOLON, tokens[2].getTokenType());
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "src/lsp.hh"
+#include <sstream>
+
+namespace
+{
+    std::vector<json::Value> messages(const std::string &written)
+    {
+        std::istringstream in(written);
+        std::vector<json::Value> parsed;
+        while (std::optional<std::string> message = lsp::readMessage(in))
+        {
+            parsed.push_back(json::parse(*message));
+        }
+        return parsed;
+    }
+
+    std::string didOpen(const std::string &uri, const std::string &text)
+    {
+        json::Value textDocument = json::Value::makeObject();
+        textDocument["uri"] = uri;
+        textDocument["version"] = 1;
+        textDocument["languageId"] = "anchor";
+        textDocument["text"] = text;
+
+        json::Value notification = json::Value::makeObject();
+        notification["jsonrpc"] = "2.0";
+        notification["method"] = "textDocument/didOpen";
+        notification["params"]["textDocument"] = textDocument;
+        return notification.dump();
+    }
+
+    std::string didChange(const std::string &uri, int version, int line, int character, int endLine, int endCharacter, const std::string &text)
+    {
+        json::Value change = json::Value::makeObject();
+        change["range"]["start"]["line"] = line;
+        change["range"]["start"]["character"] = character;
+        change["range"]["end"]["line"] = endLine;
+        change["range"]["end"]["character"] = endCharacter;
+        change["text"] = text;
+
+        json::Value notification = json::Value::makeObject();
+        notification["jsonrpc"] = "2.0";
+        notification["method"] = "textDocument/didChange";
+        notification["params"]["textDocument"]["uri"] = uri;
+        notification["params"]["textDocument"]["version"] = version;
+        notification["params"]["contentChanges"] = std::vector<json::Value>{change};
+        return notification.dump();
+    }
+}
+
+TEST(LspTest, ItShouldAdvertiseIncrementalSyncOnInitialize)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(R"({"jsonrpc": "2.0", "id": 1, "method": "initialize", "params": {}})");
+
+    std::vector<json::Value> written = messages(out.str());
+    ASSERT_EQ(1, written.size());
+    EXPECT_EQ(1, written[0]["id"].asInteger());
+    EXPECT_EQ(2, written[0]["result"]["capabilities"]["textDocumentSync"]["change"].asInteger());
+}
+
+TEST(LspTest, ItShouldPublishNoDiagnosticsForValidProgram)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(didOpen("file:///main.anchor", R"(function integer main() {
+    print("Hello, World!");
+    return 0;
+};)"));
+
+    std::vector<json::Value> written = messages(out.str());
+    ASSERT_EQ(1, written.size());
+    EXPECT_EQ("textDocument/publishDiagnostics", written[0]["method"].asString());
+    EXPECT_EQ("file:///main.anchor", written[0]["params"]["uri"].asString());
+    EXPECT_TRUE(written[0]["params"]["diagnostics"].asArray().empty());
+
+    const lsp::Document *document = testObject.getDocument("file:///main.anchor");
+    ASSERT_NE(nullptr, document);
+    EXPECT_EQ(1, document->unit.program.stmts.size());
+    EXPECT_FALSE(document->unit.tokens.empty());
+}
+
+TEST(LspTest, ItShouldPublishSyntaxErrorWithRange)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(didOpen("file:///main.anchor", R"(function void foo() {
+    print"Hello World!");
+};)"));
+
+    std::vector<json::Value> written = messages(out.str());
+    ASSERT_EQ(1, written.size());
+    const std::vector<json::Value> &diagnostics = written[0]["params"]["diagnostics"].asArray();
+    ASSERT_EQ(1, diagnostics.size());
+    EXPECT_EQ("Expected: LEFT_PAREN at line 2, column 10, but found \"\"Hello World!\"\".", diagnostics[0]["message"].asString());
+    EXPECT_EQ(1, diagnostics[0]["range"]["start"]["line"].asInteger());
+    EXPECT_EQ(9, diagnostics[0]["range"]["start"]["character"].asInteger());
+    EXPECT_EQ(1, diagnostics[0]["range"]["end"]["line"].asInteger());
+    EXPECT_EQ(23, diagnostics[0]["range"]["end"]["character"].asInteger());
+}
+
+TEST(LspTest, ItShouldClearDiagnosticsAfterIncrementalFix)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(didOpen("file:///main.anchor", R"(function void foo() {
+    print"Hello World!");
+};)"));
+    testObject.handle(didChange("file:///main.anchor", 2, 1, 9, 1, 9, "("));
+
+    std::vector<json::Value> written = messages(out.str());
+    ASSERT_EQ(2, written.size());
+    EXPECT_EQ(2, written[1]["params"]["version"].asInteger());
+    EXPECT_TRUE(written[1]["params"]["diagnostics"].asArray().empty());
+    EXPECT_EQ(R"(function void foo() {
+    print("Hello World!");
+};)",
+              testObject.getDocument("file:///main.anchor")->unit.source);
+}
+
+TEST(LspTest, ItShouldPublishTypeErrors)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(didOpen("file:///main.anchor", R"(function integer main() {
+    string a;
+    a = 3;
+    return 0;
+};)"));
+
+    std::vector<json::Value> written = messages(out.str());
+    const std::vector<json::Value> &diagnostics = written[0]["params"]["diagnostics"].asArray();
+    ASSERT_EQ(1, diagnostics.size());
+    EXPECT_EQ("Type Error: Expression at line 3, column 5 had STRING on left, INTEGER on right.", diagnostics[0]["message"].asString());
+}
+
+TEST(LspTest, ItShouldSurviveIncompleteDocumentsWhileTyping)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    std::string source = R"(function integer main() {
+    print("Hello" + "World");
+    return 0;
+};)";
+
+    testObject.handle(didOpen("file:///main.anchor", ""));
+    for (std::size_t i = 0; i < source.length(); i++)
+    {
+        std::string typed(1, source[i]);
+        const std::string &text = testObject.getDocument("file:///main.anchor")->unit.source;
+        int line = static_cast<int>(std::count(text.begin(), text.end(), '\n'));
+        int character = static_cast<int>(text.length() - (text.rfind('\n') == std::string::npos ? 0 : text.rfind('\n') + 1));
+        testObject.handle(didChange("file:///main.anchor", static_cast<int>(i) + 2, line, character, line, character, typed));
+    }
+
+    std::vector<json::Value> written = messages(out.str());
+    ASSERT_EQ(source.length() + 1, written.size());
+    EXPECT_EQ(source, testObject.getDocument("file:///main.anchor")->unit.source);
+    EXPECT_TRUE(written.back()["params"]["diagnostics"].asArray().empty());
+}
+
+TEST(LspTest, ItShouldReportUnterminatedStringLiteral)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(didOpen("file:///main.anchor", R"(print("Hello)"));
+
+    std::vector<json::Value> written = messages(out.str());
+    const std::vector<json::Value> &diagnostics = written[0]["params"]["diagnostics"].asArray();
+    ASSERT_EQ(1, diagnostics.size());
+    EXPECT_EQ("Unterminated string literal at line 1, column 7.", diagnostics[0]["message"].asString());
+}
+
+TEST(LspTest, ItShouldRespondMethodNotFoundForUnknownRequest)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(R"({"jsonrpc": "2.0", "id": 7, "method": "textDocument/hover", "params": {}})");
+    testObject.handle(R"({"jsonrpc": "2.0", "method": "$/cancelRequest", "params": {}})");
+
+    std::vector<json::Value> written = messages(out.str());
+    ASSERT_EQ(1, written.size());
+    EXPECT_EQ(7, written[0]["id"].asInteger());
+    EXPECT_EQ(-32601, written[0]["error"]["code"].asInteger());
+}
+
+TEST(LspTest, ItShouldExitCleanlyOnlyAfterShutdown)
+{
+    std::ostringstream out;
+    lsp::Server testObject(out);
+
+    testObject.handle(R"({"jsonrpc": "2.0", "id": 1, "method": "shutdown"})");
+    testObject.handle(R"({"jsonrpc": "2.0", "method": "exit"})");
+
+    EXPECT_TRUE(testObject.hasExited());
+    EXPECT_EQ(0, testObject.exitCode());
+
+    lsp::Server abrupt(out);
+    abrupt.handle(R"({"jsonrpc": "2.0", "method": "exit"})");
+    EXPECT_TRUE(abrupt.hasExited());
+    EXPECT_EQ(1, abrupt.exitCode());
+}
+
+TEST(LspTest, ItShouldReadFramedMessages)
+{
+    std::istringstream in("Content-Length: 2\r\n\r\n{}Content-Length: 4\r\nContent-Type: application/vscode-jsonrpc\r\n\r\nnull");
+
+    EXPECT_EQ("{}", lsp::readMessage(in).value());
+    EXPECT_EQ("null", lsp::readMessage(in).value());
+    EXPECT_FALSE(lsp::readMessage(in).has_value());
+}
+
+TEST(LspTest, ItShouldSkipMessagesWithBadContentLength)
+{
+    std::istringstream in("Content-Length: abc\r\n\r\n{}Content-Length: 2\r\n\r\n{}Content-Length: 99999999999\r\n\r\n{}Content-Length: 4\r\n\r\nnull");
+
+    EXPECT_EQ("{}", lsp::readMessage(in).value());
+    // The oversized message swallows the rest of the stream without allocating for it.
+    EXPECT_FALSE(lsp::readMessage(in).has_value());
+}
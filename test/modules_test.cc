@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/modules.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+class ModulesTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path directory;
+
+    void SetUp() override
+    {
+        const ::testing::TestInfo *test = ::testing::UnitTest::GetInstance()->current_test_info();
+        this->directory = std::filesystem::temp_directory_path() / (std::string("anchor_modules_test_") + test->name());
+        std::filesystem::remove_all(this->directory);
+        std::filesystem::create_directories(this->directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(this->directory);
+    }
+
+    std::filesystem::path write(const std::string &name, const std::string &source)
+    {
+        std::filesystem::path path = this->directory / name;
+        std::ofstream out(path, std::ios::binary);
+        out << source;
+        return path;
+    }
+
+    std::vector<std::string> diagnostics(modules::Importer &importer, const std::filesystem::path &file, const std::string &source)
+    {
+        anchor::CompilationUnit unit(source);
+        unit.importer = importer.forFile(file);
+        anchor::lex(unit);
+        anchor::parse(unit);
+
+        std::vector<std::string> messages;
+        for (const parser::ErrorLog &errorLog : unit.diagnostics)
+        {
+            messages.push_back(errorLog.getMessage());
+        }
+        return messages;
+    }
+};
+
+TEST_F(ModulesTest, ItShouldRoundTripInterface)
+{
+    anchor::CompilationUnit unit(R"(import "other.anchor";
+function string greet(string name, integer times) {
+    return name;
+};
+function void nothing() {
+};)");
+    unit.importer = [](const std::string &)
+    {
+        return std::vector<std::shared_ptr<parser::FunctionStmt>>{};
+    };
+    anchor::lex(unit);
+    anchor::parse(unit);
+    ASSERT_FALSE(unit.hasErrors());
+
+    std::stringstream buffer;
+    modules::write(buffer, modules::extract(unit.program));
+    modules::Interface testObject = modules::read(buffer);
+
+    EXPECT_EQ(std::vector<std::string>{"other.anchor"}, testObject.imports);
+    ASSERT_EQ(2, testObject.functions.size());
+    EXPECT_EQ("greet", testObject.functions[0]->identifier);
+    EXPECT_EQ(parser::Type::STRING, testObject.functions[0]->returnType);
+    ASSERT_EQ(2, testObject.functions[0]->args.size());
+    EXPECT_EQ("times", testObject.functions[0]->args[1]->identifier);
+    EXPECT_EQ(parser::Type::INTEGER, testObject.functions[0]->args[1]->returnType);
+    EXPECT_TRUE(testObject.functions[0]->stmts.empty());
+    EXPECT_EQ(parser::Type::VOID, testObject.functions[1]->returnType);
+}
+
+TEST_F(ModulesTest, ItShouldRejectCorruptInterface)
+{
+    std::stringstream buffer("ANBI\x01");
+
+    EXPECT_THROW(modules::read(buffer), std::invalid_argument);
+}
+
+TEST_F(ModulesTest, ItShouldDeclareImportedFunctionsWithoutTheirBodies)
+{
+    this->write("math.anchor", "function integer twice(integer n) {\n    return n * 2;\n};\n");
+    std::filesystem::path app = this->write("app.anchor", "");
+    modules::Importer importer;
+
+    anchor::CompilationUnit unit("import \"math.anchor\";\nfunction integer main() {\n    print(twice(21));\n    return 0;\n};");
+    unit.importer = importer.forFile(app);
+    std::string ir = anchor::compile(unit);
+
+    ASSERT_FALSE(unit.hasErrors()) << ir;
+    EXPECT_NE(std::string::npos, ir.find("declare i32 @twice(i32"));
+    EXPECT_EQ(std::string::npos, ir.find("define i32 @twice"));
+}
+
+TEST_F(ModulesTest, ItShouldReportMissingLibrary)
+{
+    std::filesystem::path app = this->write("app.anchor", "");
+    modules::Importer importer;
+
+    std::vector<std::string> messages = this->diagnostics(importer, app, "import \"missing.anchor\";");
+
+    ASSERT_EQ(1, messages.size());
+    EXPECT_EQ("Could not find library " + (this->directory / "missing.anchor").string() + ".", messages[0]);
+}
+
+TEST_F(ModulesTest, ItShouldReportImportCycle)
+{
+    this->write("a.anchor", "import \"b.anchor\";");
+    this->write("b.anchor", "import \"a.anchor\";");
+    std::filesystem::path app = this->write("app.anchor", "");
+    modules::Importer importer;
+
+    std::vector<std::string> messages = this->diagnostics(importer, app, "import \"a.anchor\";");
+
+    ASSERT_EQ(1, messages.size());
+    EXPECT_EQ("Cannot import a.anchor: Cannot import b.anchor: Cannot import a.anchor, it imports itself: a.anchor -> b.anchor -> a.anchor.", messages[0]);
+}
+
+TEST_F(ModulesTest, ItShouldRejectLibraryDefiningMain)
+{
+    this->write("lib.anchor", "function integer main() {\n    return 0;\n};");
+    std::filesystem::path app = this->write("app.anchor", "");
+    modules::Importer importer;
+
+    std::vector<std::string> messages = this->diagnostics(importer, app, "import \"lib.anchor\";");
+
+    ASSERT_EQ(1, messages.size());
+    EXPECT_EQ("Cannot import lib.anchor, libraries cannot define main.", messages[0]);
+}
+
+TEST_F(ModulesTest, ItShouldLoadCachedInterfaceWithoutParsingLibrary)
+{
+    std::string source = "function integer twice(integer n) {\n    return n * 2;\n};\n";
+    this->write("math.anchor", source);
+    std::filesystem::path app = this->write("app.anchor", "");
+    cache::Cache cache(this->directory / "cache");
+
+    // Stands in for the library, so using it proves the library was not parsed.
+    modules::Interface cached;
+    auto thrice = std::make_shared<parser::FunctionStmt>();
+    thrice->type = parser::StmtType::FUNCTION;
+    thrice->identifier = "thrice";
+    thrice->returnType = parser::Type::INTEGER;
+    cached.functions.push_back(thrice);
+    std::ostringstream out;
+    modules::write(out, cached);
+    cache.store(cache::key(source, compiler::OptimizationLevel::O0, "interface"), out.str());
+
+    modules::Importer importer(&cache);
+    std::vector<std::shared_ptr<parser::FunctionStmt>> functions = importer.import(app, "math.anchor");
+
+    ASSERT_EQ(1, functions.size());
+    EXPECT_EQ("thrice", functions[0]->identifier);
+}
+
+TEST_F(ModulesTest, ItShouldChangeFingerprintWithImportedLibraries)
+{
+    this->write("inner.anchor", "function integer one() {\n    return 1;\n};\n");
+    this->write("outer.anchor", "import \"inner.anchor\";\nfunction integer two() {\n    return one() + 1;\n};\n");
+    std::filesystem::path app = this->write("app.anchor", "");
+    std::string source = "import \"outer.anchor\";";
+
+    std::string before = modules::Importer().fingerprint(source, app);
+    EXPECT_EQ(before, modules::Importer().fingerprint(source, app));
+
+    this->write("inner.anchor", "function integer one() {\n    return 2;\n};\n");
+    EXPECT_NE(before, modules::Importer().fingerprint(source, app));
+    EXPECT_EQ("function integer main() {};", modules::Importer().fingerprint("function integer main() {};", app));
+}
+
+TEST_F(ModulesTest, ItShouldLinkEveryLibraryIntoExecutable)
+{
+    this->write("inner.anchor", "function string greeting() {\n    return \"Hello, \";\n};\n");
+    this->write("outer.anchor", "import \"inner.anchor\";\nfunction string greet(string name) {\n    return greeting() + name;\n};\n");
+    std::filesystem::path app = this->write("app.anchor", "");
+    std::string executablePath = (this->directory / "app").string();
+    cache::Cache cache(this->directory / "cache");
+
+    for (int build = 0; build < 2; build++)
+    {
+        modules::Importer importer(&cache);
+        anchor::CompilationUnit unit("import \"outer.anchor\";\nfunction integer main() {\n    print(greet(\"World\"));\n    return 0;\n};");
+        unit.importer = importer.forFile(app);
+        ASSERT_EQ("", anchor::compileToExecutable(unit, executablePath, compiler::OptimizationLevel::O2, 0, &importer));
+
+        FILE *fp = popen(executablePath.c_str(), "r");
+        ASSERT_NE(nullptr, fp);
+        char buffer[256];
+        std::string output;
+        while (fgets(buffer, sizeof(buffer), fp) != nullptr)
+        {
+            output += buffer;
+        }
+        EXPECT_EQ(0, pclose(fp));
+        EXPECT_EQ("Hello, World", output) << "build " << build;
+    }
+
+    // Only the executable is left behind, and the cache holds both libraries' objects.
+    std::vector<std::string> files;
+    for (const auto &entry : std::filesystem::directory_iterator(this->directory))
+    {
+        files.push_back(entry.path().filename().string());
+    }
+    std::sort(files.begin(), files.end());
+    EXPECT_EQ((std::vector<std::string>{"app", "app.anchor", "cache", "inner.anchor", "outer.anchor"}), files);
+}
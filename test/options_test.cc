@@ -0,0 +1,400 @@
+#include <gtest/gtest.h>
+#include "src/options.hh"
+#include "src/x86.hh"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST(OptionsTest, ItShouldDefaultToUnoptimizedStdin)
+{
+    const char *argv[] = {"main"};
+
+    anchor::Options options = anchor::parseOptions(1, argv);
+
+    EXPECT_EQ("", options.input);
+    EXPECT_EQ(compiler::OptimizationLevel::O0, options.optimizationLevel);
+}
+
+TEST(OptionsTest, ItShouldParseOptimizationLevelAndInput)
+{
+    const char *argv[] = {"main", "-O2", "test.anchor"};
+
+    anchor::Options options = anchor::parseOptions(3, argv);
+
+    EXPECT_EQ("test.anchor", options.input);
+    EXPECT_EQ(compiler::OptimizationLevel::O2, options.optimizationLevel);
+}
+
+TEST(OptionsTest, ItShouldUseLastOptimizationLevel)
+{
+    const char *argv[] = {"main", "-O3", "test.anchor", "-O1"};
+
+    anchor::Options options = anchor::parseOptions(4, argv);
+
+    EXPECT_EQ(compiler::OptimizationLevel::O1, options.optimizationLevel);
+}
+
+TEST(OptionsTest, ItShouldRejectUnknownOption)
+{
+    const char *argv[] = {"main", "-O9"};
+
+    try
+    {
+        anchor::parseOptions(2, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Unknown option -O9.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldRejectMultipleInputs)
+{
+    const char *argv[] = {"main", "a.anchor", "b.anchor"};
+
+    try
+    {
+        anchor::parseOptions(3, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Expected a single input file, but found a.anchor and b.anchor.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldEmitObjectWithCompileOnly)
+{
+    const char *argv[] = {"main", "-c", "-o", "foo.o", "foo.anchor"};
+
+    anchor::Options options = anchor::parseOptions(5, argv);
+
+    EXPECT_EQ(anchor::Emit::OBJECT, options.emit);
+    EXPECT_EQ("foo.o", options.output);
+    EXPECT_EQ("foo.anchor", options.input);
+}
+
+TEST(OptionsTest, ItShouldEmitExecutableWithOutputOnly)
+{
+    const char *argv[] = {"main", "foo.anchor", "-o", "foo"};
+
+    anchor::Options options = anchor::parseOptions(4, argv);
+
+    EXPECT_EQ(anchor::Emit::EXECUTABLE, options.emit);
+    EXPECT_EQ("foo", options.output);
+}
+
+TEST(OptionsTest, ItShouldRequireOutputForCompileOnly)
+{
+    const char *argv[] = {"main", "-c", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(3, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Expected -o with -c.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldRejectMissingOutputName)
+{
+    const char *argv[] = {"main", "foo.anchor", "-o"};
+
+    try
+    {
+        anchor::parseOptions(3, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Expected a file name after -o.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldEmitBitcodeToOutput)
+{
+    const char *argv[] = {"main", "--emit=bc", "-o", "foo.bc", "foo.anchor"};
+
+    anchor::Options options = anchor::parseOptions(5, argv);
+
+    EXPECT_EQ(anchor::Emit::BITCODE, options.emit);
+    EXPECT_EQ("foo.bc", options.output);
+}
+
+TEST(OptionsTest, ItShouldEmitTextualIrToOutput)
+{
+    const char *argv[] = {"main", "--emit=llvm", "-o", "foo.ll", "foo.anchor"};
+
+    anchor::Options options = anchor::parseOptions(5, argv);
+
+    EXPECT_EQ(anchor::Emit::LLVM_IR, options.emit);
+    EXPECT_EQ("foo.ll", options.output);
+}
+
+TEST(OptionsTest, ItShouldRunInProcess)
+{
+    const char *argv[] = {"main", "--run", "-O2", "foo.anchor"};
+
+    anchor::Options options = anchor::parseOptions(4, argv);
+
+    EXPECT_TRUE(options.run);
+    EXPECT_EQ("foo.anchor", options.input);
+}
+
+TEST(OptionsTest, ItShouldRunTieredInProcess)
+{
+    const char *argv[] = {"main", "--tiered", "foo.anchor"};
+
+    anchor::Options options = anchor::parseOptions(3, argv);
+
+    EXPECT_TRUE(options.run);
+    EXPECT_TRUE(options.tiered);
+    EXPECT_EQ("foo.anchor", options.input);
+}
+
+TEST(OptionsTest, ItShouldRunLazilyInProcess)
+{
+    const char *argv[] = {"main", "--lazy", "-O1", "foo.anchor"};
+
+    anchor::Options options = anchor::parseOptions(4, argv);
+
+    EXPECT_TRUE(options.run);
+    EXPECT_TRUE(options.lazy);
+    EXPECT_FALSE(options.tiered);
+    EXPECT_EQ(compiler::OptimizationLevel::O1, options.optimizationLevel);
+}
+
+TEST(OptionsTest, ItShouldRejectLazyWithOtherWaysToRun)
+{
+    const std::vector<std::pair<std::vector<const char *>, std::string>> cases{
+        {{"main", "--lazy", "--tiered", "foo.anchor"}, "--lazy cannot be combined with --tiered."},
+        {{"main", "--lazy", "--codegen-threads=2", "foo.anchor"}, "--lazy cannot be combined with --codegen-threads."},
+        {{"main", "--lazy", "--stream", "foo.anchor"}, "--lazy cannot be combined with --stream."},
+    };
+
+    for (const auto &[argv, message] : cases)
+    {
+        try
+        {
+            anchor::parseOptions(static_cast<int>(argv.size()), argv.data());
+            FAIL() << "Expected std::invalid_argument to have been thrown.";
+        }
+        catch (std::invalid_argument &e)
+        {
+            EXPECT_EQ(message, e.what());
+        }
+    }
+}
+
+TEST(OptionsTest, ItShouldParseRepl)
+{
+    const char *argv[] = {"main", "-O2", "--repl"};
+
+    anchor::Options options = anchor::parseOptions(3, argv);
+
+    EXPECT_TRUE(options.repl);
+    EXPECT_FALSE(options.run);
+    EXPECT_EQ(compiler::OptimizationLevel::O2, options.optimizationLevel);
+}
+
+TEST(OptionsTest, ItShouldRejectReplWithInputFile)
+{
+    const char *argv[] = {"main", "--repl", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(3, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("--repl reads statements from standard input, it only combines with -O0, -O1, -O2 and -O3.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldParseX86Backend)
+{
+    const char *argv[] = {"main", "--run", "--backend=x86", "foo.anchor"};
+    if (!x86::isHost)
+    {
+        EXPECT_THROW(anchor::parseOptions(4, argv), std::invalid_argument);
+        return;
+    }
+
+    anchor::Options options = anchor::parseOptions(4, argv);
+
+    EXPECT_EQ(anchor::Backend::X86, options.backend);
+    EXPECT_TRUE(options.run);
+}
+
+TEST(OptionsTest, ItShouldRejectX86BackendWithoutRun)
+{
+    const char *argv[] = {"main", "--backend=x86", "-o", "foo", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(5, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("--backend=x86 only runs programs, with --run and without --tiered, --lazy or --codegen-threads.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldRejectRunWithOutput)
+{
+    const char *argv[] = {"main", "--run", "-o", "foo", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(5, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("--run cannot be combined with -c, -o or --emit.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldParseCacheSwitches)
+{
+    const char *withDirectory[] = {"main", "--cache-dir=/tmp/anchor", "foo.anchor"};
+    anchor::Options options = anchor::parseOptions(3, withDirectory);
+    EXPECT_TRUE(options.cache);
+    EXPECT_EQ("/tmp/anchor", options.cacheDirectory);
+
+    const char *disabled[] = {"main", "--no-cache", "foo.anchor"};
+    EXPECT_FALSE(anchor::parseOptions(3, disabled).cache);
+}
+
+TEST(OptionsTest, ItShouldRejectCacheDirectoryWithNoCache)
+{
+    const char *argv[] = {"main", "--no-cache", "--cache-dir=/tmp/anchor", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(4, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("--cache-dir cannot be combined with --no-cache.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldParseCodegenThreads)
+{
+    const char *argv[] = {"main", "--codegen-threads=8", "foo.anchor"};
+
+    EXPECT_EQ(8, anchor::parseOptions(3, argv).codegenThreads);
+}
+
+TEST(OptionsTest, ItShouldRejectZeroCodegenThreads)
+{
+    const char *argv[] = {"main", "--codegen-threads=0", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(3, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Expected a number of threads from 1 to 9999 after --codegen-threads=.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldParseBatchOfInputs)
+{
+    const char *argv[] = {"main", "-j", "4", "a.anchor", "b.anchor", "-o", "out"};
+
+    anchor::Options options = anchor::parseOptions(7, argv);
+
+    EXPECT_EQ(4, options.jobs);
+    EXPECT_EQ((std::vector<std::string>{"a.anchor", "b.anchor"}), options.inputs);
+    EXPECT_EQ("a.anchor", options.input);
+    EXPECT_EQ("out", options.output);
+}
+
+TEST(OptionsTest, ItShouldParseJobsWrittenTogether)
+{
+    const char *argv[] = {"main", "-j8", "a.anchor", "-o", "out"};
+
+    EXPECT_EQ(8, anchor::parseOptions(5, argv).jobs);
+}
+
+TEST(OptionsTest, ItShouldRejectBatchWithoutOutputDirectory)
+{
+    const char *argv[] = {"main", "-j", "2", "a.anchor", "b.anchor"};
+
+    try
+    {
+        anchor::parseOptions(5, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Expected an output directory with -o and -j.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldRejectZeroJobs)
+{
+    const char *argv[] = {"main", "-j", "0", "a.anchor", "-o", "out"};
+
+    try
+    {
+        anchor::parseOptions(6, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("Expected a number of jobs from 1 to 9999 after -j.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldParseStream)
+{
+    const char *argv[] = {"main", "--stream", "-o", "program", "foo.anchor"};
+
+    anchor::Options options = anchor::parseOptions(5, argv);
+
+    EXPECT_TRUE(options.stream);
+    EXPECT_EQ(anchor::Emit::EXECUTABLE, options.emit);
+}
+
+TEST(OptionsTest, ItShouldRejectStreamToObject)
+{
+    const char *argv[] = {"main", "--stream", "-c", "-o", "foo.o", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(6, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("--stream writes textual IR or executables, it cannot be combined with -c or --emit=bc.", e.what());
+    }
+}
+
+TEST(OptionsTest, ItShouldRejectStreamWithRun)
+{
+    const char *argv[] = {"main", "--stream", "--run", "foo.anchor"};
+
+    try
+    {
+        anchor::parseOptions(4, argv);
+        FAIL() << "Expected std::invalid_argument to have been thrown.";
+    }
+    catch (std::invalid_argument &e)
+    {
+        EXPECT_STREQ("--run cannot be combined with --stream.", e.what());
+    }
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/parallel.hh"
+#include "test/jit_fixture.hh"
+
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+class ParallelTest : public JitFixture
+{
+protected:
+    anchor::CompilationUnit parse(const std::string &sourceCode)
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        EXPECT_FALSE(unit.hasErrors());
+        return unit;
+    }
+
+    std::string compile(const parser::Program &program, compiler::OptimizationLevel level, unsigned threads, std::size_t partitionSize)
+    {
+        parallel::PartitionedCompiler partitioned(level, threads, partitionSize);
+        partitioned.compile(program);
+
+        std::string ir;
+        llvm::raw_string_ostream out(ir);
+        partitioned.link().print(out);
+        return out.str();
+    }
+
+    std::string runPartitioned(const parser::Program &program, compiler::OptimizationLevel level, unsigned threads, std::size_t partitionSize)
+    {
+        parallel::PartitionedCompiler partitioned(level, threads, partitionSize);
+        partitioned.compile(program);
+
+        jit::Jit jit(level);
+        this->capture(jit);
+        partitioned.addTo(jit);
+        int exitCode = jit.runMain();
+        if (exitCode != 0)
+        {
+            return std::to_string(exitCode) + " was returned from main";
+        }
+        return this->getCaptured();
+    }
+};
+
+TEST_F(ParallelTest, ItShouldProduceTheSameModuleForAnyNumberOfThreads)
+{
+    anchor::CompilationUnit unit = this->parse(generateChain(40));
+
+    for (compiler::OptimizationLevel level : {compiler::OptimizationLevel::O0, compiler::OptimizationLevel::O2})
+    {
+        std::string expected = this->compile(unit.program, level, 1, 3);
+        for (unsigned threads : {2U, 4U, 8U, 64U})
+        {
+            EXPECT_EQ(expected, this->compile(unit.program, level, threads, 3)) << threads << " threads";
+        }
+    }
+}
+
+TEST_F(ParallelTest, ItShouldSplitFunctionsIntoFixedSizePartitions)
+{
+    anchor::CompilationUnit unit = this->parse(generateChain(10));
+
+    parallel::PartitionedCompiler partitioned(compiler::OptimizationLevel::O0, 2, 4);
+    partitioned.compile(unit.program);
+
+    // f0..f9 and main.
+    EXPECT_EQ(3, partitioned.size());
+}
+
+TEST_F(ParallelTest, ItShouldDeclareFunctionsDefinedInOtherPartitions)
+{
+    anchor::CompilationUnit unit = this->parse(generateChain(3));
+
+    compiler::Compiler compiler;
+    compiler.compilePartition(unit.program, 1, 2);
+    std::string ir;
+    llvm::raw_string_ostream out(ir);
+    compiler.print(out);
+
+    EXPECT_NE(std::string::npos, out.str().find("declare i32 @f0(i32"));
+    EXPECT_NE(std::string::npos, out.str().find("define i32 @f1(i32"));
+    EXPECT_EQ(std::string::npos, out.str().find("@f2"));
+    EXPECT_EQ(std::string::npos, out.str().find("@main"));
+}
+
+TEST_F(ParallelTest, ItShouldLinkPartitionsIntoAValidModule)
+{
+    anchor::CompilationUnit unit = this->parse(generateChain(12));
+
+    parallel::PartitionedCompiler partitioned(compiler::OptimizationLevel::O2, 4, 2);
+    partitioned.compile(unit.program);
+    auto [context, module] = partitioned.link().release();
+
+    std::string errors;
+    llvm::raw_string_ostream errorStream(errors);
+    EXPECT_FALSE(llvm::verifyModule(*module, &errorStream)) << errorStream.str();
+    for (int i = 0; i < 12; i++)
+    {
+        llvm::Function *function = module->getFunction("f" + std::to_string(i));
+        ASSERT_NE(nullptr, function);
+        EXPECT_FALSE(function->isDeclaration());
+    }
+    EXPECT_EQ(1, module->getFunction("printf") != nullptr);
+}
+
+TEST_F(ParallelTest, ItShouldCompileProgramWithoutFunctions)
+{
+    anchor::CompilationUnit unit = this->parse("");
+
+    parallel::PartitionedCompiler partitioned(compiler::OptimizationLevel::O0, 4);
+    partitioned.compile(unit.program);
+
+    EXPECT_EQ(1, partitioned.size());
+}
+
+TEST_F(ParallelTest, ItShouldRunLikeOneModule)
+{
+    anchor::CompilationUnit unit = this->parse(generateChain(20));
+
+    EXPECT_EQ("524288done", this->runPartitioned(unit.program, compiler::OptimizationLevel::O0, 3, 4));
+    EXPECT_EQ("524288done", this->runPartitioned(unit.program, compiler::OptimizationLevel::O2, 3, 4));
+}
+
+TEST_F(ParallelTest, ItShouldMatchOneModuleOnEveryWorkload)
+{
+    for (const auto &entry : std::filesystem::directory_iterator(ANCHOR_BENCH_WORKLOADS_DIR))
+    {
+        std::ifstream workload(entry.path());
+        std::stringstream sourceCode;
+        sourceCode << workload.rdbuf();
+        anchor::CompilationUnit unit = this->parse(sourceCode.str());
+
+        EXPECT_EQ(this->run(sourceCode.str(), compiler::OptimizationLevel::O2), this->runPartitioned(unit.program, compiler::OptimizationLevel::O2, 4, 1)) << entry.path();
+    }
+}
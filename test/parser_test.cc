@@ -205,3 +205,162 @@ TEST(ParserTest, ItShouldThrowExceptionIfOffenderTokenTypeExistsWithinExpected)
         FAIL() << "Should have thrown std::invalid_argument.";
     }
 }
+
+TEST(ParserTest, ItShouldRecoverFromUnclosedFunctionBody)
+{
+    std::string sourceCode = "function integer main() { print(5";
+
+    std::deque<lexer::Token> tokens = lexer::lex(sourceCode);
+
+    parser::Parser testObject(tokens);
+    parser::Program program = testObject.parse();
+
+    EXPECT_FALSE(program.isSyntacticallyCorrect());
+    EXPECT_EQ(lexer::Location(1, 34), program.errors[0].getStart());
+}
+
+TEST(ParserTest, ItShouldReportMissingExpression)
+{
+    std::string sourceCode = "function void foo() {print();};";
+
+    std::deque<lexer::Token> tokens = lexer::lex(sourceCode);
+
+    parser::Parser testObject(tokens);
+    parser::Program program = testObject.parse();
+
+    ASSERT_EQ(1, program.errors.size());
+    EXPECT_EQ("Expected: STRING, IDENTIFIER, INTEGER, TRUE, FALSE at line 1, column 28, but found \")\".", program.errors[0].getMessage());
+}
+
+TEST(ParserTest, ItShouldResolveVariablesToInnermostDeclaration)
+{
+    std::string sourceCode = R"(function integer foo(integer x) {
+    if (true) {
+        integer x;
+        x = 1;
+    };
+    return x;
+};)";
+
+    std::deque<lexer::Token> tokens = lexer::lex(sourceCode);
+
+    parser::Parser testObject(tokens);
+    parser::Program program = testObject.parse();
+
+    ASSERT_TRUE(program.isSyntacticallyCorrect());
+    auto function = std::static_pointer_cast<parser::FunctionStmt>(program.stmts[0]);
+    auto ifStmt = std::static_pointer_cast<parser::IfStmt>(function->stmts[0]);
+    auto assignment = std::static_pointer_cast<parser::VarAssignmentExpr>(std::static_pointer_cast<parser::ExprStmt>(ifStmt->stmts[1])->expr);
+    auto returned = std::static_pointer_cast<parser::VarExpr>(std::static_pointer_cast<parser::ReturnStmt>(function->stmts[1])->expr);
+
+    EXPECT_EQ(ifStmt->stmts[0].get(), assignment->declaration);
+    EXPECT_EQ(function->args[0].get(), returned->declaration);
+}
+
+TEST(ParserTest, ItShouldTypeCallsToImportedFunctions)
+{
+    std::string sourceCode = R"(import "math.anchor";
+function integer main() {
+    return twice(2);
+};)";
+    std::deque<lexer::Token> tokens = lexer::lex(sourceCode);
+    std::vector<std::string> imported;
+    parser::Importer importer = [&imported](const std::string &path)
+    {
+        imported.push_back(path);
+        auto twice = std::make_shared<parser::FunctionStmt>();
+        twice->type = parser::StmtType::FUNCTION;
+        twice->identifier = "twice";
+        twice->returnType = parser::Type::INTEGER;
+        return std::vector<std::shared_ptr<parser::FunctionStmt>>{twice};
+    };
+
+    parser::Parser testObject(tokens, importer);
+    parser::Program program = testObject.parse();
+
+    ASSERT_TRUE(program.isSyntacticallyCorrect());
+    EXPECT_EQ(std::vector<std::string>{"math.anchor"}, imported);
+    auto importStmt = std::static_pointer_cast<parser::ImportStmt>(program.stmts[0]);
+    EXPECT_EQ(parser::StmtType::IMPORT, importStmt->type);
+    EXPECT_EQ("math.anchor", importStmt->path);
+    ASSERT_EQ(1, importStmt->declarations.size());
+    auto main = std::static_pointer_cast<parser::FunctionStmt>(program.stmts[1]);
+    auto returned = std::static_pointer_cast<parser::ReturnStmt>(main->stmts[0]);
+    EXPECT_EQ(parser::Type::INTEGER, returned->expr->returnType);
+}
+
+TEST(ParserTest, ItShouldReportImportWithoutImporter)
+{
+    std::deque<lexer::Token> tokens = lexer::lex("import \"math.anchor\";");
+
+    parser::Parser testObject(tokens);
+    parser::Program program = testObject.parse();
+
+    ASSERT_EQ(1, program.errors.size());
+    EXPECT_EQ("Cannot import math.anchor, imports are not supported here.", program.errors[0].getMessage());
+}
+
+TEST(ParserTest, ItShouldReportImportInsideFunction)
+{
+    std::deque<lexer::Token> tokens = lexer::lex("function void foo() {\n    import \"math.anchor\";\n};");
+    parser::Importer importer = [](const std::string &) -> std::vector<std::shared_ptr<parser::FunctionStmt>>
+    {
+        throw std::runtime_error("Should not have been called.");
+    };
+
+    parser::Parser testObject(tokens, importer);
+    parser::Program program = testObject.parse();
+
+    ASSERT_EQ(1, program.errors.size());
+    EXPECT_EQ("Cannot import math.anchor inside a function at line 2, imports belong at the top level of a file.", program.errors[0].getMessage());
+}
+
+TEST(ParserTest, ItShouldReportImporterFailureAtPath)
+{
+    std::deque<lexer::Token> tokens = lexer::lex("import \"math.anchor\";");
+    parser::Importer importer = [](const std::string &) -> std::vector<std::shared_ptr<parser::FunctionStmt>>
+    {
+        throw std::runtime_error("Could not find library math.anchor.");
+    };
+
+    parser::Parser testObject(tokens, importer);
+    parser::Program program = testObject.parse();
+
+    ASSERT_EQ(1, program.errors.size());
+    EXPECT_EQ("Could not find library math.anchor.", program.errors[0].getMessage());
+    EXPECT_EQ(lexer::Location(1, 8), program.errors[0].getStart());
+}
+
+TEST(ParserTest, ItShouldParseOneStatementAtATimeFromLexer)
+{
+    std::string source = "function integer one() {\n    return 1;\n};\nfunction integer two() {\n    return one() + 1;\n};";
+    lexer::Lexer lexer(source);
+
+    parser::Parser testObject(lexer);
+    auto one = std::static_pointer_cast<parser::FunctionStmt>(testObject.next());
+    auto two = std::static_pointer_cast<parser::FunctionStmt>(testObject.next());
+
+    ASSERT_NE(nullptr, one);
+    ASSERT_NE(nullptr, two);
+    EXPECT_EQ("one", one->identifier);
+    EXPECT_EQ("two", two->identifier);
+    auto returned = std::static_pointer_cast<parser::ReturnStmt>(two->stmts[0]);
+    EXPECT_EQ(parser::Type::INTEGER, returned->expr->returnType);
+    EXPECT_EQ(nullptr, testObject.next());
+    EXPECT_TRUE(testObject.errors().empty());
+}
+
+TEST(ParserTest, ItShouldParseLexedSourceLikeTokens)
+{
+    std::string source = "function integer main( {\n};\nfunction integer foo() {\n    return 1;\n};";
+    std::deque<lexer::Token> tokens = lexer::lex(source);
+    lexer::Lexer lexer(source);
+
+    parser::Program expected = parser::Parser(tokens).parse();
+    parser::Program actual = parser::Parser(lexer).parse();
+
+    ASSERT_EQ(expected.stmts.size(), actual.stmts.size());
+    ASSERT_EQ(1, actual.errors.size());
+    EXPECT_EQ(expected.errors[0].getMessage(), actual.errors[0].getMessage());
+    EXPECT_EQ(parser::StmtType::FUNCTION, actual.stmts[1]->type);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "src/protocol.hh"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+class ProtocolTest : public ::testing::Test
+{
+protected:
+    int fds[2];
+
+    void SetUp() override
+    {
+        ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, this->fds));
+    }
+
+    void TearDown() override
+    {
+        ::close(this->fds[0]);
+        if (this->fds[1] >= 0)
+        {
+            ::close(this->fds[1]);
+        }
+    }
+};
+
+TEST_F(ProtocolTest, ItShouldRoundTripRequests)
+{
+    protocol::Request request;
+    request.args = {"-O2", "--emit=llvm", ""};
+    request.workingDirectory = "/home/anchor";
+    request.input = std::string("function integer main() {\0};", 28);
+
+    protocol::writeRequest(this->fds[0], request);
+    protocol::writeRequest(this->fds[0], protocol::Request());
+    std::optional<protocol::Request> first = protocol::readRequest(this->fds[1]);
+    std::optional<protocol::Request> second = protocol::readRequest(this->fds[1]);
+
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(request.args, first->args);
+    EXPECT_EQ(request.workingDirectory, first->workingDirectory);
+    EXPECT_EQ(request.input, first->input);
+    ASSERT_TRUE(second.has_value());
+    EXPECT_TRUE(second->args.empty());
+}
+
+TEST_F(ProtocolTest, ItShouldRoundTripResponses)
+{
+    protocol::Response response;
+    response.exitCode = 1;
+    response.out = "; ModuleID = 'anchor'\n";
+    response.err = "Type Error\n";
+
+    protocol::writeResponse(this->fds[1], response);
+    protocol::Response testObject = protocol::readResponse(this->fds[0]);
+
+    EXPECT_EQ(1, testObject.exitCode);
+    EXPECT_EQ(response.out, testObject.out);
+    EXPECT_EQ(response.err, testObject.err);
+}
+
+TEST_F(ProtocolTest, ItShouldEndRequestsWhenPeerCloses)
+{
+    ::close(this->fds[1]);
+    this->fds[1] = -1;
+
+    EXPECT_FALSE(protocol::readRequest(this->fds[0]).has_value());
+}
+
+TEST_F(ProtocolTest, ItShouldThrowWhenPeerClosesMidMessage)
+{
+    ASSERT_EQ(6, ::write(this->fds[1], "\x02\x00\x00\x00\x05\x00", 6));
+    ::close(this->fds[1]);
+    this->fds[1] = -1;
+
+    EXPECT_THROW(protocol::readRequest(this->fds[0]), std::runtime_error);
+}
+
+TEST(ProtocolSocketTest, ItShouldRejectSocketPathTooLongForAddress)
+{
+    EXPECT_THROW(protocol::listen("/tmp/" + std::string(200, 'a')), std::invalid_argument);
+}
+
+TEST(ProtocolSocketTest, ItShouldReportNoServerListening)
+{
+    EXPECT_THROW(protocol::connect("/tmp/anchor_protocol_test_nobody.sock"), std::runtime_error);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "src/repl.hh"
+#include "test/jit_fixture.hh"
+
+#include <algorithm>
+#include <sstream>
+
+class ReplTest : public JitFixture
+{
+protected:
+    jit::Jit jit;
+    std::unique_ptr<repl::Repl> session;
+
+    void SetUp() override
+    {
+        this->capture(this->jit);
+        this->session = std::make_unique<repl::Repl>(this->jit);
+    }
+
+    // Evaluates each input in turn, expecting no diagnostics, and returns what they printed.
+    std::string evaluate(const std::vector<std::string> &inputs)
+    {
+        std::size_t printed = this->getCaptured().size();
+        for (const std::string &input : inputs)
+        {
+            EXPECT_EQ("", this->session->evaluate(input)) << input;
+        }
+        return this->getCaptured().substr(printed);
+    }
+};
+
+TEST_F(ReplTest, ItShouldRunTopLevelStatementsAtOnce)
+{
+    EXPECT_EQ("3", this->evaluate({"print(1 + 2);"}));
+    EXPECT_EQ("yes", this->evaluate({"if (2 > 1) {\n    print(\"yes\");\n};"}));
+}
+
+TEST_F(ReplTest, ItShouldKeepVariablesBetweenInputs)
+{
+    EXPECT_EQ("0", this->evaluate({"integer x;", "print(x);"}));
+    EXPECT_EQ("10", this->evaluate({"x = 5;", "print(x * 2);"}));
+    EXPECT_EQ("!", this->evaluate({"string s;", "print(s + \"!\");"}));
+    EXPECT_EQ("anchor!", this->evaluate({"s = \"anchor\";", "s = s + \"!\";", "print(s);"}));
+    EXPECT_EQ("8", this->evaluate({"integer i; i = 0; while (i < 8) { i = i + 1; };", "print(i);"}));
+}
+
+TEST_F(ReplTest, ItShouldCallFunctionsDefinedInEarlierInputs)
+{
+    this->evaluate({"function integer fib(integer n) {\n    if (n < 2) {\n        return n;\n    };\n    return fib(n - 1) + fib(n - 2);\n};"});
+    this->evaluate({"integer limit;", "limit = 20;"});
+    this->evaluate({"function integer fibToLimit() {\n    return fib(limit);\n};"});
+
+    EXPECT_EQ("6765", this->evaluate({"print(fibToLimit());"}));
+}
+
+TEST_F(ReplTest, ItShouldRebindRedefinedFunctionWithoutRecompilingCallers)
+{
+    this->evaluate({"function integer base() {\n    return 1;\n};", "function integer caller() {\n    return base() + 10;\n};"});
+    EXPECT_EQ("11", this->evaluate({"print(caller());"}));
+
+    this->evaluate({"function integer base() {\n    return 2;\n};"});
+
+    EXPECT_EQ("12", this->evaluate({"print(caller());"}));
+}
+
+TEST_F(ReplTest, ItShouldRejectRedefinitionWithAnotherSignature)
+{
+    this->evaluate({"function integer answer() {\n    return 42;\n};"});
+
+    EXPECT_EQ("Cannot redefine answer with another signature, code compiled already calls it with the old one.\n", this->session->evaluate("function string answer() {\n    return \"42\";\n};"));
+    EXPECT_EQ("43", this->evaluate({"print(answer() + 1);"}));
+}
+
+TEST_F(ReplTest, ItShouldReportDiagnosticsAndCarryOn)
+{
+    EXPECT_EQ("Expected: INTEGER_TYPE, BOOLEAN_TYPE at line 1, column 24, but found \"{\".\n", this->session->evaluate("function integer main( {\n};"));
+    EXPECT_NE("", this->session->evaluate("print(missing);"));
+    EXPECT_EQ("Cannot return outside a function.\n", this->session->evaluate("return 1;"));
+    EXPECT_EQ("Cannot return outside a function.\n", this->session->evaluate("if (true) {\n    return 1;\n};"));
+
+    EXPECT_EQ("1", this->evaluate({"print(1);"}));
+}
+
+TEST_F(ReplTest, ItShouldReportCallToUnknownFunction)
+{
+    EXPECT_EQ("Cannot compile call to unknown function g.\n", this->session->evaluate("print(g(1));"));
+
+    EXPECT_EQ("1", this->evaluate({"print(1);"}));
+}
+
+TEST_F(ReplTest, ItShouldForgetFunctionThatFailedToCompile)
+{
+    EXPECT_EQ("Cannot compile reference to undeclared variable y.\n", this->session->evaluate("function integer f(integer a) {\n    return a + y;\n};"));
+    EXPECT_EQ("Cannot compile call to unknown function f.\n", this->session->evaluate("print(f(1));"));
+
+    EXPECT_EQ("2", this->evaluate({"function integer f(integer a) {\n    return a + 1;\n};", "print(f(1));"}));
+}
+
+TEST_F(ReplTest, ItShouldStopAtFirstBadStatementOfInput)
+{
+    EXPECT_NE("", this->session->evaluate("print(1); print(missing); print(2);"));
+    EXPECT_EQ("1", this->getCaptured());
+}
+
+TEST_F(ReplTest, ItShouldWaitForWholeStatements)
+{
+    EXPECT_FALSE(repl::isComplete(""));
+    EXPECT_FALSE(repl::isComplete("print(1)"));
+    EXPECT_FALSE(repl::isComplete("function integer f() {\n    return 1;\n"));
+    EXPECT_FALSE(repl::isComplete("function integer f() {\n    return 1;\n}"));
+    EXPECT_TRUE(repl::isComplete("function integer f() {\n    return 1;\n};"));
+    EXPECT_TRUE(repl::isComplete("print(1);\n"));
+    EXPECT_TRUE(repl::isComplete("print(1 $ 2"));
+}
+
+TEST_F(ReplTest, ItShouldReadStatementsSpreadOverLines)
+{
+    std::istringstream in("function integer twice(integer n) {\n    return n * 2;\n};\n\nprint(twice(\n    21));\nprint(missing);\nprint(\"done\");\nprint(");
+    std::ostringstream out;
+    std::ostringstream err;
+
+    this->session->run(in, out, err, true);
+
+    EXPECT_EQ("42done", this->getCaptured());
+    EXPECT_EQ("> ... ... > > ... > > > ... \n", out.str());
+    std::string diagnostics = err.str();
+    EXPECT_EQ(2, std::count(diagnostics.begin(), diagnostics.end(), '\n')) << diagnostics;
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/server.hh"
+
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+class ServerTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path directory;
+    std::string socketPath;
+    std::unique_ptr<server::Server> testObject;
+    std::thread serving;
+
+    void SetUp() override
+    {
+        const ::testing::TestInfo *test = ::testing::UnitTest::GetInstance()->current_test_info();
+        this->directory = std::filesystem::temp_directory_path() / (std::string("anchor_server_test_") + test->name());
+        std::filesystem::remove_all(this->directory);
+        std::filesystem::create_directories(this->directory);
+
+        // Socket paths are short, so this one does not live in the directory.
+        this->socketPath = "/tmp/anchor_server_test_" + std::to_string(::getpid()) + ".sock";
+        this->testObject = std::make_unique<server::Server>(this->socketPath, 4);
+        this->serving = std::thread([this]()
+                                    { this->testObject->run(); });
+    }
+
+    void TearDown() override
+    {
+        this->testObject->stop();
+        this->serving.join();
+        this->testObject.reset();
+        std::filesystem::remove_all(this->directory);
+    }
+
+    protocol::Response send(std::vector<std::string> args, const std::string &input = "")
+    {
+        protocol::Request request;
+        request.args = std::move(args);
+        request.workingDirectory = this->directory.string();
+        request.input = input;
+        return protocol::send(this->socketPath, request);
+    }
+};
+
+namespace
+{
+    const std::string program = R"(function integer square(integer n) {
+    return n * n;
+};
+function integer main() {
+    print(square(7));
+    return 0;
+};)";
+}
+
+TEST_F(ServerTest, ItShouldCompileLikeMain)
+{
+    protocol::Response response = this->send({"--no-cache"}, program);
+
+    EXPECT_EQ(0, response.exitCode);
+    EXPECT_EQ(anchor::compile(program) + "\n", response.out);
+    EXPECT_EQ("", response.err);
+}
+
+TEST_F(ServerTest, ItShouldReportDiagnostics)
+{
+    protocol::Response response = this->send({"--no-cache", "--emit=bc"}, "function integer main( {\n};");
+
+    EXPECT_EQ(1, response.exitCode);
+    EXPECT_EQ("", response.out);
+    EXPECT_EQ("Expected: INTEGER_TYPE, BOOLEAN_TYPE at line 1, column 24, but found \"{\".\n", response.err);
+}
+
+TEST_F(ServerTest, ItShouldReportBadArguments)
+{
+    protocol::Response response = this->send({"--no-such-option"});
+
+    EXPECT_EQ(1, response.exitCode);
+    EXPECT_EQ(0, response.err.find("Unknown option --no-such-option."));
+}
+
+TEST_F(ServerTest, ItShouldResolvePathsAgainstClientDirectory)
+{
+    {
+        std::ofstream source(this->directory / "square.anchor");
+        source << program;
+    }
+
+    protocol::Response response = this->send({"--no-cache", "-O2", "--emit=llvm", "-o", "square.ll", "square.anchor"});
+
+    EXPECT_EQ(0, response.exitCode) << response.err;
+    std::ifstream written(this->directory / "square.ll");
+    std::stringstream ir;
+    ir << written.rdbuf();
+    EXPECT_EQ(anchor::compile(program, compiler::OptimizationLevel::O2), ir.str());
+}
+
+TEST_F(ServerTest, ItShouldRefuseToRunPrograms)
+{
+    protocol::Response response = this->send({"--run"}, program);
+
+    EXPECT_EQ(1, response.exitCode);
+    EXPECT_EQ("Cannot run programs here, compile them instead.\n", response.err);
+}
+
+TEST_F(ServerTest, ItShouldServeConcurrentRequests)
+{
+    std::string expected = anchor::compile(program, compiler::OptimizationLevel::O2) + "\n";
+
+    std::vector<std::thread> clients;
+    std::vector<std::string> outputs(32);
+    for (std::size_t i = 0; i < outputs.size(); i++)
+    {
+        clients.emplace_back([this, &outputs, i]()
+                             { outputs[i] = this->send({"--no-cache", "-O2"}, program).out; });
+    }
+    for (std::thread &client : clients)
+    {
+        client.join();
+    }
+
+    for (const std::string &output : outputs)
+    {
+        EXPECT_EQ(expected, output);
+    }
+}
+
+TEST_F(ServerTest, ItShouldRefuseSecondServerOnSameSocket)
+{
+    EXPECT_THROW(server::Server(this->socketPath, 1), std::runtime_error);
+}
+
+TEST(CompilerPoolTest, ItShouldCompileSameModuleWithResetCompiler)
+{
+    compiler::CompilerPool testObject;
+    std::string first;
+    std::string second;
+    {
+        compiler::CompilerPool::Lease lease = testObject.acquire(compiler::OptimizationLevel::O2);
+        anchor::CompilationUnit unit(program);
+        unit.compiler = &lease.get();
+        first = anchor::compile(unit, compiler::OptimizationLevel::O2);
+    }
+    ASSERT_EQ(1, testObject.idleCount(compiler::OptimizationLevel::O2));
+    {
+        compiler::CompilerPool::Lease lease = testObject.acquire(compiler::OptimizationLevel::O2);
+        anchor::CompilationUnit unit(program);
+        unit.compiler = &lease.get();
+        second = anchor::compile(unit, compiler::OptimizationLevel::O2);
+    }
+
+    EXPECT_EQ(anchor::compile(program, compiler::OptimizationLevel::O2), first);
+    EXPECT_EQ(first, second);
+}
+
+TEST(CompilerPoolTest, ItShouldReplaceCompilerAfterMaximumUses)
+{
+    compiler::CompilerPool testObject(2);
+    testObject.warm(compiler::OptimizationLevel::O0, 1);
+
+    compiler::Compiler *warmed;
+    {
+        compiler::CompilerPool::Lease lease = testObject.acquire(compiler::OptimizationLevel::O0);
+        warmed = &lease.get();
+    }
+    {
+        compiler::CompilerPool::Lease lease = testObject.acquire(compiler::OptimizationLevel::O0);
+        EXPECT_EQ(warmed, &lease.get());
+        EXPECT_EQ(0, testObject.idleCount(compiler::OptimizationLevel::O0));
+    }
+
+    EXPECT_EQ(0, testObject.idleCount(compiler::OptimizationLevel::O0));
+}
+
+TEST(CompilerPoolTest, ItShouldRejectCompilerAtOtherLevel)
+{
+    compiler::CompilerPool testObject;
+    compiler::CompilerPool::Lease lease = testObject.acquire(compiler::OptimizationLevel::O0);
+    anchor::CompilationUnit unit(program);
+    unit.compiler = &lease.get();
+
+    EXPECT_THROW(anchor::compile(unit, compiler::OptimizationLevel::O2), std::invalid_argument);
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/streaming.hh"
+#include "test/jit_fixture.hh"
+
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+class StreamingTest : public JitFixture
+{
+protected:
+    std::string stream(const std::string &sourceCode, compiler::OptimizationLevel level, std::size_t chunkSize)
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        std::string ir;
+        llvm::raw_string_ostream out(ir);
+        EXPECT_EQ("", anchor::compileStreamingToIR(unit, out, level, chunkSize));
+        return out.str();
+    }
+
+    // Reads streamed IR back as one module and runs it.
+    std::string runStreamed(const std::string &sourceCode, compiler::OptimizationLevel level, std::size_t chunkSize)
+    {
+        std::string ir = this->stream(sourceCode, level, chunkSize);
+
+        auto context = std::make_unique<llvm::LLVMContext>();
+#if LLVM_VERSION_MAJOR < 15
+        context->enableOpaquePointers();
+#endif
+        llvm::SMDiagnostic diagnostic;
+        std::unique_ptr<llvm::Module> module = llvm::parseAssemblyString(ir, diagnostic, *context);
+        if (module == nullptr)
+        {
+            std::string message;
+            llvm::raw_string_ostream messageStream(message);
+            diagnostic.print("streamed", messageStream);
+            return messageStream.str() + ir;
+        }
+
+        std::string errors;
+        llvm::raw_string_ostream errorStream(errors);
+        if (llvm::verifyModule(*module, &errorStream))
+        {
+            return errorStream.str();
+        }
+        return this->run(std::move(context), std::move(module), level);
+    }
+};
+
+TEST_F(StreamingTest, ItShouldPrintChunksAsOneModule)
+{
+    for (compiler::OptimizationLevel level : {compiler::OptimizationLevel::O0, compiler::OptimizationLevel::O2})
+    {
+        EXPECT_EQ("2048done", this->runStreamed(generateChain(12), level, 5));
+    }
+}
+
+TEST_F(StreamingTest, ItShouldEmitAChunkPerChunkSizeFunctions)
+{
+    std::vector<std::string> chunks;
+    streaming::StreamingCompiler streamed(compiler::OptimizationLevel::O0, [&](compiler::Compiler &compiler)
+                                          {
+                                              std::string ir;
+                                              llvm::raw_string_ostream out(ir);
+                                              compiler.print(out);
+                                              chunks.push_back(out.str()); },
+                                          4);
+    anchor::CompilationUnit unit(generateChain(10));
+
+    streamed.compile(unit);
+
+    // f0..f9 and main.
+    ASSERT_EQ(3, streamed.size());
+    ASSERT_EQ(3, chunks.size());
+    EXPECT_NE(std::string::npos, chunks[1].find("declare i32 @f3(i32"));
+    EXPECT_NE(std::string::npos, chunks[1].find("define i32 @f4(i32"));
+    EXPECT_EQ(std::string::npos, chunks[1].find("@f0"));
+    EXPECT_EQ(std::string::npos, chunks[1].find("@f8"));
+}
+
+TEST_F(StreamingTest, ItShouldNotKeepTokensOrTree)
+{
+    streaming::StreamingCompiler streamed(compiler::OptimizationLevel::O0, [](compiler::Compiler &) {}, 1);
+    anchor::CompilationUnit unit(generateChain(3));
+
+    streamed.compile(unit);
+
+    EXPECT_FALSE(unit.hasErrors());
+    EXPECT_TRUE(unit.tokens.empty());
+    EXPECT_TRUE(unit.program.stmts.empty());
+    EXPECT_EQ(4, streamed.size());
+}
+
+TEST_F(StreamingTest, ItShouldStopEmittingAtFirstDiagnostic)
+{
+    std::size_t emitted = 0;
+    streaming::StreamingCompiler streamed(compiler::OptimizationLevel::O0, [&](compiler::Compiler &)
+                                          { emitted++; },
+                                          2);
+    anchor::CompilationUnit unit(generateChain(4) + "function integer broken( {\n};\nfunction integer again( {\n};\n");
+
+    streamed.compile(unit);
+
+    // f0..f3 were emitted before the error, main never completed a chunk.
+    EXPECT_EQ(2, emitted);
+    ASSERT_EQ(2, unit.diagnostics.size());
+    EXPECT_EQ("Expected: INTEGER_TYPE, BOOLEAN_TYPE at line 18, column 26, but found \"{\".", unit.diagnostics[0].getMessage());
+}
+
+TEST_F(StreamingTest, ItShouldReportInvalidTokens)
+{
+    anchor::CompilationUnit unit("function integer main() {\n    return 1 $ 2;\n};");
+    std::string ir;
+    llvm::raw_string_ostream out(ir);
+
+    std::string errors = anchor::compileStreamingToIR(unit, out, compiler::OptimizationLevel::O0);
+
+    EXPECT_TRUE(unit.hasErrors());
+    EXPECT_NE("", errors);
+    EXPECT_EQ("", out.str());
+}
+
+TEST_F(StreamingTest, ItShouldCompileProgramWithoutFunctions)
+{
+    std::string ir = this->stream("", compiler::OptimizationLevel::O0, 4);
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+#if LLVM_VERSION_MAJOR < 15
+    context->enableOpaquePointers();
+#endif
+    llvm::SMDiagnostic diagnostic;
+    EXPECT_NE(nullptr, llvm::parseAssemblyString(ir, diagnostic, *context)) << ir;
+}
+
+TEST_F(StreamingTest, ItShouldMatchOneModuleOnEveryWorkload)
+{
+    for (const auto &entry : std::filesystem::directory_iterator(ANCHOR_BENCH_WORKLOADS_DIR))
+    {
+        std::ifstream workload(entry.path());
+        std::stringstream sourceCode;
+        sourceCode << workload.rdbuf();
+
+        EXPECT_EQ(this->run(sourceCode.str(), compiler::OptimizationLevel::O2), this->runStreamed(sourceCode.str(), compiler::OptimizationLevel::O2, 1)) << entry.path();
+    }
+}
+
+TEST_F(StreamingTest, ItShouldLinkExecutableFromChunks)
+{
+    std::filesystem::path executable = std::filesystem::temp_directory_path() / "anchor_streaming_test_executable";
+    anchor::CompilationUnit unit(generateChain(7));
+
+    EXPECT_EQ("", anchor::compileStreamingToExecutable(unit, executable.string(), compiler::OptimizationLevel::O1, nullptr, 3));
+
+    std::string output = executable.string() + ".out";
+    EXPECT_EQ(0, std::system((executable.string() + " > " + output).c_str()));
+    std::ifstream printed(output);
+    std::stringstream contents;
+    contents << printed.rdbuf();
+    EXPECT_EQ("64done", contents.str());
+    EXPECT_FALSE(std::filesystem::exists(executable.string() + ".0.o"));
+    std::filesystem::remove(executable);
+    std::filesystem::remove(output);
+}
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include "src/anchor.hh"
+#include "src/tiering.hh"
+#include "test/jit_fixture.hh"
+
+#include "llvm/Support/raw_ostream.h"
+
+namespace
+{
+    const std::string fib = R"(function integer fib(integer n) {
+    if (n < 2) {
+        return n;
+    };
+    return fib(n - 1) + fib(n - 2);
+};
+
+function integer main() {
+    print(fib(5));
+    print(fib(20));
+    print(fib(21));
+    return 0;
+};)";
+}
+
+class TieringTest : public JitFixture
+{
+protected:
+    std::vector<std::string> promoted;
+
+    std::string runTiered(const std::string &sourceCode, int threshold, bool background)
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            return unit.diagnostics[0].getMessage();
+        }
+
+        jit::Jit jit;
+        this->capture(jit);
+        int exitCode = 0;
+        {
+            tiering::TieredJit tiered(jit, unit.program, threshold, background);
+            exitCode = tiered.runMain();
+            this->promoted = tiered.getPromoted();
+        }
+        if (exitCode != 0)
+        {
+            return std::to_string(exitCode) + " was returned from main";
+        }
+        return this->getCaptured();
+    }
+};
+
+TEST_F(TieringTest, ItShouldPromoteHotFunctionAndKeepItsResults)
+{
+    EXPECT_EQ("5676510946", this->runTiered(fib, 100, false));
+    EXPECT_EQ(std::vector<std::string>{"fib"}, this->promoted);
+}
+
+TEST_F(TieringTest, ItShouldNotPromoteColdFunctions)
+{
+    EXPECT_EQ("5676510946", this->runTiered(fib, 1000000, false));
+    EXPECT_TRUE(this->promoted.empty());
+}
+
+TEST_F(TieringTest, ItShouldPromoteOnBackgroundThreadWithoutChangingOutput)
+{
+    EXPECT_EQ("5676510946", this->runTiered(fib, 100, true));
+    EXPECT_LE(this->promoted.size(), 1);
+}
+
+TEST_F(TieringTest, ItShouldPromoteFunctionThatLoopsForLong)
+{
+    std::string sourceCode = R"(function integer sum(integer n) {
+    integer i;
+    integer total;
+    i = 0;
+    total = 0;
+    while (i < n) {
+        i = i + 1;
+        total = total + i;
+    };
+    return total;
+};
+
+function integer main() {
+    print(sum(100));
+    print(sum(100));
+    return 0;
+};)";
+
+    EXPECT_EQ("50505050", this->runTiered(sourceCode, 10, false));
+    EXPECT_EQ(std::vector<std::string>{"sum"}, this->promoted);
+}
+
+TEST_F(TieringTest, ItShouldPromoteFunctionOnlyOnce)
+{
+    anchor::CompilationUnit unit(fib);
+    anchor::lex(unit);
+    anchor::parse(unit);
+
+    jit::Jit jit;
+    this->capture(jit);
+    tiering::TieredJit tiered(jit, unit.program, 100, false);
+    EXPECT_EQ(0, tiered.runMain());
+
+    // As the call counter does when it wraps around.
+    tiered.tierUp("fib");
+
+    EXPECT_EQ(std::vector<std::string>{"fib"}, tiered.getPromoted());
+}
+
+TEST_F(TieringTest, ItShouldCallPromotedFunctionsThroughEntryPointers)
+{
+    std::string sourceCode = R"(function string greet(string name) {
+    return "Hello, " + name;
+};
+
+function integer square(integer n) {
+    return n * n;
+};
+
+function integer main() {
+    integer i;
+    integer total;
+    i = 0;
+    total = 0;
+    while (i < 50) {
+        total = total + square(i);
+        i = i + 1;
+    };
+    print(greet("World"));
+    print(greet("Anchor"));
+    print(total);
+    return 0;
+};)";
+
+    EXPECT_EQ("Hello, WorldHello, Anchor40425", this->runTiered(sourceCode, 2, false));
+    EXPECT_EQ((std::vector<std::string>{"square", "greet"}), this->promoted);
+}
+
+TEST_F(TieringTest, ItShouldCountCallsOnlyInBaselineTier)
+{
+    anchor::CompilationUnit unit(fib);
+    anchor::lex(unit);
+    anchor::parse(unit);
+
+    std::string baselineIr;
+    {
+        compiler::Compiler baseline(compiler::OptimizationLevel::O0);
+        baseline.compileBaselineTier(unit.program, 10);
+        llvm::raw_string_ostream outs(baselineIr);
+        baseline.print(outs);
+    }
+    EXPECT_NE(std::string::npos, baselineIr.find("atomicrmw add ptr @fib.calls, i32 1 monotonic"));
+    EXPECT_NE(std::string::npos, baselineIr.find("load atomic ptr, ptr @fib.entry acquire"));
+
+    std::string optimizedIr;
+    {
+        compiler::Compiler optimizing(compiler::OptimizationLevel::O2);
+        optimizing.compileOptimizedTier(unit.program, "fib");
+        llvm::raw_string_ostream outs(optimizedIr);
+        optimizing.print(outs);
+    }
+    EXPECT_NE(std::string::npos, optimizedIr.find("define i32 @fib.tier2"));
+    EXPECT_EQ(std::string::npos, optimizedIr.find("@fib.calls"));
+    EXPECT_EQ(std::string::npos, optimizedIr.find("define i32 @main"));
+}
+
+TEST_F(TieringTest, ItShouldRejectOptimizedTierOfUnknownFunction)
+{
+    anchor::CompilationUnit unit(fib);
+    anchor::lex(unit);
+    anchor::parse(unit);
+
+    compiler::Compiler optimizing(compiler::OptimizationLevel::O2);
+    EXPECT_THROW(optimizing.compileOptimizedTier(unit.program, "missing"), std::invalid_argument);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "src/bytecode.hh"
+#include "src/compilationunit.hh"
+#include "src/vm.hh"
+#include "test/jit_fixture.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+class VmTest : public JitFixture
+{
+protected:
+    int exitCode = 0;
+
+    std::string runVm(const std::string &sourceCode)
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        if (unit.hasErrors())
+        {
+            return unit.diagnostics[0].getMessage();
+        }
+
+        bytecode::Module module = bytecode::lower(unit.program);
+        std::ostringstream out;
+        vm::Machine machine(module, out);
+        this->exitCode = machine.runMain();
+        return out.str();
+    }
+};
+
+TEST_F(VmTest, ItShouldPrintIntegersStringsAndBooleans)
+{
+    std::string output = this->runVm(R"(function integer main() {
+    boolean b;
+    b = 1 < 2;
+    print(40 + 2);
+    print("Hello" + ", " + "World");
+    print(b);
+    print(3 > 4);
+    return 0;
+};)");
+
+    EXPECT_EQ("42Hello, World10", output);
+}
+
+TEST_F(VmTest, ItShouldReturnExitCodeOfMain)
+{
+    this->runVm(R"(function integer main() {
+    return 7 * 6;
+};)");
+
+    EXPECT_EQ(42, this->exitCode);
+}
+
+TEST_F(VmTest, ItShouldPassAndReturnStringsAndIntegers)
+{
+    std::string sourceCode = R"(function string repeat(string s, integer times) {
+    string result;
+    while (times > 0) {
+        result = result + s;
+        times = times - 1;
+    };
+    return result;
+};
+
+function integer add(integer a, integer b) {
+    return a + b;
+};
+
+function integer main() {
+    print(repeat("ab", add(1, add(1, 1))));
+    print(add(add(1, 2), add(3, 4)) - 1);
+    return 0;
+};)";
+
+    EXPECT_EQ("ababab9", this->runVm(sourceCode));
+    EXPECT_EQ(this->run(sourceCode), this->runVm(sourceCode));
+}
+
+TEST_F(VmTest, ItShouldShadowVariablesInNestedBlocks)
+{
+    std::string output = this->runVm(R"(function integer main() {
+    integer x;
+    x = 1;
+    if (true) {
+        integer x;
+        x = 2;
+        print(x);
+    };
+    if (x == 1) {
+        string x;
+        x = "s";
+        print(x);
+    };
+    print(x);
+    return 0;
+};)");
+
+    EXPECT_EQ("2s1", output);
+}
+
+TEST_F(VmTest, ItShouldMatchJitOnEveryWorkload)
+{
+    for (const auto &entry : std::filesystem::directory_iterator(ANCHOR_BENCH_WORKLOADS_DIR))
+    {
+        std::ifstream workload(entry.path());
+        std::stringstream sourceCode;
+        sourceCode << workload.rdbuf();
+
+        EXPECT_EQ(this->run(sourceCode.str()), this->runVm(sourceCode.str())) << entry.path();
+    }
+}
+
+TEST_F(VmTest, ItShouldRunModuleReadBackFromFile)
+{
+    anchor::CompilationUnit unit(R"(function integer fib(integer n) {
+    if (n < 2) {
+        return n;
+    };
+    return fib(n - 1) + fib(n - 2);
+};
+
+function integer main() {
+    print(fib(20));
+    return 0;
+};)");
+    anchor::lex(unit);
+    anchor::parse(unit);
+
+    std::stringstream file;
+    bytecode::write(file, bytecode::lower(unit.program));
+    bytecode::Module module = bytecode::read(file);
+
+    std::ostringstream out;
+    vm::Machine machine(module, out);
+    EXPECT_EQ(0, machine.runMain());
+    EXPECT_EQ("6765", out.str());
+}
+
+TEST_F(VmTest, ItShouldReportUnboundedRecursion)
+{
+    EXPECT_THROW(this->runVm(R"(function integer forever(integer n) {
+    return forever(n + 1);
+};
+
+function integer main() {
+    return forever(0);
+};)"),
+                 std::runtime_error);
+}
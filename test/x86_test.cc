@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include "src/compilationunit.hh"
+#include "src/x86.hh"
+#include "test/jit_fixture.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+class X86Test : public JitFixture
+{
+protected:
+    x86::Jit jit;
+
+    void SetUp() override
+    {
+        if (!x86::isHost)
+        {
+            GTEST_SKIP() << "x86-64 code cannot run on this host.";
+        }
+    }
+
+    parser::Program parse(const std::string &sourceCode)
+    {
+        anchor::CompilationUnit unit(sourceCode);
+        anchor::lex(unit);
+        anchor::parse(unit);
+        EXPECT_FALSE(unit.hasErrors());
+        return unit.program;
+    }
+
+    std::string runX86(const std::string &sourceCode)
+    {
+        this->capture(this->jit);
+        this->jit.add(x86::compile(this->parse(sourceCode)));
+        int exitCode = this->jit.runMain();
+        if (exitCode != 0)
+        {
+            return std::to_string(exitCode) + " was returned from main";
+        }
+        return this->getCaptured();
+    }
+};
+
+// The {i8*, i32} struct strings travel as.
+class AnchorString
+{
+public:
+    const char *characters;
+    int size;
+};
+
+TEST_F(X86Test, ItShouldPrintIntegersStringsAndBooleans)
+{
+    std::string output = this->runX86(R"(function integer main() {
+    boolean b;
+    string s;
+    b = 1 < 2;
+    print(40 + 2);
+    print(s + "Hello" + ", " + "World");
+    print(b);
+    print(3 > 4);
+    print(6 == 2 * 3);
+    print(0 - 7 * 3);
+    return 0;
+};)");
+
+    EXPECT_EQ("42Hello, World101-21", output);
+}
+
+TEST_F(X86Test, ItShouldReturnExitCodeOfMain)
+{
+    EXPECT_EQ("42 was returned from main", this->runX86(R"(function integer main() {
+    return 7 * 6;
+};)"));
+}
+
+TEST_F(X86Test, ItShouldPassArgumentsThatDoNotFitInRegistersOnStack)
+{
+    // Two strings and two integers fill the six argument registers, so the third
+    // string goes on the stack and the last integer still takes no register.
+    std::string output = this->runX86(R"(function string join(string a, integer b, string c, integer d, string e, integer f, integer g) {
+    print(g);
+    print(f);
+    print(d);
+    print(b);
+    return a + c + e;
+};
+
+function integer main() {
+    string middle;
+    middle = "b";
+    print(join("a", 1, middle, 2, "c", 3, 4));
+    return 0;
+};)");
+
+    EXPECT_EQ("4321abc", output);
+}
+
+TEST_F(X86Test, ItShouldShadowVariablesInNestedBlocks)
+{
+    std::string output = this->runX86(R"(function integer main() {
+    integer i;
+    integer total;
+    while (i < 3) {
+        i = i + 1;
+        if (true) {
+            integer i;
+            i = 10;
+            total = total + i;
+        };
+        string s;
+        s = s + "x";
+        print(s);
+    };
+    if (total == 30) {
+        string total;
+        total = "s";
+        print(total);
+    };
+    print(total + i);
+    return 0;
+};)");
+
+    EXPECT_EQ("xxxs33", output);
+}
+
+TEST_F(X86Test, ItShouldBeCallableFromHostWithSystemVConvention)
+{
+    this->jit.add(x86::compile(this->parse(R"(function integer twice(integer n) {
+    return n * 2;
+};
+
+function string greet(string name, integer times) {
+    string greeting;
+    while (times > 0) {
+        greeting = greeting + "Hello, ";
+        times = times - 1;
+    };
+    return greeting + name;
+};)")));
+
+    auto twice = reinterpret_cast<int (*)(int)>(this->jit.lookup("twice"));
+    EXPECT_EQ(-42, twice(-21));
+
+    auto greet = reinterpret_cast<AnchorString (*)(AnchorString, int)>(this->jit.lookup("greet"));
+    AnchorString greeting = greet(AnchorString{"anchor", 7}, 2);
+    EXPECT_STREQ("Hello, Hello, anchor", greeting.characters);
+    EXPECT_EQ(21, greeting.size);
+}
+
+TEST_F(X86Test, ItShouldOnlyReadLowestBitOfBooleanArguments)
+{
+    this->jit.add(x86::compile(this->parse(R"(function integer pick(boolean b) {
+    if (b) {
+        return 1;
+    };
+    return 0;
+};
+
+function integer pickLast(integer a, integer b, integer c, integer d, integer e, integer f, boolean g) {
+    return pick(g);
+};)")));
+
+    // An i1 from LLVM code may carry anything above its lowest bit.
+    auto pick = reinterpret_cast<int (*)(int)>(this->jit.lookup("pick"));
+    EXPECT_EQ(0, pick(0xFE));
+    EXPECT_EQ(1, pick(0xFF));
+
+    auto pickLast = reinterpret_cast<int (*)(int, int, int, int, int, int, int)>(this->jit.lookup("pickLast"));
+    EXPECT_EQ(0, pickLast(0, 0, 0, 0, 0, 0, 0x100));
+    EXPECT_EQ(1, pickLast(0, 0, 0, 0, 0, 0, 0x101));
+}
+
+TEST_F(X86Test, ItShouldMatchLlvmOnEveryWorkload)
+{
+    for (const auto &entry : std::filesystem::directory_iterator(ANCHOR_BENCH_WORKLOADS_DIR))
+    {
+        std::ifstream workload(entry.path());
+        std::stringstream sourceCode;
+        sourceCode << workload.rdbuf();
+
+        std::string expected = this->run(sourceCode.str());
+        x86::Jit jit;
+        this->capture(jit);
+        jit.add(x86::compile(this->parse(sourceCode.str())));
+        jit.runMain();
+        EXPECT_EQ(expected, this->getCaptured()) << entry.path();
+    }
+}
+
+TEST_F(X86Test, ItShouldRejectWhatOnlyLlvmCompiles)
+{
+    EXPECT_THROW(x86::compile(this->parse(R"(function boolean same(string a, string b) {
+    return a == b;
+};)")),
+                 std::invalid_argument);
+    EXPECT_THROW(this->jit.lookup("main"), std::runtime_error);
+}